@@ -46,10 +46,12 @@ namespace wsdb {
  * @a WSDB_FILE_REOPEN: file already opened, disk manager should not open file twice
  * @a WSDB_NOT_IMPLEMENTED: method not implemented, used for abstract class method
  * @a WSDB_NO_FREE_FRAME: buffer pool manager cannot find available frame to load page
+ * @a WSDB_NO_FREE_MEMORY: memory broker cannot grant the minimum memory an operator requests
  * @a WSDB_RECORD_EXISTS: record already exists, used for table manager for record insertion
  * @a WSDB_RECORD_MISS: record not exists, used for table manager for record deletion
  * @a WSDB_RECLEN_ERROR: record length error, used to check if the record length exceeds MAX_RECORD_SIZE
  * @a WSDB_PAGE_MISS: used for table manager to check if RID.page is valid
+ * @a WSDB_PAGE_FULL: no space left in a slotted page for the record written to a given RID
  * @a WSDB_FILE_READ_ERROR: unix error when failing to read file
  * @a WSDB_FILE_WRITE_ERROR: unix error when failing to write file
  * @a WSDB_INVALID_SQL: invalid SQL statement, syntax error
@@ -76,10 +78,12 @@ namespace wsdb {
   ENUM(WSDB_FILE_REOPEN)       \
   ENUM(WSDB_NOT_IMPLEMENTED)   \
   ENUM(WSDB_NO_FREE_FRAME)     \
+  ENUM(WSDB_NO_FREE_MEMORY)    \
   ENUM(WSDB_RECORD_EXISTS)     \
   ENUM(WSDB_RECORD_MISS)       \
   ENUM(WSDB_RECLEN_ERROR)      \
   ENUM(WSDB_PAGE_MISS)         \
+  ENUM(WSDB_PAGE_FULL)         \
   ENUM(WSDB_FILE_READ_ERROR)   \
   ENUM(WSDB_FILE_WRITE_ERROR)  \
   ENUM(WSDB_INVALID_SQL)       \
@@ -22,7 +22,13 @@
 #ifndef WSDB_BITMAP_H
 #define WSDB_BITMAP_H
 
+#include <atomic>
+#include <bit>
+#include <cstdint>
 #include <cstring>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
 #include "../../common/error.h"
 #include "../../common/micro.h"
 
@@ -52,19 +58,175 @@ public:
     return (bitmap[bit_idx / BITMAP_WIDTH] & (1 << (bit_idx % BITMAP_WIDTH))) != 0;
   }
 
+  /**
+   * Atomically set the bit, threads racing for the same bit see exactly one winner
+   * @return true if the bit was 0 and is set by this call
+   */
+  static auto TrySetBit(char *bitmap, size_t bit_idx) -> bool
+  {
+    auto mask = static_cast<char>(1 << (bit_idx % BITMAP_WIDTH));
+    return (std::atomic_ref<char>(bitmap[bit_idx / BITMAP_WIDTH]).fetch_or(mask) & mask) == 0;
+  }
+
+  /**
+   * Atomically reset the bit
+   * @return true if the bit was 1 and is reset by this call
+   */
+  static auto TryResetBit(char *bitmap, size_t bit_idx) -> bool
+  {
+    auto mask = static_cast<char>(1 << (bit_idx % BITMAP_WIDTH));
+    return (std::atomic_ref<char>(bitmap[bit_idx / BITMAP_WIDTH]).fetch_and(static_cast<char>(~mask)) & mask) != 0;
+  }
+
+  /**
+   * Atomically find a 0 bit in [0, bit_num) and set it, bytes are loaded atomically so that the bitmap can be
+   * claimed by several threads at the same time
+   * @param start hint of the first 0 bit, the search begins from its byte, bits before the byte are not searched
+   * @return index of the claimed bit, bit_num if all bits are 1
+   */
+  static auto ClaimFirst(char *bitmap, size_t bit_num, size_t start = 0) -> size_t
+  {
+    for (size_t byte_idx = start / BITMAP_WIDTH; byte_idx < BITMAP_SIZE(bit_num); ++byte_idx) {
+      std::atomic_ref<char> byte(bitmap[byte_idx]);
+      char                  old = byte.load(std::memory_order_relaxed);
+      while (static_cast<unsigned char>(old) != 0xff) {
+        size_t bit_idx = byte_idx * BITMAP_WIDTH + std::countr_one(static_cast<unsigned char>(old));
+        if (bit_idx >= bit_num) {
+          return bit_num;
+        }
+        // on failure old is reloaded and the next 0 bit of the byte is tried
+        if (byte.compare_exchange_weak(old, static_cast<char>(old | (1 << (bit_idx % BITMAP_WIDTH))))) {
+          return bit_idx;
+        }
+      }
+    }
+    return bit_num;
+  }
+
   static void Clear(char *bitmap, size_t bit_num) { memset(bitmap, 0, BITMAP_SIZE(bit_num)); }
 
   static void Set(char *bitmap, size_t bit_num) { memset(bitmap, 0xff, BITMAP_SIZE(bit_num)); }
 
+  /**
+   * Find the first bit equal to value in [start, bit_num), 64 bits are tested at a time with ctz,
+   * long ranges skip 256 bits at a time with AVX2 when the cpu supports it
+   * @return bit_num if not found
+   */
   static auto FindFirst(const char *bitmap, size_t bit_num, size_t start, bool value) -> size_t
   {
-    for (size_t i = start; i < bit_num; i++) {
-      if (GetBit(bitmap, i) == value) {
-        return i;
+    if (start >= bit_num) {
+      return bit_num;
+    }
+    size_t word_num = WordNum(bit_num);
+    size_t word_idx = start / WORD_BITS;
+    // flip the words when looking for 0, so that we always look for the lowest set bit
+    uint64_t flip = value ? 0 : ~uint64_t{0};
+    uint64_t word = (LoadWord(bitmap, bit_num, word_idx) ^ flip) & (~uint64_t{0} << (start % WORD_BITS));
+    while (word == 0) {
+      if (++word_idx >= word_num) {
+        return bit_num;
+      }
+      if (word_num - word_idx >= AVX2_MIN_WORDS && HasAVX2()) {
+        word_idx = SkipBlocksAVX2(bitmap, word_idx, word_num, value);
+        if (word_idx >= word_num) {
+          return bit_num;
+        }
       }
+      word = LoadWord(bitmap, bit_num, word_idx) ^ flip;
     }
-    return bit_num;
+    size_t idx = word_idx * WORD_BITS + std::countr_zero(word);
+    return idx < bit_num ? idx : bit_num;
+  }
+
+  /**
+   * Count the set bits in [0, bit_num)
+   */
+  static auto Count(const char *bitmap, size_t bit_num) -> size_t
+  {
+    size_t count    = 0;
+    size_t word_num = WordNum(bit_num);
+    for (size_t i = 0; i < word_num; ++i) {
+      count += std::popcount(LoadWord(bitmap, bit_num, i));
+    }
+    return count;
+  }
+
+  /**
+   * Call func(bit_idx) for every set bit in [0, bit_num) in ascending order, a word at a time
+   */
+  template <typename Func>
+  static void ForEachSetBit(const char *bitmap, size_t bit_num, Func &&func)
+  {
+    size_t word_num = WordNum(bit_num);
+    for (size_t i = 0; i < word_num; ++i) {
+      for (uint64_t word = LoadWord(bitmap, bit_num, i); word != 0; word &= word - 1) {
+        func(i * WORD_BITS + std::countr_zero(word));
+      }
+    }
+  }
+
+private:
+  static constexpr size_t WORD_BITS = 64;
+  // below this number of words, the overhead of AVX2 is not worth it
+  static constexpr size_t AVX2_MIN_WORDS = 8;
+
+  static auto WordNum(size_t bit_num) -> size_t { return (bit_num + WORD_BITS - 1) / WORD_BITS; }
+
+  /// load the word_idx-th 64-bit word, bytes and bits beyond bit_num are read as 0
+  static auto LoadWord(const char *bitmap, size_t bit_num, size_t word_idx) -> uint64_t
+  {
+    size_t   byte_off  = word_idx * sizeof(uint64_t);
+    size_t   byte_num  = BITMAP_SIZE(bit_num);
+    uint64_t word      = 0;
+    if (byte_off + sizeof(uint64_t) <= byte_num) {
+      memcpy(&word, bitmap + byte_off, sizeof(uint64_t));
+    } else {
+      memcpy(&word, bitmap + byte_off, byte_num - byte_off);
+    }
+    // bit i is stored in byte i / 8 at position i % 8, which is bit i of a little-endian word
+    if constexpr (std::endian::native == std::endian::big) {
+      word = __builtin_bswap64(word);
+    }
+    size_t tail_bits = bit_num - word_idx * WORD_BITS;
+    if (tail_bits < WORD_BITS) {
+      word &= (uint64_t{1} << tail_bits) - 1;
+    }
+    return word;
+  }
+
+  static auto HasAVX2() -> bool
+  {
+#if defined(__x86_64__) || defined(__i386__)
+    static const bool has_avx2 = __builtin_cpu_supports("avx2");
+    return has_avx2;
+#else
+    return false;
+#endif
+  }
+
+  /**
+   * Skip 256-bit blocks that contain no bit equal to value, the last (partial) word is never skipped
+   * @return index of the first word of the first block that may contain the bit
+   */
+#if defined(__x86_64__) || defined(__i386__)
+  __attribute__((target("avx2"))) static auto SkipBlocksAVX2(
+      const char *bitmap, size_t word_idx, size_t word_num, bool value) -> size_t
+  {
+    constexpr size_t block_words = sizeof(__m256i) / sizeof(uint64_t);
+    const __m256i    ones        = _mm256_set1_epi64x(-1);
+    for (; word_idx + block_words < word_num; word_idx += block_words) {
+      __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(bitmap + word_idx * sizeof(uint64_t)));
+      // testz: all bits are 0, testc: all bits are 1
+      bool skip = value ? _mm256_testz_si256(block, block) : _mm256_testc_si256(block, ones);
+      if (!skip) {
+        break;
+      }
+    }
+    return word_idx;
   }
+#else
+  static auto SkipBlocksAVX2(const char *, size_t word_idx, size_t, bool) -> size_t { return word_idx; }
+#endif
 };
 }  // namespace wsdb
 
@@ -84,7 +84,7 @@ public:
     return r_col_;
   }
 
-  [[nodiscard]] auto GetRVal() const -> ValueSptr
+  [[nodiscard]] auto GetRVal() const -> const ValueSptr &
   {
     WSDB_ASSERT(rval_type_ == kValue, fmt::format("should be: {}", CondRvalTypeToString(rval_type_)));
     return r_val_;
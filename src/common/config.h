@@ -28,18 +28,77 @@ constexpr size_t  BUFFER_POOL_SIZE = 8;
 const std::string REPLACER         = "LRUReplacer";
 // enable this to use LRUKReplacer
 const size_t REPLACER_LRU_K = 10;
+// set this environment variable to a file name to record page accesses of the server, see buffer_pool_benchmark
+const std::string BUFFER_TRACE_ENV = "WSDB_BUFFER_TRACE";
 /// system
 constexpr size_t MAX_REC_SIZE = 1024;
+// string fields declared wider than this are stored out of line in row tables, rows keep a pointer and a prefix
+constexpr size_t TOAST_THRESHOLD = 64;
+// bytes of an out-of-line value kept in the row, a value no longer than this is not moved out at all
+constexpr size_t TOAST_PREFIX_SIZE = 16;
+// number of pages a table iterator asks the disk to read ahead during a sequential scan
+constexpr size_t SCAN_PREFETCH_PAGES = 16;
+// a pax page has up to this many times the slots its rows take plain, the rows beyond are encoded, see PAXPageHandle
+constexpr size_t PAX_SLOT_RATIO = 4;
+// an insert encodes a full pax page again only if at least 1/PAX_FREEZE_GAIN of its plain slots become free by it
+constexpr size_t PAX_FREEZE_GAIN = 8;
+// number of insert pages of a table, inserting threads are spread over them by thread id
+constexpr size_t TABLE_INSERT_PAGE_NUM = 16;
+// 1MB, the memtable of an lsm table turns immutable and is flushed to a sorted run in the background at this size
+constexpr size_t LSM_MEMTABLE_SIZE = 1024 * 1024;
+// number of sorted runs in level 0 of an lsm table before they are compacted into level 1
+constexpr size_t LSM_LEVEL0_RUN_NUM = 4;
+// level i + 1 of an lsm table holds this many times the bytes of level i, level 0 holds LSM_LEVEL0_RUN_NUM memtables
+constexpr size_t LSM_LEVEL_SIZE_RATIO = 10;
+// bits of the bloom filter of a sorted run per key, about 1% false positives
+constexpr size_t LSM_BLOOM_BITS_PER_KEY = 10;
+// the partition of a row of a partitioned table is kept in the page id of its rid above this many bits, so a partition
+// holds up to 2^24 pages and a table up to MAX_PARTITION_NUM partitions
+constexpr size_t PARTITION_PAGE_BITS = 24;
+constexpr size_t MAX_PARTITION_NUM   = 1 << (31 - PARTITION_PAGE_BITS);
+// number of pages VACUUM empties while holding the table, queries on the table run between the steps
+constexpr size_t VACUUM_STEP_PAGES = 8;
+/// memory
+// 256MB, total memory shared by the buffer pool and operators' working memory, managed by MemoryBroker
+constexpr size_t MEMORY_BUDGET = 256 * 1024 * 1024;
+// frames of the buffer pool never lent to operators, so that the query feeding an operator can still pin its pages
+constexpr size_t POOL_RESERVED_FRAMES = 4;
+// 64KB, records and values of a query are carved from blocks of this size, see MemoryContext
+constexpr size_t MEMORY_CONTEXT_BLOCK_SIZE = 64 * 1024;
 /// executor
-// 64MB, used for sort executor's buffer
+// 64MB, the most memory a sort executor asks for, the actual size depends on the grant of MemoryBroker
 constexpr size_t SORT_BUFFER_SIZE = 64 * 1024 * 1024;
 // 10-way merge sort, max tmp file to use in merge sort
 constexpr size_t SORT_WAY_NUM = 10;
+// the least memory a sort executor can run with, records are spilled to disk more often with a smaller grant
+constexpr size_t SORT_MIN_BUFFER_SIZE = SORT_WAY_NUM * PAGE_SIZE;
+// number of parser threads of COPY, each of them pins at most one page of the buffer pool at a time
+constexpr size_t COPY_WORKER_NUM = 4;
+// 4MB, the input file of COPY is cut into ranges of about this size on row boundaries, one range per task
+constexpr size_t COPY_RANGE_SIZE = 4 * 1024 * 1024;
+// rows a COPY worker parses before inserting them as one batch
+constexpr size_t COPY_BATCH_ROWS = 1024;
+// most worker threads of parallel scans running at a time over all queries, a scan asking for more gets what is left
+constexpr size_t MAX_SCAN_WORKER_NUM = 16;
+// frames of the buffer pool parallel scans leave to the rest of their queries and to other queries, each worker keeps
+// one page pinned, so the workers running at a time are bounded by the frames left as well
+constexpr size_t SCAN_FRAME_HEADROOM = 4;
+// pages a parallel scan worker claims at a time
+constexpr size_t SCAN_MORSEL_PAGES = 4 * SCAN_PREFETCH_PAGES;
+// rows a parallel scan worker hands over to the consumer at a time
+constexpr size_t SCAN_BATCH_ROWS = 256;
+// batches per worker of a parallel scan waiting for the consumer, workers that get further ahead wait
+constexpr size_t SCAN_QUEUE_BATCHES = 4;
 
 const std::string DB_SUFFIX  = ".db";
 const std::string TAB_SUFFIX = ".tab";
 const std::string IDX_SUFFIX = ".idx";
 const std::string TMP_SUFFIX = ".tmp";
+const std::string ZMP_SUFFIX = ".zmp";
+const std::string TST_SUFFIX = ".tst";
+const std::string DIC_SUFFIX = ".dic";
+const std::string LSM_SUFFIX = ".lsm";
+const std::string RUN_SUFFIX = ".run";
 
 const std::string DB_DIR  = "db";
 const std::string TAB_DIR = "tab";
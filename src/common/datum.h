@@ -0,0 +1,267 @@
+/*------------------------------------------------------------------------------
+ - Copyright (c) 2024. Websoft research group, Nanjing University.
+ -
+ - This program is free software: you can redistribute it and/or modify
+ - it under the terms of the GNU General Public License as published by
+ - the Free Software Foundation, either version 3 of the License, or
+ - (at your option) any later version.
+ -
+ - This program is distributed in the hope that it will be useful,
+ - but WITHOUT ANY WARRANTY; without even the implied warranty of
+ - MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ - GNU General Public License for more details.
+ -
+ - You should have received a copy of the GNU General Public License
+ - along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ -----------------------------------------------------------------------------*/
+
+//
+// Created by ziqi on 2024/9/20.
+//
+
+#ifndef WSDB_DATUM_H
+#define WSDB_DATUM_H
+
+#include <cstring>
+#include <functional>
+#include <string>
+#include <string_view>
+
+#include "value.h"
+
+namespace wsdb {
+
+/**
+ * @brief A 16-byte value passed by copy, used where values are read per row, e.g. evaluating conditions and hashing.
+ *
+ * Numbers and booleans are stored inline, strings shorter than INLINE_SIZE bytes are copied inline and longer ones
+ * point to the memory they are read from, so such a datum is only valid as long as that memory, e.g. the record or the
+ * Value it is read from. Nothing is allocated, comparison and hashing dispatch on the type with a switch.
+ * Use ToValue to keep a datum beyond the memory it points to.
+ */
+class Datum
+{
+public:
+  /// inline strings are zero terminated, so the longest one is INLINE_SIZE - 1 bytes
+  static constexpr size_t INLINE_SIZE = 8;
+
+  Datum() : Datum(TYPE_NULL, true) {}
+
+  static auto Null(FieldType type) -> Datum { return {type, true}; }
+
+  static auto Int(int32_t value) -> Datum
+  {
+    Datum datum(TYPE_INT, false);
+    datum.int_ = value;
+    return datum;
+  }
+
+  static auto Float(float value) -> Datum
+  {
+    Datum datum(TYPE_FLOAT, false);
+    datum.float_ = value;
+    return datum;
+  }
+
+  static auto Bool(bool value) -> Datum
+  {
+    Datum datum(TYPE_BOOL, false);
+    datum.bool_ = value;
+    return datum;
+  }
+
+  /// @param data must outlive the datum if size is not less than INLINE_SIZE
+  static auto String(const char *data, size_t size) -> Datum
+  {
+    Datum datum(TYPE_STRING, false);
+    datum.size_ = static_cast<uint32_t>(size);
+    if (size < INLINE_SIZE) {
+      memcpy(datum.inline_, data, size);
+    } else {
+      datum.ptr_ = data;
+    }
+    return datum;
+  }
+
+  /**
+   * Read a non-null field of a record, a string is cut at the first '\0' like StringValue
+   * @param type
+   * @param data
+   * @param size size of the field
+   * @return
+   */
+  static auto FromField(FieldType type, const char *data, size_t size) -> Datum
+  {
+    switch (type) {
+      case TYPE_BOOL: return Bool(*reinterpret_cast<const bool *>(data));
+      case TYPE_INT: return Int(*reinterpret_cast<const int32_t *>(data));
+      case TYPE_FLOAT: return Float(*reinterpret_cast<const float *>(data));
+      case TYPE_STRING: return String(data, strnlen(data, size));
+      default: WSDB_FETAL("Unsupported field type");
+    }
+  }
+
+  /// @param value must outlive the datum if it is a string, arrays are not supported
+  static auto FromValue(const Value &value) -> Datum
+  {
+    if (value.IsNull()) {
+      return Null(value.GetType());
+    }
+    switch (value.GetType()) {
+      case TYPE_BOOL: return Bool(static_cast<const BoolValue &>(value).Get());
+      case TYPE_INT: return Int(static_cast<const IntValue &>(value).Get());
+      case TYPE_FLOAT: return Float(static_cast<const FloatValue &>(value).Get());
+      case TYPE_STRING: {
+        const auto &str = static_cast<const StringValue &>(value).Get();
+        return String(str.data(), str.size());
+      }
+      default: WSDB_FETAL(fmt::format("Unsupported datum type {}", FieldTypeToString(value.GetType())));
+    }
+  }
+
+  [[nodiscard]] auto ToValue() const -> ValueSptr
+  {
+    if (is_null_) {
+      return ValueFactory::CreateNullValue(GetType());
+    }
+    switch (GetType()) {
+      case TYPE_BOOL: return ValueFactory::CreateBoolValue(bool_);
+      case TYPE_INT: return ValueFactory::CreateIntValue(int_);
+      case TYPE_FLOAT: return ValueFactory::CreateFloatValue(float_);
+      case TYPE_STRING: return ValueFactory::CreateStringValue(GetStringData(), size_);
+      default: WSDB_FETAL("Unsupported datum type");
+    }
+  }
+
+  [[nodiscard]] auto GetType() const -> FieldType { return static_cast<FieldType>(type_); }
+
+  [[nodiscard]] auto IsNull() const -> bool { return is_null_; }
+
+  [[nodiscard]] auto GetInt() const -> int32_t { return int_; }
+
+  [[nodiscard]] auto GetFloat() const -> float { return float_; }
+
+  [[nodiscard]] auto GetBool() const -> bool { return bool_; }
+
+  [[nodiscard]] auto GetString() const -> std::string_view { return {GetStringData(), size_}; }
+
+  /**
+   * Compare two non-null datums, int and float are compared as float like ValueFactory::AlignTypes
+   * @return -1, 0 or 1 as lhs is less than, equal to or greater than rhs
+   */
+  static auto Compare(const Datum &lhs, const Datum &rhs) -> int
+  {
+    if (lhs.type_ != rhs.type_) {
+      if (!lhs.IsNumeric() || !rhs.IsNumeric()) {
+        WSDB_THROW(WSDB_TYPE_MISSMATCH,
+            fmt::format(
+                "Type mismatch: {} != {}", FieldTypeToString(lhs.GetType()), FieldTypeToString(rhs.GetType())));
+      }
+      return Three(lhs.AsFloat(), rhs.AsFloat());
+    }
+    switch (lhs.GetType()) {
+      case TYPE_BOOL: return Three(lhs.bool_, rhs.bool_);
+      case TYPE_INT: return Three(lhs.int_, rhs.int_);
+      case TYPE_FLOAT: return Three(lhs.float_, rhs.float_);
+      case TYPE_STRING: return Three(lhs.GetString().compare(rhs.GetString()), 0);
+      default: WSDB_FETAL("Unsupported datum type");
+    }
+  }
+
+  /**
+   * Evaluate lhs op rhs like the operators of Value, i.e. two nulls are equal, and null satisfies no other comparison
+   * @param op any comparison but OP_IN
+   * @param lhs
+   * @param rhs
+   * @return
+   */
+  static auto Eval(CompOp op, const Datum &lhs, const Datum &rhs) -> bool
+  {
+    if (lhs.is_null_ || rhs.is_null_) {
+      bool both_null = lhs.is_null_ && rhs.is_null_;
+      switch (op) {
+        case OP_EQ: return both_null;
+        case OP_NE: return !both_null;
+        case OP_LT:
+        case OP_LE:
+        case OP_GT:
+        case OP_GE: return false;
+        default: WSDB_FETAL(CompOpToString(op));
+      }
+    }
+    auto cmp = Compare(lhs, rhs);
+    switch (op) {
+      case OP_EQ: return cmp == 0;
+      case OP_NE: return cmp != 0;
+      case OP_LT: return cmp < 0;
+      case OP_LE: return cmp <= 0;
+      case OP_GT: return cmp > 0;
+      case OP_GE: return cmp >= 0;
+      default: WSDB_FETAL(CompOpToString(op));
+    }
+  }
+
+  /// hash of the value, a string hashes the same as std::string, a null hashes to 0
+  [[nodiscard]] auto Hash() const -> size_t
+  {
+    if (is_null_) {
+      return 0;
+    }
+    switch (GetType()) {
+      case TYPE_BOOL: return std::hash<bool>{}(bool_);
+      case TYPE_INT: return std::hash<int32_t>{}(int_);
+      case TYPE_FLOAT: return std::hash<float>{}(float_);
+      case TYPE_STRING: return std::hash<std::string_view>{}(GetString());
+      default: WSDB_FETAL("Unsupported datum type");
+    }
+  }
+
+  [[nodiscard]] auto ToString() const -> std::string
+  {
+    if (is_null_) {
+      return "(null)";
+    }
+    switch (GetType()) {
+      case TYPE_BOOL: return std::to_string(bool_);
+      case TYPE_INT: return std::to_string(int_);
+      case TYPE_FLOAT: return std::to_string(float_);
+      case TYPE_STRING: return std::string(GetString());
+      default: WSDB_FETAL("Unsupported datum type");
+    }
+  }
+
+private:
+  Datum(FieldType type, bool is_null) : ptr_(nullptr), type_(static_cast<uint8_t>(type)), is_null_(is_null) {}
+
+  [[nodiscard]] auto IsNumeric() const -> bool { return type_ == TYPE_INT || type_ == TYPE_FLOAT; }
+
+  [[nodiscard]] auto AsFloat() const -> float { return type_ == TYPE_INT ? static_cast<float>(int_) : float_; }
+
+  [[nodiscard]] auto GetStringData() const -> const char * { return size_ < INLINE_SIZE ? inline_ : ptr_; }
+
+  template <typename T>
+  static auto Three(const T &lhs, const T &rhs) -> int
+  {
+    return lhs < rhs ? -1 : (rhs < lhs ? 1 : 0);
+  }
+
+private:
+  union
+  {
+    int32_t     int_;
+    float       float_;
+    bool        bool_;
+    const char *ptr_;
+    char        inline_[INLINE_SIZE];
+  };
+  // length of a string
+  uint32_t size_{0};
+  uint8_t  type_;
+  bool     is_null_;
+};
+
+static_assert(sizeof(Datum) == 16, "Datum should fit in 16 bytes");
+
+}  // namespace wsdb
+
+#endif  // WSDB_DATUM_H
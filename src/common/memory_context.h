@@ -0,0 +1,191 @@
+/*------------------------------------------------------------------------------
+ - Copyright (c) 2024. Websoft research group, Nanjing University.
+ -
+ - This program is free software: you can redistribute it and/or modify
+ - it under the terms of the GNU General Public License as published by
+ - the Free Software Foundation, either version 3 of the License, or
+ - (at your option) any later version.
+ -
+ - This program is distributed in the hope that it will be useful,
+ - but WITHOUT ANY WARRANTY; without even the implied warranty of
+ - MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ - GNU General Public License for more details.
+ -
+ - You should have received a copy of the GNU General Public License
+ - along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ -----------------------------------------------------------------------------*/
+
+//
+// Created by ziqi on 2024/9/11.
+//
+
+#ifndef WSDB_MEMORY_CONTEXT_H
+#define WSDB_MEMORY_CONTEXT_H
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include "config.h"
+#include "../../common/micro.h"
+
+namespace wsdb {
+
+/**
+ * @brief A per-query arena that records and values of the executor tree are carved from.
+ *
+ * Small allocations are bumped from blocks of MEMORY_CONTEXT_BLOCK_SIZE bytes and recycled through free lists of
+ * 16-byte size classes, so a query that creates and drops millions of records touches the heap only once per block.
+ * Allocations larger than the largest size class go to the heap directly. All blocks are released at once when the
+ * context is destroyed, objects allocated from a context must not outlive it.
+ *
+ * Nothing is allocated from a context unless it is passed explicitly, Record and ValueFactory take an optional context
+ * and allocate from the heap without one. Executors are handed the context of their query by Executor::Translate and
+ * pass it to the records they produce, everything else (tables, the catalog, index entries) stays on the heap. A
+ * context is not thread-safe, each worker thread of a query uses a context of its own.
+ */
+class MemoryContext
+{
+public:
+  struct Stats
+  {
+    size_t alloc_count_{0};
+    size_t free_count_{0};
+    // bytes requested by live and freed allocations
+    size_t alloc_bytes_{0};
+    // allocations served by the heap because they are too large
+    size_t large_alloc_count_{0};
+    size_t block_count_{0};
+
+    [[nodiscard]] auto ToString() const -> std::string
+    {
+      return fmt::format("allocs: {}, frees: {}, bytes: {}, large allocs: {}, blocks: {} ({} bytes)", alloc_count_,
+          free_count_, alloc_bytes_, large_alloc_count_, block_count_, block_count_ * MEMORY_CONTEXT_BLOCK_SIZE);
+    }
+  };
+
+  MemoryContext() = default;
+
+  ~MemoryContext()
+  {
+    for (auto block : blocks_) {
+      ::operator delete(block);
+    }
+  }
+
+  DISABLE_COPY_MOVE_AND_ASSIGN(MemoryContext)
+
+  auto Allocate(size_t size) -> void *
+  {
+    stats_.alloc_count_++;
+    stats_.alloc_bytes_ += size;
+    if (size > MAX_SMALL_SIZE) {
+      stats_.large_alloc_count_++;
+      return ::operator new(size);
+    }
+    auto cls = SizeClass(size);
+    if (free_lists_[cls] != nullptr) {
+      auto chunk       = free_lists_[cls];
+      free_lists_[cls] = chunk->next_;
+      return chunk;
+    }
+    auto chunk_size = (cls + 1) * ALIGNMENT;
+    if (cursor_ + chunk_size > end_) {
+      cursor_ = static_cast<char *>(::operator new(MEMORY_CONTEXT_BLOCK_SIZE));
+      end_    = cursor_ + MEMORY_CONTEXT_BLOCK_SIZE;
+      blocks_.push_back(cursor_);
+      stats_.block_count_++;
+    }
+    auto ptr = cursor_;
+    cursor_ += chunk_size;
+    return ptr;
+  }
+
+  /**
+   * Give a chunk back to its free list, the size must be the one passed to Allocate
+   * @param ptr
+   * @param size
+   */
+  void Deallocate(void *ptr, size_t size)
+  {
+    stats_.free_count_++;
+    if (size > MAX_SMALL_SIZE) {
+      ::operator delete(ptr);
+      return;
+    }
+    auto cls         = SizeClass(size);
+    auto chunk       = static_cast<FreeChunk *>(ptr);
+    chunk->next_     = free_lists_[cls];
+    free_lists_[cls] = chunk;
+  }
+
+  [[nodiscard]] auto GetStats() const -> const Stats & { return stats_; }
+
+private:
+  struct FreeChunk
+  {
+    FreeChunk *next_;
+  };
+
+  static constexpr size_t ALIGNMENT      = 16;
+  static constexpr size_t CLASS_NUM      = 32;
+  static constexpr size_t MAX_SMALL_SIZE = ALIGNMENT * CLASS_NUM;
+
+  static auto SizeClass(size_t size) -> size_t { return size == 0 ? 0 : (size - 1) / ALIGNMENT; }
+
+  std::vector<char *>                blocks_;
+  char                              *cursor_{nullptr};
+  char                              *end_{nullptr};
+  std::array<FreeChunk *, CLASS_NUM> free_lists_{};
+  Stats                              stats_;
+};
+
+/**
+ * @brief Standard allocator over a memory context, behaves like std::allocator if the context is nullptr.
+ * The context is captured on construction, so objects are freed to the context they came from
+ */
+template <typename T>
+class ContextAllocator
+{
+public:
+  using value_type = T;
+
+  explicit ContextAllocator(MemoryContext *ctx = nullptr) : ctx_(ctx) {}
+
+  template <typename U>
+  ContextAllocator(const ContextAllocator<U> &other) : ctx_(other.GetContext())  // NOLINT: rebind
+  {}
+
+  auto allocate(size_t n) -> T *
+  {
+    if (ctx_ == nullptr) {
+      return static_cast<T *>(::operator new(n * sizeof(T)));
+    }
+    return static_cast<T *>(ctx_->Allocate(n * sizeof(T)));
+  }
+
+  void deallocate(T *ptr, size_t n)
+  {
+    if (ctx_ == nullptr) {
+      ::operator delete(ptr);
+      return;
+    }
+    ctx_->Deallocate(ptr, n * sizeof(T));
+  }
+
+  [[nodiscard]] auto GetContext() const -> MemoryContext * { return ctx_; }
+
+  template <typename U>
+  auto operator==(const ContextAllocator<U> &other) const -> bool
+  {
+    return ctx_ == other.GetContext();
+  }
+
+private:
+  MemoryContext *ctx_;
+};
+
+}  // namespace wsdb
+
+#endif  // WSDB_MEMORY_CONTEXT_H
@@ -21,6 +21,7 @@
 
 #ifndef WSDB_META_H
 #define WSDB_META_H
+#include <cstdint>
 #include <string>
 #include <vector>
 #include <memory>
@@ -40,6 +41,9 @@ struct FieldSchema
   //  bool        is_primary_key_{};
   //  bool        is_unique_{};
   bool nullable_{true};
+  // strings are stored as codes of a dictionary of the table, see DictHandle, how a field is stored does not take part
+  // in comparison
+  bool dict_encoded_{false};
   auto operator==(const FieldSchema &rhs) const -> bool
   {
     return table_id_ == rhs.table_id_ && field_name_ == rhs.field_name_ && field_size_ == rhs.field_size_ &&
@@ -80,19 +84,34 @@ struct RTField
   }
 };
 
+// a table file starts with the magic number and the version of its format, files of another version are not opened
+#define TABLE_FILE_MAGIC 0x42445357U  // "WSDB"
+// version history:
+// 1: the record num of a page is 8-byte aligned, at PAGE_RECORD_NUM_OFFSET before the next free page id
+// 2: partition_num_ ends the table header, the field schemas and the partition scheme follow it
+// 3: a flag byte per field, dict_encoded_, follows the field schemas and comes before the partition scheme
+// 4: pax pages have more slots than their plain layout holds, rows are encoded in the page once the plain slots run
+//    out, see PAXPageHandle
+// 5: memory_snapshot_ ends the table header
+#define TABLE_FORMAT_VERSION 5U
+
 /**
  * Table header is the first page of a table, it contains the meta information of the table
  */
 struct TableHeader
 {
+  uint32_t  magic_{TABLE_FILE_MAGIC};
+  uint32_t  version_{TABLE_FORMAT_VERSION};
   size_t    page_num_{0};
   page_id_t first_free_page_{INVALID_PAGE_ID};
   size_t    rec_num_{0};
   size_t    rec_size_{0};
   size_t    rec_per_page_{0};
   size_t    field_num_{0};
-  size_t    bitmap_size_{0};   // bit map size == BITMAP_SIZE(n_rec_per_page)
-  size_t    nullmap_size_{0};  // null map size == BITMAP_SIZE(n_field)
+  size_t    bitmap_size_{0};          // bit map size == BITMAP_SIZE(n_rec_per_page)
+  size_t    nullmap_size_{0};         // null map size == BITMAP_SIZE(n_field)
+  size_t    partition_num_{0};        // 0 if the table is not partitioned, see PartitionScheme
+  bool      memory_snapshot_{false};  // rows of an in-memory table are kept across closes, see MemoryEngine
 };
 
 #endif  // WSDB_META_H
@@ -29,10 +29,18 @@
 
 #define FILE_HEADER_PAGE_ID 0
 
+// record num is kept 8-byte aligned so that concurrent inserts can update it atomically, the layout changed with
+// format version 1 of table files, see TABLE_FORMAT_VERSION
 #define PAGE_LSN_OFFSET 0
-#define PAGE_NEXT_FREE_PAGE_ID_OFFSET (PAGE_LSN_OFFSET + sizeof(lsn_t))
-#define PAGE_RECORD_NUM_OFFSET (PAGE_NEXT_FREE_PAGE_ID_OFFSET + sizeof(page_id_t))
-#define PAGE_HEADER_SIZE (PAGE_RECORD_NUM_OFFSET + sizeof(size_t))
+#define PAGE_RECORD_NUM_OFFSET (PAGE_LSN_OFFSET + sizeof(lsn_t))
+#define PAGE_NEXT_FREE_PAGE_ID_OFFSET (PAGE_RECORD_NUM_OFFSET + sizeof(size_t))
+#define PAGE_HEADER_SIZE (PAGE_NEXT_FREE_PAGE_ID_OFFSET + sizeof(page_id_t))
+
+// a page that is not in the free page list keeps one of the states below as its next free page id
+// the page is the insert page of some threads, see TableHandle::InsertRecord
+#define OWNED_PAGE_ID (-2)
+// the page is full, it goes back to the free page list when a record is deleted from it
+#define FULL_PAGE_ID (-3)
 
 class Page
 {
@@ -98,7 +106,7 @@ public:
 private:
   file_id_t fid_{INVALID_FILE_ID};
   page_id_t pid_{INVALID_PAGE_ID};
-  char      data_[PAGE_SIZE]{};
+  alignas(8) char data_[PAGE_SIZE]{};
 };
 
 #endif  // WSDB_PAGE_H
@@ -47,7 +47,10 @@ constexpr int32_t INVALID_FILE_ID  = -1;
 
 #define ENUM_ENTITIES \
   ENUM(NARY_MODEL)    \
-  ENUM(PAX_MODEL)
+  ENUM(PAX_MODEL)     \
+  ENUM(SLOTTED_MODEL) \
+  ENUM(MEMORY_MODEL)  \
+  ENUM(LSM_MODEL)
 #define ENUM(ent) ENUMENTRY(ent)
 DECLARE_ENUM(StorageModel)
 #undef ENUM
@@ -56,6 +59,17 @@ ENUM_TO_STRING_BODY(StorageModel)
 #undef ENUM
 #undef ENUM_ENTITIES
 
+#define ENUM_ENTITIES   \
+  ENUM(RANGE_PARTITION) \
+  ENUM(HASH_PARTITION)
+#define ENUM(ent) ENUMENTRY(ent)
+DECLARE_ENUM(PartitionType)
+#undef ENUM
+#define ENUM(ent) ENUM2STRING(ent)
+ENUM_TO_STRING_BODY(PartitionType)
+#undef ENUM
+#undef ENUM_ENTITIES
+
 #define ENUM_ENTITIES \
   ENUM(TYPE_NULL)     \
   ENUM(TYPE_BOOL)     \
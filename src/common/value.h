@@ -26,6 +26,7 @@
 #include <string>
 #include <vector>
 #include "types.h"
+#include "memory_context.h"
 #include "../../common/error.h"
 #include "../../common/micro.h"
 
@@ -549,43 +550,54 @@ private:
 class ValueFactory
 {
 public:
-  static auto CreateIntValue(int value) -> IntValueSptr { return std::make_shared<IntValue>(value, false); }
+  /// values are allocated from ctx if one is given, else from the heap, see MemoryContext
+  static auto CreateIntValue(int value, MemoryContext *ctx = nullptr) -> IntValueSptr
+  {
+    return Make<IntValue>(ctx, value, false);
+  }
 
-  static auto CreateFloatValue(float value) -> FloatValueSptr { return std::make_shared<FloatValue>(value, false); }
+  static auto CreateFloatValue(float value, MemoryContext *ctx = nullptr) -> FloatValueSptr
+  {
+    return Make<FloatValue>(ctx, value, false);
+  }
 
-  static auto CreateBoolValue(bool value) -> BoolValueSptr { return std::make_shared<BoolValue>(value, false); }
+  static auto CreateBoolValue(bool value, MemoryContext *ctx = nullptr) -> BoolValueSptr
+  {
+    return Make<BoolValue>(ctx, value, false);
+  }
 
-  static auto CreateStringValue(const char *value, size_t size) -> StringValueSptr
+  static auto CreateStringValue(const char *value, size_t size, MemoryContext *ctx = nullptr) -> StringValueSptr
   {
-    return std::make_shared<StringValue>(value, size, false);
+    return Make<StringValue>(ctx, value, size, false);
   }
 
   static auto CreateArrayValue(const std::vector<ValueSptr> &values) -> ArrayValueSptr
   {
-    return std::make_shared<ArrayValue>(values, false);
+    return Make<ArrayValue>(nullptr, values, false);
   }
 
-  static auto CreateArrayValue() -> ArrayValueSptr { return std::make_shared<ArrayValue>(); }
+  static auto CreateArrayValue() -> ArrayValueSptr { return Make<ArrayValue>(nullptr); }
 
-  static auto CreateValue(FieldType type, const char *data, size_t size = -1) -> ValueSptr
+  static auto CreateValue(FieldType type, const char *data, size_t size = -1, MemoryContext *ctx = nullptr)
+      -> ValueSptr
   {
     switch (type) {
-      case FieldType::TYPE_BOOL: return ValueFactory::CreateBoolValue(*reinterpret_cast<const bool *>(data));
-      case FieldType::TYPE_INT: return ValueFactory::CreateIntValue(*reinterpret_cast<const int32_t *>(data));
-      case FieldType::TYPE_FLOAT: return ValueFactory::CreateFloatValue(*reinterpret_cast<const float *>(data));
-      case FieldType::TYPE_STRING: return ValueFactory::CreateStringValue(data, size);
+      case FieldType::TYPE_BOOL: return ValueFactory::CreateBoolValue(*reinterpret_cast<const bool *>(data), ctx);
+      case FieldType::TYPE_INT: return ValueFactory::CreateIntValue(*reinterpret_cast<const int32_t *>(data), ctx);
+      case FieldType::TYPE_FLOAT: return ValueFactory::CreateFloatValue(*reinterpret_cast<const float *>(data), ctx);
+      case FieldType::TYPE_STRING: return ValueFactory::CreateStringValue(data, size, ctx);
       default: WSDB_FETAL("Unsupported field type");
     }
   }
 
-  static auto CreateNullValue(FieldType type) -> ValueSptr
+  static auto CreateNullValue(FieldType type, MemoryContext *ctx = nullptr) -> ValueSptr
   {
     switch (type) {
-      case FieldType::TYPE_INT: return std::make_shared<IntValue>(0, true);
-      case FieldType::TYPE_FLOAT: return std::make_shared<FloatValue>(0.0f, true);
-      case FieldType::TYPE_BOOL: return std::make_shared<BoolValue>(false, true);
-      case FieldType::TYPE_STRING: return std::make_shared<StringValue>("", 0, true);
-      case FieldType::TYPE_ARRAY: return std::make_shared<ArrayValue>(std::vector<ValueSptr>(), true);
+      case FieldType::TYPE_INT: return Make<IntValue>(ctx, 0, true);
+      case FieldType::TYPE_FLOAT: return Make<FloatValue>(ctx, 0.0f, true);
+      case FieldType::TYPE_BOOL: return Make<BoolValue>(ctx, false, true);
+      case FieldType::TYPE_STRING: return Make<StringValue>(ctx, "", 0, true);
+      case FieldType::TYPE_ARRAY: return Make<ArrayValue>(ctx, std::vector<ValueSptr>(), true);
       default: WSDB_FETAL("Unknown FieldType");
     }
   }
@@ -633,6 +645,13 @@ public:
           fmt::format("Type mismatch {} != {}", FieldTypeToString(value->GetType()), FieldTypeToString(type)));
     }
   }
+
+private:
+  template <typename T, typename... Args>
+  static auto Make(MemoryContext *ctx, Args &&...args) -> std::shared_ptr<T>
+  {
+    return std::allocate_shared<T>(ContextAllocator<T>(ctx), std::forward<Args>(args)...);
+  }
 };
 
 }  // namespace wsdb
@@ -26,18 +26,149 @@
 
 namespace wsdb {
 
-// translate the plan to executor
-auto Executor::Translate(const std::shared_ptr<AbstractPlan> &plan, DatabaseHandle *db) -> AbstractExecutorUptr
+namespace {
+/**
+ * @return the scan at the bottom of a pipeline of projection, filter and sequential scan that is asked to run in
+ * parallel, nullptr if the plan is not such a pipeline or the table is not stored in pages
+ */
+auto GetParallelScan(std::shared_ptr<AbstractPlan> plan, DatabaseHandle *db) -> std::shared_ptr<ScanPlan>
 {
-  if (db == nullptr) {
-    WSDB_THROW(WSDB_DB_NOT_OPEN, "");
+  if (const auto proj = std::dynamic_pointer_cast<ProjectPlan>(plan)) {
+    plan = proj->child_;
+  }
+  if (const auto filter = std::dynamic_pointer_cast<FilterPlan>(plan)) {
+    plan = filter->child_;
+  }
+  auto scan = std::dynamic_pointer_cast<ScanPlan>(plan);
+  if (scan == nullptr || scan->parallel_ <= 1) {
+    return nullptr;
+  }
+  auto tab = db->GetTable(scan->table_name_);
+  if (tab == nullptr || tab->GetPartitionScheme() != nullptr || tab->GetStorageModel() == LSM_MODEL ||
+      tab->GetStorageModel() == MEMORY_MODEL) {
+    return nullptr;
+  }
+  return scan;
+}
+
+/// filter the records of child by the conditions of the plan, whose columns are bound to the out schema of child
+auto MakeFilter(const FilterPlan &filter, AbstractExecutorUptr child) -> AbstractExecutorUptr
+{
+  auto conds = ConditionExpr::Bind(filter.conds_, *child->GetOutSchema());
+  std::function<bool(const RecordView &)> filter_func = [conds = std::move(conds)](const RecordView &record) {
+    return ConditionExpr::Eval(conds, record);
+  };
+  return std::make_unique<FilterExecutor>(std::move(child), std::move(filter_func));
+}
+
+/// @return the fields of schema read by the projection and by the filter right below it, if any
+auto GetReadFields(const ProjectPlan &proj, const RecordSchema &schema) -> std::vector<size_t>
+{
+  std::vector<size_t> fields;
+  for (const auto &field : proj.schema_->GetFields()) {
+    fields.push_back(schema.BindField(field).field_idx_);
+  }
+  if (const auto filter = std::dynamic_pointer_cast<FilterPlan>(proj.child_)) {
+    for (const auto &cond : filter->conds_) {
+      fields.push_back(schema.BindField(cond.GetLCol()).field_idx_);
+      if (cond.GetRhsType() == kColumn) {
+        fields.push_back(schema.BindField(cond.GetRCol()).field_idx_);
+      }
+    }
+  }
+  return fields;
+}
+
+/// build the executors of a pipeline found by GetParallelScan for a worker reading the pages claimed from morsels
+auto MakeScanPipeline(const std::shared_ptr<AbstractPlan> &plan, TableHandle *tab, PageMorsels *morsels,
+    MemoryContext *mem_ctx, std::optional<std::vector<size_t>> fields = std::nullopt) -> AbstractExecutorUptr
+{
+  AbstractExecutorUptr executor;
+  if (const auto proj = std::dynamic_pointer_cast<ProjectPlan>(plan)) {
+    // every worker projects with a schema of its own
+    executor = std::make_unique<ProjectionExecutor>(
+        MakeScanPipeline(proj->child_, tab, morsels, mem_ctx, GetReadFields(*proj, tab->GetSchema())),
+        std::make_unique<RecordSchema>(proj->schema_->GetFields()));
+  } else if (const auto filter = std::dynamic_pointer_cast<FilterPlan>(plan)) {
+    auto scan = std::make_unique<SeqScanExecutor>(tab, filter->conds_, std::nullopt, morsels, std::move(fields));
+    scan->SetMemoryContext(mem_ctx);
+    executor = MakeFilter(*filter, std::move(scan));
+  } else {
+    executor = std::make_unique<SeqScanExecutor>(tab, ConditionVec{}, std::nullopt, morsels, std::move(fields));
+  }
+  executor->SetMemoryContext(mem_ctx);
+  return executor;
+}
+
+/// set the memory context of the executor, the records it produces are allocated from it
+auto WithContext(AbstractExecutorUptr executor, MemoryContext *mem_ctx) -> AbstractExecutorUptr
+{
+  if (executor != nullptr) {
+    executor->SetMemoryContext(mem_ctx);
+  }
+  return executor;
+}
+
+/**
+ * Scan the table of a scan plan, or of a filter right over one, the conditions of the filter are pushed down to the
+ * scan so that pages ruled out by the zone map are not read
+ * @param proj the projection over plan, if given, the scan only fetches the long values of the fields read above it
+ * @return nullptr if plan is neither
+ */
+auto MakeSeqScan(const std::shared_ptr<AbstractPlan> &plan, DatabaseHandle *db, MemoryContext *mem_ctx,
+    const ProjectPlan *proj = nullptr) -> AbstractExecutorUptr
+{
+  const auto filter = std::dynamic_pointer_cast<FilterPlan>(plan);
+  const auto scan   = std::dynamic_pointer_cast<ScanPlan>(filter != nullptr ? filter->child_ : plan);
+  if (scan == nullptr) {
+    return nullptr;
+  }
+  auto tab = db->GetTable(scan->table_name_);
+  if (tab == nullptr) {
+    WSDB_THROW(WSDB_TABLE_MISS, scan->table_name_);
+  }
+  std::optional<std::vector<size_t>> fields;
+  if (proj != nullptr) {
+    fields = GetReadFields(*proj, tab->GetSchema());
+  }
+  if (filter == nullptr) {
+    return WithContext(
+        std::make_unique<SeqScanExecutor>(tab, ConditionVec{}, std::nullopt, nullptr, std::move(fields)), mem_ctx);
+  }
+  return MakeFilter(*filter,
+      WithContext(
+          std::make_unique<SeqScanExecutor>(tab, filter->conds_, scan->partitions_, nullptr, std::move(fields)),
+          mem_ctx));
+}
+
+/// translate one node of the plan, its children are translated by Executor::Translate
+auto TranslatePlan(const std::shared_ptr<AbstractPlan> &plan, DatabaseHandle *db, MemoryContext *mem_ctx)
+    -> AbstractExecutorUptr
+{
+  auto translate = [mem_ctx](const std::shared_ptr<AbstractPlan> &child, DatabaseHandle *child_db) {
+    return Executor::Translate(child, child_db, mem_ctx);
+  };
+  // every worker of a parallel scan runs the whole pipeline above the scan
+  if (const auto scan = GetParallelScan(plan, db)) {
+    auto tab = db->GetTable(scan->table_name_);
+    return std::make_unique<ParallelScanExecutor>(
+        tab, scan->parallel_, [plan, tab](PageMorsels *morsels, MemoryContext *worker_ctx) {
+          return MakeScanPipeline(plan, tab, morsels, worker_ctx);
+        });
   }
   // translate
   if (const auto create_table = std::dynamic_pointer_cast<CreateTablePlan>(plan)) {
     return std::make_unique<CreateTableExecutor>(
-        create_table->table_name_, std::move(create_table->schema_), db, create_table->storage_);
+        create_table->table_name_,
+        std::move(create_table->schema_),
+        db,
+        create_table->storage_,
+        std::move(create_table->partition_scheme_),
+        create_table->memory_snapshot_);
   } else if (const auto drop_table = std::dynamic_pointer_cast<DropTablePlan>(plan)) {
     return std::make_unique<DropTableExecutor>(drop_table->table_name_, db);
+  } else if (const auto drop_part = std::dynamic_pointer_cast<DropPartitionPlan>(plan)) {
+    return std::make_unique<DropPartitionExecutor>(drop_part->table_name_, drop_part->partition_, db);
   } else if (const auto desc_table = std::dynamic_pointer_cast<DescTablePlan>(plan)) {
     return std::make_unique<DescTableExecutor>(db->GetTable(desc_table->table_name_));
   } else if (const auto show_table = std::dynamic_pointer_cast<ShowTablesPlan>(plan)) {
@@ -46,34 +177,49 @@ auto Executor::Translate(const std::shared_ptr<AbstractPlan> &plan, DatabaseHand
     if (db->GetTable(insert->table_name_) == nullptr) {
       WSDB_THROW(WSDB_TABLE_MISS, insert->table_name_);
     }
-    auto                    tab = db->GetTable(insert->table_name_);
-    std::vector<RecordUptr> inserts;
-    inserts.emplace_back(std::make_unique<Record>(&tab->GetSchema(), insert->values_, INVALID_RID));
+    auto                tab = db->GetTable(insert->table_name_);
+    std::vector<Record> inserts;
+    inserts.reserve(insert->rows_.size());
+    for (const auto &row : insert->rows_) {
+      if (row.size() != tab->GetSchema().GetFieldCount()) {
+        WSDB_THROW(WSDB_GRAMMAR_ERROR,
+            fmt::format("{} values for {} columns", row.size(), tab->GetSchema().GetFieldCount()));
+      }
+      inserts.emplace_back(&tab->GetSchema(), row, INVALID_RID);
+    }
     return std::make_unique<InsertExecutor>(tab, db->GetIndexes(insert->table_name_), std::move(inserts));
+  } else if (const auto copy = std::dynamic_pointer_cast<CopyPlan>(plan)) {
+    auto tab = db->GetTable(copy->table_name_);
+    if (tab == nullptr) {
+      WSDB_THROW(WSDB_TABLE_MISS, copy->table_name_);
+    }
+    return std::make_unique<CopyExecutor>(tab, db->GetIndexes(copy->table_name_), copy->file_name_);
+  } else if (const auto vacuum = std::dynamic_pointer_cast<VacuumPlan>(plan)) {
+    auto tab = db->GetTable(vacuum->table_name_);
+    if (tab == nullptr) {
+      WSDB_THROW(WSDB_TABLE_MISS, vacuum->table_name_);
+    }
+    return std::make_unique<VacuumExecutor>(tab, db->GetIndexes(vacuum->table_name_));
   } else if (const auto update = std::dynamic_pointer_cast<UpdatePlan>(plan)) {
     auto tab = db->GetTable(update->table_name_);
     if (tab == nullptr) {
       WSDB_THROW(WSDB_TABLE_MISS, update->table_name_);
     }
     return std::make_unique<UpdateExecutor>(
-        Translate(update->child_, db), tab, db->GetIndexes(update->table_name_), std::move(update->updates_));
+        translate(update->child_, db), tab, db->GetIndexes(update->table_name_), std::move(update->updates_));
   } else if (const auto del = std::dynamic_pointer_cast<DeletePlan>(plan)) {
     auto tab = db->GetTable(del->table_name_);
     if (tab == nullptr) {
       WSDB_THROW(WSDB_TABLE_MISS, del->table_name_);
     }
-    return std::make_unique<DeleteExecutor>(Translate(del->child_, db), tab, db->GetIndexes(del->table_name_));
+    return std::make_unique<DeleteExecutor>(translate(del->child_, db), tab, db->GetIndexes(del->table_name_));
   } else if (const auto filter = std::dynamic_pointer_cast<FilterPlan>(plan)) {
-    std::function<bool(const Record &)> filter_func = [filter](const Record &record) {
-      return ConditionExpr::Eval(filter->conds_, record);
-    };
-    return std::make_unique<FilterExecutor>(Translate(filter->child_, db), std::move(filter_func));
-  } else if (const auto scan = std::dynamic_pointer_cast<ScanPlan>(plan)) {
-    auto tab = db->GetTable(scan->table_name_);
-    if (tab == nullptr) {
-      WSDB_THROW(WSDB_TABLE_MISS, scan->table_name_);
+    if (auto scan = MakeSeqScan(plan, db, mem_ctx)) {
+      return scan;
     }
-    return std::make_unique<SeqScanExecutor>(tab);
+    return MakeFilter(*filter, translate(filter->child_, db));
+  } else if (const auto scan = std::dynamic_pointer_cast<ScanPlan>(plan)) {
+    return MakeSeqScan(plan, db, mem_ctx);
   } else if (const auto idx_scan = std::dynamic_pointer_cast<IdxScanPlan>(plan)) {
     return std::make_unique<IdxScanExecutor>(db->GetTable(idx_scan->table_name_),
         db->GetIndex(idx_scan->idx_id_),
@@ -81,17 +227,21 @@ auto Executor::Translate(const std::shared_ptr<AbstractPlan> &plan, DatabaseHand
         idx_scan->matched_fields_);
   } else if (const auto sort_plan = std::dynamic_pointer_cast<SortPlan>(plan)) {
     return std::make_unique<SortExecutor>(
-        Translate(sort_plan->child_, db), std::move(sort_plan->key_schema_), sort_plan->is_desc_);
+        translate(sort_plan->child_, db), std::move(sort_plan->key_schema_), sort_plan->is_desc_);
   } else if (const auto proj_plan = std::dynamic_pointer_cast<ProjectPlan>(plan)) {
-    return std::make_unique<ProjectionExecutor>(Translate(proj_plan->child_, db), std::move(proj_plan->schema_));
+    auto child = MakeSeqScan(proj_plan->child_, db, mem_ctx, proj_plan.get());
+    if (child == nullptr) {
+      child = translate(proj_plan->child_, db);
+    }
+    return std::make_unique<ProjectionExecutor>(std::move(child), std::move(proj_plan->schema_));
   } else if (const auto join_plan = std::dynamic_pointer_cast<JoinPlan>(plan)) {
     if (join_plan->strategy_ == NESTED_LOOP) {
       return std::make_unique<NestedLoopJoinExecutor>(
-          join_plan->type_, Translate(join_plan->left_, db), Translate(join_plan->right_, db), join_plan->conds_);
+          join_plan->type_, translate(join_plan->left_, db), translate(join_plan->right_, db), join_plan->conds_);
     } else if (join_plan->strategy_ == SORT_MERGE) {
       return std::make_unique<SortMergeJoinExecutor>(join_plan->type_,
-          Translate(join_plan->left_, db),
-          Translate(join_plan->right_, db),
+          translate(join_plan->left_, db),
+          translate(join_plan->right_, db),
           std::move(join_plan->left_key_schema_),
           std::move(join_plan->right_key_schema_));
     }
@@ -99,15 +249,32 @@ auto Executor::Translate(const std::shared_ptr<AbstractPlan> &plan, DatabaseHand
     auto agg_schema   = std::make_unique<RecordSchema>(agg_plan->agg_fields);
     auto group_schema = std::make_unique<RecordSchema>(agg_plan->group_fields_);
     return std::make_unique<AggregateExecutor>(
-        Translate(agg_plan->child_, db), std::move(agg_schema), std::move(group_schema));
+        translate(agg_plan->child_, db), std::move(agg_schema), std::move(group_schema));
+  } else if (const auto meta_agg = std::dynamic_pointer_cast<MetaAggregatePlan>(plan)) {
+    auto tab = db->GetTable(meta_agg->table_name_);
+    if (tab == nullptr) {
+      WSDB_THROW(WSDB_TABLE_MISS, meta_agg->table_name_);
+    }
+    return std::make_unique<MetaAggregateExecutor>(tab, std::make_unique<RecordSchema>(meta_agg->agg_fields_));
   } else if (const auto lim = std::dynamic_pointer_cast<LimitPlan>(plan)) {
-    return std::make_unique<LimitExecutor>(Translate(lim->child_, db), lim->limit_);
+    return std::make_unique<LimitExecutor>(translate(lim->child_, db), lim->limit_);
 
   } else {
     WSDB_FETAL("Unknown plan type");
   }
   return nullptr;
 }
+}  // namespace
+
+// translate the plan to executor
+auto Executor::Translate(const std::shared_ptr<AbstractPlan> &plan, DatabaseHandle *db, MemoryContext *mem_ctx)
+    -> AbstractExecutorUptr
+{
+  if (db == nullptr) {
+    WSDB_THROW(WSDB_DB_NOT_OPEN, "");
+  }
+  return WithContext(TranslatePlan(plan, db, mem_ctx), mem_ctx);
+}
 void Executor::Execute(const AbstractExecutorUptr &executor, Context *ctx)
 {
   if (executor->GetType() == TXN) {
@@ -119,7 +286,7 @@ void Executor::Execute(const AbstractExecutorUptr &executor, Context *ctx)
     ctx->nt_ctl_->SendRecHeader(ctx->client_fd_, header);
     auto rec = executor->GetRecord();
     if (rec != nullptr) {
-      ctx->nt_ctl_->SendRec(ctx->client_fd_, rec.get());
+      ctx->nt_ctl_->SendRec(ctx->client_fd_, *rec);
     }
     while (!executor->IsEnd()) {
       executor->Next();
@@ -128,16 +295,17 @@ void Executor::Execute(const AbstractExecutorUptr &executor, Context *ctx)
       }
       rec = executor->GetRecord();
       WSDB_ASSERT(rec != nullptr, "");
-      ctx->nt_ctl_->SendRec(ctx->client_fd_, rec.get());
+      ctx->nt_ctl_->SendRec(ctx->client_fd_, *rec);
     }
     ctx->nt_ctl_->SendRecFinish(ctx->client_fd_);
   } else {
     auto header = executor->GetOutSchema();
     ctx->nt_ctl_->SendRecHeader(ctx->client_fd_, header);
     for (executor->Init(); !executor->IsEnd(); executor->Next()) {
-      auto rec = executor->GetRecord();
-      WSDB_ASSERT(rec != nullptr, "");
-      ctx->nt_ctl_->SendRec(ctx->client_fd_, rec.get());
+      // records are sent straight from the view, no owned copy is needed
+      auto rec = executor->GetRecordView();
+      WSDB_ASSERT(rec.IsValid(), "");
+      ctx->nt_ctl_->SendRec(ctx->client_fd_, rec);
     }
     ctx->nt_ctl_->SendRecFinish(ctx->client_fd_);
   }
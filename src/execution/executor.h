@@ -32,7 +32,15 @@ class Executor
 public:
   Executor() = default;
 
-  static auto Translate(const std::shared_ptr<AbstractPlan> &plan, DatabaseHandle *db) -> AbstractExecutorUptr;
+  /**
+   * Translate the plan to an executor tree
+   * @param plan
+   * @param db
+   * @param mem_ctx memory context of the query handed to every executor, nullptr to allocate from the heap
+   * @return
+   */
+  static auto Translate(const std::shared_ptr<AbstractPlan> &plan, DatabaseHandle *db, MemoryContext *mem_ctx = nullptr)
+      -> AbstractExecutorUptr;
 
   static void Execute(const AbstractExecutorUptr &executor, Context *ctx);
 };
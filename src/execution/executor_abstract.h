@@ -63,17 +63,38 @@ public:
 
   [[nodiscard]] auto GetType() const -> ExecutorType { return type_; }
 
-  [[nodiscard]] auto GetRecord() -> RecordUptr
+  /**
+   * Set the memory context of the query, the records the executor produces are allocated from it
+   * @param mem_ctx nullptr to allocate from the heap, the context must outlive the executor
+   */
+  void SetMemoryContext(MemoryContext *mem_ctx) { mem_ctx_ = mem_ctx; }
+
+  /**
+   * View the current record without copying, valid until Next is called unless the view holds a page guard.
+   * Executors that pass records of their child through (filter, limit) override this to forward the child's view
+   */
+  [[nodiscard]] virtual auto GetRecordView() -> RecordView
   {
     if (record_ == nullptr) {
+      return {};
+    }
+    return {*record_};
+  }
+
+  /// owned copy of the current record, used by pipeline breakers that keep records across Next
+  [[nodiscard]] auto GetRecord() -> RecordUptr
+  {
+    auto view = GetRecordView();
+    if (!view.IsValid()) {
       return nullptr;
     }
-    return std::make_unique<Record>(*record_);
+    return view.Materialize(mem_ctx_);
   };
 
 protected:
   RecordSchemaUptr out_schema_;
   RecordUptr       record_;
+  MemoryContext   *mem_ctx_{nullptr};
 
 private:
   ExecutorType type_;
@@ -42,7 +42,8 @@ AggregateExecutor::AggregateExecutor(
     : AbstractExecutor(Basic),
       child_(std::move(child)),
       agg_schema_(std::move(agg_schema)),
-      group_schema_(std::move(group_schema))
+      group_schema_(std::move(group_schema)),
+      group_map_(0, RecordHasher(*group_schema_))
 {
   std::vector<RTField> fields;
   for (const auto &field : group_schema_->GetFields()) {
@@ -22,6 +22,7 @@
 #ifndef WSDB_EXECUTOR_AGGREGATE_H
 #define WSDB_EXECUTOR_AGGREGATE_H
 #include <unordered_map>
+#include "system/handle/record_compare.h"
 #include "executor_abstract.h"
 
 namespace wsdb {
@@ -78,8 +79,9 @@ private:
   AbstractExecutorUptr                                 child_;
   RecordSchemaUptr                                     agg_schema_;
   RecordSchemaUptr                                     group_schema_;
-  std::unordered_map<Record, AggregateValue>           group_map_;
-  std::unordered_map<Record, AggregateValue>::iterator group_iter_;
+  // group keys are records of group_schema_, hashed by a kernel chosen for the group schema
+  std::unordered_map<Record, AggregateValue, RecordHasher>           group_map_;
+  std::unordered_map<Record, AggregateValue, RecordHasher>::iterator group_iter_;
 };
 
 }  // namespace wsdb
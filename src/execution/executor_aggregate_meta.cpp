@@ -0,0 +1,75 @@
+/*------------------------------------------------------------------------------
+ - Copyright (c) 2024. Websoft research group, Nanjing University.
+ -
+ - This program is free software: you can redistribute it and/or modify
+ - it under the terms of the GNU General Public License as published by
+ - the Free Software Foundation, either version 3 of the License, or
+ - (at your option) any later version.
+ -
+ - This program is distributed in the hope that it will be useful,
+ - but WITHOUT ANY WARRANTY; without even the implied warranty of
+ - MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ - GNU General Public License for more details.
+ -
+ - You should have received a copy of the GNU General Public License
+ - along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ -----------------------------------------------------------------------------*/
+
+//
+// Created by ziqi on 2024/9/15.
+//
+
+#include "executor_aggregate_meta.h"
+
+#include <limits>
+
+namespace wsdb {
+
+MetaAggregateExecutor::MetaAggregateExecutor(TableHandle *tbl, RecordSchemaUptr agg_schema)
+    : AbstractExecutor(Basic), tbl_(tbl), is_end_(true)
+{
+  out_schema_ = std::move(agg_schema);
+}
+
+void MetaAggregateExecutor::Init()
+{
+  std::vector<ValueSptr> values;
+  for (const auto &field : out_schema_->GetFields()) {
+    if (field.agg_type_ == AGG_COUNT_STAR) {
+      // COUNT(*) is an int like the other counts, see Planner
+      auto rec_num = tbl_->GetRecordNum();
+      if (rec_num > static_cast<size_t>(std::numeric_limits<int>::max())) {
+        WSDB_THROW(WSDB_UNSUPPORTED_OP, fmt::format("COUNT(*) of {} records exceeds int", rec_num));
+      }
+      values.push_back(ValueFactory::CreateIntValue(static_cast<int>(rec_num)));
+      continue;
+    }
+    WSDB_ASSERT(field.agg_type_ == AGG_MIN || field.agg_type_ == AGG_MAX, "Unsupported aggregate");
+    auto field_idx = tbl_->GetSchema().GetFieldIndex(tbl_->GetTableId(), field.field_.field_name_);
+    auto value     = tbl_->GetExtremum(field_idx, field.agg_type_ == AGG_MAX);
+    if (value == nullptr) {
+      // the table keeps no bounds of the column, e.g. it is slotted, the optimizer leaves such tables out but a plan
+      // built otherwise is answered all the same
+      value = ScanExtremum(field_idx, field.agg_type_ == AGG_MAX);
+    }
+    // a column without non-null values, e.g. of an empty table, yields NULL like AggregateExecutor
+    values.push_back(value);
+  }
+  record_ = std::make_unique<Record>(out_schema_.get(), values, INVALID_RID);
+  is_end_ = false;
+}
+
+void MetaAggregateExecutor::Next() { is_end_ = true; }
+
+auto MetaAggregateExecutor::ScanExtremum(size_t field_idx, bool is_max) -> ValueSptr
+{
+  ValueSptr best = ValueFactory::CreateNullValue(tbl_->GetSchema().GetFieldAt(field_idx).field_.field_type_);
+  for (auto iter = tbl_->MakeIterator(); !iter->IsEnd(); iter->Next()) {
+    auto value = iter->GetRecord()->GetValueAt(field_idx);
+    best       = is_max ? Value::Max(best, value) : Value::Min(best, value);
+  }
+  return best;
+}
+
+auto MetaAggregateExecutor::IsEnd() const -> bool { return is_end_; }
+}  // namespace wsdb
@@ -0,0 +1,56 @@
+/*------------------------------------------------------------------------------
+ - Copyright (c) 2024. Websoft research group, Nanjing University.
+ -
+ - This program is free software: you can redistribute it and/or modify
+ - it under the terms of the GNU General Public License as published by
+ - the Free Software Foundation, either version 3 of the License, or
+ - (at your option) any later version.
+ -
+ - This program is distributed in the hope that it will be useful,
+ - but WITHOUT ANY WARRANTY; without even the implied warranty of
+ - MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ - GNU General Public License for more details.
+ -
+ - You should have received a copy of the GNU General Public License
+ - along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ -----------------------------------------------------------------------------*/
+
+//
+// Created by ziqi on 2024/9/15.
+//
+
+/**
+ * @brief answer ungrouped COUNT(*), MIN and MAX over a whole table without scanning it, COUNT(*) is read from the
+ * table header, MIN and MAX are found by reading only the pages whose zone map range can hold the extremum
+ *
+ * Outputs a single record with the aggregate fields, the same as AggregateExecutor without group fields.
+ */
+
+#ifndef WSDB_EXECUTOR_AGGREGATE_META_H
+#define WSDB_EXECUTOR_AGGREGATE_META_H
+
+#include "executor_abstract.h"
+#include "system/handle/table_handle.h"
+
+namespace wsdb {
+class MetaAggregateExecutor : public AbstractExecutor
+{
+public:
+  MetaAggregateExecutor(TableHandle *tbl, RecordSchemaUptr agg_schema);
+
+  void Init() override;
+
+  void Next() override;
+
+  [[nodiscard]] auto IsEnd() const -> bool override;
+
+private:
+  /// @return the extremum of the field found by reading every record, null value if no record has a non-null value
+  auto ScanExtremum(size_t field_idx, bool is_max) -> ValueSptr;
+
+  TableHandle *const tbl_;
+  bool               is_end_;
+};
+}  // namespace wsdb
+
+#endif  // WSDB_EXECUTOR_AGGREGATE_META_H
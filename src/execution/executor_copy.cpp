@@ -0,0 +1,328 @@
+/*------------------------------------------------------------------------------
+ - Copyright (c) 2024. Websoft research group, Nanjing University.
+ -
+ - This program is free software: you can redistribute it and/or modify
+ - it under the terms of the GNU General Public License as published by
+ - the Free Software Foundation, either version 3 of the License, or
+ - (at your option) any later version.
+ -
+ - This program is distributed in the hope that it will be useful,
+ - but WITHOUT ANY WARRANTY; without even the implied warranty of
+ - MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ - GNU General Public License for more details.
+ -
+ - You should have received a copy of the GNU General Public License
+ - along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ -----------------------------------------------------------------------------*/
+
+//
+// Created by ziqi on 2024/9/12.
+//
+
+#include "executor_copy.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <charconv>
+#include <chrono>              // NOLINT
+#include <condition_variable>  // NOLINT
+#include <cstring>
+#include <thread>  // NOLINT
+
+namespace wsdb {
+
+namespace {
+/// @return whether there is an odd number of quotes in [begin, end)
+auto OddQuotes(const char *begin, const char *end) -> bool
+{
+  bool odd = false;
+  for (const char *pos = begin; (pos = static_cast<const char *>(memchr(pos, '"', end - pos))) != nullptr; ++pos) {
+    odd = !odd;
+  }
+  return odd;
+}
+
+/**
+ * Find the line break that ends a row, line breaks inside quoted fields are part of the row. An escaped quote is two
+ * quotes, so a position is inside a quoted field if an odd number of quotes is between it and the start of its row
+ * @param pos
+ * @param end
+ * @param quoted whether pos is inside a quoted field
+ * @return the line break, end if there is none
+ */
+auto FindRowEnd(const char *pos, const char *end, bool quoted) -> const char *
+{
+  while (pos < end) {
+    const auto *eol = static_cast<const char *>(memchr(pos, '\n', end - pos));
+    eol             = eol == nullptr ? end : eol;
+    quoted ^= OddQuotes(pos, eol);
+    if (!quoted) {
+      return eol;
+    }
+    pos = eol + 1;
+  }
+  return end;
+}
+}  // namespace
+
+CopyExecutor::CopyExecutor(TableHandle *tbl, std::list<IndexHandle *> indexes, std::string file_name)
+    : AbstractExecutor(DML), tbl_(tbl), indexes_(std::move(indexes)), file_name_(std::move(file_name)), is_end_(false)
+{
+  std::vector<RTField> fields(1);
+  fields[0]   = RTField{.field_ = {.field_name_ = "copied", .field_size_ = sizeof(int), .field_type_ = TYPE_INT}};
+  out_schema_ = std::make_unique<RecordSchema>(fields);
+}
+
+void CopyExecutor::Init() { WSDB_FETAL("CopyExecutor does not support Init"); }
+
+void CopyExecutor::Next()
+{
+  int fd = open(file_name_.c_str(), O_RDONLY);
+  if (fd < 0) {
+    WSDB_THROW(WSDB_FILE_NOT_EXISTS, file_name_);
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0) {
+    close(fd);
+    WSDB_THROW(WSDB_FILE_READ_ERROR, file_name_);
+  }
+  auto        file_size = static_cast<size_t>(st.st_size);
+  const char *file_data = nullptr;
+  if (file_size > 0) {
+    void *addr = mmap(nullptr, file_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (addr == MAP_FAILED) {
+      close(fd);
+      WSDB_THROW(WSDB_FILE_READ_ERROR, file_name_);
+    }
+    madvise(addr, file_size, MADV_SEQUENTIAL);
+    file_data = static_cast<const char *>(addr);
+  }
+  close(fd);
+
+  // 1. cut the file into ranges, a range ends right after the line break of a row so that no row spans two ranges
+  std::vector<std::pair<const char *, const char *>> ranges;
+  for (const char *begin = file_data, *end = file_data + file_size; begin < end;) {
+    const char *cut = begin + std::min(COPY_RANGE_SIZE, static_cast<size_t>(end - begin));
+    if (cut < end) {
+      cut = FindRowEnd(cut, end, OddQuotes(begin, cut));
+      cut = cut == end ? end : cut + 1;
+    }
+    ranges.emplace_back(begin, cut);
+    begin = cut;
+  }
+
+  // 2. load ranges in parallel
+  auto                     start = std::chrono::steady_clock::now();
+  std::atomic<size_t>      next_range{0};
+  size_t                   finished{0};
+  std::mutex               finish_latch;
+  std::condition_variable  finish_cv;
+  std::vector<std::thread> workers;
+  size_t                   worker_num = std::min(COPY_WORKER_NUM, ranges.size());
+  for (size_t i = 0; i < worker_num; ++i) {
+    workers.emplace_back([&]() {
+      for (size_t idx = next_range++; idx < ranges.size() && !failed_; idx = next_range++) {
+        try {
+          LoadRange(ranges[idx].first, ranges[idx].second);
+        } catch (...) {
+          std::lock_guard<std::mutex> lock{error_latch_};
+          if (!failed_.exchange(true)) {
+            error_ = std::current_exception();
+          }
+        }
+      }
+      std::lock_guard<std::mutex> lock{finish_latch};
+      finished++;
+      finish_cv.notify_one();
+    });
+  }
+
+  // 3. report progress until all workers finish
+  {
+    std::unique_lock<std::mutex> lock{finish_latch};
+    while (!finish_cv.wait_for(lock, std::chrono::seconds(1), [&]() { return finished == worker_num; })) {
+      WSDB_LOG(fmt::format("COPY {}: {} rows, {}/{} bytes",
+          tbl_->GetTableName(),
+          row_num_.load(),
+          loaded_bytes_.load(),
+          file_size));
+    }
+  }
+  for (auto &worker : workers) {
+    worker.join();
+  }
+  if (file_data != nullptr) {
+    munmap(const_cast<char *>(file_data), file_size);
+  }
+
+  // 4. rethrow the first error, with the number of rows that stay in the table
+  if (error_ != nullptr) {
+    try {
+      std::rethrow_exception(error_);
+    } catch (WSDBException_ &e) {
+      throw WSDBException_(
+          e.type_, e.cname_, e.fname_, fmt::format("{}, {} rows loaded before the error", e.msg_, row_num_.load()));
+    }
+  }
+  std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+  WSDB_LOG(fmt::format("COPY {}: {} rows in {:.3f}s, {:.0f} rows/sec",
+      tbl_->GetTableName(),
+      row_num_.load(),
+      elapsed.count(),
+      static_cast<double>(row_num_.load()) / std::max(elapsed.count(), 1e-6)));
+
+  std::vector<ValueSptr> values{ValueFactory::CreateIntValue(static_cast<int>(row_num_.load()))};
+  record_ = std::make_unique<Record>(out_schema_.get(), values, INVALID_RID);
+  is_end_ = true;
+}
+
+auto CopyExecutor::IsEnd() const -> bool { return is_end_; }
+
+void CopyExecutor::LoadRange(const char *begin, const char *end)
+{
+  const auto         &schema = tbl_->GetSchema();
+  std::vector<char>   nullmap(BITMAP_SIZE(schema.GetFieldCount()));
+  std::vector<char>   data(schema.GetRecordLength());
+  std::vector<Record> batch;
+  batch.reserve(COPY_BATCH_ROWS);
+  size_t range_size = end - begin;
+  while (begin < end && !failed_) {
+    const auto      *eol = FindRowEnd(begin, end, false);
+    std::string_view line(begin, eol - begin);
+    begin = eol + 1;
+    if (!line.empty() && line.back() == '\r') {
+      line.remove_suffix(1);
+    }
+    if (line.empty()) {
+      continue;
+    }
+    ParseRow(line, nullmap.data(), data.data());
+    batch.emplace_back(&schema, nullmap.data(), data.data(), INVALID_RID);
+    if (batch.size() == COPY_BATCH_ROWS) {
+      InsertBatch(batch);
+    }
+  }
+  InsertBatch(batch);
+  loaded_bytes_ += range_size;
+}
+
+void CopyExecutor::ParseRow(std::string_view line, char *nullmap, char *data) const
+{
+  const auto &schema = tbl_->GetSchema();
+  memset(nullmap, 0, BITMAP_SIZE(schema.GetFieldCount()));
+  memset(data, 0, schema.GetRecordLength());
+  // pos is line.size() + 1 after the last field
+  size_t pos = 0;
+  for (size_t i = 0; i < schema.GetFieldCount(); ++i) {
+    if (pos > line.size()) {
+      WSDB_THROW(WSDB_GRAMMAR_ERROR, fmt::format("{} fields expected: {}", schema.GetFieldCount(), line));
+    }
+    if (pos < line.size() && line[pos] == '"') {
+      std::string text;
+      for (pos++;; pos++) {
+        if (pos >= line.size()) {
+          WSDB_THROW(WSDB_GRAMMAR_ERROR, fmt::format("unterminated quote: {}", line));
+        }
+        if (line[pos] == '"') {
+          if (pos + 1 < line.size() && line[pos + 1] == '"') {
+            text.push_back('"');
+            pos++;
+            continue;
+          }
+          break;
+        }
+        text.push_back(line[pos]);
+      }
+      // skip the closing quote and the separator
+      pos++;
+      if (pos < line.size() && line[pos] != ',') {
+        WSDB_THROW(WSDB_GRAMMAR_ERROR, fmt::format("',' expected after a quoted field: {}", line));
+      }
+      pos++;
+      ParseField(i, text, data);
+      continue;
+    }
+    size_t sep  = std::min(line.find(',', pos), line.size());
+    auto   text = line.substr(pos, sep - pos);
+    pos         = sep + 1;
+    // rows are cut by counting quotes, a quote is only allowed in a quoted field
+    if (text.find('"') != std::string_view::npos) {
+      WSDB_THROW(WSDB_GRAMMAR_ERROR, fmt::format("'\"' in an unquoted field: {}", line));
+    }
+    if (text.empty()) {
+      BitMap::SetBit(nullmap, i, true);
+      continue;
+    }
+    ParseField(i, text, data);
+  }
+  if (pos <= line.size()) {
+    WSDB_THROW(WSDB_GRAMMAR_ERROR, fmt::format("{} fields expected: {}", schema.GetFieldCount(), line));
+  }
+}
+
+void CopyExecutor::ParseField(size_t field_idx, std::string_view text, char *data) const
+{
+  const auto &schema = tbl_->GetSchema();
+  const auto &field  = schema.GetFieldAt(field_idx).field_;
+  char       *dst    = data + schema.GetFieldOffset(field_idx);
+  auto        parse  = [&](auto &value) {
+    auto [ptr, ec] = std::from_chars(text.data(), text.data() + text.size(), value);
+    if (ec != std::errc() || ptr != text.data() + text.size()) {
+      WSDB_THROW(WSDB_TYPE_MISSMATCH,
+          fmt::format("field:{}, {}: {}", field.field_name_, FieldTypeToString(field.field_type_), text));
+    }
+    memcpy(dst, &value, sizeof(value));
+  };
+  switch (field.field_type_) {
+    case TYPE_INT: {
+      int value;
+      parse(value);
+      break;
+    }
+    case TYPE_FLOAT: {
+      float value;
+      parse(value);
+      break;
+    }
+    case TYPE_BOOL: {
+      if (text != "true" && text != "false" && text != "1" && text != "0") {
+        WSDB_THROW(WSDB_TYPE_MISSMATCH, fmt::format("field:{}, BOOL: {}", field.field_name_, text));
+      }
+      *reinterpret_cast<bool *>(dst) = text == "true" || text == "1";
+      break;
+    }
+    case TYPE_STRING: {
+      if (text.size() > field.field_size_) {
+        WSDB_THROW(WSDB_STRING_OVERFLOW,
+            fmt::format("field:{}, size:{}, requested:{}", field.field_name_, field.field_size_, text.size()));
+      }
+      memcpy(dst, text.data(), text.size());
+      break;
+    }
+    default: WSDB_THROW(WSDB_UNSUPPORTED_OP, fmt::format("field:{}", field.field_name_));
+  }
+}
+
+void CopyExecutor::InsertBatch(std::vector<Record> &batch)
+{
+  if (batch.empty()) {
+    return;
+  }
+  auto rids = tbl_->InsertRecords(batch);
+  if (!indexes_.empty()) {
+    std::lock_guard<std::mutex> lock{index_latch_};
+    for (size_t i = 0; i < batch.size(); ++i) {
+      batch[i].SetRID(rids[i]);
+      for (auto &index_handle : indexes_) {
+        index_handle->InsertRecord(batch[i]);
+      }
+    }
+  }
+  row_num_ += batch.size();
+  batch.clear();
+}
+
+}  // namespace wsdb
@@ -0,0 +1,93 @@
+/*------------------------------------------------------------------------------
+ - Copyright (c) 2024. Websoft research group, Nanjing University.
+ -
+ - This program is free software: you can redistribute it and/or modify
+ - it under the terms of the GNU General Public License as published by
+ - the Free Software Foundation, either version 3 of the License, or
+ - (at your option) any later version.
+ -
+ - This program is distributed in the hope that it will be useful,
+ - but WITHOUT ANY WARRANTY; without even the implied warranty of
+ - MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ - GNU General Public License for more details.
+ -
+ - You should have received a copy of the GNU General Public License
+ - along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ -----------------------------------------------------------------------------*/
+
+//
+// Created by ziqi on 2024/9/12.
+//
+
+#ifndef WSDB_EXECUTOR_COPY_H
+#define WSDB_EXECUTOR_COPY_H
+
+#include <atomic>
+#include <exception>
+#include <mutex>  // NOLINT
+#include <string_view>
+
+#include "executor_abstract.h"
+#include "system/handle/index_handle.h"
+#include "system/handle/table_handle.h"
+
+namespace wsdb {
+
+/**
+ * Load a csv file into a table, the file is mapped into memory and cut into ranges on row boundaries, parser threads
+ * convert the rows of a range to records and insert them in batches, see TableHandle::InsertRecords.
+ * Each line of the file is a row without header, fields are separated by ',' and can be quoted by '"' with '""' as an
+ * escaped quote, an empty unquoted field is null while "" is an empty string. A quoted field may hold ',' and line
+ * breaks, a quote anywhere else is an error.
+ */
+class CopyExecutor : public AbstractExecutor
+{
+public:
+  CopyExecutor(TableHandle *tbl, std::list<IndexHandle *> indexes, std::string file_name);
+
+  void Init() override;
+
+  /**
+   * Load the whole file, the output record holds the number of loaded rows
+   * 1. map the file into memory and cut it into ranges of about COPY_RANGE_SIZE bytes that end at the end of a row
+   * 2. start COPY_WORKER_NUM threads, each takes ranges one by one and loads them using LoadRange
+   * 3. report progress every second until the threads finish, then report rows/sec
+   * 4. rethrow the first error of the threads with the number of rows loaded before it, they stay in the table
+   */
+  void Next() override;
+
+  [[nodiscard]] auto IsEnd() const -> bool override;
+
+private:
+  void LoadRange(const char *begin, const char *end);
+
+  /**
+   * Convert a row to the binary record layout
+   * @param line the row without its line break, it spans several lines if a quoted field holds line breaks
+   * @param nullmap[out]
+   * @param data[out]
+   */
+  void ParseRow(std::string_view line, char *nullmap, char *data) const;
+
+  /// write a field in text to its offset in data
+  void ParseField(size_t field_idx, std::string_view text, char *data) const;
+
+  void InsertBatch(std::vector<Record> &batch);
+
+private:
+  TableHandle *const             tbl_;
+  const std::list<IndexHandle *> indexes_;
+  const std::string              file_name_;
+  bool                           is_end_;
+
+  std::atomic<size_t> row_num_{0};
+  std::atomic<size_t> loaded_bytes_{0};
+  // indexes are not thread-safe, their insertion is serialized
+  std::mutex         index_latch_;
+  std::mutex         error_latch_;
+  std::exception_ptr error_;
+  std::atomic<bool>  failed_{false};
+};
+}  // namespace wsdb
+
+#endif  // WSDB_EXECUTOR_COPY_H
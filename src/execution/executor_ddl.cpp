@@ -46,7 +46,7 @@ static auto MakeTableDescOutSchema(size_t sz_db_name, size_t sz_tb_name) -> std:
                           .field_type_      = TYPE_INT}};
   fields[4] = RTField{
       .field_ = {
-          .table_id_ = INVALID_TABLE_ID, .field_name_ = "StorageModel", .field_size_ = 10, .field_type_ = TYPE_STRING}};
+          .table_id_ = INVALID_TABLE_ID, .field_name_ = "StorageModel", .field_size_ = 16, .field_type_ = TYPE_STRING}};
 
   fields[5] = RTField{.field_ = {.table_id_ = INVALID_TABLE_ID,
                           .field_name_      = "IndexNum",
@@ -69,12 +69,14 @@ static auto MakeTableDescValue(const std::string &db_name, const std::string &tb
 }
 
 /// CreateTableExecutor
-CreateTableExecutor::CreateTableExecutor(
-    std::string table_name, wsdb::RecordSchemaUptr schema, wsdb::DatabaseHandle *db, StorageModel storage)
+CreateTableExecutor::CreateTableExecutor(std::string table_name, wsdb::RecordSchemaUptr schema,
+    wsdb::DatabaseHandle *db, StorageModel storage, PartitionSchemeUptr partition_scheme, bool memory_snapshot)
     : AbstractExecutor(DDL),
       tab_name_(std::move(table_name)),
       schema_(std::move(schema)),
       storage_(storage),
+      partition_scheme_(std::move(partition_scheme)),
+      memory_snapshot_(memory_snapshot),
       db_(db),
       is_end_(false)
 {
@@ -90,7 +92,7 @@ void CreateTableExecutor::Next()
   if (db_->GetTable(tab_name_) != nullptr) {
     WSDB_THROW(WSDB_TABLE_EXIST, tab_name_);
   }
-  db_->CreateTable(tab_name_, *schema_, storage_);
+  db_->CreateTable(tab_name_, *schema_, storage_, partition_scheme_.get(), memory_snapshot_);
   auto values = MakeTableDescValue(db_->GetName(),
       tab_name_,
       schema_->GetFieldCount(),
@@ -131,6 +133,32 @@ void DropTableExecutor::Next()
 }
 auto DropTableExecutor::IsEnd() const -> bool { return is_end_; }
 
+/// DropPartition Executor
+DropPartitionExecutor::DropPartitionExecutor(std::string table_name, size_t partition, wsdb::DatabaseHandle *db)
+    : AbstractExecutor(DDL), tab_name_(std::move(table_name)), partition_(partition), db_(db), is_end_(false)
+{
+  out_schema_ = MakeTableDescOutSchema(db_->GetName().size(), tab_name_.size());
+}
+
+void DropPartitionExecutor::Init() { WSDB_FETAL("DropPartitionExecutor does not support Init"); }
+void DropPartitionExecutor::Next()
+{
+  if (is_end_) {
+    WSDB_FETAL("DropPartitionExecutor is end");
+  }
+  db_->DropPartition(tab_name_, partition_);
+  auto tab    = db_->GetTable(tab_name_);
+  auto values = MakeTableDescValue(db_->GetName(),
+      tab_name_,
+      tab->GetSchema().GetFieldCount(),
+      tab->GetSchema().GetRecordLength(),
+      StorageModelToString(tab->GetStorageModel()),
+      db_->GetIndexNum(tab->GetTableId()));
+  record_     = std::make_unique<Record>(out_schema_.get(), values, INVALID_RID);
+  is_end_     = true;
+}
+auto DropPartitionExecutor::IsEnd() const -> bool { return is_end_; }
+
 /// DescTable Executor
 
 DescTableExecutor::DescTableExecutor(wsdb::TableHandle *tbl_hdl)
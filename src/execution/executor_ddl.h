@@ -31,7 +31,8 @@ namespace wsdb {
 class CreateTableExecutor : public AbstractExecutor
 {
 public:
-  CreateTableExecutor(std::string table_name, RecordSchemaUptr schema, DatabaseHandle *db, StorageModel storage);
+  CreateTableExecutor(std::string table_name, RecordSchemaUptr schema, DatabaseHandle *db, StorageModel storage,
+      PartitionSchemeUptr partition_scheme = nullptr, bool memory_snapshot = false);
 
   void Init() override;
 
@@ -40,10 +41,12 @@ public:
   [[nodiscard]] auto IsEnd() const -> bool override;
 
 private:
-  std::string      tab_name_;
-  RecordSchemaUptr schema_;
-  StorageModel     storage_;
-  DatabaseHandle  *db_;
+  std::string         tab_name_;
+  RecordSchemaUptr    schema_;
+  StorageModel        storage_;
+  PartitionSchemeUptr partition_scheme_;
+  bool                memory_snapshot_;
+  DatabaseHandle     *db_;
 
 private:
   bool is_end_;
@@ -68,6 +71,27 @@ private:
   bool is_end_;
 };
 
+/// empty a partition of a partitioned table by replacing its file, the rows are not deleted one by one
+class DropPartitionExecutor : public AbstractExecutor
+{
+public:
+  DropPartitionExecutor(std::string table_name, size_t partition, DatabaseHandle *db);
+
+  void Init() override;
+
+  void Next() override;
+
+  [[nodiscard]] auto IsEnd() const -> bool override;
+
+private:
+  std::string     tab_name_;
+  size_t          partition_;
+  DatabaseHandle *db_;
+
+private:
+  bool is_end_;
+};
+
 class DescTableExecutor : public AbstractExecutor
 {
 public:
@@ -23,6 +23,8 @@
 #define WSDB_EXECUTOR_DEFS_H
 
 #include "executor_aggregate.h"
+#include "executor_aggregate_meta.h"
+#include "executor_copy.h"
 #include "executor_ddl.h"
 #include "executor_delete.h"
 #include "executor_filter.h"
@@ -31,9 +33,11 @@
 #include "executor_join_nestedloop.h"
 #include "executor_join_sortmerge.h"
 #include "executor_limit.h"
+#include "executor_parallelscan.h"
 #include "executor_projection.h"
 #include "executor_seqscan.h"
 #include "executor_sort.h"
 #include "executor_update.h"
+#include "executor_vacuum.h"
 
 #endif  // WSDB_EXECUTOR_DEFS_H
@@ -38,15 +38,16 @@ void DeleteExecutor::Next()
   int count = 0;
 
   // WSDB_STUDENT_TODO(l2, t1);
-  child_->Init();
-  while (!child_->IsEnd()) {
-    child_->Next();
-    tbl_->DeleteRecord(child_->GetRecord()->GetRID());
-    count++;
-
+  // the child scans the table with a TableIterator, deleting the slot under the iterator is safe
+  for (child_->Init(); !child_->IsEnd(); child_->Next()) {
+    // only the indexes need an owned copy of the deleted record
+    auto       view   = child_->GetRecordView();
+    RecordUptr record = indexes_.empty() ? nullptr : view.Materialize();
+    tbl_->DeleteRecord(view.GetRID());
     for (auto &index : indexes_) {
-      index->DeleteRecord(*child_->GetRecord());
+      index->DeleteRecord(*record);
     }
+    count++;
   }
 
   std::vector<ValueSptr> values{ValueFactory::CreateIntValue(count)};
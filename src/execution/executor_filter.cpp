@@ -23,37 +23,38 @@
 
 namespace wsdb {
 
-FilterExecutor::FilterExecutor(AbstractExecutorUptr child, std::function<bool(const Record &)> filter)
+FilterExecutor::FilterExecutor(AbstractExecutorUptr child, std::function<bool(const RecordView &)> filter)
     : AbstractExecutor(Basic), child_(std::move(child)), filter_(std::move(filter))
 {}
 void FilterExecutor::Init()
 {
-  // WSDB_STUDENT_TODO(l2, t1);
   child_->Init();
-
-  is_end_ = child_->IsEnd();
+  SeekMatch();
 }
 
 void FilterExecutor::Next()
 {
-  // WSDB_STUDENT_TODO(l2, t1);
-  while (!is_end_) {
-    child_->Next();
-    if (filter_(*child_->GetRecord())) {
-      record_ = child_->GetRecord();
-      is_end_ = child_->IsEnd();
-      break;
-    } else {
-      is_end_ = child_->IsEnd();
-    }
-  }
+  child_->Next();
+  SeekMatch();
 }
 
-auto FilterExecutor::IsEnd() const -> bool
+auto FilterExecutor::IsEnd() const -> bool { return is_end_; }
+
+void FilterExecutor::SeekMatch()
 {
-  // WSDB_STUDENT_TODO(l2, t1);
-  return is_end_;
+  for (; !child_->IsEnd(); child_->Next()) {
+    auto view = child_->GetRecordView();
+    if (filter_(view)) {
+      view_   = std::move(view);
+      is_end_ = false;
+      return;
+    }
+  }
+  view_   = RecordView();
+  is_end_ = true;
 }
 
 auto FilterExecutor::GetOutSchema() const -> const RecordSchema * { return child_->GetOutSchema(); }
+
+auto FilterExecutor::GetRecordView() -> RecordView { return view_; }
 }  // namespace wsdb
@@ -34,7 +34,7 @@ namespace wsdb {
 class FilterExecutor : public AbstractExecutor
 {
 public:
-  FilterExecutor(AbstractExecutorUptr child, std::function<bool(const Record &)> filter);
+  FilterExecutor(AbstractExecutorUptr child, std::function<bool(const RecordView &)> filter);
 
   void Init() override;
 
@@ -44,10 +44,19 @@ public:
 
   [[nodiscard]] auto GetOutSchema() const -> const RecordSchema * override;
 
+  /// records are passed through as views of the child, no copy is made
+  [[nodiscard]] auto GetRecordView() -> RecordView override;
+
+private:
+  /// advance the child until a record satisfies the filter or the child is end
+  void SeekMatch();
+
 private:
-  const AbstractExecutorUptr                child_;   // 更改声明为 const
-  const std::function<bool(const Record &)> filter_;  // 更改声明为 const
-  bool                                      is_end_;
+  const AbstractExecutorUptr                    child_;   // 更改声明为 const
+  const std::function<bool(const RecordView &)> filter_;  // 更改声明为 const
+  bool                                          is_end_;
+  // view of the matched record of the child
+  RecordView view_;
 };
 
 }  // namespace wsdb
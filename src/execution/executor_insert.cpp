@@ -23,7 +23,7 @@
 
 namespace wsdb {
 
-InsertExecutor::InsertExecutor(TableHandle *tbl, std::list<IndexHandle *> indexes, std::vector<RecordUptr> inserts)
+InsertExecutor::InsertExecutor(TableHandle *tbl, std::list<IndexHandle *> indexes, std::vector<Record> inserts)
     : AbstractExecutor(DML), tbl_(tbl), indexes_(std::move(indexes)), inserts_(std::move(inserts)), is_end_(false)
 {
   std::vector<RTField> fields(1);
@@ -35,17 +35,15 @@ void InsertExecutor::Init() { WSDB_FETAL("InsertExecutor does not support Init")
 
 void InsertExecutor::Next()
 {
-  // number of inserted records
-  int count = 0;
-
   // WSDB_STUDENT_TODO(l2, t1);
   // 理论上讲按火山模型这里应该只插入一条记录？但是按照下文这里应该插入所有的记录
-  for (auto &insert_record : inserts_) {
-    tbl_->InsertRecord(*insert_record);
-    count++;
-
+  // all rows of the statement are written in one batch, so that each page is pinned once
+  auto rids  = tbl_->InsertRecords(inserts_);
+  auto count = static_cast<int>(rids.size());
+  for (size_t i = 0; i < inserts_.size(); ++i) {
+    inserts_[i].SetRID(rids[i]);
     for (auto &index_handle : indexes_) {
-      index_handle->InsertRecord(*insert_record);
+      index_handle->InsertRecord(inserts_[i]);
     }
   }
 
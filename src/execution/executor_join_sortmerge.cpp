@@ -27,14 +27,13 @@ SortMergeJoinExecutor::SortMergeJoinExecutor(JoinType join_type, AbstractExecuto
     // condition vec is not used in sort merge join, it has been converted to key schemas
     : JoinExecutor(join_type, std::move(left), std::move(right), {}),
       left_key_schema_(std::move(left_key_schema)),
-      right_key_schema_(std::move(right_key_schema))
+      right_key_schema_(std::move(right_key_schema)),
+      key_cmp_(*left_key_schema_, *left_->GetOutSchema(), *right_key_schema_, *right_->GetOutSchema())
 {}
 
 auto SortMergeJoinExecutor::Compare(const wsdb::Record &left, const wsdb::Record &right) const -> int
 {
-  auto left_key  = std::make_unique<Record>(left_key_schema_.get(), left);
-  auto right_key = std::make_unique<Record>(right_key_schema_.get(), right);
-  return Record::Compare(*left_key, *right_key);
+  return key_cmp_.Compare(left, right);
 }
 
 void SortMergeJoinExecutor::InitInnerJoin() { WSDB_STUDENT_TODO(l3, f1); }
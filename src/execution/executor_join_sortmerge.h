@@ -27,6 +27,7 @@
 #ifndef WSDB_EXECUTOR_JOIN_SORTMERGE_H
 #define WSDB_EXECUTOR_JOIN_SORTMERGE_H
 
+#include "system/handle/record_compare.h"
 #include "executor_join.h"
 
 namespace wsdb {
@@ -54,6 +55,8 @@ private:
 private:
   RecordSchemaUptr left_key_schema_;
   RecordSchemaUptr right_key_schema_;
+  // compares the key of a left record with that of a right one, see Compare
+  RecordComparator key_cmp_;
 
   // temporarily store record from the left executor
   RecordUptr left_rec_;
@@ -28,29 +28,29 @@ LimitExecutor::LimitExecutor(AbstractExecutorUptr child, int limit)
 
 void LimitExecutor::Init()
 {
-  // WSDB_STUDENT_TODO(l2, t1);
   WSDB_ASSERT(child_->GetType() == Basic, "LimitExecutor 需要可执行 Init() 的子执行器");
   child_->Init();
-
-  count_  = 0;
-  is_end_ = child_->IsEnd() || count_ >= limit_;
+  count_ = 0;
+  Fetch();
 }
 
 void LimitExecutor::Next()
 {
-  // WSDB_STUDENT_TODO(l2, t1);
-  child_->Next();
-  record_ = child_->GetRecord();
-  count_++;
-  
-  is_end_ = child_->IsEnd() || count_ >= limit_;
+  // do not pull more records from the child once the limit is reached
+  if (++count_ < limit_) {
+    child_->Next();
+  }
+  Fetch();
 }
 
-[[nodiscard]] auto LimitExecutor::IsEnd() const -> bool
+[[nodiscard]] auto LimitExecutor::IsEnd() const -> bool { return is_end_; }
+
+void LimitExecutor::Fetch()
 {
-  //  WSDB_STUDENT_TODO(l2, t1);
-  return is_end_;
+  is_end_ = child_->IsEnd() || count_ >= limit_;
 }
 
 [[nodiscard]] auto LimitExecutor::GetOutSchema() const -> const RecordSchema * { return child_->GetOutSchema(); }
+
+auto LimitExecutor::GetRecordView() -> RecordView { return is_end_ ? RecordView() : child_->GetRecordView(); }
 }  // namespace wsdb
@@ -43,6 +43,13 @@ public:
 
   [[nodiscard]] auto GetOutSchema() const -> const RecordSchema * override;
 
+  /// records are passed through as views of the child, no copy is made
+  [[nodiscard]] auto GetRecordView() -> RecordView override;
+
+private:
+  /// check whether the current record of the child is within the limit
+  void Fetch();
+
 private:
   const AbstractExecutorUptr child_;  // 更改声明为 const
   // max number of records to return，更改声明为 const
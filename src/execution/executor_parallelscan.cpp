@@ -0,0 +1,197 @@
+/*------------------------------------------------------------------------------
+ - Copyright (c) 2024. Websoft research group, Nanjing University.
+ -
+ - This program is free software: you can redistribute it and/or modify
+ - it under the terms of the GNU General Public License as published by
+ - the Free Software Foundation, either version 3 of the License, or
+ - (at your option) any later version.
+ -
+ - This program is distributed in the hope that it will be useful,
+ - but WITHOUT ANY WARRANTY; without even the implied warranty of
+ - MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ - GNU General Public License for more details.
+ -
+ - You should have received a copy of the GNU General Public License
+ - along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ -----------------------------------------------------------------------------*/
+
+//
+// Created by ziqi on 2024/9/19.
+//
+
+#include "executor_parallelscan.h"
+
+#include "common/memory_context.h"
+
+namespace wsdb {
+
+ParallelScanExecutor::ParallelScanExecutor(TableHandle *tab, size_t worker_num, PipelineFactory make_pipeline)
+    : AbstractExecutor(Basic),
+      tab_(tab),
+      worker_num_(std::min(worker_num, MAX_WORKER_NUM)),
+      make_pipeline_(std::move(make_pipeline)),
+      // built before the executor is handed the context of the query, its records come from the heap
+      inline_pipeline_(make_pipeline_(nullptr, nullptr))
+{
+  // records of the workers are copied as they are, the out schema is the one of the pipelines
+  out_schema_ = std::make_unique<RecordSchema>(inline_pipeline_->GetOutSchema()->GetFields());
+  row_size_   = out_schema_->GetRecordLength() + BITMAP_SIZE(out_schema_->GetFieldCount());
+}
+
+ParallelScanExecutor::~ParallelScanExecutor() { Stop(); }
+
+void ParallelScanExecutor::Init()
+{
+  Stop();
+  // 1. take the workers, no more than there are morsels
+  auto page_num   = static_cast<page_id_t>(tab_->GetPageNum());
+  auto data_pages = static_cast<size_t>(std::max(page_num - FILE_HEADER_PAGE_ID - 1, 0));
+  auto worker_num = AcquireWorkers(std::min(worker_num_, (data_pages + SCAN_MORSEL_PAGES - 1) / SCAN_MORSEL_PAGES));
+  is_inline_      = worker_num == 0;
+  if (is_inline_) {
+    inline_pipeline_->Init();
+    return;
+  }
+  // 2. cut the pages into morsels
+  morsels_ = std::make_unique<PageMorsels>(FILE_HEADER_PAGE_ID + 1, page_num, SCAN_MORSEL_PAGES);
+  // 3. start the workers
+  stopped_        = false;
+  error_          = nullptr;
+  running_        = worker_num;
+  queue_capacity_ = SCAN_QUEUE_BATCHES * worker_num;
+  for (size_t i = 0; i < worker_num; ++i) {
+    workers_.emplace_back([this]() { Work(); });
+  }
+  Pop();
+}
+
+void ParallelScanExecutor::Next()
+{
+  if (is_inline_) {
+    inline_pipeline_->Next();
+    return;
+  }
+  WSDB_ASSERT(!IsEnd(), "ParallelScanExecutor is end");
+  if (++pos_ < batch_->rids_.size()) {
+    return;
+  }
+  Pop();
+}
+
+auto ParallelScanExecutor::IsEnd() const -> bool
+{
+  return is_inline_ ? inline_pipeline_->IsEnd() : batch_ == nullptr;
+}
+
+auto ParallelScanExecutor::GetRecordView() -> RecordView
+{
+  if (is_inline_) {
+    return inline_pipeline_->GetRecordView();
+  }
+  if (IsEnd()) {
+    return {};
+  }
+  const char *row = batch_->rows_.data() + pos_ * row_size_;
+  return {out_schema_.get(), row + out_schema_->GetRecordLength(), row, batch_->rids_[pos_], batch_};
+}
+
+void ParallelScanExecutor::Work()
+{
+  // records and values of the pipeline are freed before the context, which lives as long as the thread
+  MemoryContext mem_ctx;
+  try {
+    auto pipeline = make_pipeline_(morsels_.get(), &mem_ctx);
+    auto rec_len  = out_schema_->GetRecordLength();
+    auto batch    = std::make_shared<Batch>();
+    batch->rows_.reserve(SCAN_BATCH_ROWS * row_size_);
+    for (pipeline->Init(); !pipeline->IsEnd() && !stopped_; pipeline->Next()) {
+      auto view = pipeline->GetRecordView();
+      batch->rows_.insert(batch->rows_.end(), view.GetData(), view.GetData() + rec_len);
+      batch->rows_.insert(batch->rows_.end(), view.GetNullMap(), view.GetNullMap() + row_size_ - rec_len);
+      batch->rids_.push_back(view.GetRID());
+      if (batch->rids_.size() == SCAN_BATCH_ROWS) {
+        if (!Push(std::move(batch))) {
+          break;
+        }
+        batch = std::make_shared<Batch>();
+        batch->rows_.reserve(SCAN_BATCH_ROWS * row_size_);
+      }
+    }
+    if (batch != nullptr && !batch->rids_.empty()) {
+      Push(std::move(batch));
+    }
+  } catch (...) {
+    // the other workers stop as well, the consumer rethrows the first error
+    std::lock_guard<std::mutex> lock{queue_latch_};
+    if (error_ == nullptr) {
+      error_ = std::current_exception();
+    }
+    stopped_ = true;
+    not_full_.notify_all();
+  }
+  std::lock_guard<std::mutex> lock{queue_latch_};
+  running_--;
+  not_empty_.notify_one();
+}
+
+auto ParallelScanExecutor::Push(std::shared_ptr<Batch> batch) -> bool
+{
+  std::unique_lock<std::mutex> lock{queue_latch_};
+  not_full_.wait(lock, [this]() { return queue_.size() < queue_capacity_ || stopped_; });
+  if (stopped_) {
+    return false;
+  }
+  queue_.push_back(std::move(batch));
+  not_empty_.notify_one();
+  return true;
+}
+
+void ParallelScanExecutor::Pop()
+{
+  std::unique_lock<std::mutex> lock{queue_latch_};
+  not_empty_.wait(lock, [this]() { return !queue_.empty() || running_ == 0 || error_ != nullptr; });
+  if (error_ != nullptr) {
+    auto error = error_;
+    lock.unlock();
+    Stop();
+    std::rethrow_exception(error);
+  }
+  batch_ = nullptr;
+  pos_   = 0;
+  if (!queue_.empty()) {
+    batch_ = std::move(queue_.front());
+    queue_.pop_front();
+    not_full_.notify_one();
+  }
+}
+
+void ParallelScanExecutor::Stop()
+{
+  {
+    std::lock_guard<std::mutex> lock{queue_latch_};
+    stopped_ = true;
+    not_full_.notify_all();
+  }
+  for (auto &worker : workers_) {
+    worker.join();
+  }
+  ReleaseWorkers(workers_.size());
+  workers_.clear();
+  queue_.clear();
+  batch_   = nullptr;
+  morsels_ = nullptr;
+}
+
+auto ParallelScanExecutor::AcquireWorkers(size_t num) -> size_t
+{
+  auto   used    = used_workers_.load();
+  size_t granted = 0;
+  do {
+    granted = std::min(num, MAX_WORKER_NUM - std::min(used, MAX_WORKER_NUM));
+  } while (granted > 0 && !used_workers_.compare_exchange_weak(used, used + granted));
+  return granted;
+}
+
+void ParallelScanExecutor::ReleaseWorkers(size_t num) { used_workers_ -= num; }
+
+}  // namespace wsdb
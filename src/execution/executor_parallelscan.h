@@ -0,0 +1,148 @@
+/*------------------------------------------------------------------------------
+ - Copyright (c) 2024. Websoft research group, Nanjing University.
+ -
+ - This program is free software: you can redistribute it and/or modify
+ - it under the terms of the GNU General Public License as published by
+ - the Free Software Foundation, either version 3 of the License, or
+ - (at your option) any later version.
+ -
+ - This program is distributed in the hope that it will be useful,
+ - but WITHOUT ANY WARRANTY; without even the implied warranty of
+ - MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ - GNU General Public License for more details.
+ -
+ - You should have received a copy of the GNU General Public License
+ - along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ -----------------------------------------------------------------------------*/
+
+//
+// Created by ziqi on 2024/9/19.
+//
+
+#ifndef WSDB_EXECUTOR_PARALLELSCAN_H
+#define WSDB_EXECUTOR_PARALLELSCAN_H
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>  // NOLINT
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>  // NOLINT
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "executor_abstract.h"
+#include "system/handle/table_handle.h"
+
+namespace wsdb {
+
+/**
+ * @brief Scan a table with several worker threads, each of which runs a pipeline of its own, i.e. a sequential scan
+ * over the runs of pages it claims from PageMorsels, with the filter and the projection above the scan.
+ *
+ * Workers copy the records of their pipelines into batches and hand them over through a bounded queue, a worker that
+ * gets too far ahead of the consumer waits. Records come out in no particular order, and stay valid after Next as
+ * their views share the batch.
+ * Workers are taken from MAX_WORKER_NUM threads shared by all queries, the pipeline runs in the thread of the
+ * executor if none is left. A worker keeps the page it reads pinned, so there are no more workers than frames of the
+ * buffer pool beyond SCAN_FRAME_HEADROOM. Each worker allocates from a memory context of its own, as a context is not
+ * thread-safe.
+ */
+class ParallelScanExecutor : public AbstractExecutor
+{
+public:
+  /**
+   * build the pipeline of a worker, the scan reads the pages claimed from the morsels, or the whole table if nullptr,
+   * and the executors allocate from the memory context given, see AbstractExecutor::SetMemoryContext
+   */
+  using PipelineFactory = std::function<AbstractExecutorUptr(PageMorsels *, MemoryContext *)>;
+
+  /**
+   * @param tab
+   * @param worker_num number of workers asked for
+   * @param make_pipeline
+   */
+  ParallelScanExecutor(TableHandle *tab, size_t worker_num, PipelineFactory make_pipeline);
+
+  ~ParallelScanExecutor() override;
+
+  /**
+   * Start the scan, a running scan is stopped first
+   * 1. take up to worker_num workers from the shared ones, run the pipeline in this thread if none is left
+   * 2. cut the pages of the table into morsels of SCAN_MORSEL_PAGES pages
+   * 3. start the workers, see Work
+   */
+  void Init() override;
+
+  /// move to the next record of the current batch, or wait for the next batch, rethrow the first error of the workers
+  void Next() override;
+
+  [[nodiscard]] auto IsEnd() const -> bool override;
+
+  [[nodiscard]] auto GetRecordView() -> RecordView override;
+
+  /// @return number of workers of the running scan, 0 if the pipeline runs in the thread of the executor
+  [[nodiscard]] auto GetWorkerNum() const -> size_t { return workers_.size(); }
+
+private:
+  /// records of a worker back to back, each as | data | null map | like Record
+  struct Batch
+  {
+    std::vector<char> rows_;
+    std::vector<RID>  rids_;
+  };
+
+  /// run a pipeline over the claimed pages and push its records in batches until it is exhausted or stopped
+  void Work();
+
+  /// @return false if the scan is stopped while waiting for room in the queue
+  auto Push(std::shared_ptr<Batch> batch) -> bool;
+
+  /// wait for a batch, or for all workers to finish
+  void Pop();
+
+  /// stop the workers and give them back, batches left in the queue are dropped
+  void Stop();
+
+  /// @return number of workers taken from the shared ones, at most num
+  static auto AcquireWorkers(size_t num) -> size_t;
+
+  static void ReleaseWorkers(size_t num);
+
+private:
+  TableHandle *const    tab_;
+  const size_t          worker_num_;
+  const PipelineFactory make_pipeline_;
+  // runs in the thread of the executor when no worker is available, also gives the out schema
+  AbstractExecutorUptr inline_pipeline_;
+  bool                 is_inline_{false};
+  // bytes of a record in a batch
+  size_t row_size_{0};
+
+  PageMorselsUptr          morsels_;
+  std::vector<std::thread> workers_;
+  // batches waiting for the consumer, at most SCAN_QUEUE_BATCHES per worker
+  std::mutex                         queue_latch_;
+  std::condition_variable            not_empty_;
+  std::condition_variable            not_full_;
+  std::deque<std::shared_ptr<Batch>> queue_;
+  size_t                             queue_capacity_{0};
+  size_t                             running_{0};
+  std::atomic<bool>                  stopped_{false};
+  std::exception_ptr                 error_;
+  // the batch read by the consumer and the position in it
+  std::shared_ptr<Batch> batch_;
+  size_t                 pos_{0};
+
+  static_assert(BUFFER_POOL_SIZE > SCAN_FRAME_HEADROOM, "no frame is left to parallel scans");
+  // most workers running at a time, one page is pinned by each of them
+  static constexpr size_t MAX_WORKER_NUM = std::min(MAX_SCAN_WORKER_NUM, BUFFER_POOL_SIZE - SCAN_FRAME_HEADROOM);
+
+  // workers of parallel scans running over all queries
+  inline static std::atomic<size_t> used_workers_{0};
+};
+
+}  // namespace wsdb
+
+#endif  // WSDB_EXECUTOR_PARALLELSCAN_H
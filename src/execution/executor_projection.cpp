@@ -27,31 +27,33 @@ ProjectionExecutor::ProjectionExecutor(AbstractExecutorUptr child, RecordSchemaU
     : AbstractExecutor(Basic), child_(std::move(child))
 {
   out_schema_ = std::move(proj_schema);
+  fields_.reserve(out_schema_->GetFieldCount());
+  for (const auto &field : out_schema_->GetFields()) {
+    fields_.push_back(child_->GetOutSchema()->BindField(field));
+  }
 }
 
 // hint: record_ = std::make_unique<Record>(out_schema_.get(), *child_record);
 
 void ProjectionExecutor::Init()
 {
-  // WSDB_STUDENT_TODO(l2, t1);
   WSDB_ASSERT(child_->GetType() == Basic, "ProjectionExecutor 需要可执行 Init() 的子执行器");
   child_->Init();
-  is_end_ = child_->IsEnd();
+  Project();
 }
 
 void ProjectionExecutor::Next()
 {
-  // WSDB_STUDENT_TODO(l2, t1);
   child_->Next();
-  record_ = std::make_unique<Record>(out_schema_.get(), *child_->GetRecord());
-  
-  is_end_ = child_->IsEnd();
+  Project();
 }
 
-auto ProjectionExecutor::IsEnd() const -> bool
+auto ProjectionExecutor::IsEnd() const -> bool { return is_end_; }
+
+void ProjectionExecutor::Project()
 {
-  // WSDB_STUDENT_TODO(l2, t1);
-  return is_end_;
+  is_end_ = child_->IsEnd();
+  record_ = is_end_ ? nullptr : std::make_unique<Record>(out_schema_.get(), child_->GetRecordView(), fields_, mem_ctx_);
 }
 
 }  // namespace wsdb
\ No newline at end of file
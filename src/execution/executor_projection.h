@@ -41,8 +41,14 @@ public:
 
   [[nodiscard]] auto IsEnd() const -> bool override;
 
+private:
+  /// project the current record of the child
+  void Project();
+
 private:
   const AbstractExecutorUptr child_;  // 更改声明为 const
+  // fields of the out schema bound to the out schema of the child
+  std::vector<BoundField> fields_;
   // 新加的
   bool is_end_;
 };
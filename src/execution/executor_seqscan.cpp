@@ -23,35 +23,29 @@
 
 namespace wsdb {
 
-SeqScanExecutor::SeqScanExecutor(TableHandle *tab) : AbstractExecutor(Basic), tab_(tab) {}
+SeqScanExecutor::SeqScanExecutor(TableHandle *tab, ConditionVec conds, std::optional<std::vector<size_t>> partitions,
+    PageMorsels *morsels, std::optional<std::vector<size_t>> fields)
+    : AbstractExecutor(Basic),
+      tab_(tab),
+      conds_(std::move(conds)),
+      partitions_(std::move(partitions)),
+      morsels_(morsels),
+      fields_(std::move(fields))
+{}
 
 void SeqScanExecutor::Init()
 {
-  rid_ = tab_->GetFirstRID();
-
-  // WSDB_STUDENT_TODO(l2, t1);
-  is_end_ = rid_ == INVALID_RID;
-  if (!is_end_) {
-    record_ = tab_->GetRecord(rid_);
-    rid_    = tab_->GetNextRID(rid_);
-    is_end_ = rid_ == INVALID_RID;
-  }
+  iter_ = tab_->MakeIterator(conds_.empty() ? nullptr : &conds_,
+      partitions_.has_value() ? &*partitions_ : nullptr,
+      morsels_,
+      fields_.has_value() ? &*fields_ : nullptr);
 }
 
-void SeqScanExecutor::Next()
-{
-  // WSDB_STUDENT_TODO(l2, t1);
-  record_ = tab_->GetRecord(rid_);
-  rid_    = tab_->GetNextRID(rid_);
-
-  is_end_ = rid_ == INVALID_RID;
-}
+void SeqScanExecutor::Next() { iter_->Next(); }
 
-auto SeqScanExecutor::IsEnd() const -> bool
-{
-  // WSDB_STUDENT_TODO(l2, t1);
-  return is_end_;
-}
+auto SeqScanExecutor::IsEnd() const -> bool { return iter_ == nullptr || iter_->IsEnd(); }
 
 auto SeqScanExecutor::GetOutSchema() const -> const RecordSchema * { return &tab_->GetSchema(); }
-}  // namespace wsdb
\ No newline at end of file
+
+auto SeqScanExecutor::GetRecordView() -> RecordView { return IsEnd() ? RecordView() : iter_->GetRecordView(); }
+}  // namespace wsdb
@@ -26,6 +26,9 @@
 
 #ifndef WSDB_EXECUTOR_SEQSCAN_H
 #define WSDB_EXECUTOR_SEQSCAN_H
+#include <optional>
+#include <vector>
+
 #include "executor_abstract.h"
 #include "system/handle/table_handle.h"
 
@@ -33,7 +36,16 @@ namespace wsdb {
 class SeqScanExecutor : public AbstractExecutor
 {
 public:
-  explicit SeqScanExecutor(TableHandle *tab);
+  /**
+   * @param tab
+   * @param conds conditions of the filter above the scan, used to skip pages by the zone map, records are not checked
+   * @param partitions partitions to scan of a partitioned table, all partitions if not set
+   * @param morsels runs of pages to scan for a worker of a parallel scan, the whole table if nullptr
+   * @param fields fields read by the operators above the scan, all fields if not set, see TableHandle::MakeIterator
+   */
+  explicit SeqScanExecutor(TableHandle *tab, ConditionVec conds = {},
+      std::optional<std::vector<size_t>> partitions = std::nullopt, PageMorsels *morsels = nullptr,
+      std::optional<std::vector<size_t>> fields = std::nullopt);
 
   void Init() override;
 
@@ -43,11 +55,16 @@ public:
 
   [[nodiscard]] auto GetOutSchema() const -> const RecordSchema * override;
 
+  /// view into the pinned page of the iterator, no copy is made
+  [[nodiscard]] auto GetRecordView() -> RecordView override;
+
 private:
   TableHandle *const tab_;  // 更改声明为 const
-  RID                rid_;
-  // 新加的
-  bool is_end_;
+  const ConditionVec                       conds_;
+  const std::optional<std::vector<size_t>> partitions_;
+  PageMorsels *const                       morsels_;
+  const std::optional<std::vector<size_t>> fields_;
+  TableIteratorUptr                        iter_;
 };
 }  // namespace wsdb
 
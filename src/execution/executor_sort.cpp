@@ -19,6 +19,9 @@
 // Created by ziqi on 2024/8/5.
 //
 #include <unistd.h>
+#include <cstring>
+#include <filesystem>
+#include <limits>
 #include "common/config.h"
 #include "executor_sort.h"
 
@@ -30,101 +33,287 @@ SortExecutor::SortExecutor(AbstractExecutorUptr child, RecordSchemaUptr key_sche
     : AbstractExecutor(Basic),
       child_(std::move(child)),
       key_schema_(std::move(key_schema)),
+      key_norm_(*key_schema_, *child_->GetOutSchema(), is_desc),
       buf_idx_(0),
       is_desc_(is_desc),
       is_sorted_(false),
+      is_end_(false),
       is_merge_sort_(false),
-      max_rec_num_(SORT_BUFFER_SIZE / child_->GetOutSchema()->GetRecordLength()),
+      row_size_(sizeof(RID) + BITMAP_SIZE(child_->GetOutSchema()->GetFieldCount()) +
+                child_->GetOutSchema()->GetRecordLength()),
+      max_rec_num_(0),
       tmp_file_num_(0),
       merge_result_file_(fmt::format("sort_result_{}", sort_result_fresh_id_++))
-{
-  // comment the line below after testing
-  //  max_rec_num_ = 10;
-}
+{}
 
 SortExecutor::~SortExecutor()
 {
+  // the reclaimer of the grant uses the members declared after it
+  ReleaseBuffer();
   if (is_merge_sort_) {
-    // TODO: do some clean up, e.g. close the result file
-    WSDB_STUDENT_TODO(l2, f1);
+    if (merge_result_file_handle_ != nullptr) {
+      merge_result_file_handle_->close();
+    }
+    std::filesystem::remove(SORT_FILE_PATH(merge_result_file_));
   }
 }
 
 void SortExecutor::Init()
 {
-  // TODO: decide whether to use merge sort according to the cardinality of the child.
-  // leave is_merge_sort_ as false if you just want to use in-memory sort
+  auto nullmap_size = BITMAP_SIZE(GetOutSchema()->GetFieldCount());
+  AllocateBuffer();
   is_merge_sort_ = false;
-  if (is_merge_sort_) {
-    WSDB_STUDENT_TODO(l2, f1);
-  }
-  // WSDB_STUDENT_TODO(l2, t1);
+  is_end_        = false;
+  tmp_file_num_  = 0;
   for (child_->Init(); !child_->IsEnd(); child_->Next()) {
-    sort_buffer_.push_back(child_->GetRecord());
+    // the child may run out of frames and reclaim those of the buffer through SpillFrames, so the row is fetched
+    // before the latch is taken
+    auto view = child_->GetRecordView();
+    // copy the row into the next slot, the key is normalized once here
+    std::lock_guard<std::mutex> lock{buffer_latch_};
+    auto                        rid = view.GetRID();
+    char *row  = GetSlot(sort_buffer_.size());
+    memcpy(row, &rid, sizeof(RID));
+    memcpy(row + sizeof(RID), view.GetNullMap(), nullmap_size);
+    memcpy(row + sizeof(RID) + nullmap_size, view.GetData(), GetOutSchema()->GetRecordLength());
+    sort_keys_.resize(sort_keys_.size() + key_norm_.GetKeySize());
+    key_norm_.Normalize(view, sort_keys_.data() + sort_keys_.size() - key_norm_.GetKeySize());
+    sort_buffer_.push_back(row);
+    if (sort_buffer_.size() >= max_rec_num_) {
+      is_merge_sort_ = true;
+      SortBuffer();
+      DumpBufferToFile(tmp_file_num_++);
+    }
+  }
+  {
+    std::lock_guard<std::mutex> lock{buffer_latch_};
+    is_filling_ = false;
+  }
+  if (is_merge_sort_) {
+    if (!sort_buffer_.empty()) {
+      SortBuffer();
+      DumpBufferToFile(tmp_file_num_++);
+    }
+    // all runs are on disk, merging only holds one record per run
+    ReleaseBuffer();
+    Merge();
+    merge_result_file_handle_ =
+        std::make_unique<std::ifstream>(SORT_FILE_PATH(merge_result_file_), std::ios::in | std::ios::binary);
+  } else {
+    SortBuffer();
   }
-  SortBuffer();
-  // is_sorted_ = true;
-  buf_idx_ = 0;
+  is_sorted_ = true;
+  buf_idx_   = 0;
+  // position on the first record
+  Next();
 }
 
 void SortExecutor::Next()
 {
   if (is_merge_sort_) {
-    WSDB_STUDENT_TODO(L2, f1);
+    LoadMergeResult();
+    return;
   }
-  // WSDB_STUDENT_TODO(L2, t1);
   if (buf_idx_ >= sort_buffer_.size()) {
     is_end_ = true;
+    record_ = nullptr;
+    ReleaseBuffer();
   } else {
-    record_ = std::move(sort_buffer_[buf_idx_]);
+    // the record is copied out of the slot, it stays valid after the buffer is released
+    const char *row = sort_buffer_[buf_idx_];
+    RID         rid;
+    memcpy(&rid, row, sizeof(RID));
+    row += sizeof(RID);
+    record_ = std::make_unique<Record>(
+        GetOutSchema(), row, row + BITMAP_SIZE(GetOutSchema()->GetFieldCount()), rid, mem_ctx_);
     buf_idx_++;
   }
 }
 
-auto SortExecutor::IsEnd() const -> bool
-{
-  if (is_merge_sort_) {
-    WSDB_STUDENT_TODO(L2, f1);
-  }
-  // WSDB_STUDENT_TODO(L2, t1);
-  return is_end_;
-}
+auto SortExecutor::IsEnd() const -> bool { return is_end_; }
 
-auto SortExecutor::Compare(const Record &lhs, const Record &rhs) const -> bool
+auto SortExecutor::Compare(const char *lhs, const char *rhs) const -> bool
 {
-  auto lkey = std::make_unique<Record>(key_schema_.get(), lhs);
-  auto rkey = std::make_unique<Record>(key_schema_.get(), rhs);
-  return is_desc_ ? Record::Compare(*lkey, *rkey) > 0 : lkey->Compare(*lkey, *rkey) < 0;
+  // descending fields are inverted by the normalizer
+  return memcmp(lhs, rhs, key_norm_.GetKeySize()) < 0;
 }
 
 auto SortExecutor::GetOutSchema() const -> const RecordSchema * { return child_->GetOutSchema(); }
 
 /// methods below are only used for merge sort
 
+void SortExecutor::WriteRecord(std::ofstream &file, const Record &record)
+{
+  auto rid = record.GetRID();
+  file.write(reinterpret_cast<const char *>(&rid), sizeof(RID));
+  file.write(record.GetNullMap(), static_cast<std::streamsize>(BITMAP_SIZE(record.GetSchema()->GetFieldCount())));
+  file.write(record.GetData(), static_cast<std::streamsize>(record.GetSchema()->GetRecordLength()));
+  if (!file) {
+    WSDB_THROW(WSDB_FILE_WRITE_ERROR, "failed to spill sort run");
+  }
+}
+
+auto SortExecutor::ReadRecord(std::ifstream &file, const RecordSchema *schema, MemoryContext *mem_ctx) -> RecordUptr
+{
+  auto              nullmap_size = BITMAP_SIZE(schema->GetFieldCount());
+  std::vector<char> buf(nullmap_size + schema->GetRecordLength());
+  RID               rid;
+  file.read(reinterpret_cast<char *>(&rid), sizeof(RID));
+  file.read(buf.data(), static_cast<std::streamsize>(buf.size()));
+  if (!file) {
+    return nullptr;
+  }
+  return std::make_unique<Record>(schema, buf.data(), buf.data() + nullmap_size, rid, mem_ctx);
+}
+
 auto SortExecutor::GetSortFileName(size_t file_group, size_t file_idx) const -> std::string
 {
   return fmt::format("{}_{}_{}", merge_result_file_, file_group, file_idx);
 }
 
+void SortExecutor::AllocateBuffer()
+{
+  ReleaseBuffer();
+  // ask for enough memory to sort in memory, the broker may grant less under pressure and sorted runs are spilled
+  grant_ = MemoryGrant(SORT_BUFFER_SIZE, SORT_MIN_BUFFER_SIZE, MemoryBroker::GetInstance(), true);
+  if (grant_.IsDenied()) {
+    WSDB_THROW(WSDB_NO_FREE_MEMORY, fmt::format("sort requires at least {} bytes", SORT_MIN_BUFFER_SIZE));
+  }
+  // the heap block holds at least one row, so that rows are still sorted one at a time once the frames are reclaimed,
+  // a row the heap part of the grant cannot hold is granted on its own
+  if (grant_.GetHeapSize() < row_size_) {
+    row_grant_ = MemoryGrant(row_size_, row_size_, MemoryBroker::GetInstance());
+    if (row_grant_.IsDenied()) {
+      WSDB_THROW(WSDB_NO_FREE_MEMORY, fmt::format("sort requires {} bytes on the heap for a row", row_size_));
+    }
+  }
+  heap_rows_   = std::max<size_t>(grant_.GetHeapSize() / row_size_, 1);
+  frame_rows_  = PAGE_SIZE / row_size_;
+  max_rec_num_ = heap_rows_ + frame_rows_ * grant_.GetFrames().size();
+  heap_buffer_ = std::make_unique_for_overwrite<char[]>(heap_rows_ * row_size_);
+  is_filling_  = true;
+  grant_.SetReclaimer([this]() { return SpillFrames(); });
+}
+
+auto SortExecutor::SpillFrames() -> bool
+{
+  std::lock_guard<std::mutex> lock{buffer_latch_};
+  if (!is_filling_) {
+    return false;
+  }
+  if (!sort_buffer_.empty()) {
+    is_merge_sort_ = true;
+    SortBuffer();
+    DumpBufferToFile(tmp_file_num_++);
+  }
+  max_rec_num_ = heap_rows_;
+  return true;
+}
+
+auto SortExecutor::GetSlot(size_t idx) const -> char *
+{
+  if (idx < heap_rows_) {
+    return heap_buffer_.get() + idx * row_size_;
+  }
+  idx -= heap_rows_;
+  return grant_.GetFrames()[idx / frame_rows_] + idx % frame_rows_ * row_size_;
+}
+
+void SortExecutor::ReleaseBuffer()
+{
+  // unregister the reclaimer first, it may be spilling the buffer right now
+  grant_.Reset();
+  row_grant_.Reset();
+  sort_buffer_.clear();
+  sort_keys_.clear();
+  heap_buffer_ = nullptr;
+}
+
 void SortExecutor::SortBuffer()
 {
-  // WSDB_STUDENT_TODO(L2, t1);
-  std::sort(sort_buffer_.begin(), sort_buffer_.end(), [this](const RecordUptr &lhs, const RecordUptr &rhs) {
-    return Compare(*lhs, *rhs);
+  // sort the positions of the rows by the keys normalized on insertion
+  auto                key_size = key_norm_.GetKeySize();
+  std::vector<size_t> order(sort_buffer_.size());
+  for (size_t i = 0; i < sort_buffer_.size(); ++i) {
+    order[i] = i;
+  }
+  std::sort(order.begin(), order.end(), [this, key_size](size_t lhs, size_t rhs) {
+    return Compare(sort_keys_.data() + lhs * key_size, sort_keys_.data() + rhs * key_size);
   });
+  std::vector<char *> sorted;
+  sorted.reserve(sort_buffer_.size());
+  for (auto idx : order) {
+    sorted.push_back(sort_buffer_[idx]);
+  }
+  sort_buffer_ = std::move(sorted);
+  sort_keys_.clear();
 }
 
-void SortExecutor::DumpBufferToFile(size_t file_idx) { WSDB_STUDENT_TODO(L2, f1); }
+void SortExecutor::DumpBufferToFile(size_t file_idx)
+{
+  // rows are kept in the layout of WriteRecord, they are written as they are
+  std::ofstream file(SORT_FILE_PATH(GetSortFileName(0, file_idx)), std::ios::out | std::ios::binary | std::ios::trunc);
+  for (const auto *row : sort_buffer_) {
+    file.write(row, static_cast<std::streamsize>(row_size_));
+  }
+  if (!file) {
+    WSDB_THROW(WSDB_FILE_WRITE_ERROR, "failed to spill sort run");
+  }
+  sort_buffer_.clear();
+}
 
-void SortExecutor::LoadMergeResult() { WSDB_STUDENT_TODO(L2, f1); }
+void SortExecutor::LoadMergeResult()
+{
+  record_ = ReadRecord(*merge_result_file_handle_, GetOutSchema(), mem_ctx_);
+  if (record_ == nullptr) {
+    is_end_ = true;
+  }
+}
 
 void SortExecutor::Merge()
 {
-  // 1. create a heap according to is_desc_
-  // 2. read the first tuple from each file
-  // 3. pop the top of the heap and write to file: group 1, file: file_index
-  // run until all runs are exhausted, then read tuples from group 1, file 0, write to group 0, file 0 ...
-  WSDB_STUDENT_TODO(L2, f1);
+  // the top of the heap is the record to be output first
+  auto cmp = [this](const SortHeapNode &lhs, const SortHeapNode &rhs) { return Compare(rhs.GetKey(), lhs.GetKey()); };
+  // merge SORT_WAY_NUM runs of group g into one run of group 1 - g, until only one run is left
+  size_t group    = 0;
+  size_t file_num = tmp_file_num_;
+  while (file_num > 1) {
+    size_t out_num = 0;
+    for (size_t begin = 0; begin < file_num; begin += SORT_WAY_NUM, out_num++) {
+      auto                      end = std::min(begin + SORT_WAY_NUM, file_num);
+      std::vector<SortHeapNode> heap;
+      heap.reserve(end - begin);
+      for (size_t i = begin; i < end; ++i) {
+        auto file = std::make_shared<std::ifstream>(
+            SORT_FILE_PATH(GetSortFileName(group, i)), std::ios::in | std::ios::binary);
+        heap.emplace_back(std::move(file), GetOutSchema(), 0, &key_norm_);
+        if (!heap.back().LoadNextRecord(std::numeric_limits<size_t>::max())) {
+          heap.back().CloseFile();
+          heap.pop_back();
+        }
+      }
+      std::make_heap(heap.begin(), heap.end(), cmp);
+      std::ofstream out(
+          SORT_FILE_PATH(GetSortFileName(1 - group, out_num)), std::ios::out | std::ios::binary | std::ios::trunc);
+      while (!heap.empty()) {
+        std::pop_heap(heap.begin(), heap.end(), cmp);
+        auto &node = heap.back();
+        WriteRecord(out, *node.GetRecord());
+        if (node.LoadNextRecord(std::numeric_limits<size_t>::max())) {
+          std::push_heap(heap.begin(), heap.end(), cmp);
+        } else {
+          node.CloseFile();
+          heap.pop_back();
+        }
+      }
+      for (size_t i = begin; i < end; ++i) {
+        std::filesystem::remove(SORT_FILE_PATH(GetSortFileName(group, i)));
+      }
+    }
+    group    = 1 - group;
+    file_num = out_num;
+  }
+  std::filesystem::rename(SORT_FILE_PATH(GetSortFileName(group, 0)), SORT_FILE_PATH(merge_result_file_));
 }
 
-}  // namespace wsdb
\ No newline at end of file
+}  // namespace wsdb
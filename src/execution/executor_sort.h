@@ -28,7 +28,10 @@
 #define WSDB_EXECUTOR_SORT_H
 #include <functional>
 #include <fstream>
+#include <mutex>  // NOLINT
 #include <utility>
+#include "storage/buffer/memory_broker.h"
+#include "system/handle/record_compare.h"
 #include "executor_abstract.h"
 
 namespace wsdb {
@@ -55,8 +58,14 @@ private:
   public:
     SortHeapNode() = delete;
 
-    SortHeapNode(std::shared_ptr<std::ifstream> file_handle, const RecordSchema *schema, size_t rec_idx)
-        : file_handle_(std::move(file_handle)), schema_(schema), rec_idx_(rec_idx), record_(nullptr)
+    SortHeapNode(std::shared_ptr<std::ifstream> file_handle, const RecordSchema *schema, size_t rec_idx,
+        const KeyNormalizer *key_norm)
+        : file_handle_(std::move(file_handle)),
+          schema_(schema),
+          rec_idx_(rec_idx),
+          record_(nullptr),
+          key_norm_(key_norm),
+          key_(key_norm->GetKeySize())
     {}
 
     SortHeapNode(const SortHeapNode &other)
@@ -65,6 +74,8 @@ private:
       schema_      = other.schema_;
       rec_idx_     = other.rec_idx_;
       record_      = std::make_unique<Record>(*other.record_);
+      key_norm_    = other.key_norm_;
+      key_         = other.key_;
     }
 
     SortHeapNode(SortHeapNode &&other) noexcept
@@ -73,6 +84,8 @@ private:
       schema_      = other.schema_;
       rec_idx_     = other.rec_idx_;
       record_      = std::move(other.record_);
+      key_norm_    = other.key_norm_;
+      key_         = std::move(other.key_);
     }
 
     auto operator=(const SortHeapNode &other) -> SortHeapNode &
@@ -84,6 +97,19 @@ private:
       schema_      = other.schema_;
       rec_idx_     = other.rec_idx_;
       record_      = std::make_unique<Record>(*other.record_);
+      key_norm_    = other.key_norm_;
+      key_         = other.key_;
+      return *this;
+    }
+
+    auto operator=(SortHeapNode &&other) noexcept -> SortHeapNode &
+    {
+      file_handle_ = std::move(other.file_handle_);
+      schema_      = other.schema_;
+      rec_idx_     = other.rec_idx_;
+      record_      = std::move(other.record_);
+      key_norm_    = other.key_norm_;
+      key_         = std::move(other.key_);
       return *this;
     }
 
@@ -97,11 +123,23 @@ private:
       WSDB_ASSERT(file_handle_ != nullptr, "file_handle_ is nullptr");
       WSDB_ASSERT(file_handle_->is_open(), "file_handle_ is not open");
 
-      WSDB_STUDENT_TODO(l2, f1);
+      if (rec_idx_ >= max_rec_num) {
+        return false;
+      }
+      record_ = ReadRecord(*file_handle_, schema_);
+      if (record_ == nullptr) {
+        return false;
+      }
+      key_norm_->Normalize(*record_, key_.data());
+      rec_idx_++;
+      return true;
     }
 
     [[nodiscard]] auto GetRecord() const -> const RecordUptr & { return record_; }
 
+    /// normalized key of the record
+    [[nodiscard]] auto GetKey() const -> const char * { return key_.data(); }
+
     void CloseFile()
     {
       WSDB_ASSERT(file_handle_ != nullptr, "file_handle_ is nullptr");
@@ -114,12 +152,46 @@ private:
     const RecordSchema            *schema_;   // schema of the record
     size_t                         rec_idx_;  // index of the record in the file
     RecordUptr                     record_;   // record
+    const KeyNormalizer           *key_norm_{nullptr};
+    std::vector<char>              key_;  // normalized key of record_
   };
 
 private:
+  /// records are spilled as | rid | nullmap | data |
+  static void WriteRecord(std::ofstream &file, const Record &record);
+
+  /// @return nullptr if the file is end, else the record allocated from mem_ctx
+  static auto ReadRecord(std::ifstream &file, const RecordSchema *schema, MemoryContext *mem_ctx = nullptr)
+      -> RecordUptr;
+
   [[nodiscard]] inline auto GetSortFileName(size_t file_group, size_t file_idx) const -> std::string;
 
-  [[nodiscard]] inline auto Compare(const Record &lhs, const Record &rhs) const -> bool;
+  /// @return true if the normalized key lhs goes before rhs
+  [[nodiscard]] inline auto Compare(const char *lhs, const char *rhs) const -> bool;
+
+  /**
+   * Carve the sort buffer from the grant, rows are laid out as in the spilled runs
+   * 1. ask MemoryBroker for SORT_BUFFER_SIZE bytes, throw WSDB_NO_FREE_MEMORY if not even SORT_MIN_BUFFER_SIZE is left
+   * 2. allocate the heap part of the grant as one block, the frames lent by the buffer pool hold the other rows. The
+   *    block holds at least one row, if the heap part is smaller the row is granted apart, throw WSDB_NO_FREE_MEMORY if
+   *    it is denied
+   * 3. cut the block and each frame into row slots, max_rec_num_ is the number of slots
+   */
+  void AllocateBuffer();
+
+  /// @return the idx-th row slot, the slots of the heap block come first, then those of each frame
+  [[nodiscard]] auto GetSlot(size_t idx) const -> char *;
+
+  /// drop the sort buffer and give the grant back, the frames go back to the buffer pool
+  void ReleaseBuffer();
+
+  /**
+   * Reclaimer of grant_, called when the buffer pool runs out of frames, possibly on another thread
+   * 1. grant the buffer latch, refuse if the buffer is not being filled, the sorted rows are being output from it
+   * 2. sort and spill the rows in the buffer as a run, only the heap block is used for the rows that follow
+   * @return true if the frames can be taken
+   */
+  auto SpillFrames() -> bool;
 
   void SortBuffer();
 
@@ -132,16 +204,30 @@ private:
 private:
   const AbstractExecutorUptr child_;       // 更改声明为 const
   const RecordSchemaUptr     key_schema_;  // 更改声明为 const
-  std::vector<RecordUptr>    sort_buffer_;
+  // records are sorted and merged by their normalized keys, see Compare
+  const KeyNormalizer        key_norm_;
+  // rows of the sort buffer in slots of row_size_ bytes, and their normalized keys in the same order
+  std::vector<char *>        sort_buffer_;
+  std::vector<char>          sort_keys_;
   size_t                     buf_idx_;
   const bool                 is_desc_;  // 更改声明为 const
   bool                       is_sorted_;//该变量似乎没用
   bool                       is_end_;
-  // use for merge sort, if you want to use merge sort, set it to true if the record number is larger than max_rec_num_
-  bool        is_merge_sort_;
-  size_t      max_rec_num_;
-  size_t      tmp_file_num_;
-  std::string merge_result_file_;
+  // use for merge sort, set to true if the record number is larger than max_rec_num_
+  bool                    is_merge_sort_;
+  // guards the sort buffer while it is filled, SpillFrames may spill it from another thread
+  std::mutex              buffer_latch_;
+  bool                    is_filling_{false};
+  // decided by the memory granted by MemoryBroker, sorted runs are spilled to disk once the buffer is full
+  MemoryGrant             grant_;
+  MemoryGrant             row_grant_;  // the only row of heap_buffer_ when the heap part of grant_ cannot hold one
+  std::unique_ptr<char[]> heap_buffer_;
+  size_t                  row_size_;
+  size_t                  heap_rows_{0};   // row slots in heap_buffer_
+  size_t                  frame_rows_{0};  // row slots in each frame of grant_
+  size_t                  max_rec_num_;
+  size_t                  tmp_file_num_;
+  std::string             merge_result_file_;
   // we use file stream instead of disk manager to obtain faster sort speed;
   std::unique_ptr<std::ifstream> merge_result_file_handle_;
 };
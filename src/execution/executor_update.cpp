@@ -46,17 +46,23 @@ void UpdateExecutor::Next()
   int count = 0;
 
   // WSDB_STUDENT_TODO(l2, t1);
-  child_->Init();
-  while (!child_->IsEnd()) {
-    child_->Next();
-    Record &record{*child_->GetRecord()};
-    for (auto &update : updates_) {
-      Record new_record{Record(
-          std::make_unique<RecordSchema>(std::vector<RTField>{update.first}).get(), std::vector<ValueSptr>{update.second}, record.GetRID())};
-      tbl_->UpdateRecord(record.GetRID(), new_record);
-      for (IndexHandle *const &index : indexes_) {
-        index->UpdateRecord(record, new_record);
-      }
+  // the child scans the table with a TableIterator, records are updated in place so none is visited twice
+  const auto &schema = tbl_->GetSchema();
+  for (child_->Init(); !child_->IsEnd(); child_->Next()) {
+    auto                   view = child_->GetRecordView();
+    std::vector<ValueSptr> values(schema.GetFieldCount());
+    for (size_t i = 0; i < values.size(); ++i) {
+      values[i] = view.GetValueAt(i);
+    }
+    for (const auto &[field, value] : updates_) {
+      values[schema.GetRTFieldIndex(field)] = value;
+    }
+    Record new_record(&schema, values, view.GetRID());
+    // the view points into the page, keep the old record for the indexes before it is overwritten
+    RecordUptr old_record = indexes_.empty() ? nullptr : view.Materialize();
+    tbl_->UpdateRecord(view.GetRID(), new_record);
+    for (IndexHandle *const &index : indexes_) {
+      index->UpdateRecord(*old_record, new_record);
     }
     count++;
   }
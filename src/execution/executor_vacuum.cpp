@@ -0,0 +1,63 @@
+/*------------------------------------------------------------------------------
+ - Copyright (c) 2024. Websoft research group, Nanjing University.
+ -
+ - This program is free software: you can redistribute it and/or modify
+ - it under the terms of the GNU General Public License as published by
+ - the Free Software Foundation, either version 3 of the License, or
+ - (at your option) any later version.
+ -
+ - This program is distributed in the hope that it will be useful,
+ - but WITHOUT ANY WARRANTY; without even the implied warranty of
+ - MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ - GNU General Public License for more details.
+ -
+ - You should have received a copy of the GNU General Public License
+ - along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ -----------------------------------------------------------------------------*/
+
+//
+// Created by ziqi on 2024/9/15.
+//
+
+#include "executor_vacuum.h"
+
+#include <thread>  // NOLINT
+
+namespace wsdb {
+
+VacuumExecutor::VacuumExecutor(TableHandle *tbl, std::list<IndexHandle *> indexes)
+    : AbstractExecutor(DML), tbl_(tbl), indexes_(std::move(indexes)), is_end_(false)
+{
+  std::vector<RTField> fields(2);
+  fields[0]   = RTField{.field_ = {.field_name_ = "moved", .field_size_ = sizeof(int), .field_type_ = TYPE_INT}};
+  fields[1]   = RTField{.field_ = {.field_name_ = "freed pages", .field_size_ = sizeof(int), .field_type_ = TYPE_INT}};
+  out_schema_ = std::make_unique<RecordSchema>(fields);
+}
+
+void VacuumExecutor::Init() { WSDB_FETAL("VacuumExecutor does not support Init"); }
+
+void VacuumExecutor::Next()
+{
+  int  moved    = 0;
+  auto page_num = tbl_->GetPageNum();
+  auto on_move  = [this, &moved](const Record &old_record, const Record &new_record) {
+    for (auto &index : indexes_) {
+      index->DeleteRecord(old_record);
+      index->InsertRecord(new_record);
+    }
+    moved++;
+  };
+  // other queries on the table get a chance to run between the steps
+  while (tbl_->Vacuum(VACUUM_STEP_PAGES, on_move)) {
+    std::this_thread::yield();
+  }
+
+  std::vector<ValueSptr> values{ValueFactory::CreateIntValue(moved),
+      ValueFactory::CreateIntValue(static_cast<int>(page_num - tbl_->GetPageNum()))};
+  record_ = std::make_unique<Record>(out_schema_.get(), values, INVALID_RID);
+
+  is_end_ = true;
+}
+
+auto VacuumExecutor::IsEnd() const -> bool { return is_end_; }
+}  // namespace wsdb
@@ -0,0 +1,56 @@
+/*------------------------------------------------------------------------------
+ - Copyright (c) 2024. Websoft research group, Nanjing University.
+ -
+ - This program is free software: you can redistribute it and/or modify
+ - it under the terms of the GNU General Public License as published by
+ - the Free Software Foundation, either version 3 of the License, or
+ - (at your option) any later version.
+ -
+ - This program is distributed in the hope that it will be useful,
+ - but WITHOUT ANY WARRANTY; without even the implied warranty of
+ - MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ - GNU General Public License for more details.
+ -
+ - You should have received a copy of the GNU General Public License
+ - along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ -----------------------------------------------------------------------------*/
+
+//
+// Created by ziqi on 2024/9/15.
+//
+
+/**
+ * @brief compact a table after large deletes, records of the last pages are moved into free slots of earlier pages,
+ * the emptied pages are cut from the file and the indexes are updated with the new rids of the moved records
+ *
+ * The table is compacted in steps of VACUUM_STEP_PAGES pages, queries on the table wait for a step at most. A step
+ * fails if the table is being scanned, records moved by the steps before are kept and their indexes are up to date.
+ * Outputs the number of moved records and the number of pages cut from the file.
+ */
+
+#ifndef WSDB_EXECUTOR_VACUUM_H
+#define WSDB_EXECUTOR_VACUUM_H
+
+#include "executor_abstract.h"
+#include "system/handle/database_handle.h"
+
+namespace wsdb {
+class VacuumExecutor : public AbstractExecutor
+{
+public:
+  VacuumExecutor(TableHandle *tbl, std::list<IndexHandle *> indexes);
+
+  void Init() override;
+
+  void Next() override;
+
+  [[nodiscard]] auto IsEnd() const -> bool override;
+
+private:
+  TableHandle *const             tbl_;
+  const std::list<IndexHandle *> indexes_;
+  bool                           is_end_;
+};
+}  // namespace wsdb
+
+#endif  // WSDB_EXECUTOR_VACUUM_H
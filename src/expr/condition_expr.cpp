@@ -23,39 +23,75 @@
 
 namespace wsdb {
 
-auto ConditionExpr::Eval(const ConditionVec &condition, const wsdb::Record &record) -> bool
+auto ConditionExpr::Eval(const ConditionVec &condition, const RecordView &record) -> bool
 {
   return std::all_of(
       condition.begin(), condition.end(), [&record](const Condition &cond) { return EvalCond(cond, record); });
 }
 
-auto ConditionExpr::EvalCond(const Condition &condition, const wsdb::Record &record) -> bool
+auto ConditionExpr::EvalCond(const Condition &condition, const RecordView &record) -> bool
 {
+  // values are read as datums, nothing is allocated per record
   // first get the lhs value according to condition
   auto idx = record.GetSchema()->GetRTFieldIndex(condition.GetLCol());
   WSDB_ASSERT(idx != record.GetSchema()->GetFieldCount(), "Invalid field");
-  auto lhs = record.GetValueAt(idx);
+  auto lhs = record.GetDatumAt(idx);
   WSDB_ASSERT(condition.GetRhsType() == kValue || condition.GetRhsType() == kColumn, "Invalid condition type");
-  ValueSptr rhs;
-  if (condition.GetRhsType() == kValue) {
-    rhs = condition.GetRVal();
-  } else {
+  if (condition.GetRhsType() == kColumn) {
     idx = record.GetSchema()->GetRTFieldIndex(condition.GetRCol());
     WSDB_ASSERT(idx != record.GetSchema()->GetFieldCount(), "Invalid field");
-    rhs = record.GetValueAt(idx);
+    return Datum::Eval(condition.GetOp(), lhs, record.GetDatumAt(idx));
   }
-  ValueFactory::AlignTypes(lhs, rhs);
-  switch (condition.GetOp()) {
-    case OP_EQ: return *lhs == *rhs;
-    case OP_NE: return *lhs != *rhs;
-    case OP_LT: return *lhs < *rhs;
-    case OP_LE: return *lhs <= *rhs;
-    case OP_GT: return *lhs > *rhs;
-    case OP_GE: return *lhs >= *rhs;
-    case OP_IN: return std::dynamic_pointer_cast<ArrayValue>(rhs)->Contains(lhs);
-    default: WSDB_FETAL(CompOpToString(condition.GetOp()));
+  const auto &rhs = condition.GetRVal();
+  if (condition.GetOp() == OP_IN) {
+    const auto &values = dynamic_cast<const ArrayValue &>(*rhs).Get();
+    return std::any_of(values.begin(), values.end(), [&lhs](const ValueSptr &value) {
+      return Datum::Eval(OP_EQ, lhs, Datum::FromValue(*value));
+    });
   }
-  // should never reach here
+  return Datum::Eval(condition.GetOp(), lhs, Datum::FromValue(*rhs));
 }
 
-}  // namespace wsdb
\ No newline at end of file
+auto ConditionExpr::Bind(const ConditionVec &condition, const RecordSchema &schema) -> BoundConditionVec
+{
+  BoundConditionVec bound;
+  bound.reserve(condition.size());
+  for (const auto &cond : condition) {
+    WSDB_ASSERT(cond.GetRhsType() == kValue || cond.GetRhsType() == kColumn, "Invalid condition type");
+    BoundCondition bound_cond;
+    bound_cond.op_            = cond.GetOp();
+    bound_cond.lhs_           = schema.BindField(cond.GetLCol());
+    bound_cond.rhs_is_column_ = cond.GetRhsType() == kColumn;
+    if (bound_cond.rhs_is_column_) {
+      bound_cond.rhs_ = schema.BindField(cond.GetRCol());
+    } else if (cond.GetOp() == OP_IN) {
+      for (const auto &value : dynamic_cast<const ArrayValue &>(*cond.GetRVal()).Get()) {
+        bound_cond.rhs_values_.push_back(Datum::FromValue(*value));
+      }
+      bound_cond.rhs_holder_ = cond.GetRVal();
+    } else {
+      bound_cond.rhs_values_.push_back(Datum::FromValue(*cond.GetRVal()));
+      bound_cond.rhs_holder_ = cond.GetRVal();
+    }
+    bound.push_back(std::move(bound_cond));
+  }
+  return bound;
+}
+
+auto ConditionExpr::Eval(const BoundConditionVec &condition, const RecordView &record) -> bool
+{
+  return std::all_of(condition.begin(), condition.end(), [&record](const BoundCondition &cond) {
+    auto lhs = record.GetDatum(cond.lhs_);
+    if (cond.rhs_is_column_) {
+      return Datum::Eval(cond.op_, lhs, record.GetDatum(cond.rhs_));
+    }
+    if (cond.op_ == OP_IN) {
+      return std::any_of(cond.rhs_values_.begin(), cond.rhs_values_.end(), [&lhs](const Datum &value) {
+        return Datum::Eval(OP_EQ, lhs, value);
+      });
+    }
+    return Datum::Eval(cond.op_, lhs, cond.rhs_values_.front());
+  });
+}
+
+}  // namespace wsdb
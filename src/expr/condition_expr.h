@@ -27,16 +27,49 @@
 
 namespace wsdb {
 
+/// a condition with its columns resolved to their place in the records it is evaluated on, see ConditionExpr::Bind
+struct BoundCondition
+{
+  CompOp     op_{OP_EQ};
+  BoundField lhs_{};
+  // the rhs is a column if rhs_is_column_, otherwise it is the only datum in rhs_values_, or all of them for IN
+  bool               rhs_is_column_{false};
+  BoundField         rhs_{};
+  std::vector<Datum> rhs_values_;
+  // holds the memory string datums in rhs_values_ point to
+  ValueSptr rhs_holder_;
+};
+
+using BoundConditionVec = std::vector<BoundCondition>;
+
 class ConditionExpr
 {
 public:
   ConditionExpr() = delete;
   DISABLE_COPY_MOVE_AND_ASSIGN(ConditionExpr);
 
-  static auto Eval(const ConditionVec &condition, const Record &record)-> bool;
+  /**
+   * Evaluate the conjunction of conditions on a record, owned records convert to views implicitly
+   * @param condition
+   * @param record
+   * @return
+   */
+  static auto Eval(const ConditionVec &condition, const RecordView &record) -> bool;
+
+  /**
+   * Resolve the columns of conditions once, so that evaluating them per record looks nothing up
+   * @param condition
+   * @param schema schema of the records the conditions are evaluated on
+   * @return
+   * @throw WSDB_FIELD_MISS if a column is not in the schema
+   */
+  static auto Bind(const ConditionVec &condition, const RecordSchema &schema) -> BoundConditionVec;
+
+  /// Evaluate the conjunction of bound conditions on a record of the schema they are bound to
+  static auto Eval(const BoundConditionVec &condition, const RecordView &record) -> bool;
 
 private:
-  static auto EvalCond(const Condition &condition, const Record &record) -> bool;
+  static auto EvalCond(const Condition &condition, const RecordView &record) -> bool;
 };
 
 }  // namespace wsdb
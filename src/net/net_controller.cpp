@@ -114,16 +114,15 @@ void NetController::SendRecHeader(int fd, const RecordSchema *header)
   memcpy(pkg_.buf_, header_str.c_str(), pkg_.len_);
   FlushSend(fd);
 }
-void NetController::SendRec(int fd, const Record *rec)
+void NetController::SendRec(int fd, const RecordView &rec)
 {
   // append record to buffer and flush if buffer is full
   auto &pkg_ = client_buffer_[fd];
   pkg_.type_ = net::NET_PKG_REC_BODY;
   // record format: {field_value}\t{field_value}\t ...
   std::string rec_str;
-  for (int i = 0; i < static_cast<int>(rec->GetSchema()->GetFieldCount()); ++i) {
-    auto v = rec->GetValueAt(i);
-    rec_str += v->ToString();
+  for (int i = 0; i < static_cast<int>(rec.GetSchema()->GetFieldCount()); ++i) {
+    rec_str += rec.GetDatumAt(i).ToString();
     rec_str += '\t';
   }
   // FIXME: accumulate records and send, may cause client waiting sometimes
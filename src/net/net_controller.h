@@ -43,7 +43,7 @@ public:
   void SendRecHeader(int fd, const RecordSchema *header);
 
   /// record will be stored until buffer is full and flush to socket
-  void SendRec(int fd, const Record *rec);
+  void SendRec(int fd, const RecordView &rec);
 
   void SendRecFinish(int fd);
 
@@ -54,6 +54,9 @@ auto Optimizer::LogicalOptimize(std::shared_ptr<AbstractPlan> plan, DatabaseHand
     join->right_ = LogicalOptimize(join->right_, db);
     return LogicalOptimizeJoin(join);
   } else if (auto agg = std::dynamic_pointer_cast<AggregatePlan>(plan)) {
+    if (auto meta_agg = LogicalOptimizeAggregate(agg, db)) {
+      return meta_agg;
+    }
     agg->child_ = LogicalOptimize(agg->child_, db);
     return agg;
   } else if (auto lim = std::dynamic_pointer_cast<LimitPlan>(plan)) {
@@ -73,10 +76,44 @@ auto Optimizer::LogicalOptimizeScan(const std::shared_ptr<ScanPlan> &scan, Condi
   std::shared_ptr<AbstractPlan> new_scan = scan;
   if (index != nullptr) {
     new_scan = std::make_shared<IdxScanPlan>(scan->table_name_, index->GetIndexId(), index_conds, max_matched_fields);
+  } else if (auto tab = db->GetTable(scan->table_name_); tab != nullptr && tab->GetPartitionScheme() != nullptr) {
+    // skip the partitions that can not hold rows satisfying the conditions
+    scan->partitions_ = tab->GetPartitionScheme()->Prune(conds);
   }
   return new_scan;
 }
 
+auto Optimizer::LogicalOptimizeAggregate(const std::shared_ptr<AggregatePlan> &agg, DatabaseHandle *db)
+    -> std::shared_ptr<AbstractPlan>
+{
+  // a filter below the aggregate means the header and zone maps do not describe the input
+  auto scan = std::dynamic_pointer_cast<ScanPlan>(agg->child_);
+  if (scan == nullptr || !agg->group_fields_.empty() || agg->agg_fields.empty()) {
+    return nullptr;
+  }
+  auto tab = db->GetTable(scan->table_name_);
+  if (tab == nullptr) {
+    return nullptr;
+  }
+  for (const auto &field : agg->agg_fields) {
+    if (field.agg_type_ == AGG_COUNT_STAR) {
+      continue;
+    }
+    if (field.agg_type_ != AGG_MIN && field.agg_type_ != AGG_MAX) {
+      return nullptr;
+    }
+    // records of slotted pages may be moved to other pages, and lsm and in-memory tables keep no zone map, see
+    // TableHandle::GetExtremum
+    auto field_idx = tab->GetSchema().GetFieldIndex(tab->GetTableId(), field.field_.field_name_);
+    if (tab->GetStorageModel() == SLOTTED_MODEL || tab->GetStorageModel() == LSM_MODEL ||
+        tab->GetStorageModel() == MEMORY_MODEL || field_idx == tab->GetSchema().GetFieldCount() ||
+        !tab->GetZoneMap().HasZone(field_idx)) {
+      return nullptr;
+    }
+  }
+  return std::make_shared<MetaAggregatePlan>(scan->table_name_, agg->agg_fields);
+}
+
 auto Optimizer::LogicalOptimizeJoin(std::shared_ptr<JoinPlan> join) -> std::shared_ptr<AbstractPlan>
 {
   if (join->strategy_ == NESTED_LOOP) {
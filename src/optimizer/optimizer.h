@@ -39,6 +39,16 @@ private:
   static auto LogicalOptimizeScan(const std::shared_ptr<ScanPlan> &scan, ConditionVec conds,
       wsdb::DatabaseHandle *db) -> std::shared_ptr<AbstractPlan>;
 
+  /**
+   * answer an ungrouped aggregate over a whole table without scanning it if all aggregates are COUNT(*), or MIN and
+   * MAX of columns covered by the zone map of a table whose records stay in the page they are counted in
+   * @param agg
+   * @param db
+   * @return MetaAggregatePlan replacing the aggregate and its scan, nullptr if the aggregate needs a scan
+   */
+  static auto LogicalOptimizeAggregate(const std::shared_ptr<AggregatePlan> &agg, DatabaseHandle *db)
+      -> std::shared_ptr<AbstractPlan>;
+
   static auto LogicalOptimizeJoin(std::shared_ptr<JoinPlan> join) -> std::shared_ptr<AbstractPlan>;
 
   static auto PhysicalOptimize(std::shared_ptr<AbstractPlan> plan, DatabaseHandle *db) -> std::shared_ptr<AbstractPlan>;
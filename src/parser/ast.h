@@ -92,8 +92,11 @@ struct ColDef : public Field
 {
   std::string              col_name_;
   std::shared_ptr<TypeLen> type_len_;
+  // ENCODING DICT, the values are stored as codes of a dictionary
+  bool dict_encoded_;
 
-  ColDef(std::string col_name, std::shared_ptr<TypeLen> &type_len) : col_name_(std::move(col_name)), type_len_(type_len)
+  ColDef(std::string col_name, std::shared_ptr<TypeLen> &type_len, bool dict_encoded = false)
+      : col_name_(std::move(col_name)), type_len_(type_len), dict_encoded_(dict_encoded)
   {}
 };
 
@@ -111,14 +114,23 @@ struct OpenDatabase : public TreeNode
   explicit OpenDatabase(std::string db_name) : db_name_(std::move(db_name)) {}
 };
 
+struct PartitionBy;
+
 struct CreateTable : public TreeNode
 {
   std::string                         tab_name_;
   std::vector<std::shared_ptr<Field>> fields_;
   StorageModel                        model_;
-
-  CreateTable(std::string tab_name, std::vector<std::shared_ptr<Field>> fields, StorageModel model)
-      : tab_name_(std::move(tab_name)), fields_(std::move(fields)), model_(model)
+  bool                                snapshot_;   // STORAGE = MEMORY SNAPSHOT, rows are kept across closes
+  std::shared_ptr<PartitionBy>        partition_;  // nullptr if the table is not partitioned
+
+  CreateTable(std::string tab_name, std::vector<std::shared_ptr<Field>> fields, StorageModel model, bool snapshot,
+      std::shared_ptr<PartitionBy> partition)
+      : tab_name_(std::move(tab_name)),
+        fields_(std::move(fields)),
+        model_(model),
+        snapshot_(snapshot),
+        partition_(std::move(partition))
   {}
 };
 
@@ -136,6 +148,21 @@ struct DescTable : public TreeNode
   DescTable(std::string tab_name) : tab_name_(std::move(tab_name)) {}
 };
 
+struct VacuumTable : public TreeNode
+{
+  std::string tab_name_;
+
+  explicit VacuumTable(std::string tab_name) : tab_name_(std::move(tab_name)) {}
+};
+
+struct DropPartition : public TreeNode
+{
+  std::string tab_name_;
+  int         partition_;
+
+  DropPartition(std::string tab_name, int partition) : tab_name_(std::move(tab_name)), partition_(partition) {}
+};
+
 struct CreateIndex : public TreeNode
 {
   std::string              tab_name_;
@@ -207,6 +234,18 @@ struct ArrLit : public Value
 struct NullLit : public Value
 {};
 
+struct PartitionBy : public TreeNode
+{
+  PartitionType                       type_;
+  std::string                         col_name_;
+  std::vector<std::shared_ptr<Value>> bounds_;  // for range partitioning
+  int                                 partition_num_;  // for hash partitioning
+
+  PartitionBy(PartitionType type, std::string col_name, std::vector<std::shared_ptr<Value>> bounds, int partition_num)
+      : type_(type), col_name_(std::move(col_name)), bounds_(std::move(bounds)), partition_num_(partition_num)
+  {}
+};
+
 struct Col : public Expr
 {
   std::string tab_name;
@@ -268,11 +307,21 @@ struct GroupBy : public TreeNode
 
 struct InsertStmt : public TreeNode
 {
-  std::string                         tab_name;
-  std::vector<std::shared_ptr<Value>> vals;
+  std::string                                      tab_name;
+  std::vector<std::vector<std::shared_ptr<Value>>> rows;
+
+  InsertStmt(std::string tab_name_, std::vector<std::vector<std::shared_ptr<Value>>> rows_)
+      : tab_name(std::move(tab_name_)), rows(std::move(rows_))
+  {}
+};
+
+struct CopyStmt : public TreeNode
+{
+  std::string tab_name;
+  std::string file_name;
 
-  InsertStmt(std::string tab_name_, std::vector<std::shared_ptr<Value>> vals_)
-      : tab_name(std::move(tab_name_)), vals(std::move(vals_))
+  CopyStmt(std::string tab_name_, std::string file_name_)
+      : tab_name(std::move(tab_name_)), file_name(std::move(file_name_))
   {}
 };
 
@@ -331,11 +380,13 @@ struct SelectStmt : public TreeNode
   std::vector<std::shared_ptr<BinaryExpr>> having;
 
   int limit;
+  // number of workers scanning each table
+  int parallel;
 
   SelectStmt(std::vector<std::shared_ptr<Col>> cols_, std::vector<std::shared_ptr<TreeNode>> tabs_,
       std::vector<std::shared_ptr<BinaryExpr>> conds_, std::shared_ptr<OrderBy> order_,
       std::shared_ptr<GroupBy> groupby_, std::vector<std::shared_ptr<BinaryExpr>> having_, JoinStrategy join_st_,
-      int limit_)
+      int limit_, int parallel_)
       : cols(std::move(cols_)),
         tabs(std::move(tabs_)),
         conds(std::move(conds_)),
@@ -343,7 +394,8 @@ struct SelectStmt : public TreeNode
         order(std::move(order_)),
         groupby(std::move(groupby_)),
         having(std::move(having_)),
-        limit(limit_)
+        limit(limit_),
+        parallel(parallel_)
   {
     has_sort    = (bool)order;
     has_groupby = (bool)groupby;
@@ -371,6 +423,8 @@ struct SemValue
 
   StorageModel sv_storage_model;
 
+  std::shared_ptr<PartitionBy> sv_partition;
+
   std::shared_ptr<TypeLen> sv_type_len;
 
   std::shared_ptr<Field>              sv_field;
@@ -381,6 +435,8 @@ struct SemValue
   std::shared_ptr<Value>              sv_val;
   std::vector<std::shared_ptr<Value>> sv_vals;
 
+  std::vector<std::vector<std::shared_ptr<Value>>> sv_val_rows;
+
   std::shared_ptr<AggCol>           sv_agg_col;
   std::shared_ptr<Col>              sv_col;
   std::vector<std::shared_ptr<Col>> sv_cols;
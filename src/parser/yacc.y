@@ -33,7 +33,8 @@ using namespace ast;
 
 // keywords
 %token EXPLAIN SHOW TABLES CREATE TABLE DROP DESC INSERT INTO VALUES DELETE FROM OPEN DATABASE ON ASC AS ORDER GROUP BY SUM AVG MAX MIN COUNT IN STATIC_CHECKPOINT USING NESTED_LOOP_JOIN SORT_MERGE_JOIN
-WHERE HAVING UPDATE SET SELECT INT CHAR FLOAT BOOL INDEX AND JOIN INNER OUTER EXIT HELP TXN_BEGIN TXN_COMMIT TXN_ABORT TXN_ROLLBACK ORDER_BY ENABLE_NESTLOOP ENABLE_SORTMERGE STORAGE PAX NARY LIMIT
+WHERE HAVING UPDATE SET SELECT INT CHAR FLOAT BOOL INDEX AND JOIN INNER OUTER EXIT HELP TXN_BEGIN TXN_COMMIT TXN_ABORT TXN_ROLLBACK ORDER_BY ENABLE_NESTLOOP ENABLE_SORTMERGE STORAGE PAX NARY SLOTTED MEMORY SNAPSHOT LSM VARCHAR LIMIT COPY VACUUM
+ALTER PARTITION PARTITIONS RANGE HASH PARALLEL ENCODING DICT
 // non-keywords
 %token LEQ NEQ GEQ T_EOF
 
@@ -51,10 +52,13 @@ WHERE HAVING UPDATE SET SELECT INT CHAR FLOAT BOOL INDEX AND JOIN INNER OUTER EX
 %type <sv_type_len> type
 %type <sv_comp_op> op
 %type <sv_storage_model> optStorageModel
-%type <sv_int> optLimit
+%type <sv_bool> optSnapshot
+%type <sv_partition> optPartition
+%type <sv_int> optLimit optParallel
 %type <sv_expr> expr
 %type <sv_val> value
 %type <sv_vals> valueList
+%type <sv_val_rows> valueRows
 %type <sv_str> tbName colName optAlias
 %type <sv_strs> colNameList
 %type <sv_node_arr> tableList
@@ -156,9 +160,9 @@ indexStmt:
     }
 
 ddl:
-        CREATE TABLE tbName '(' fieldList ')' optStorageModel
+        CREATE TABLE tbName '(' fieldList ')' optStorageModel optSnapshot optPartition
     {
-        $$ = std::make_shared<CreateTable>($3, $5, $7);
+        $$ = std::make_shared<CreateTable>($3, $5, $7, $8, $9);
     }
     |   DROP TABLE tbName
     {
@@ -168,6 +172,14 @@ ddl:
     {
         $$ = std::make_shared<DescTable>($2);
     }
+    |   VACUUM tbName
+    {
+        $$ = std::make_shared<VacuumTable>($2);
+    }
+    |   ALTER TABLE tbName DROP PARTITION VALUE_INT
+    {
+        $$ = std::make_shared<DropPartition>($3, $6);
+    }
     |   CREATE INDEX tbName '(' colNameList ')'
     {
         $$ = std::make_shared<CreateIndex>($3, $5);
@@ -184,12 +196,36 @@ optStorageModel:
     { $$ = NARY_MODEL; }
     | STORAGE '=' PAX
     { $$ = PAX_MODEL; }
+    | STORAGE '=' SLOTTED
+    { $$ = SLOTTED_MODEL; }
+    | STORAGE '=' MEMORY
+    { $$ = MEMORY_MODEL; }
+    | STORAGE '=' LSM
+    { $$ = LSM_MODEL; }
+    ;
+
+optSnapshot:
+    /* epsilon */ { $$ = false; }
+    | SNAPSHOT
+    { $$ = true; }
+    ;
+
+optPartition:
+    /* epsilon */ { $$ = nullptr; }
+    | PARTITION BY RANGE '(' colName ')' '(' valueList ')'
+    { $$ = std::make_shared<PartitionBy>(RANGE_PARTITION, $5, $8, 0); }
+    | PARTITION BY HASH '(' colName ')' PARTITIONS VALUE_INT
+    { $$ = std::make_shared<PartitionBy>(HASH_PARTITION, $5, std::vector<std::shared_ptr<Value>>{}, $8); }
     ;
 
 dml:
-        INSERT INTO tbName VALUES '(' valueList ')'
+        INSERT INTO tbName VALUES valueRows
+    {
+        $$ = std::make_shared<InsertStmt>($3, $5);
+    }
+    |   COPY tbName FROM VALUE_STRING
     {
-        $$ = std::make_shared<InsertStmt>($3, $6);
+        $$ = std::make_shared<CopyStmt>($2, $4);
     }
     |   DELETE FROM tbName optWhereClause
     {
@@ -206,9 +242,9 @@ dml:
     ;
 
 selectStmt:
-        SELECT selector FROM tableList optWhereClause opt_order_clause optGroupByClause optHavingClause optUsingJoinClause optLimit
+        SELECT selector FROM tableList optWhereClause opt_order_clause optGroupByClause optHavingClause optUsingJoinClause optLimit optParallel
     {
-        $$ = std::make_shared<SelectStmt>($2, $4, $5, $6, $7, $8, $9, $10);
+        $$ = std::make_shared<SelectStmt>($2, $4, $5, $6, $7, $8, $9, $10, $11);
     }
     ;
 
@@ -220,6 +256,14 @@ optLimit:
     | /* epsilon */ { $$ = -1; }
     ;
 
+optParallel:
+    PARALLEL VALUE_INT
+    {
+        $$ = $2;
+    }
+    | /* epsilon */ { $$ = 1; }
+    ;
+
 fieldList:
         field
     {
@@ -247,6 +291,10 @@ field:
     {
         $$ = std::make_shared<ColDef>($1, $2);
     }
+    |   colName type ENCODING DICT
+    {
+        $$ = std::make_shared<ColDef>($1, $2, true);
+    }
     ;
 
 type:
@@ -262,6 +310,11 @@ type:
     {
         $$ = std::make_shared<TypeLen>(TYPE_STRING, $3);
     }
+    |   VARCHAR '(' VALUE_INT ')'
+    {
+        // strings are zero padded in records, slotted pages store them without the padding
+        $$ = std::make_shared<TypeLen>(TYPE_STRING, $3);
+    }
     |   FLOAT
     {
         $$ = std::make_shared<TypeLen>(TYPE_FLOAT, sizeof(float));
@@ -279,6 +332,17 @@ valueList:
     }
     ;
 
+valueRows:
+        '(' valueList ')'
+    {
+        $$ = std::vector<std::vector<std::shared_ptr<Value>>>{$2};
+    }
+    |   valueRows ',' '(' valueList ')'
+    {
+        $$.push_back($4);
+    }
+    ;
+
 value:
         VALUE_INT
     {
@@ -21,8 +21,10 @@
 
 #ifndef WSDB_PLAN_H
 #define WSDB_PLAN_H
+#include <optional>
 #include <utility>
 
+#include "system/handle/partition.h"
 #include "system/handle/record_handle.h"
 #include "common/condition.h"
 
@@ -70,18 +72,32 @@ public:
 class CreateTablePlan : public AbstractPlan
 {
 public:
-  CreateTablePlan(std::string table_name, RecordSchemaUptr schema, StorageModel storage)
-      : table_name_(std::move(table_name)), schema_(std::move(schema)), storage_(storage)
+  CreateTablePlan(std::string table_name, RecordSchemaUptr schema, StorageModel storage,
+      PartitionSchemeUptr partition_scheme, bool memory_snapshot = false)
+      : table_name_(std::move(table_name)),
+        schema_(std::move(schema)),
+        storage_(storage),
+        partition_scheme_(std::move(partition_scheme)),
+        memory_snapshot_(memory_snapshot)
   {}
 
   auto ToString(int level) const -> std::string override
   {
+    if (partition_scheme_ != nullptr) {
+      return fmt::format("{}CreateTablePlan [{}] <{}> {}",
+          TAB_STR(level),
+          table_name_,
+          schema_->ToString(),
+          partition_scheme_->ToString());
+    }
     return fmt::format("{}CreateTablePlan [{}] <{}>", TAB_STR(level), table_name_, schema_->ToString());
   }
 
-  std::string      table_name_;
-  RecordSchemaUptr schema_;
-  StorageModel     storage_;
+  std::string         table_name_;
+  RecordSchemaUptr    schema_;
+  StorageModel        storage_;
+  PartitionSchemeUptr partition_scheme_;  // nullptr if the table is not partitioned
+  bool                memory_snapshot_;   // rows of an in-memory table are written to its file on close
 };
 
 class DropTablePlan : public AbstractPlan
@@ -108,6 +124,31 @@ public:
   std::string table_name_;
 };
 
+class VacuumPlan : public AbstractPlan
+{
+public:
+  explicit VacuumPlan(std::string table_name) : table_name_(std::move(table_name)) {}
+  auto ToString(int level) const -> std::string override
+  {
+    return fmt::format("{}VacuumPlan [{}]", TAB_STR(level), table_name_);
+  }
+  std::string table_name_;
+};
+
+class DropPartitionPlan : public AbstractPlan
+{
+public:
+  DropPartitionPlan(std::string table_name, size_t partition)
+      : table_name_(std::move(table_name)), partition_(partition)
+  {}
+  auto ToString(int level) const -> std::string override
+  {
+    return fmt::format("{}DropPartitionPlan [{}] <{}>", TAB_STR(level), table_name_, partition_);
+  }
+  std::string table_name_;
+  size_t      partition_;
+};
+
 class ShowTablesPlan : public AbstractPlan
 {
   auto ToString(int level) const -> std::string override { return fmt::format("{}ShowTablesPlan", TAB_STR(level)); }
@@ -116,21 +157,39 @@ class ShowTablesPlan : public AbstractPlan
 class InsertPlan : public AbstractPlan
 {
 public:
-  InsertPlan(std::string table_name, std::vector<ValueSptr> values)
-      : table_name_(std::move(table_name)), values_(std::move(values))
+  InsertPlan(std::string table_name, std::vector<std::vector<ValueSptr>> rows)
+      : table_name_(std::move(table_name)), rows_(std::move(rows))
   {}
   auto ToString(int level) const -> std::string override
   {
-    std::string value_str;
-    for (const auto &value : values_) {
-      value_str += value->ToString() + ", ";
+    std::string rows_str;
+    for (const auto &row : rows_) {
+      std::string value_str;
+      for (const auto &value : row) {
+        value_str += value->ToString() + ", ";
+      }
+      value_str.back() = ')';
+      rows_str += "(" + value_str + ", ";
     }
-    value_str.back() = ')';
-    value_str        = "(" + value_str;
-    return fmt::format("{}InsertPlan [{}] <{}>", TAB_STR(level), table_name_, value_str);
+    rows_str.resize(rows_str.size() - 2);
+    return fmt::format("{}InsertPlan [{}] <{}>", TAB_STR(level), table_name_, rows_str);
+  }
+  std::string                         table_name_;
+  std::vector<std::vector<ValueSptr>> rows_;
+};
+
+class CopyPlan : public AbstractPlan
+{
+public:
+  CopyPlan(std::string table_name, std::string file_name)
+      : table_name_(std::move(table_name)), file_name_(std::move(file_name))
+  {}
+  auto ToString(int level) const -> std::string override
+  {
+    return fmt::format("{}CopyPlan [{}] <{}>", TAB_STR(level), table_name_, file_name_);
   }
-  std::string            table_name_;
-  std::vector<ValueSptr> values_;
+  std::string table_name_;
+  std::string file_name_;
 };
 
 class UpdatePlan : public AbstractPlan
@@ -195,9 +254,23 @@ public:
   explicit ScanPlan(std::string table_name) : table_name_(std::move(table_name)) {}
   auto ToString(int level) const -> std::string override
   {
+    if (partitions_.has_value()) {
+      std::string partition_str;
+      for (const auto &partition : *partitions_) {
+        partition_str += (partition_str.empty() ? "" : ", ") + std::to_string(partition);
+      }
+      return fmt::format("{}ScanPlan [{}] <partitions: {}>", TAB_STR(level), table_name_, partition_str);
+    }
+    if (parallel_ > 1) {
+      return fmt::format("{}ScanPlan [{}] <parallel: {}>", TAB_STR(level), table_name_, parallel_);
+    }
     return fmt::format("{}ScanPlan [{}]", TAB_STR(level), table_name_);
   }
   std::string table_name_;
+  // partitions left after pruning, all partitions if not set
+  std::optional<std::vector<size_t>> partitions_;
+  // number of workers asked for by the query, the scan and the filter and projection above it run in parallel if > 1
+  size_t parallel_{1};
 };
 
 class IdxScanPlan : public AbstractPlan
@@ -322,6 +395,27 @@ public:
   std::vector<RTField>          agg_fields;
 };
 
+/// ungrouped COUNT(*), MIN and MAX over a whole table, answered from the table header and zone maps without a scan
+class MetaAggregatePlan : public AbstractPlan
+{
+public:
+  MetaAggregatePlan(std::string table_name, std::vector<RTField> agg_fields)
+      : table_name_(std::move(table_name)), agg_fields_(std::move(agg_fields))
+  {}
+  auto ToString(int level) const -> std::string override
+  {
+    std::string agg_fields_str;
+    for (const auto &field : agg_fields_) {
+      agg_fields_str += field.ToString() + ", ";
+    }
+    agg_fields_str.pop_back();
+    agg_fields_str.pop_back();
+    return fmt::format("{}MetaAggregatePlan [{}] <agg fields: {}>", TAB_STR(level), table_name_, agg_fields_str);
+  }
+  std::string          table_name_;
+  std::vector<RTField> agg_fields_;
+};
+
 class LimitPlan : public AbstractPlan
 {
 public:
@@ -52,12 +52,21 @@ std::shared_ptr<AbstractPlan> Planner::PlanAST(const std::shared_ptr<ast::TreeNo
   }
   /// insert
   if (const auto ins = std::dynamic_pointer_cast<ast::InsertStmt>(ast)) {
-    std::vector<ValueSptr> values;
-    values.reserve(ins->vals.size());
-    for (const auto &v : ins->vals) {
-      values.push_back(TransformValue(v));
+    std::vector<std::vector<ValueSptr>> rows;
+    rows.reserve(ins->rows.size());
+    for (const auto &row : ins->rows) {
+      std::vector<ValueSptr> values;
+      values.reserve(row.size());
+      for (const auto &v : row) {
+        values.push_back(TransformValue(v));
+      }
+      rows.push_back(std::move(values));
     }
-    return std::make_shared<InsertPlan>(ins->tab_name, values);
+    return std::make_shared<InsertPlan>(ins->tab_name, std::move(rows));
+  }
+  /// copy
+  if (const auto copy = std::dynamic_pointer_cast<ast::CopyStmt>(ast)) {
+    return std::make_shared<CopyPlan>(copy->tab_name, copy->file_name);
   }
   /// update
   if (const auto upd = std::dynamic_pointer_cast<ast::UpdateStmt>(ast)) {
@@ -84,8 +93,21 @@ std::shared_ptr<AbstractPlan> Planner::PlanAST(const std::shared_ptr<ast::TreeNo
   }
   /// create table
   if (const auto ctab = std::dynamic_pointer_cast<ast::CreateTable>(ast)) {
-    auto schema = CreateRecordSchema(ctab->fields_, ctab->tab_name_, db);
-    return std::make_shared<CreateTablePlan>(ctab->tab_name_, std::move(schema), ctab->model_);
+    auto                schema = CreateRecordSchema(ctab->fields_, ctab->tab_name_, db);
+    PartitionSchemeUptr partition_scheme;
+    if (const auto &part = ctab->partition_; part != nullptr) {
+      std::vector<ValueSptr> bounds;
+      for (const auto &bound : part->bounds_) {
+        bounds.push_back(TransformValue(bound));
+      }
+      // a negative number of partitions turns huge and is rejected when the scheme is bound
+      auto partition_num =
+          part->type_ == RANGE_PARTITION ? bounds.size() + 1 : static_cast<size_t>(part->partition_num_);
+      partition_scheme =
+          std::make_unique<PartitionScheme>(part->type_, part->col_name_, partition_num, std::move(bounds));
+    }
+    return std::make_shared<CreateTablePlan>(
+        ctab->tab_name_, std::move(schema), ctab->model_, std::move(partition_scheme), ctab->snapshot_);
   }
   /// drop table
   if (const auto dtab = std::dynamic_pointer_cast<ast::DropTable>(ast)) {
@@ -95,6 +117,14 @@ std::shared_ptr<AbstractPlan> Planner::PlanAST(const std::shared_ptr<ast::TreeNo
   if (const auto desc = std::dynamic_pointer_cast<ast::DescTable>(ast)) {
     return std::make_shared<DescTablePlan>(desc->tab_name_);
   }
+  /// vacuum table
+  if (const auto vac = std::dynamic_pointer_cast<ast::VacuumTable>(ast)) {
+    return std::make_shared<VacuumPlan>(vac->tab_name_);
+  }
+  /// drop partition
+  if (const auto dpart = std::dynamic_pointer_cast<ast::DropPartition>(ast)) {
+    return std::make_shared<DropPartitionPlan>(dpart->tab_name_, static_cast<size_t>(dpart->partition_));
+  }
   /// show tables
   if (const auto stab = std::dynamic_pointer_cast<ast::ShowTables>(ast)) {
     return std::make_shared<ShowTablesPlan>();
@@ -125,6 +155,9 @@ std::shared_ptr<AbstractPlan> Planner::PlanAST(const std::shared_ptr<ast::TreeNo
 auto Planner::AnalyseSelect(const std::shared_ptr<ast::SelectStmt> &sel, wsdb::DatabaseHandle *db,
     std::vector<std::string> &tabs) -> std::shared_ptr<AbstractPlan>
 {
+  if (sel->parallel < 1) {
+    WSDB_THROW(WSDB_GRAMMAR_ERROR, fmt::format("PARALLEL {}, expect at least 1 worker", sel->parallel));
+  }
   std::vector<RTField>          sel_fields;
   bool                          is_agg   = false;
   std::shared_ptr<AbstractPlan> sub_plan = nullptr;
@@ -193,7 +226,7 @@ auto Planner::AnalyseSelect(const std::shared_ptr<ast::SelectStmt> &sel, wsdb::D
     return MakeProjSortPlan(plan, sel_fields, order_fields, is_desc);
   } else if (tabs.size() == 1) {
     /// single table without sub query or joins
-    auto plan = MakeFilterScanPlan(tabs[0], where);
+    auto plan = MakeFilterScanPlan(tabs[0], where, sel->parallel);
     if (is_agg) {
       plan = MakeAggregatePlan(plan, group_fields, sel_fields, having);
     }
@@ -207,8 +240,8 @@ auto Planner::AnalyseSelect(const std::shared_ptr<ast::SelectStmt> &sel, wsdb::D
       auto                          join_cond  = GetConditionsForJoin(join_expr->left, join_expr->right, where, db);
       auto                          left_cond  = GetConditionsForTable(join_expr->left, where, db);
       auto                          right_cond = GetConditionsForTable(join_expr->right, where, db);
-      std::shared_ptr<AbstractPlan> left_plan  = MakeFilterScanPlan(join_expr->left, left_cond);
-      std::shared_ptr<AbstractPlan> right_plan = MakeFilterScanPlan(join_expr->right, right_cond);
+      std::shared_ptr<AbstractPlan> left_plan  = MakeFilterScanPlan(join_expr->left, left_cond, sel->parallel);
+      std::shared_ptr<AbstractPlan> right_plan = MakeFilterScanPlan(join_expr->right, right_cond, sel->parallel);
       std::shared_ptr<AbstractPlan> sum_plan   = std::make_shared<JoinPlan>(
           std::move(left_plan), std::move(right_plan), join_cond, join_expr->type, sel->join_strategy);
       if (is_agg) {
@@ -220,7 +253,7 @@ auto Planner::AnalyseSelect(const std::shared_ptr<ast::SelectStmt> &sel, wsdb::D
       auto join_tabs      = tabs;
       auto right_tab_name = join_tabs.back();
       auto right_cond     = GetConditionsForTable(right_tab_name, where, db);
-      auto right_plan     = MakeFilterScanPlan(right_tab_name, right_cond);
+      auto right_plan     = MakeFilterScanPlan(right_tab_name, right_cond, sel->parallel);
       join_tabs.pop_back();
       std::vector<std::string> right_tree_tables{right_tab_name};
       // NOTE: the generated join tree is not balanced
@@ -233,7 +266,7 @@ auto Planner::AnalyseSelect(const std::shared_ptr<ast::SelectStmt> &sel, wsdb::D
           join_cond.insert(join_cond.end(), join_cond_tmp.begin(), join_cond_tmp.end());
         }
         auto left_cond = GetConditionsForTable(left_tab_name, where, db);
-        auto left_plan = MakeFilterScanPlan(left_tab_name, left_cond);
+        auto left_plan = MakeFilterScanPlan(left_tab_name, left_cond, sel->parallel);
         right_plan     = std::make_shared<JoinPlan>(
             std::move(left_plan), std::move(right_plan), join_cond, INNER_JOIN, sel->join_strategy);
         join_tabs.pop_back();
@@ -341,14 +374,18 @@ auto Planner::CreateRecordSchema(const std::vector<std::shared_ptr<ast::Field>>
       WSDB_FETAL("Invalid field definition");
     }
     FieldSchema fs;
-    fs.field_name_ = col_def->col_name_;
-    fs.field_type_ = col_def->type_len_->type_;
-    fs.field_size_ = col_def->type_len_->len_;
-    auto tbl       = db->GetTable(tab_name);
-    fs.table_id_   = tbl != nullptr ? tbl->GetTableId() : INVALID_TABLE_ID;
+    fs.field_name_   = col_def->col_name_;
+    fs.field_type_   = col_def->type_len_->type_;
+    fs.field_size_   = col_def->type_len_->len_;
+    fs.dict_encoded_ = col_def->dict_encoded_;
+    auto tbl         = db->GetTable(tab_name);
+    fs.table_id_     = tbl != nullptr ? tbl->GetTableId() : INVALID_TABLE_ID;
     if (fs.field_size_ == 0) {
       WSDB_THROW(WSDB_GRAMMAR_ERROR, "Field size cannot be 0");
     }
+    if (fs.dict_encoded_ && fs.field_type_ != TYPE_STRING) {
+      WSDB_THROW(WSDB_GRAMMAR_ERROR, fmt::format("ENCODING DICT of non-string field {}", fs.field_name_));
+    }
     rt_fields.push_back({.field_ = fs});
   }
   return std::make_unique<RecordSchema>(rt_fields);
@@ -446,10 +483,11 @@ auto Planner::GetConditionsForTable(
   return ret;
 }
 
-auto Planner::MakeFilterScanPlan(
-    const std::string &tab_name, const ConditionVec &conds) -> std::shared_ptr<AbstractPlan>
+auto Planner::MakeFilterScanPlan(const std::string &tab_name, const ConditionVec &conds, size_t parallel)
+    -> std::shared_ptr<AbstractPlan>
 {
-  auto scan_plan = std::make_shared<ScanPlan>(tab_name);
+  auto scan_plan       = std::make_shared<ScanPlan>(tab_name);
+  scan_plan->parallel_ = parallel;
   if (conds.empty()) {
     return scan_plan;
   }
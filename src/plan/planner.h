@@ -76,8 +76,9 @@ private:
   static auto GetConditionsForTable(
       const std::string &tab_name, const ConditionVec &conds, DatabaseHandle *db) -> ConditionVec;
 
-  static auto MakeFilterScanPlan(
-      const std::string &tab_name, const ConditionVec &conds) -> std::shared_ptr<AbstractPlan>;
+  /// @param parallel number of workers the scan is asked to run with
+  static auto MakeFilterScanPlan(const std::string &tab_name, const ConditionVec &conds, size_t parallel = 1)
+      -> std::shared_ptr<AbstractPlan>;
 
   static auto MakeAggregatePlan(std::shared_ptr<AbstractPlan> &child, const std::vector<RTField> &group_fields,
       const std::vector<RTField> &proj_fields, const ConditionVec &havings) -> std::shared_ptr<AbstractPlan>;
@@ -21,20 +21,22 @@
 #include "buffer_pool_manager.h"
 #include "replacer/lru_replacer.h"
 #include "replacer/lru_k_replacer.h"
+#include "memory_broker.h"
 
 #include "../../../common/error.h"
 
 namespace wsdb {
 
-BufferPoolManager::BufferPoolManager(DiskManager *disk_manager, LogManager *log_manager, size_t replacer_lru_k)
+BufferPoolManager::BufferPoolManager(
+    DiskManager *disk_manager, LogManager *log_manager, size_t replacer_lru_k, const std::string &replacer)
     : disk_manager_(disk_manager), log_manager_(log_manager)
 {
-  if (REPLACER == "LRUReplacer") {
+  if (replacer == "LRUReplacer") {
     replacer_ = std::make_unique<LRUReplacer>();
-  } else if (REPLACER == "LRUKReplacer") {
+  } else if (replacer == "LRUKReplacer") {
     replacer_ = std::make_unique<LRUKReplacer>(replacer_lru_k);
   } else {
-    WSDB_FETAL("Unknown replacer: " + REPLACER);
+    WSDB_FETAL("Unknown replacer: " + replacer);
   }
   // init free_list_
   for (frame_id_t i = 0; i < static_cast<int>(BUFFER_POOL_SIZE); i++) {
@@ -45,18 +47,27 @@ BufferPoolManager::BufferPoolManager(DiskManager *disk_manager, LogManager *log_
 auto BufferPoolManager::FetchPage(file_id_t fid, page_id_t pid) -> Page *
 {
   // WSDB_STUDENT_TODO(l1, t2);
-  std::lock_guard<std::mutex> lock{latch_};
+  std::unique_lock<std::mutex> lock{latch_};
 
-  fid_pid_t  fp{fid, pid};
+  if (trace_file_ != nullptr) {
+    *trace_file_ << fid << ' ' << pid << '\n';
+  }
+  fid_pid_t fp{fid, pid};
+  auto      lookup_it{page_frame_lookup_.find(fp)};
+  // the latch is released while lent frames are reclaimed, the page may have been fetched by others meanwhile
+  while (lookup_it == page_frame_lookup_.end() && ReclaimFrames(lock)) {
+    lookup_it = page_frame_lookup_.find(fp);
+  }
   frame_id_t frame_id;
-  auto       lookup_it{page_frame_lookup_.find(fp)};
   if (lookup_it != page_frame_lookup_.end()) {
     frame_id = lookup_it->second;
     replacer_->Pin(frame_id);
     frames_[frame_id].Pin();
+    hit_count_.fetch_add(1, std::memory_order_relaxed);
   } else {
     frame_id = GetAvailableFrame();
     UpdateFrame(frame_id, fid, pid);
+    miss_count_.fetch_add(1, std::memory_order_relaxed);
   }
 
   return frames_[frame_id].GetPage();
@@ -195,6 +206,19 @@ auto BufferPoolManager::GetAvailableFrame() -> frame_id_t
   return frame_id;
 }
 
+auto BufferPoolManager::ReclaimFrames(std::unique_lock<std::mutex> &lock) -> bool
+{
+  if (!free_list_.empty() || replacer_->Size() > 0 || memory_broker_ == nullptr || lent_frames_.empty()) {
+    return false;
+  }
+  auto memory_broker = memory_broker_;
+  // the frames are returned through ReturnFrames, which takes the latch
+  lock.unlock();
+  auto reclaimed = memory_broker->Reclaim(1);
+  lock.lock();
+  return reclaimed > 0;
+}
+
 void BufferPoolManager::UpdateFrame(frame_id_t frame_id, file_id_t fid, page_id_t pid)
 {
   // WSDB_STUDENT_TODO(l1, t2);
@@ -216,6 +240,76 @@ void BufferPoolManager::UpdateFrame(frame_id_t frame_id, file_id_t fid, page_id_
   replacer_->Pin(frame_id);
 }
 
+void BufferPoolManager::SetMemoryBroker(MemoryBroker *memory_broker)
+{
+  std::lock_guard<std::mutex> lock{latch_};
+  // lent frames are still used by operators, the broker refuses to switch until they are returned
+  WSDB_ASSERT(lent_frames_.empty(), "frames are still lent to the memory broker");
+  memory_broker_ = memory_broker;
+}
+
+auto BufferPoolManager::LendFrames(size_t frame_num) -> std::vector<char *>
+{
+  std::lock_guard<std::mutex> lock{latch_};
+
+  std::vector<frame_id_t> frame_ids;
+  for (; frame_ids.size() < frame_num && !free_list_.empty(); free_list_.pop_front()) {
+    frame_ids.push_back(free_list_.front());
+  }
+  frame_id_t frame_id;
+  while (frame_ids.size() < frame_num && replacer_->Victim(&frame_id)) {
+    Frame &frame{frames_[frame_id]};
+    Page  &page{*frame.GetPage()};
+    if (frame.IsDirty()) {
+      disk_manager_->WritePage(page.GetFileId(), page.GetPageId(), page.GetData());
+    }
+    page_frame_lookup_.erase(fid_pid_t{page.GetFileId(), page.GetPageId()});
+    frame.Reset();
+    frame_ids.push_back(frame_id);
+  }
+  std::vector<char *> frames;
+  for (auto id : frame_ids) {
+    frames.push_back(frames_[id].GetPage()->GetData());
+    lent_frames_.emplace(frames.back(), id);
+  }
+  return frames;
+}
+
+void BufferPoolManager::ReturnFrames(const std::vector<char *> &frames)
+{
+  std::lock_guard<std::mutex> lock{latch_};
+
+  for (auto data : frames) {
+    auto iter = lent_frames_.find(data);
+    WSDB_ASSERT(iter != lent_frames_.end(), "return a frame that is not lent");
+    // the operator has overwritten the page, it is cleared so that no stale page id is looked up on reuse
+    frames_[iter->second].Reset();
+    free_list_.push_back(iter->second);
+    lent_frames_.erase(iter);
+  }
+}
+
+void BufferPoolManager::SetTraceFile(const std::string &file_name)
+{
+  std::lock_guard<std::mutex> lock{latch_};
+  if (file_name.empty()) {
+    trace_file_ = nullptr;
+    return;
+  }
+  trace_file_ = std::make_unique<std::ofstream>(file_name, std::ios::out | std::ios::app);
+  if (!trace_file_->is_open()) {
+    trace_file_ = nullptr;
+    WSDB_THROW(WSDB_FILE_NOT_OPEN, file_name);
+  }
+}
+
+auto BufferPoolManager::GetPinCount(file_id_t fid, page_id_t pid) -> int
+{
+  std::lock_guard<std::mutex> lock{latch_};
+  const auto                  it = page_frame_lookup_.find({fid, pid});
+  return it == page_frame_lookup_.end() ? 0 : frames_[it->second].GetPinCount();
+}
+
 auto BufferPoolManager::GetFrame(file_id_t fid, page_id_t pid) -> Frame *
 {
   const auto it = page_frame_lookup_.find({fid, pid});
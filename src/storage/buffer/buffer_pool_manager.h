@@ -22,6 +22,8 @@
 #ifndef WSDB_BUFFER_POOL_MANAGER_H
 #define WSDB_BUFFER_POOL_MANAGER_H
 
+#include <atomic>
+#include <fstream>
 #include <list>
 #include <memory>
 #include <mutex>  // NOLINT
@@ -56,10 +58,19 @@ struct hash<wsdb::fid_pid_t>
 
 namespace wsdb {
 
+class MemoryBroker;
+
 class BufferPoolManager
 {
 public:
-  explicit BufferPoolManager(DiskManager *disk_manager, LogManager *log_manager = nullptr, size_t replacer_lru_k = 0);
+  /**
+   * @param disk_manager
+   * @param log_manager
+   * @param replacer_lru_k k of LRUKReplacer
+   * @param replacer name of the replacer, "LRUReplacer" or "LRUKReplacer", REPLACER in common/config.h by default
+   */
+  explicit BufferPoolManager(DiskManager *disk_manager, LogManager *log_manager = nullptr, size_t replacer_lru_k = 0,
+      const std::string &replacer = REPLACER);
 
   ~BufferPoolManager() = default;
 
@@ -69,7 +80,7 @@ public:
    * Fetch the requested page from disk.
    * 1. grant the latch
    * 2. check if the page is in the frame
-   * 3. if the page is not in the frame, GetAvailableFrame and UpdateFrame
+   * 3. if the page is not in the frame, ReclaimFrames if none is available, then GetAvailableFrame and UpdateFrame
    * 4. else pin the frame both in the buffer and the replacer and return the page
    * @param fid file that the page belongs to
    * @param pid page id
@@ -128,12 +139,56 @@ public:
    */
   auto FlushAllPages(file_id_t fid) -> bool;
 
+  /**
+   * Get the number of pins on the page
+   * 1. grant the latch
+   * 2. return 0 if the page is not in the buffer, else the pin count of its frame
+   * @param fid
+   * @param pid
+   * @return number of pins, the pins of the caller included
+   */
+  auto GetPinCount(file_id_t fid, page_id_t pid) -> int;
+
   /**
    * Get the frame, used for test
    * 无锁，因此原则上不应使用
    */
   auto GetFrame(file_id_t fid, page_id_t pid) -> Frame *;
 
+  /**
+   * Set the memory broker that frames are lent to, called by MemoryBroker::RegisterBufferPool
+   * @param memory_broker nullptr if the buffer pool is unregistered
+   */
+  void SetMemoryBroker(MemoryBroker *memory_broker);
+
+  /**
+   * Lend idle frames to the memory broker, the memory of a lent frame is used by an operator and does not cache pages
+   * until it is returned
+   * 1. grant the latch
+   * 2. take frames from the free list first, then evict unpinned frames chosen by the replacer
+   * @param frame_num number of frames wanted
+   * @return data of the lent frames, PAGE_SIZE bytes each, fewer than frame_num if the other frames are pinned
+   */
+  auto LendFrames(size_t frame_num) -> std::vector<char *>;
+
+  /**
+   * Take back frames lent to the memory broker and put them into the free list
+   * @param frames data of the frames returned by LendFrames
+   */
+  void ReturnFrames(const std::vector<char *> &frames);
+
+  /**
+   * Record every page access as a "fid pid" line, so that real workloads can be replayed by the buffer pool benchmark
+   * @param file_name trace file, empty to stop tracing
+   */
+  void SetTraceFile(const std::string &file_name);
+
+  /// number of FetchPage calls that found the page in the buffer
+  [[nodiscard]] auto GetHitCount() const -> size_t { return hit_count_; }
+
+  /// number of FetchPage calls that read the page from disk
+  [[nodiscard]] auto GetMissCount() const -> size_t { return miss_count_; }
+
 private:
   /// sub procedures used by public APIs, should not be locked by latch
 
@@ -146,6 +201,16 @@ private:
    */
   auto GetAvailableFrame() -> frame_id_t;
 
+  /**
+   * Reclaim frames lent to operators when the free list is empty and every frame is pinned
+   * 1. return false if a frame is available or no frame is lent
+   * 2. release the latch and ask the memory broker to make operators spill and return their frames
+   * 3. grant the latch again
+   * @param lock the lock holding latch_
+   * @return true if frames are returned, the caller looks the page up again since the latch has been released
+   */
+  auto ReclaimFrames(std::unique_lock<std::mutex> &lock) -> bool;
+
   /**
    * Update the frame
    * 1. if the frame is dirty, flush the page to disk
@@ -165,6 +230,11 @@ private:
   std::unique_ptr<Replacer>                 replacer_;
   std::array<Frame, BUFFER_POOL_SIZE>       frames_;
   std::list<frame_id_t>                     free_list_;
+  std::unordered_map<char *, frame_id_t>    lent_frames_;  // frames lent to the memory broker by their data
+  MemoryBroker                             *memory_broker_{nullptr};
+  std::atomic<size_t>                       hit_count_{0};
+  std::atomic<size_t>                       miss_count_{0};
+  std::unique_ptr<std::ofstream>            trace_file_;
   std::unordered_map<fid_pid_t, frame_id_t> page_frame_lookup_;
 };
 
@@ -0,0 +1,171 @@
+/*------------------------------------------------------------------------------
+ - Copyright (c) 2024. Websoft research group, Nanjing University.
+ -
+ - This program is free software: you can redistribute it and/or modify
+ - it under the terms of the GNU General Public License as published by
+ - the Free Software Foundation, either version 3 of the License, or
+ - (at your option) any later version.
+ -
+ - This program is distributed in the hope that it will be useful,
+ - but WITHOUT ANY WARRANTY; without even the implied warranty of
+ - MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ - GNU General Public License for more details.
+ -
+ - You should have received a copy of the GNU General Public License
+ - along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ -----------------------------------------------------------------------------*/
+
+//
+// Created by ziqi on 2024/9/2.
+//
+#include "memory_broker.h"
+#include "buffer_pool_manager.h"
+
+#include "../../../common/error.h"
+
+namespace wsdb {
+
+void MemoryBroker::RegisterBufferPool(BufferPoolManager *bpm, size_t frame_num)
+{
+  bpm->SetMemoryBroker(this);
+  std::lock_guard<std::mutex> lock{latch_};
+  WSDB_ASSERT(frame_num * PAGE_SIZE <= budget_, "buffer pool exceeds the memory budget");
+  WSDB_ASSERT(lent_frames_ == 0, "frames of the previous buffer pool are still lent");
+  bpm_             = bpm;
+  pool_bytes_      = frame_num * PAGE_SIZE;
+  lendable_frames_ = frame_num > POOL_RESERVED_FRAMES ? frame_num - POOL_RESERVED_FRAMES : 0;
+}
+
+void MemoryBroker::UnregisterBufferPool(BufferPoolManager *bpm)
+{
+  {
+    std::lock_guard<std::mutex> lock{latch_};
+    if (bpm_ != bpm) {
+      return;
+    }
+    WSDB_ASSERT(lent_frames_ == 0, "frames of the buffer pool are still lent");
+  }
+  bpm->SetMemoryBroker(nullptr);
+  std::lock_guard<std::mutex> lock{latch_};
+  bpm_             = nullptr;
+  pool_bytes_      = 0;
+  lendable_frames_ = 0;
+}
+
+auto MemoryBroker::Acquire(size_t desired, size_t minimum, std::vector<char *> *frames) -> size_t
+{
+  WSDB_ASSERT(minimum <= desired, "minimum grant is larger than the desired one");
+  BufferPoolManager *bpm;
+  size_t             heap;
+  size_t             shortfall_frames;
+  {
+    std::lock_guard<std::mutex> lock{latch_};
+    auto                        capacity  = budget_ - pool_bytes_;
+    auto                        available = capacity > granted_ ? capacity - granted_ : 0;
+    if (desired <= available) {
+      granted_ += desired;
+      return desired;
+    }
+    // reserve what is left on the heap, the rest comes from frames that are not lent yet
+    heap = available;
+    granted_ += heap;
+    bpm              = frames == nullptr ? nullptr : bpm_;
+    shortfall_frames = std::min((desired - heap + PAGE_SIZE - 1) / PAGE_SIZE, lendable_frames_ - lent_frames_);
+    lent_frames_ += bpm == nullptr ? 0 : shortfall_frames;
+  }
+  // the buffer pool latch is taken without holding ours
+  std::vector<char *> borrowed;
+  if (bpm != nullptr && shortfall_frames > 0) {
+    borrowed = bpm->LendFrames(shortfall_frames);
+  }
+  auto frame_bytes = borrowed.size() * PAGE_SIZE;
+  auto grant       = heap + frame_bytes;
+
+  std::unique_lock<std::mutex> lock{latch_};
+  if (bpm != nullptr) {
+    lent_frames_ -= shortfall_frames - borrowed.size();
+  }
+  if (grant < minimum || grant == 0) {
+    granted_ -= heap;
+    lent_frames_ -= borrowed.size();
+    lock.unlock();
+    if (!borrowed.empty()) {
+      bpm->ReturnFrames(borrowed);
+    }
+    return 0;
+  }
+  // frames are rounded up to whole pages, give back the heap they cover beyond desired
+  if (grant > desired) {
+    auto excess = std::min(heap, grant - desired);
+    granted_ -= excess;
+    grant -= excess;
+  }
+  if (!borrowed.empty()) {
+    frames->insert(frames->end(), borrowed.begin(), borrowed.end());
+  }
+  return grant;
+}
+
+void MemoryBroker::Release(size_t bytes, const std::vector<char *> &frames)
+{
+  BufferPoolManager *bpm;
+  {
+    std::lock_guard<std::mutex> lock{latch_};
+    WSDB_ASSERT(frames.size() <= lent_frames_, "release more frames than lent");
+    WSDB_ASSERT(bytes - frames.size() * PAGE_SIZE <= granted_, "release more memory than granted");
+    granted_ -= bytes - frames.size() * PAGE_SIZE;
+    lent_frames_ -= frames.size();
+    bpm = bpm_;
+  }
+  if (!frames.empty()) {
+    bpm->ReturnFrames(frames);
+  }
+}
+
+auto MemoryBroker::Reclaim(size_t frame_num) -> size_t
+{
+  std::lock_guard<std::mutex> reclaim_lock{reclaim_latch_};
+
+  size_t reclaimed = 0;
+  for (auto grant : reclaimable_) {
+    if (reclaimed >= frame_num) {
+      break;
+    }
+    if (grant->frames_.empty() || !grant->reclaimer_()) {
+      continue;
+    }
+    // the operator no longer touches the frames, they leave the grant with the memory they stand for
+    std::vector<char *> frames;
+    frames.swap(grant->frames_);
+    grant->size_ -= frames.size() * PAGE_SIZE;
+    reclaimed += frames.size();
+    Release(frames.size() * PAGE_SIZE, frames);
+  }
+  return reclaimed;
+}
+
+void MemoryBroker::AddReclaimable(MemoryGrant *grant)
+{
+  std::lock_guard<std::mutex> reclaim_lock{reclaim_latch_};
+  reclaimable_.push_back(grant);
+}
+
+void MemoryBroker::RemoveReclaimable(MemoryGrant *grant)
+{
+  std::lock_guard<std::mutex> reclaim_lock{reclaim_latch_};
+  std::erase(reclaimable_, grant);
+}
+
+auto MemoryBroker::GetGranted() -> size_t
+{
+  std::lock_guard<std::mutex> lock{latch_};
+  return granted_ + lent_frames_ * PAGE_SIZE;
+}
+
+auto MemoryBroker::GetLentFrames() -> size_t
+{
+  std::lock_guard<std::mutex> lock{latch_};
+  return lent_frames_;
+}
+
+}  // namespace wsdb
@@ -0,0 +1,237 @@
+/*------------------------------------------------------------------------------
+ - Copyright (c) 2024. Websoft research group, Nanjing University.
+ -
+ - This program is free software: you can redistribute it and/or modify
+ - it under the terms of the GNU General Public License as published by
+ - the Free Software Foundation, either version 3 of the License, or
+ - (at your option) any later version.
+ -
+ - This program is distributed in the hope that it will be useful,
+ - but WITHOUT ANY WARRANTY; without even the implied warranty of
+ - MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ - GNU General Public License for more details.
+ -
+ - You should have received a copy of the GNU General Public License
+ - along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ -----------------------------------------------------------------------------*/
+
+//
+// Created by ziqi on 2024/9/2.
+//
+
+#ifndef WSDB_MEMORY_BROKER_H
+#define WSDB_MEMORY_BROKER_H
+
+#include <functional>
+#include <mutex>  // NOLINT
+#include <vector>
+
+#include "common/config.h"
+#include "../../../common/error.h"
+#include "../../../common/micro.h"
+
+namespace wsdb {
+
+class BufferPoolManager;
+class MemoryGrant;
+
+/**
+ * @brief MemoryBroker manages one process-wide memory budget shared by the buffer pool and operator working memory.
+ *
+ * The buffer pool registers its frames first, the rest of the budget is handed out to operators (sort, hash
+ * aggregate, hash join) as grants on the heap. When the heap budget is exhausted, the broker borrows idle frames from
+ * the buffer pool for operators that take them, the memory of a lent frame belongs to the grant until it is released
+ * and the frame goes back to the buffer pool, at least POOL_RESERVED_FRAMES frames are never lent.
+ * Operators that receive less than they asked for are expected to spill to disk. When every frame left in the buffer
+ * pool is pinned, the buffer pool reclaims lent frames from the grants that registered a reclaimer.
+ */
+class MemoryBroker
+{
+public:
+  explicit MemoryBroker(size_t budget = MEMORY_BUDGET) : budget_(budget) {}
+
+  ~MemoryBroker() = default;
+
+  DISABLE_COPY_MOVE_AND_ASSIGN(MemoryBroker)
+
+  /**
+   * Register the buffer pool, its frames are reserved from the budget and may be lent to operators.
+   * Only one buffer pool is tracked, registering another one replaces the previous registration, no frame of the
+   * previous one may be lent
+   * @param bpm
+   * @param frame_num number of frames owned by the buffer pool
+   */
+  void RegisterBufferPool(BufferPoolManager *bpm, size_t frame_num);
+
+  void UnregisterBufferPool(BufferPoolManager *bpm);
+
+  /**
+   * Request operator memory
+   * 1. grant the latch, grant desired bytes on the heap if the free budget allows
+   * 2. else reserve the free budget, and if frames is not nullptr, borrow idle frames from the buffer pool for the rest
+   * 3. grant the reserved budget plus the borrowed frames if it is no less than minimum, else give both back
+   * @param desired bytes the operator wants to hold everything in memory
+   * @param minimum bytes the operator cannot run without
+   * @param frames[out] data of the borrowed frames, PAGE_SIZE bytes each, the rest of the grant is on the heap
+   * @return granted bytes, 0 if the request is denied
+   */
+  auto Acquire(size_t desired, size_t minimum, std::vector<char *> *frames = nullptr) -> size_t;
+
+  /**
+   * Release operator memory, the frames of the grant are returned to the buffer pool
+   * @param bytes granted bytes, including the frames
+   * @param frames the frames of the grant
+   */
+  void Release(size_t bytes, const std::vector<char *> &frames = {});
+
+  /**
+   * Reclaim frames lent to operators, called by the buffer pool when none of its frames can be evicted
+   * 1. grant the reclaim latch, ask the reclaimable grants holding frames to spill, in the order they registered
+   * 2. take the frames of each grant whose reclaimer agreed and return them to the buffer pool
+   * @param frame_num number of frames wanted, more may be returned since a grant gives back all of its frames
+   * @return number of frames returned to the buffer pool, 0 if no grant could give any back
+   */
+  auto Reclaim(size_t frame_num) -> size_t;
+
+  [[nodiscard]] auto GetBudget() const -> size_t { return budget_; }
+
+  /// @return granted bytes, including the lent frames
+  [[nodiscard]] auto GetGranted() -> size_t;
+
+  [[nodiscard]] auto GetLentFrames() -> size_t;
+
+  static auto GetInstance() -> MemoryBroker *
+  {
+    static MemoryBroker instance;
+    return &instance;
+  }
+
+private:
+  friend class MemoryGrant;
+
+  void AddReclaimable(MemoryGrant *grant);
+
+  /// wait for a running Reclaim to finish, the grant is not asked to spill after that
+  void RemoveReclaimable(MemoryGrant *grant);
+
+private:
+  std::mutex         latch_;
+  const size_t       budget_;
+  BufferPoolManager *bpm_{nullptr};
+  size_t             pool_bytes_{0};
+  // frames that can be lent at most, the buffer pool keeps the rest for the queries feeding the operators
+  size_t             lendable_frames_{0};
+  size_t             lent_frames_{0};
+  // bytes granted on the heap, the storage of lent frames stays in the buffer pool and is not part of it
+  size_t             granted_{0};
+  // serializes reclaims, a grant is not unregistered while its reclaimer runs
+  std::mutex                 reclaim_latch_;
+  std::vector<MemoryGrant *> reclaimable_;
+};
+
+/**
+ * @brief RAII wrapper of a memory grant, released when the holder is destroyed
+ */
+class MemoryGrant
+{
+public:
+  /**
+   * Called by MemoryBroker::Reclaim on the thread that needs a frame, it may run concurrently with the operator.
+   * The operator spills the data it keeps in the frames and stops using them, then the frames are taken from the grant.
+   * @return false if the operator cannot give up its frames now, the grant keeps them
+   */
+  using Reclaimer = std::function<bool()>;
+
+  MemoryGrant() = default;
+
+  /**
+   * @param desired
+   * @param minimum
+   * @param broker
+   * @param use_frames whether the operator keeps its data in the frames of GetFrames, else the grant is all on heap
+   */
+  MemoryGrant(
+      size_t desired, size_t minimum, MemoryBroker *broker = MemoryBroker::GetInstance(), bool use_frames = false)
+      : broker_(broker), size_(broker->Acquire(desired, minimum, use_frames ? &frames_ : nullptr))
+  {}
+
+  ~MemoryGrant() { Reset(); }
+
+  DISABLE_COPY_AND_ASSIGN(MemoryGrant)
+
+  MemoryGrant(MemoryGrant &&other) noexcept
+      : broker_(other.broker_), frames_(std::move(other.frames_)), size_(other.size_)
+  {
+    WSDB_ASSERT(other.reclaimer_ == nullptr, "move a grant registered for reclaim");
+    other.frames_.clear();
+    other.size_ = 0;
+  }
+
+  auto operator=(MemoryGrant &&other) noexcept -> MemoryGrant &
+  {
+    if (this != &other) {
+      WSDB_ASSERT(other.reclaimer_ == nullptr, "move a grant registered for reclaim");
+      Reset();
+      broker_ = other.broker_;
+      frames_ = std::move(other.frames_);
+      size_   = other.size_;
+      other.frames_.clear();
+      other.size_ = 0;
+    }
+    return *this;
+  }
+
+  [[nodiscard]] auto GetSize() const -> size_t { return size_; }
+
+  /// @return bytes the operator may allocate on the heap
+  [[nodiscard]] auto GetHeapSize() const -> size_t
+  {
+    return size_ > frames_.size() * PAGE_SIZE ? size_ - frames_.size() * PAGE_SIZE : 0;
+  }
+
+  /// @return frames lent by the buffer pool, PAGE_SIZE bytes each, valid until the grant is released
+  [[nodiscard]] auto GetFrames() const -> const std::vector<char *> & { return frames_; }
+
+  [[nodiscard]] auto IsDenied() const -> bool { return size_ == 0; }
+
+  /**
+   * Let the broker reclaim the frames of the grant when the buffer pool runs out of frames, the grant must not be moved
+   * afterwards
+   * @param reclaimer
+   */
+  void SetReclaimer(Reclaimer reclaimer)
+  {
+    WSDB_ASSERT(reclaimer_ == nullptr, "reclaimer is already set");
+    if (broker_ == nullptr || frames_.empty()) {
+      return;
+    }
+    reclaimer_ = std::move(reclaimer);
+    broker_->AddReclaimable(this);
+  }
+
+  void Reset()
+  {
+    if (reclaimer_ != nullptr) {
+      broker_->RemoveReclaimable(this);
+      reclaimer_ = nullptr;
+    }
+    if (broker_ != nullptr && size_ > 0) {
+      broker_->Release(size_, frames_);
+    }
+    frames_.clear();
+    size_ = 0;
+  }
+
+private:
+  friend class MemoryBroker;
+
+  MemoryBroker       *broker_{nullptr};
+  Reclaimer           reclaimer_;
+  // filled by Acquire before size_ is set
+  std::vector<char *> frames_;
+  size_t              size_{0};
+};
+
+}  // namespace wsdb
+
+#endif  // WSDB_MEMORY_BROKER_H
@@ -0,0 +1,32 @@
+/*------------------------------------------------------------------------------
+ - Copyright (c) 2024. Websoft research group, Nanjing University.
+ -
+ - This program is free software: you can redistribute it and/or modify
+ - it under the terms of the GNU General Public License as published by
+ - the Free Software Foundation, either version 3 of the License, or
+ - (at your option) any later version.
+ -
+ - This program is distributed in the hope that it will be useful,
+ - but WITHOUT ANY WARRANTY; without even the implied warranty of
+ - MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ - GNU General Public License for more details.
+ -
+ - You should have received a copy of the GNU General Public License
+ - along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ -----------------------------------------------------------------------------*/
+
+//
+// Created by ziqi on 2024/9/10.
+//
+
+#include "page_guard.h"
+
+namespace wsdb {
+
+PageGuard::PageGuard(BufferPoolManager *bpm, file_id_t fid, page_id_t pid)
+    : bpm_(bpm), fid_(fid), pid_(pid), page_(bpm->FetchPage(fid, pid))
+{}
+
+PageGuard::~PageGuard() { bpm_->UnpinPage(fid_, pid_, is_dirty_); }
+
+}  // namespace wsdb
@@ -0,0 +1,67 @@
+/*------------------------------------------------------------------------------
+ - Copyright (c) 2024. Websoft research group, Nanjing University.
+ -
+ - This program is free software: you can redistribute it and/or modify
+ - it under the terms of the GNU General Public License as published by
+ - the Free Software Foundation, either version 3 of the License, or
+ - (at your option) any later version.
+ -
+ - This program is distributed in the hope that it will be useful,
+ - but WITHOUT ANY WARRANTY; without even the implied warranty of
+ - MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ - GNU General Public License for more details.
+ -
+ - You should have received a copy of the GNU General Public License
+ - along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ -----------------------------------------------------------------------------*/
+
+//
+// Created by ziqi on 2024/9/10.
+//
+
+#ifndef WSDB_PAGE_GUARD_H
+#define WSDB_PAGE_GUARD_H
+
+#include "buffer_pool_manager.h"
+
+namespace wsdb {
+
+/**
+ * @brief Keep a page pinned in the buffer pool for as long as the guard is alive.
+ *
+ * The page is fetched in the constructor and unpinned in the destructor, the guard is usually held by a shared
+ * pointer so that record views pointing into the frame keep the page resident after the scan has moved on.
+ */
+class PageGuard
+{
+public:
+  PageGuard() = delete;
+
+  PageGuard(BufferPoolManager *bpm, file_id_t fid, page_id_t pid);
+
+  ~PageGuard();
+
+  DISABLE_COPY_MOVE_AND_ASSIGN(PageGuard)
+
+  [[nodiscard]] auto GetPage() const -> Page * { return page_; }
+
+  [[nodiscard]] auto GetFileId() const -> file_id_t { return fid_; }
+
+  [[nodiscard]] auto GetPageId() const -> page_id_t { return pid_; }
+
+  /// the page is written back as dirty when the guard is released
+  void MarkDirty() { is_dirty_ = true; }
+
+private:
+  BufferPoolManager *const bpm_;
+  const file_id_t          fid_;
+  const page_id_t          pid_;
+  Page                    *page_;
+  bool                     is_dirty_{false};
+};
+
+DEFINE_SHARED_PTR(PageGuard);
+
+}  // namespace wsdb
+
+#endif  // WSDB_PAGE_GUARD_H
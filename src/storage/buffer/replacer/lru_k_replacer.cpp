@@ -27,12 +27,69 @@ namespace wsdb {
 
 LRUKReplacer::LRUKReplacer(size_t k) : max_size_(BUFFER_POOL_SIZE), k_(k) {}
 
-auto LRUKReplacer::Victim(frame_id_t *frame_id) -> bool { WSDB_STUDENT_TODO(labs(), f1); }
+auto LRUKReplacer::Victim(frame_id_t *frame_id) -> bool
+{
+  std::lock_guard<std::mutex> lock{latch_};
 
-void LRUKReplacer::Pin(frame_id_t frame_id) { WSDB_STUDENT_TODO(l1, f1); }
+  auto               victim_it = node_store_.end();
+  unsigned long long max_dist  = 0;
+  timestamp_t        min_ts    = 0;
+  for (auto it = node_store_.begin(); it != node_store_.end(); ++it) {
+    auto &node = it->second;
+    if (!node.IsEvictable()) {
+      continue;
+    }
+    // frames with less than k accesses have infinite distance, evict the one accessed earliest among them
+    auto dist = node.GetBackwardKDistance(cur_ts_);
+    auto ts   = node.GetEarliestTimestamp();
+    if (victim_it == node_store_.end() || dist > max_dist || (dist == max_dist && ts < min_ts)) {
+      victim_it = it;
+      max_dist  = dist;
+      min_ts    = ts;
+    }
+  }
+  if (victim_it == node_store_.end()) {
+    return false;
+  }
+  *frame_id = victim_it->first;
+  node_store_.erase(victim_it);
+  cur_size_--;
+  return true;
+}
 
-void LRUKReplacer::Unpin(frame_id_t frame_id) { WSDB_STUDENT_TODO(l1, f1); }
+void LRUKReplacer::Pin(frame_id_t frame_id)
+{
+  std::lock_guard<std::mutex> lock{latch_};
 
-auto LRUKReplacer::Size() -> size_t { WSDB_STUDENT_TODO(l1, f1); }
+  auto it = node_store_.find(frame_id);
+  if (it == node_store_.end()) {
+    WSDB_ASSERT(node_store_.size() < max_size_, "Pin a new frame when the replacer is full");
+    it = node_store_.emplace(frame_id, LRUKNode(frame_id, k_)).first;
+  }
+  auto &node = it->second;
+  node.AddHistory(cur_ts_++);
+  if (node.IsEvictable()) {
+    node.SetEvictable(false);
+    cur_size_--;
+  }
+}
+
+void LRUKReplacer::Unpin(frame_id_t frame_id)
+{
+  std::lock_guard<std::mutex> lock{latch_};
+
+  auto it = node_store_.find(frame_id);
+  WSDB_ASSERT(it != node_store_.end(), "Unpin a frame that is not in the replacer");
+  if (!it->second.IsEvictable()) {
+    it->second.SetEvictable(true);
+    cur_size_++;
+  }
+}
+
+auto LRUKReplacer::Size() -> size_t
+{
+  std::lock_guard<std::mutex> lock{latch_};
+  return cur_size_;
+}
 
 }  // namespace wsdb
@@ -21,6 +21,7 @@
 
 #ifndef WSDB_LRU_K_REPLACER_H
 #define WSDB_LRU_K_REPLACER_H
+#include <limits>
 #include <list>
 #include <mutex>
 #include <unordered_map>
@@ -52,7 +53,13 @@ private:
 
     explicit LRUKNode(frame_id_t fid, size_t k) : fid_(fid), k(k), is_evictable_(false) {}
 
-    void AddHistory(timestamp_t ts) { WSDB_STUDENT_TODO(l1, f1); }
+    void AddHistory(timestamp_t ts)
+    {
+      history_.push_back(ts);
+      if (history_.size() > k) {
+        history_.pop_front();
+      }
+    }
 
     /**
      * Get the distance between the current timestamp and the k-th timestamp in the history,
@@ -62,12 +69,18 @@ private:
      */
     auto GetBackwardKDistance(timestamp_t cur_ts) -> unsigned long long
     {
-      WSDB_STUDENT_TODO(l1, f1);
+      if (history_.size() < k) {
+        return std::numeric_limits<unsigned long long>::max();
+      }
+      return static_cast<unsigned long long>(cur_ts - history_.front());
     }
 
-    [[nodiscard]] auto IsEvictable() const -> bool { WSDB_STUDENT_TODO(l1, f1); }
+    /// the earliest timestamp in the history, used to break ties among frames with infinite distance
+    [[nodiscard]] auto GetEarliestTimestamp() const -> timestamp_t { return history_.front(); }
+
+    [[nodiscard]] auto IsEvictable() const -> bool { return is_evictable_; }
 
-    auto SetEvictable(bool set_evictable) -> void { WSDB_STUDENT_TODO(l1, f1); }
+    auto SetEvictable(bool set_evictable) -> void { is_evictable_ = set_evictable; }
 
   private:
     std::list<timestamp_t> history_;
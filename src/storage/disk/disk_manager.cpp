@@ -98,6 +98,24 @@ void DiskManager::ReadPage(file_id_t fid, page_id_t page_id, char *data)
   }
 }
 
+void DiskManager::TruncateFile(file_id_t fid, size_t page_num)
+{
+  WSDB_ASSERT(fid_name_map_.find(fid) != fid_name_map_.end(), fmt::format("fid: {}", fid));
+  if (ftruncate(fid, static_cast<off_t>(page_num) * static_cast<off_t>(PAGE_SIZE)) < 0) {
+    WSDB_THROW(WSDB_FILE_WRITE_ERROR, fmt::format("fid: {}, page_num: {}", fid, page_num));
+  }
+}
+
+void DiskManager::PrefetchPages(file_id_t fid, page_id_t page_id, size_t page_num)
+{
+  WSDB_ASSERT(fid_name_map_.find(fid) != fid_name_map_.end(), fmt::format("fid: {}", fid));
+  // only a hint, a failure just means no readahead
+  posix_fadvise(fid,
+      static_cast<off_t>(page_id) * static_cast<off_t>(PAGE_SIZE),
+      static_cast<off_t>(page_num * PAGE_SIZE),
+      POSIX_FADV_WILLNEED);
+}
+
 void DiskManager::ReadFile(file_id_t fid, char *data, size_t size, size_t offset, int type)
 {
   WSDB_ASSERT(fid_name_map_.find(fid) != fid_name_map_.end(), "File not Opened");
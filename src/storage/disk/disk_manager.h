@@ -66,6 +66,22 @@ public:
 
   void ReadPage(file_id_t fid, page_id_t page_id, char *data);
 
+  /**
+   * Hint the OS to read pages [page_id, page_id + page_num) ahead of time, used by sequential scans.
+   * The pages are not loaded into the buffer pool, ReadPage of these pages will hit the OS page cache instead.
+   * @param fid
+   * @param page_id the first page to prefetch
+   * @param page_num
+   */
+  void PrefetchPages(file_id_t fid, page_id_t page_id, size_t page_num);
+
+  /**
+   * Cut the file down to its first page_num pages, pages beyond are dropped
+   * @param fid
+   * @param page_num
+   */
+  void TruncateFile(file_id_t fid, size_t page_num);
+
   void ReadFile(file_id_t fid, char *data, size_t size, size_t offset, int type);
 
   /**
@@ -23,6 +23,8 @@
 #define WSDB_STORAGE_H
 
 #include "buffer/buffer_pool_manager.h"
+#include "buffer/memory_broker.h"
+#include "buffer/page_guard.h"
 #include "disk/disk_manager.h"
 
 #endif  // WSDB_STORAGE_H
@@ -0,0 +1,415 @@
+/*------------------------------------------------------------------------------
+ - Copyright (c) 2024. Websoft research group, Nanjing University.
+ -
+ - This program is free software: you can redistribute it and/or modify
+ - it under the terms of the GNU General Public License as published by
+ - the Free Software Foundation, either version 3 of the License, or
+ - (at your option) any later version.
+ -
+ - This program is distributed in the hope that it will be useful,
+ - but WITHOUT ANY WARRANTY; without even the implied warranty of
+ - MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ - GNU General Public License for more details.
+ -
+ - You should have received a copy of the GNU General Public License
+ - along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ -----------------------------------------------------------------------------*/
+
+//
+// Created by ziqi on 2024/9/14.
+//
+
+#include "column_encoding.h"
+
+#include <bit>
+#include <cstring>
+#include <limits>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "common/bitmap.h"
+
+namespace wsdb {
+
+namespace {
+
+// run lengths and dictionary sizes are stored in 2 bytes
+constexpr size_t MAX_RUN_LENGTH = std::numeric_limits<uint16_t>::max();
+
+template <typename T>
+auto Load(const char *src) -> T
+{
+  T value;
+  memcpy(&value, src, sizeof(T));
+  return value;
+}
+
+template <typename T>
+void Store(char *dst, T value)
+{
+  memcpy(dst, &value, sizeof(T));
+}
+
+auto PackedSize(size_t num, uint8_t bits) -> size_t { return (num * bits + 7) / 8; }
+
+/// bits needed for offsets in [0, range], no bit at all if all offsets are 0
+auto BitsOf(uint64_t range) -> uint8_t { return static_cast<uint8_t>(std::bit_width(range)); }
+
+/// pack the values of bits bits each, lowest bit first, out is cleared before
+void Pack(const std::vector<uint32_t> &values, uint8_t bits, char *out)
+{
+  auto bytes = reinterpret_cast<uint8_t *>(out);
+  memset(bytes, 0, PackedSize(values.size(), bits));
+  for (size_t i = 0; i < values.size(); ++i) {
+    size_t pos = i * bits;
+    for (uint8_t done = 0; done < bits;) {
+      auto take = std::min<uint8_t>(8 - pos % 8, bits - done);
+      bytes[pos / 8] |= static_cast<uint8_t>(((values[i] >> done) & ((1U << take) - 1)) << (pos % 8));
+      done += take;
+      pos += take;
+    }
+  }
+}
+
+auto Unpack(const char *in, size_t idx, uint8_t bits) -> uint32_t
+{
+  auto     bytes = reinterpret_cast<const uint8_t *>(in);
+  uint32_t value = 0;
+  size_t   pos   = idx * bits;
+  for (uint8_t done = 0; done < bits;) {
+    auto take = std::min<uint8_t>(8 - pos % 8, bits - done);
+    value |= static_cast<uint32_t>((bytes[pos / 8] >> (pos % 8)) & ((1U << take) - 1)) << done;
+    done += take;
+    pos += take;
+  }
+  return value;
+}
+
+void SetBits(char *bitmap, size_t begin, size_t end, bool value)
+{
+  for (size_t i = begin; i < end; ++i) {
+    BitMap::SetBit(bitmap, i, value);
+  }
+}
+
+template <typename T>
+auto Compare(CompOp op, const T &lhs, const T &rhs) -> bool
+{
+  switch (op) {
+    case OP_EQ: return lhs == rhs;
+    case OP_NE: return lhs != rhs;
+    case OP_LT: return lhs < rhs;
+    case OP_LE: return lhs <= rhs;
+    case OP_GT: return lhs > rhs;
+    case OP_GE: return lhs >= rhs;
+    default: WSDB_FETAL("unsupported comparison");
+  }
+}
+
+/// `value op rhs` for a raw value of the column, the types are aligned as ValueFactory::AlignTypes does
+class Predicate
+{
+public:
+  /// @return false if the column can not be compared with rhs by op
+  auto Init(FieldType type, size_t width, CompOp op, const Value &rhs) -> bool
+  {
+    if (op != OP_EQ && op != OP_NE && op != OP_LT && op != OP_LE && op != OP_GT && op != OP_GE) {
+      return false;
+    }
+    type_  = type;
+    width_ = width;
+    op_    = op;
+    if (type == TYPE_STRING || rhs.GetType() == TYPE_STRING) {
+      if (type != rhs.GetType()) {
+        return false;
+      }
+      str_ = dynamic_cast<const StringValue &>(rhs).Get();
+      return true;
+    }
+    switch (rhs.GetType()) {
+      case TYPE_INT: num_ = dynamic_cast<const IntValue &>(rhs).Get(); break;
+      case TYPE_FLOAT: num_ = dynamic_cast<const FloatValue &>(rhs).Get(); break;
+      case TYPE_BOOL: num_ = dynamic_cast<const BoolValue &>(rhs).Get() ? 1 : 0; break;
+      default: return false;
+    }
+    if (type != rhs.GetType()) {
+      // int and float are compared as float, other combinations fail in evaluation
+      if ((type != TYPE_INT && type != TYPE_FLOAT) || (rhs.GetType() != TYPE_INT && rhs.GetType() != TYPE_FLOAT)) {
+        return false;
+      }
+      as_float_ = true;
+      num_      = static_cast<float>(num_);
+    }
+    return true;
+  }
+
+  [[nodiscard]] auto Match(const char *value) const -> bool
+  {
+    switch (type_) {
+      case TYPE_INT: return MatchNumber(Load<int32_t>(value));
+      case TYPE_FLOAT: return MatchNumber(Load<float>(value));
+      case TYPE_BOOL: return MatchNumber(Load<bool>(value) ? 1 : 0);
+      // strings end at the first '\0' as in StringValue
+      case TYPE_STRING: return Compare(op_, std::string_view(value, strnlen(value, width_)), std::string_view(str_));
+      default: WSDB_FETAL("unsupported field type");
+    }
+  }
+
+  [[nodiscard]] auto MatchNumber(double value) const -> bool
+  {
+    return Compare(op_, as_float_ ? static_cast<float>(value) : value, num_);
+  }
+
+private:
+  FieldType   type_{TYPE_NULL};
+  size_t      width_{0};
+  CompOp      op_{OP_EQ};
+  bool        as_float_{false};
+  double      num_{0};
+  std::string str_;
+};
+
+auto EncodeDict(size_t width, const char *values, size_t num, char *out, size_t &size) -> bool
+{
+  std::unordered_map<std::string_view, uint32_t> codes;
+  std::vector<std::string_view>                  dict;
+  std::vector<uint32_t>                          packed(num);
+  for (size_t i = 0; i < num; ++i) {
+    auto [it, inserted] = codes.try_emplace(std::string_view(values + i * width, width), dict.size());
+    if (inserted) {
+      dict.push_back(it->first);
+      if (dict.size() > MAX_RUN_LENGTH) {
+        return false;
+      }
+    }
+    packed[i] = it->second;
+  }
+  auto bits = BitsOf(dict.size() - 1);
+  size      = 3 + dict.size() * width + PackedSize(num, bits);
+  if (size >= num * width) {
+    return false;
+  }
+  Store<uint16_t>(out, dict.size());
+  Store<uint8_t>(out + 2, bits);
+  for (size_t i = 0; i < dict.size(); ++i) {
+    memcpy(out + 3 + i * width, dict[i].data(), width);
+  }
+  Pack(packed, bits, out + 3 + dict.size() * width);
+  return true;
+}
+
+auto EncodeRLE(size_t width, const char *values, size_t num, char *out, size_t &size) -> bool
+{
+  size_t run_num = 0;
+  for (size_t i = 0, len = 0; i < num; ++i, ++len) {
+    if (i == 0 || len == MAX_RUN_LENGTH || memcmp(values + i * width, values + (i - 1) * width, width) != 0) {
+      run_num++;
+      len = 0;
+    }
+  }
+  size = 2 + run_num * (width + 2);
+  if (run_num > MAX_RUN_LENGTH || size >= num * width) {
+    return false;
+  }
+  Store<uint16_t>(out, run_num);
+  char *run = nullptr;
+  for (size_t i = 0, len = 0; i < num; ++i, ++len) {
+    if (i == 0 || len == MAX_RUN_LENGTH || memcmp(values + i * width, values + (i - 1) * width, width) != 0) {
+      run = run == nullptr ? out + 2 : run + width + 2;
+      memcpy(run, values + i * width, width);
+      len = 0;
+    }
+    Store<uint16_t>(run + width, len + 1);
+  }
+  return true;
+}
+
+auto EncodeFOR(const char *values, size_t num, char *out, size_t &size) -> bool
+{
+  int64_t lo = std::numeric_limits<int32_t>::max();
+  int64_t hi = std::numeric_limits<int32_t>::min();
+  for (size_t i = 0; i < num; ++i) {
+    lo = std::min<int64_t>(lo, Load<int32_t>(values + i * sizeof(int32_t)));
+    hi = std::max<int64_t>(hi, Load<int32_t>(values + i * sizeof(int32_t)));
+  }
+  auto bits = BitsOf(hi - lo);
+  size      = 5 + PackedSize(num, bits);
+  if (size >= num * sizeof(int32_t)) {
+    return false;
+  }
+  std::vector<uint32_t> packed(num);
+  for (size_t i = 0; i < num; ++i) {
+    packed[i] = static_cast<uint32_t>(Load<int32_t>(values + i * sizeof(int32_t)) - lo);
+  }
+  Store<int32_t>(out, static_cast<int32_t>(lo));
+  Store<uint8_t>(out + 4, bits);
+  Pack(packed, bits, out + 5);
+  return true;
+}
+
+auto EncodeDelta(const char *values, size_t num, char *out, size_t &size) -> bool
+{
+  std::vector<int64_t> deltas(num - 1);
+  int64_t              lo = std::numeric_limits<int64_t>::max();
+  int64_t              hi = std::numeric_limits<int64_t>::min();
+  for (size_t i = 1; i < num; ++i) {
+    deltas[i - 1] = static_cast<int64_t>(Load<int32_t>(values + i * sizeof(int32_t))) -
+                    Load<int32_t>(values + (i - 1) * sizeof(int32_t));
+    lo = std::min(lo, deltas[i - 1]);
+    hi = std::max(hi, deltas[i - 1]);
+  }
+  if (deltas.empty() || hi - lo > std::numeric_limits<uint32_t>::max()) {
+    return false;
+  }
+  auto bits = BitsOf(hi - lo);
+  size      = 13 + PackedSize(num - 1, bits);
+  if (size >= num * sizeof(int32_t)) {
+    return false;
+  }
+  std::vector<uint32_t> packed(num - 1);
+  for (size_t i = 0; i < num - 1; ++i) {
+    packed[i] = static_cast<uint32_t>(deltas[i] - lo);
+  }
+  Store<int32_t>(out, Load<int32_t>(values));
+  Store<int64_t>(out + 4, lo);
+  Store<uint8_t>(out + 12, bits);
+  Pack(packed, bits, out + 13);
+  return true;
+}
+
+/// call func(idx, value) for the num integers of a FOR or DELTA column in order
+template <typename Func>
+void ForEachInteger(ColumnEncoding encoding, const char *in, size_t num, Func &&func)
+{
+  if (encoding == ColumnEncoding::FOR) {
+    auto base = Load<int32_t>(in);
+    auto bits = Load<uint8_t>(in + 4);
+    for (size_t i = 0; i < num; ++i) {
+      func(i, static_cast<int32_t>(base + static_cast<int64_t>(Unpack(in + 5, i, bits))));
+    }
+    return;
+  }
+  int64_t value = Load<int32_t>(in);
+  auto    base  = Load<int64_t>(in + 4);
+  auto    bits  = Load<uint8_t>(in + 12);
+  func(0, static_cast<int32_t>(value));
+  for (size_t i = 1; i < num; ++i) {
+    value += base + Unpack(in + 13, i - 1, bits);
+    func(i, static_cast<int32_t>(value));
+  }
+}
+
+}  // namespace
+
+auto ColumnCodec::Encode(FieldType type, size_t width, const char *values, size_t num, char *out, size_t &size)
+    -> ColumnEncoding
+{
+  auto encoding = ColumnEncoding::PLAIN;
+  if (num == 0) {
+    return encoding;
+  }
+  size_t            min_size = num * width;
+  size_t            buf_size = 0;
+  std::vector<char> buf(num * width);
+  // try each encoding into the buffer, keep the smallest one in out
+  auto try_encoding = [&](ColumnEncoding candidate, bool encoded) {
+    if (encoded && buf_size < min_size) {
+      encoding = candidate;
+      min_size = buf_size;
+      memcpy(out, buf.data(), buf_size);
+    }
+  };
+  try_encoding(ColumnEncoding::DICT, EncodeDict(width, values, num, buf.data(), buf_size));
+  try_encoding(ColumnEncoding::RLE, EncodeRLE(width, values, num, buf.data(), buf_size));
+  if (type == TYPE_INT) {
+    try_encoding(ColumnEncoding::FOR, EncodeFOR(values, num, buf.data(), buf_size));
+    try_encoding(ColumnEncoding::DELTA, EncodeDelta(values, num, buf.data(), buf_size));
+  }
+  size = min_size;
+  return encoding;
+}
+
+void ColumnCodec::Decode(ColumnEncoding encoding, size_t width, const char *in, size_t num, char *values)
+{
+  switch (encoding) {
+    case ColumnEncoding::PLAIN: memcpy(values, in, num * width); return;
+    case ColumnEncoding::DICT: {
+      auto dict_num = Load<uint16_t>(in);
+      auto bits     = Load<uint8_t>(in + 2);
+      auto codes    = in + 3 + dict_num * width;
+      for (size_t i = 0; i < num; ++i) {
+        memcpy(values + i * width, in + 3 + Unpack(codes, i, bits) * width, width);
+      }
+      return;
+    }
+    case ColumnEncoding::RLE: {
+      auto   run_num = Load<uint16_t>(in);
+      auto   run     = in + 2;
+      size_t idx     = 0;
+      for (size_t r = 0; r < run_num; ++r, run += width + 2) {
+        for (auto len = Load<uint16_t>(run + width); len > 0; --len, ++idx) {
+          memcpy(values + idx * width, run, width);
+        }
+      }
+      return;
+    }
+    case ColumnEncoding::FOR:
+    case ColumnEncoding::DELTA:
+      ForEachInteger(encoding, in, num, [values](size_t idx, int32_t value) {
+        Store<int32_t>(values + idx * sizeof(int32_t), value);
+      });
+      return;
+    default: WSDB_FETAL("unknown column encoding");
+  }
+}
+
+auto ColumnCodec::Evaluate(ColumnEncoding encoding, FieldType type, size_t width, const char *in, size_t num,
+    CompOp op, const Value &rhs, char *matches) -> bool
+{
+  Predicate pred;
+  if (rhs.IsNull() || !pred.Init(type, width, op, rhs)) {
+    return false;
+  }
+  switch (encoding) {
+    case ColumnEncoding::PLAIN:
+      for (size_t i = 0; i < num; ++i) {
+        BitMap::SetBit(matches, i, pred.Match(in + i * width));
+      }
+      return true;
+    case ColumnEncoding::DICT: {
+      // the predicate is evaluated once per distinct value, then looked up by code
+      auto              dict_num = Load<uint16_t>(in);
+      auto              bits     = Load<uint8_t>(in + 2);
+      auto              codes    = in + 3 + dict_num * width;
+      std::vector<bool> dict_matches(dict_num);
+      for (size_t i = 0; i < dict_num; ++i) {
+        dict_matches[i] = pred.Match(in + 3 + i * width);
+      }
+      for (size_t i = 0; i < num; ++i) {
+        BitMap::SetBit(matches, i, dict_matches[Unpack(codes, i, bits)]);
+      }
+      return true;
+    }
+    case ColumnEncoding::RLE: {
+      auto   run_num = Load<uint16_t>(in);
+      auto   run     = in + 2;
+      size_t idx     = 0;
+      for (size_t r = 0; r < run_num; ++r, run += width + 2) {
+        auto len = Load<uint16_t>(run + width);
+        SetBits(matches, idx, idx + len, pred.Match(run));
+        idx += len;
+      }
+      return true;
+    }
+    case ColumnEncoding::FOR:
+    case ColumnEncoding::DELTA:
+      ForEachInteger(encoding, in, num, [matches, &pred](size_t idx, int32_t value) {
+        BitMap::SetBit(matches, idx, pred.MatchNumber(value));
+      });
+      return true;
+    default: WSDB_FETAL("unknown column encoding");
+  }
+}
+
+}  // namespace wsdb
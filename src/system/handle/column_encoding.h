@@ -0,0 +1,85 @@
+/*------------------------------------------------------------------------------
+ - Copyright (c) 2024. Websoft research group, Nanjing University.
+ -
+ - This program is free software: you can redistribute it and/or modify
+ - it under the terms of the GNU General Public License as published by
+ - the Free Software Foundation, either version 3 of the License, or
+ - (at your option) any later version.
+ -
+ - This program is distributed in the hope that it will be useful,
+ - but WITHOUT ANY WARRANTY; without even the implied warranty of
+ - MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ - GNU General Public License for more details.
+ -
+ - You should have received a copy of the GNU General Public License
+ - along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ -----------------------------------------------------------------------------*/
+
+//
+// Created by ziqi on 2024/9/14.
+//
+
+#ifndef WSDB_COLUMN_ENCODING_H
+#define WSDB_COLUMN_ENCODING_H
+
+#include <cstdint>
+
+#include "common/types.h"
+#include "common/value.h"
+
+namespace wsdb {
+
+enum class ColumnEncoding : uint8_t
+{
+  PLAIN = 0,
+  DICT,
+  RLE,
+  FOR,
+  DELTA,
+};
+
+/**
+ * @brief Lightweight encodings of a column of fixed-width values, used for the frozen rows of PAX pages, see
+ * PAXPageHandle.
+ *
+ * - DICT: | dict num (2) | code bits (1) | distinct values | bit-packed codes |, low-cardinality columns of any type
+ * - RLE: | run num (2) | runs of | value | run length (2) | |, columns with long runs of any type
+ * - FOR: | base (4) | bits (1) | bit-packed (value - base) |, int columns in a narrow range
+ * - DELTA: | first (4) | base (8) | bits (1) | bit-packed (delta - base) |, sorted int columns
+ *
+ * Predicates are evaluated on the encoded data without decoding the column: once per distinct value for DICT, once
+ * per run for RLE, FOR and DELTA rebuild each integer from its packed offset on the fly.
+ */
+class ColumnCodec
+{
+public:
+  ColumnCodec() = delete;
+
+  /**
+   * Encode the column with the encoding that takes the least space
+   * @param type
+   * @param width bytes of each value
+   * @param values num values stored back to back
+   * @param num
+   * @param[out] out buffer of num * width bytes
+   * @param[out] size bytes written to out
+   * @return PLAIN if no encoding is smaller than the values, out is not written then
+   */
+  static auto Encode(FieldType type, size_t width, const char *values, size_t num, char *out, size_t &size)
+      -> ColumnEncoding;
+
+  /// decode num values encoded by Encode into values
+  static void Decode(ColumnEncoding encoding, size_t width, const char *in, size_t num, char *values);
+
+  /**
+   * Evaluate `value op rhs` for every value of the encoded column, with the comparison semantics of Value
+   * @param[out] matches bitmap of num bits, bit i is set if the i-th value satisfies the predicate
+   * @return false if the predicate is not evaluated, e.g. the types can not be compared, matches is undefined then
+   */
+  static auto Evaluate(ColumnEncoding encoding, FieldType type, size_t width, const char *in, size_t num, CompOp op,
+      const Value &rhs, char *matches) -> bool;
+};
+
+}  // namespace wsdb
+
+#endif  // WSDB_COLUMN_ENCODING_H
@@ -157,10 +157,10 @@ void DatabaseHandle::FlushMeta()
   disk_manager_->CloseFile(db_fd);
 }
 
-void DatabaseHandle::CreateTable(
-    const std::string &tab_name, const RecordSchema &rec_schema, StorageModel storage_model)
+void DatabaseHandle::CreateTable(const std::string &tab_name, const RecordSchema &rec_schema,
+    StorageModel storage_model, PartitionScheme *partition_scheme, bool memory_snapshot)
 {
-  tbl_mgr_->CreateTable(db_name_, tab_name, rec_schema, storage_model);
+  tbl_mgr_->CreateTable(db_name_, tab_name, rec_schema, storage_model, partition_scheme, memory_snapshot);
   auto tbl_hdl                   = tbl_mgr_->OpenTable(db_name_, tab_name, storage_model);
   tables_[tbl_hdl->GetTableId()] = std::move(tbl_hdl);
 
@@ -172,7 +172,7 @@ void DatabaseHandle::DropTable(const std::string &tab_name)
   auto tid   = tbl_mgr_->GetTableId(db_name_, tab_name);
   auto table = tables_[tid].get();
   tbl_mgr_->CloseTable(db_name_, *table);
-  TableManager::DropTable(db_name_, tab_name);
+  TableManager::DropTable(db_name_, tab_name, table->GetPartitionNum());
   tables_.erase(tid);
   for (auto &idx_id : tab_idx_map_[tid]) {
     auto index = indexes_[idx_id].get();
@@ -184,6 +184,19 @@ void DatabaseHandle::DropTable(const std::string &tab_name)
   FlushMeta();
 }
 
+void DatabaseHandle::DropPartition(const std::string &tab_name, size_t partition)
+{
+  auto table = GetTable(tab_name);
+  if (table == nullptr) {
+    WSDB_THROW(WSDB_TABLE_MISS, tab_name);
+  }
+  // the entries of the dropped rows would have to be found row by row
+  if (GetIndexNum(table->GetTableId()) > 0) {
+    WSDB_THROW(WSDB_UNSUPPORTED_OP, fmt::format("drop partition of {} with indexes", tab_name));
+  }
+  tbl_mgr_->DropPartition(db_name_, *table, partition);
+}
+
 void DatabaseHandle::CreateIndex(const std::string &tab_name, const RecordSchema &key_schema, IndexType idx_type)
 {
   WSDB_THROW(WSDB_NOT_IMPLEMENTED, "");
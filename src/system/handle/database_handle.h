@@ -42,10 +42,14 @@ public:
 
   void FlushMeta();
 
-  void CreateTable(const std::string &tab_name, const RecordSchema &rec_schema, StorageModel storage_model);
+  void CreateTable(const std::string &tab_name, const RecordSchema &rec_schema, StorageModel storage_model,
+      PartitionScheme *partition_scheme = nullptr, bool memory_snapshot = false);
 
   void DropTable(const std::string &tab_name);
 
+  /// empty a partition of the table, its files are replaced instead of deleting the rows one by one
+  void DropPartition(const std::string &tab_name, size_t partition);
+
   void CreateIndex(const std::string &tab_name, const RecordSchema &key_schema, IndexType idx_type);
 
   void DropIndex(const std::string &idx_name);
@@ -0,0 +1,250 @@
+/*------------------------------------------------------------------------------
+ - Copyright (c) 2024. Websoft research group, Nanjing University.
+ -
+ - This program is free software: you can redistribute it and/or modify
+ - it under the terms of the GNU General Public License as published by
+ - the Free Software Foundation, either version 3 of the License, or
+ - (at your option) any later version.
+ -
+ - This program is distributed in the hope that it will be useful,
+ - but WITHOUT ANY WARRANTY; without even the implied warranty of
+ - MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ - GNU General Public License for more details.
+ -
+ - You should have received a copy of the GNU General Public License
+ - along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ -----------------------------------------------------------------------------*/
+
+//
+// Created by ziqi on 2024/9/22.
+//
+
+#include "dict_handle.h"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <mutex>  // NOLINT
+
+namespace wsdb {
+
+namespace {
+// entry of the dictionary file, | field idx (2) | length (4) | value |
+constexpr size_t ENTRY_FIELD_OFFSET  = 0;
+constexpr size_t ENTRY_LENGTH_OFFSET = ENTRY_FIELD_OFFSET + sizeof(uint16_t);
+constexpr size_t ENTRY_VALUE_OFFSET  = ENTRY_LENGTH_OFFSET + sizeof(uint32_t);
+
+/// codes are not aligned in the row
+template <typename T>
+auto Load(const char *base, size_t offset) -> T
+{
+  T value;
+  memcpy(&value, base + offset, sizeof(T));
+  return value;
+}
+
+template <typename T>
+void Store(char *base, size_t offset, T value)
+{
+  memcpy(base + offset, &value, sizeof(T));
+}
+
+/// @return the string literal the condition compares with, nullptr if it is not a non-null string
+auto AsString(const ValueSptr &value) -> const StringValue *
+{
+  if (value == nullptr || value->IsNull() || value->GetType() != TYPE_STRING) {
+    return nullptr;
+  }
+  return dynamic_cast<const StringValue *>(value.get());
+}
+}  // namespace
+
+DictHandle::DictHandle(
+    DiskManager *disk_manager, file_id_t fid, const RecordSchema *schema, const RecordSchema *coded_schema)
+    : disk_manager_(disk_manager),
+      fid_(fid),
+      schema_(schema),
+      coded_schema_(coded_schema),
+      dicts_(schema->GetFieldCount())
+{
+  for (size_t i = 0; i < schema_->GetFieldCount(); ++i) {
+    if (schema_->GetFieldAt(i).field_.dict_encoded_) {
+      encoded_.push_back(i);
+    }
+  }
+  // replay the file, entries are in the order their codes were given
+  std::vector<char> data(std::filesystem::file_size(disk_manager_->GetFileName(fid_)));
+  disk_manager_->ReadFile(fid_, data.data(), data.size(), 0, SEEK_SET);
+  for (size_t pos = 0; pos + ENTRY_VALUE_OFFSET <= data.size();) {
+    auto field_idx = Load<uint16_t>(data.data() + pos, ENTRY_FIELD_OFFSET);
+    auto length    = Load<uint32_t>(data.data() + pos, ENTRY_LENGTH_OFFSET);
+    if (field_idx >= dicts_.size() || pos + ENTRY_VALUE_OFFSET + length > data.size()) {
+      WSDB_THROW(WSDB_FILE_READ_ERROR, fmt::format("broken dictionary entry at {}", pos));
+    }
+    auto &dict = dicts_[field_idx];
+    dict.values_.emplace_back(data.data() + pos + ENTRY_VALUE_OFFSET, length);
+    dict.codes_.emplace(dict.values_.back(), static_cast<uint32_t>(dict.values_.size() - 1));
+    pos += ENTRY_VALUE_OFFSET + length;
+  }
+}
+
+auto DictHandle::MakeCodedSchema(const RecordSchema &schema) -> RecordSchemaUptr
+{
+  std::vector<RTField> fields = schema.GetFields();
+  for (auto &field : fields) {
+    if (field.field_.dict_encoded_) {
+      field.field_.field_size_ = CODE_SIZE;
+    }
+  }
+  return std::make_unique<RecordSchema>(fields);
+}
+
+auto DictHandle::HasEncodedField(const RecordSchema &schema) -> bool
+{
+  const auto &fields = schema.GetFields();
+  return std::any_of(fields.begin(), fields.end(), [](const RTField &field) { return field.field_.dict_encoded_; });
+}
+
+void DictHandle::Pack(const char *nullmap, const char *data, char *coded)
+{
+  size_t field_idx = 0;
+  for (auto encoded : encoded_) {
+    // fields between encoded ones are copied as they are
+    for (; field_idx < encoded; ++field_idx) {
+      memcpy(coded + coded_schema_->GetFieldOffset(field_idx),
+          data + schema_->GetFieldOffset(field_idx),
+          schema_->GetFieldAt(field_idx).field_.field_size_);
+    }
+    field_idx++;
+    uint32_t code = INVALID_CODE;
+    if (!BitMap::GetBit(nullmap, encoded)) {
+      const char *value = data + schema_->GetFieldOffset(encoded);
+      code              = Encode(encoded, {value, strnlen(value, schema_->GetFieldAt(encoded).field_.field_size_)});
+    }
+    Store<uint32_t>(coded, coded_schema_->GetFieldOffset(encoded), code);
+  }
+  for (; field_idx < schema_->GetFieldCount(); ++field_idx) {
+    memcpy(coded + coded_schema_->GetFieldOffset(field_idx),
+        data + schema_->GetFieldOffset(field_idx),
+        schema_->GetFieldAt(field_idx).field_.field_size_);
+  }
+}
+
+void DictHandle::Unpack(const char *nullmap, const char *coded, char *data) const
+{
+  size_t field_idx = 0;
+  for (auto encoded : encoded_) {
+    for (; field_idx < encoded; ++field_idx) {
+      memcpy(data + schema_->GetFieldOffset(field_idx),
+          coded + coded_schema_->GetFieldOffset(field_idx),
+          schema_->GetFieldAt(field_idx).field_.field_size_);
+    }
+    field_idx++;
+    char *value = data + schema_->GetFieldOffset(encoded);
+    auto  size  = schema_->GetFieldAt(encoded).field_.field_size_;
+    memset(value, 0, size);
+    if (BitMap::GetBit(nullmap, encoded)) {
+      continue;
+    }
+    auto                                code = Load<uint32_t>(coded, coded_schema_->GetFieldOffset(encoded));
+    std::shared_lock<std::shared_mutex> lock{latch_};
+    const auto                         &str = dicts_[encoded].values_.at(code);
+    memcpy(value, str.data(), std::min(str.size(), size));
+  }
+  for (; field_idx < schema_->GetFieldCount(); ++field_idx) {
+    memcpy(data + schema_->GetFieldOffset(field_idx),
+        coded + coded_schema_->GetFieldOffset(field_idx),
+        schema_->GetFieldAt(field_idx).field_.field_size_);
+  }
+}
+
+auto DictHandle::BindConditions(const ConditionVec &conds, const RecordSchema &stored_schema) const
+    -> std::vector<CodeCondition>
+{
+  std::vector<CodeCondition> code_conds;
+  for (const auto &cond : conds) {
+    if (cond.GetRhsType() != kValue) {
+      continue;
+    }
+    auto field_idx = schema_->GetRTFieldIndex(cond.GetLCol());
+    if (field_idx == schema_->GetFieldCount() || !schema_->GetFieldAt(field_idx).field_.dict_encoded_) {
+      continue;
+    }
+    // a literal that is not a string, e.g. null, is compared with the decoded value
+    std::vector<const StringValue *> literals;
+    if (cond.GetOp() == OP_IN) {
+      for (const auto &value : dynamic_cast<const ArrayValue &>(*cond.GetRVal()).Get()) {
+        literals.push_back(AsString(value));
+      }
+    } else if (cond.GetOp() == OP_EQ || cond.GetOp() == OP_NE) {
+      literals.push_back(AsString(cond.GetRVal()));
+    }
+    if (literals.empty() || std::find(literals.begin(), literals.end(), nullptr) != literals.end()) {
+      continue;
+    }
+    CodeCondition code_cond{field_idx, stored_schema.GetFieldOffset(field_idx), cond.GetOp() == OP_NE, {}};
+    for (const auto *literal : literals) {
+      // a value not in the dictionary is in no row
+      if (auto code = Lookup(field_idx, literal->Get()); code != INVALID_CODE) {
+        code_cond.codes_.push_back(code);
+      }
+    }
+    code_conds.push_back(std::move(code_cond));
+  }
+  return code_conds;
+}
+
+auto DictHandle::Match(const std::vector<CodeCondition> &conds, const char *nullmap, const char *stored) -> bool
+{
+  return std::all_of(conds.begin(), conds.end(), [nullmap, stored](const CodeCondition &cond) {
+    if (BitMap::GetBit(nullmap, cond.field_idx_)) {
+      return cond.is_ne_;
+    }
+    auto code = Load<uint32_t>(stored, cond.offset_);
+    bool hit  = std::find(cond.codes_.begin(), cond.codes_.end(), code) != cond.codes_.end();
+    return hit != cond.is_ne_;
+  });
+}
+
+auto DictHandle::MatchesNothing(const std::vector<CodeCondition> &conds) -> bool
+{
+  return std::any_of(
+      conds.begin(), conds.end(), [](const CodeCondition &cond) { return !cond.is_ne_ && cond.codes_.empty(); });
+}
+
+auto DictHandle::Encode(size_t field_idx, std::string_view value) -> uint32_t
+{
+  if (auto code = Lookup(field_idx, value); code != INVALID_CODE) {
+    return code;
+  }
+  std::unique_lock<std::shared_mutex> lock{latch_};
+  auto                               &dict = dicts_[field_idx];
+  // another thread may have added the value in between
+  if (auto it = dict.codes_.find(value); it != dict.codes_.end()) {
+    return it->second;
+  }
+  if (dict.values_.size() == INVALID_CODE) {
+    WSDB_THROW(
+        WSDB_RECLEN_ERROR, fmt::format("dictionary of {} is full", schema_->GetFieldAt(field_idx).field_.field_name_));
+  }
+  // the entry reaches the file before any row holds its code
+  std::vector<char> entry(ENTRY_VALUE_OFFSET + value.size());
+  Store<uint16_t>(entry.data(), ENTRY_FIELD_OFFSET, static_cast<uint16_t>(field_idx));
+  Store<uint32_t>(entry.data(), ENTRY_LENGTH_OFFSET, static_cast<uint32_t>(value.size()));
+  memcpy(entry.data() + ENTRY_VALUE_OFFSET, value.data(), value.size());
+  disk_manager_->WriteFile(fid_, entry.data(), entry.size(), SEEK_END);
+  dict.values_.emplace_back(value);
+  auto code = static_cast<uint32_t>(dict.values_.size() - 1);
+  dict.codes_.emplace(dict.values_.back(), code);
+  return code;
+}
+
+auto DictHandle::Lookup(size_t field_idx, std::string_view value) const -> uint32_t
+{
+  std::shared_lock<std::shared_mutex> lock{latch_};
+  const auto                         &codes = dicts_[field_idx].codes_;
+  auto                                it    = codes.find(value);
+  return it != codes.end() ? it->second : INVALID_CODE;
+}
+
+}  // namespace wsdb
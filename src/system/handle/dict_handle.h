@@ -0,0 +1,154 @@
+/*------------------------------------------------------------------------------
+ - Copyright (c) 2024. Websoft research group, Nanjing University.
+ -
+ - This program is free software: you can redistribute it and/or modify
+ - it under the terms of the GNU General Public License as published by
+ - the Free Software Foundation, either version 3 of the License, or
+ - (at your option) any later version.
+ -
+ - This program is distributed in the hope that it will be useful,
+ - but WITHOUT ANY WARRANTY; without even the implied warranty of
+ - MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ - GNU General Public License for more details.
+ -
+ - You should have received a copy of the GNU General Public License
+ - along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ -----------------------------------------------------------------------------*/
+
+//
+// Created by ziqi on 2024/9/22.
+//
+
+#ifndef WSDB_DICT_HANDLE_H
+#define WSDB_DICT_HANDLE_H
+
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "common/condition.h"
+#include "common/meta.h"
+#include "storage/storage.h"
+#include "record_handle.h"
+
+namespace wsdb {
+
+/**
+ * @brief Table-wide dictionary encoding of low-cardinality string fields declared with ENCODING DICT.
+ *
+ * Each encoded field has a dictionary of its own that maps its distinct values to codes in order of first appearance,
+ * the stored row keeps a CODE_SIZE-byte code in place of the string. A row that repeats a value takes a few bytes
+ * instead of the declared width, and equality predicates on the field are evaluated on codes, see BindConditions.
+ *
+ * dictionary file: | entries ... |, entry: | field idx (2) | length (4) | value |
+ * The dictionaries of all encoded fields of a table share one file, an entry is appended when a value is first seen, so
+ * codes never change and the file is replayed in order when the table is opened.
+ */
+class DictHandle
+{
+public:
+  // bytes of a code in the stored row
+  static constexpr size_t CODE_SIZE = sizeof(uint32_t);
+  // code of a value that is not in the dictionary
+  static constexpr uint32_t INVALID_CODE = UINT32_MAX;
+
+  /// a conjunct on an encoded field evaluated on codes, the row passes if its code is one of codes_, or is none of
+  /// codes_ if is_ne_, a null never equals a value
+  struct CodeCondition
+  {
+    size_t                field_idx_;
+    size_t                offset_;
+    bool                  is_ne_;
+    std::vector<uint32_t> codes_;
+  };
+
+  /**
+   * Read the dictionaries from the file
+   * @param disk_manager
+   * @param fid the dictionary file of the table
+   * @param schema
+   * @param coded_schema the schema with encoded fields replaced by codes, see MakeCodedSchema
+   */
+  DictHandle(DiskManager *disk_manager, file_id_t fid, const RecordSchema *schema, const RecordSchema *coded_schema);
+
+  DISABLE_COPY_MOVE_AND_ASSIGN(DictHandle)
+
+  /// @return the schema of rows with encoded fields replaced by their codes
+  static auto MakeCodedSchema(const RecordSchema &schema) -> RecordSchemaUptr;
+
+  /// @return whether any field of the schema is dictionary encoded
+  static auto HasEncodedField(const RecordSchema &schema) -> bool;
+
+  /**
+   * Replace the values of encoded fields by their codes, new values are added to the dictionaries
+   * @param nullmap
+   * @param data row in the layout of the schema
+   * @param[out] coded row in the layout of the coded schema
+   */
+  void Pack(const char *nullmap, const char *data, char *coded);
+
+  /**
+   * Restore the values of encoded fields from their codes
+   * @param nullmap
+   * @param coded row in the layout of the coded schema
+   * @param[out] data row in the layout of the schema
+   */
+  void Unpack(const char *nullmap, const char *coded, char *data) const;
+
+  /**
+   * Translate the conditions comparing an encoded field with string literals by =, <> or IN into code conditions,
+   * the other conditions are left to the caller
+   * @param conds
+   * @param stored_schema layout of the rows the code conditions are evaluated on, codes are at the same field index
+   * @return
+   */
+  [[nodiscard]] auto BindConditions(const ConditionVec &conds, const RecordSchema &stored_schema) const
+      -> std::vector<CodeCondition>;
+
+  /// @return whether a stored row satisfies all code conditions
+  static auto Match(const std::vector<CodeCondition> &conds, const char *nullmap, const char *stored) -> bool;
+
+  /// @return whether no row can satisfy the code conditions, i.e. a value compared by = or IN is in no dictionary
+  static auto MatchesNothing(const std::vector<CodeCondition> &conds) -> bool;
+
+  [[nodiscard]] auto GetFileId() const -> file_id_t { return fid_; }
+
+private:
+  struct StringHash
+  {
+    using is_transparent = void;
+
+    auto operator()(std::string_view value) const -> size_t { return std::hash<std::string_view>{}(value); }
+  };
+
+  struct Dictionary
+  {
+    std::vector<std::string>                                                    values_;
+    std::unordered_map<std::string, uint32_t, StringHash, std::equal_to<void>> codes_;
+  };
+
+  /// @return the code of the value, the value is added to the dictionary and appended to the file if it is new
+  auto Encode(size_t field_idx, std::string_view value) -> uint32_t;
+
+  /// @return the code of the value, INVALID_CODE if it is not in the dictionary
+  [[nodiscard]] auto Lookup(size_t field_idx, std::string_view value) const -> uint32_t;
+
+  DiskManager *const  disk_manager_;
+  const file_id_t     fid_;
+  const RecordSchema *schema_;
+  const RecordSchema *coded_schema_;
+  // index of encoded fields in the schema
+  std::vector<size_t> encoded_;
+  // dictionary of each field of the schema, empty for plain fields
+  std::vector<Dictionary> dicts_;
+  // lookups take it shared, adding a value takes it exclusively
+  mutable std::shared_mutex latch_;
+};
+
+DEFINE_UNIQUE_PTR(DictHandle);
+
+}  // namespace wsdb
+
+#endif  // WSDB_DICT_HANDLE_H
@@ -0,0 +1,174 @@
+/*------------------------------------------------------------------------------
+ - Copyright (c) 2024. Websoft research group, Nanjing University.
+ -
+ - This program is free software: you can redistribute it and/or modify
+ - it under the terms of the GNU General Public License as published by
+ - the Free Software Foundation, either version 3 of the License, or
+ - (at your option) any later version.
+ -
+ - This program is distributed in the hope that it will be useful,
+ - but WITHOUT ANY WARRANTY; without even the implied warranty of
+ - MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ - GNU General Public License for more details.
+ -
+ - You should have received a copy of the GNU General Public License
+ - along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ -----------------------------------------------------------------------------*/
+
+//
+// Created by ziqi on 2024/9/17.
+//
+
+#include "lsm_engine.h"
+
+#include <cstring>
+#include <limits>
+
+namespace wsdb {
+
+/// rows of the tree in key order, the rid of a key is made up by the engine
+class LsmEngine::Iterator : public EngineIterator
+{
+public:
+  Iterator(const LsmEngine *engine, LsmIteratorUptr iter) : engine_(engine), iter_(std::move(iter)) {}
+
+  [[nodiscard]] auto IsEnd() const -> bool override { return iter_->IsEnd(); }
+
+  void Next() override { iter_->Next(); }
+
+  [[nodiscard]] auto GetRID() const -> RID override { return engine_->RIDOf(iter_->GetKey()); }
+
+  [[nodiscard]] auto GetRecord() -> RecordUptr override
+  {
+    auto value = iter_->GetValue();
+    return std::make_unique<Record>(engine_->schema_, value, value + engine_->nullmap_size_, GetRID());
+  }
+
+private:
+  const LsmEngine *const engine_;
+  LsmIteratorUptr        iter_;
+};
+
+LsmEngine::LsmEngine(const std::string &file_prefix, const RecordSchema *schema, const TableHeader &tab_hdr)
+    : schema_(schema),
+      rec_per_page_(tab_hdr.rec_per_page_),
+      nullmap_size_(tab_hdr.nullmap_size_),
+      rec_size_(tab_hdr.rec_size_),
+      lsm_(file_prefix, nullmap_size_ + rec_size_)
+{}
+
+auto LsmEngine::GetRecord(const RID &rid) -> RecordUptr
+{
+  std::vector<char> value;
+  if (!ReadRow(KeyOf(rid), value)) {
+    WSDB_THROW(WSDB_RECORD_MISS, fmt::format("RID(SlotID:{},PageID:{})", rid.SlotID(), rid.PageID()));
+  }
+  return std::make_unique<Record>(schema_, value.data(), value.data() + nullmap_size_, rid);
+}
+
+auto LsmEngine::InsertRecords(std::span<const Record> records) -> std::vector<RID>
+{
+  std::vector<RID> rids;
+  rids.reserve(records.size());
+  // keys are allocated at once, no other insert takes them, so the rows are put without the latch
+  auto key = lsm_.AllocateKeys(records.size());
+  for (const auto &record : records) {
+    PutRecord(key, record);
+    rids.push_back(RIDOf(key++));
+  }
+  return rids;
+}
+
+void LsmEngine::InsertRecord(const RID &rid, const Record &record)
+{
+  std::lock_guard<std::mutex> lock{latch_};
+  auto                        key = KeyOf(rid);
+  std::vector<char>           value;
+  if (key >= lsm_.GetNextKey()) {
+    WSDB_THROW(WSDB_PAGE_MISS, fmt::format("Page: {}", rid.PageID()));
+  }
+  if (ReadRow(key, value)) {
+    WSDB_THROW(WSDB_RECORD_EXISTS, fmt::format("RID(SlotID:{},PageID:{})", rid.SlotID(), rid.PageID()));
+  }
+  PutRecord(key, record);
+}
+
+void LsmEngine::DeleteRecord(const RID &rid)
+{
+  std::lock_guard<std::mutex> lock{latch_};
+  std::vector<char>           value;
+  if (!ReadRow(KeyOf(rid), value)) {
+    WSDB_THROW(WSDB_RECORD_MISS, fmt::format("RID(SlotID:{},PageID:{})", rid.SlotID(), rid.PageID()));
+  }
+  lsm_.Delete(KeyOf(rid));
+}
+
+void LsmEngine::UpdateRecord(const RID &rid, const Record &record)
+{
+  std::lock_guard<std::mutex> lock{latch_};
+  std::vector<char>           value;
+  if (!ReadRow(KeyOf(rid), value)) {
+    WSDB_THROW(WSDB_RECORD_MISS, fmt::format("RID(SlotID:{},PageID:{})", rid.SlotID(), rid.PageID()));
+  }
+  PutRecord(KeyOf(rid), record);
+}
+
+auto LsmEngine::Vacuum(size_t /*page_num*/, const std::function<void(const Record &, const Record &)> & /*on_move*/)
+    -> bool
+{
+  // deleted rows are dropped by compaction in the background
+  return false;
+}
+
+auto LsmEngine::GetExtremum(size_t /*field_idx*/, bool /*is_max*/) -> ValueSptr
+{
+  // no zone map is kept of the runs
+  return nullptr;
+}
+
+void LsmEngine::Snapshot() { lsm_.Flush(); }
+
+auto LsmEngine::GetFirstRID() -> RID
+{
+  auto iter = lsm_.MakeIterator();
+  return iter->IsEnd() ? INVALID_RID : RIDOf(iter->GetKey());
+}
+
+auto LsmEngine::GetNextRID(const RID &rid) -> RID
+{
+  auto iter = lsm_.MakeIterator(KeyOf(rid) + 1);
+  return iter->IsEnd() ? INVALID_RID : RIDOf(iter->GetKey());
+}
+
+auto LsmEngine::MakeIterator() -> EngineIteratorUptr { return std::make_unique<Iterator>(this, lsm_.MakeIterator()); }
+
+auto LsmEngine::KeyOf(const RID &rid) const -> lsm_key_t
+{
+  if (rid.PageID() <= FILE_HEADER_PAGE_ID || rid.SlotID() < 0 || static_cast<size_t>(rid.SlotID()) >= rec_per_page_) {
+    // no row has the key
+    return std::numeric_limits<lsm_key_t>::max() - 1;
+  }
+  return static_cast<lsm_key_t>(rid.PageID() - FILE_HEADER_PAGE_ID - 1) * rec_per_page_ + rid.SlotID();
+}
+
+auto LsmEngine::RIDOf(lsm_key_t key) const -> RID
+{
+  return {static_cast<page_id_t>(key / rec_per_page_ + FILE_HEADER_PAGE_ID + 1),
+      static_cast<slot_id_t>(key % rec_per_page_)};
+}
+
+auto LsmEngine::ReadRow(lsm_key_t key, std::vector<char> &value) -> bool
+{
+  value.resize(nullmap_size_ + rec_size_);
+  return lsm_.Get(key, value.data());
+}
+
+void LsmEngine::PutRecord(lsm_key_t key, const Record &record)
+{
+  std::vector<char> value(nullmap_size_ + rec_size_);
+  memcpy(value.data(), record.GetNullMap(), nullmap_size_);
+  memcpy(value.data() + nullmap_size_, record.GetData(), rec_size_);
+  lsm_.Put(key, value.data());
+}
+
+}  // namespace wsdb
@@ -0,0 +1,102 @@
+/*------------------------------------------------------------------------------
+ - Copyright (c) 2024. Websoft research group, Nanjing University.
+ -
+ - This program is free software: you can redistribute it and/or modify
+ - it under the terms of the GNU General Public License as published by
+ - the Free Software Foundation, either version 3 of the License, or
+ - (at your option) any later version.
+ -
+ - This program is distributed in the hope that it will be useful,
+ - but WITHOUT ANY WARRANTY; without even the implied warranty of
+ - MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ - GNU General Public License for more details.
+ -
+ - You should have received a copy of the GNU General Public License
+ - along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ -----------------------------------------------------------------------------*/
+
+//
+// Created by ziqi on 2024/9/17.
+//
+
+#ifndef WSDB_LSM_ENGINE_H
+#define WSDB_LSM_ENGINE_H
+
+#include <mutex>  // NOLINT
+#include <string>
+
+#include "common/meta.h"
+#include "common/page.h"
+#include "lsm_tree.h"
+#include "storage_engine.h"
+
+namespace wsdb {
+
+/**
+ * @brief Rows of an lsm table, stored in an LsmTree as their nullmap and data back to back.
+ *
+ * Rows are keyed by the order they are inserted in, the rid of the n-th inserted row is where it would be in a full
+ * nary table, so rids handed out before stay valid as rows are compacted. Deleted rows are dropped by compaction in the
+ * background, there is nothing to vacuum.
+ */
+class LsmEngine : public StorageEngine
+{
+public:
+  /**
+   * @param file_prefix the files of the tree are named after it
+   * @param schema
+   * @param tab_hdr rows take nullmap_size_ + rec_size_ bytes, rec_per_page_ rows share a page id in their rids
+   */
+  LsmEngine(const std::string &file_prefix, const RecordSchema *schema, const TableHeader &tab_hdr);
+
+  auto GetRecord(const RID &rid) -> RecordUptr override;
+
+  auto InsertRecords(std::span<const Record> records) -> std::vector<RID> override;
+
+  void InsertRecord(const RID &rid, const Record &record) override;
+
+  void DeleteRecord(const RID &rid) override;
+
+  void UpdateRecord(const RID &rid, const Record &record) override;
+
+  auto Vacuum(size_t page_num, const std::function<void(const Record &, const Record &)> &on_move) -> bool override;
+
+  auto GetExtremum(size_t field_idx, bool is_max) -> ValueSptr override;
+
+  /// flush the memtable to a sorted run
+  void Snapshot() override;
+
+  auto GetFirstRID() -> RID override;
+
+  auto GetNextRID(const RID &rid) -> RID override;
+
+  /// go through the rows in key order, i.e. the order they are inserted in
+  auto MakeIterator() -> EngineIteratorUptr override;
+
+private:
+  class Iterator;
+
+  /// @return key of the row at rid, a key no row has if the rid is not one of the engine
+  [[nodiscard]] auto KeyOf(const RID &rid) const -> lsm_key_t;
+
+  [[nodiscard]] auto RIDOf(lsm_key_t key) const -> RID;
+
+  /// @return false if no row has the key, value is filled otherwise
+  auto ReadRow(lsm_key_t key, std::vector<char> &value) -> bool;
+
+  /// write the nullmap and the data of the record to the tree
+  void PutRecord(lsm_key_t key, const Record &record);
+
+private:
+  const RecordSchema *const schema_;
+  const size_t              rec_per_page_;
+  const size_t              nullmap_size_;
+  const size_t              rec_size_;
+  // a row is checked and written under it, so concurrent deletes count it out once and inserts at a rid put it once
+  std::mutex latch_;
+  LsmTree    lsm_;
+};
+
+}  // namespace wsdb
+
+#endif  // WSDB_LSM_ENGINE_H
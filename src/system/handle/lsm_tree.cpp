@@ -0,0 +1,909 @@
+/*------------------------------------------------------------------------------
+ - Copyright (c) 2024. Websoft research group, Nanjing University.
+ -
+ - This program is free software: you can redistribute it and/or modify
+ - it under the terms of the GNU General Public License as published by
+ - the Free Software Foundation, either version 3 of the License, or
+ - (at your option) any later version.
+ -
+ - This program is distributed in the hope that it will be useful,
+ - but WITHOUT ANY WARRANTY; without even the implied warranty of
+ - MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ - GNU General Public License for more details.
+ -
+ - You should have received a copy of the GNU General Public License
+ - along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ -----------------------------------------------------------------------------*/
+
+//
+// Created by ziqi on 2024/9/17.
+//
+
+#include "lsm_tree.h"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <random>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "../../../common/error.h"
+#include "common/config.h"
+
+namespace wsdb {
+
+namespace {
+// | key (8) | tombstone (1) | value |
+constexpr size_t ENTRY_HEADER_SIZE = sizeof(lsm_key_t) + 1;
+// the bloom filter of a run is fastest with bits per key * ln 2 hash functions
+constexpr size_t BLOOM_HASH_NUM = std::max<size_t>(1, LSM_BLOOM_BITS_PER_KEY * 69 / 100);
+
+auto LoadKey(const char *src) -> lsm_key_t
+{
+  lsm_key_t key;
+  memcpy(&key, src, sizeof(lsm_key_t));
+  return key;
+}
+
+void StoreKey(char *dst, lsm_key_t key) { memcpy(dst, &key, sizeof(lsm_key_t)); }
+
+/// splitmix64, keys are mostly consecutive and must be spread over the filter
+auto BloomHash(lsm_key_t key) -> uint64_t
+{
+  key += 0x9e3779b97f4a7c15ULL;
+  key = (key ^ (key >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  key = (key ^ (key >> 27)) * 0x94d049bb133111ebULL;
+  return key ^ (key >> 31);
+}
+
+/// call f with the bit of each hash function for the key, hashes are derived from two halves of one hash
+template <typename F>
+void ForEachBloomBit(lsm_key_t key, size_t bit_num, F &&f)
+{
+  auto hash  = BloomHash(key);
+  auto delta = (hash >> 32) | 1;
+  for (size_t i = 0; i < BLOOM_HASH_NUM; ++i) {
+    f(static_cast<size_t>(hash % bit_num));
+    hash += delta;
+  }
+}
+
+void ReadAt(int fd, char *data, size_t size, size_t offset, const std::string &file_name)
+{
+  if (pread(fd, data, size, static_cast<off_t>(offset)) != static_cast<ssize_t>(size)) {
+    WSDB_THROW(WSDB_FILE_READ_ERROR, file_name);
+  }
+}
+
+void WriteAt(int fd, const char *data, size_t size, size_t offset, const std::string &file_name)
+{
+  if (pwrite(fd, data, size, static_cast<off_t>(offset)) != static_cast<ssize_t>(size)) {
+    WSDB_THROW(WSDB_FILE_WRITE_ERROR, file_name);
+  }
+}
+
+/// manifest: | next key (8) | next run id (8) | level num (8) | for each level: run num (8) | run ids (8 each) |
+void ReadManifestFile(const std::string &file_name, lsm_key_t &next_key, size_t &next_run_id,
+    std::vector<std::vector<size_t>> &levels)
+{
+  std::ifstream file(file_name, std::ios::binary);
+  size_t        level_num = 0;
+  file.read(reinterpret_cast<char *>(&next_key), sizeof(next_key));
+  file.read(reinterpret_cast<char *>(&next_run_id), sizeof(next_run_id));
+  file.read(reinterpret_cast<char *>(&level_num), sizeof(level_num));
+  levels.resize(level_num);
+  for (auto &level : levels) {
+    size_t run_num = 0;
+    file.read(reinterpret_cast<char *>(&run_num), sizeof(run_num));
+    level.resize(run_num);
+    file.read(reinterpret_cast<char *>(level.data()), static_cast<std::streamsize>(run_num * sizeof(size_t)));
+  }
+  if (!file) {
+    WSDB_THROW(WSDB_FILE_READ_ERROR, file_name);
+  }
+}
+}  // namespace
+
+/**
+ * @brief Skiplist of the latest entry of each key written to the tree, writers are serialized by its latch
+ */
+class MemTable
+{
+public:
+  explicit MemTable(size_t value_size) : value_size_(value_size) {}
+
+  ~MemTable()
+  {
+    auto node = head_.next_[0];
+    while (node != nullptr) {
+      auto next = node->next_[0];
+      delete node;
+      node = next;
+    }
+  }
+
+  DISABLE_COPY_MOVE_AND_ASSIGN(MemTable)
+
+  /// insert the entry, or overwrite the entry of the key
+  void Put(lsm_key_t key, const char *value, bool tombstone)
+  {
+    std::unique_lock<std::shared_mutex> lock{latch_};
+    std::array<Node *, MAX_HEIGHT>      prev{};
+    auto                                node = FindGreaterOrEqual(key, prev.data());
+    if (node == nullptr || node->key_ != key) {
+      size_t height = 1;
+      while (height < MAX_HEIGHT && rng_() % 4 == 0) {
+        height++;
+      }
+      for (; height_ < height; ++height_) {
+        prev[height_] = &head_;
+      }
+      node         = new Node;
+      node->key_   = key;
+      node->value_ = std::make_unique<char[]>(value_size_);
+      for (size_t i = 0; i < height; ++i) {
+        node->next_[i]    = prev[i]->next_[i];
+        prev[i]->next_[i] = node;
+      }
+      size_.fetch_add(ENTRY_HEADER_SIZE + value_size_);
+    }
+    node->tombstone_ = tombstone;
+    if (!tombstone) {
+      memcpy(node->value_.get(), value, value_size_);
+    }
+  }
+
+  /// @return false if there is no entry of the key, tombstone tells whether the entry deletes the key
+  auto Get(lsm_key_t key, bool &tombstone, char *value) -> bool
+  {
+    lsm_key_t found;
+    return Seek(key, found, tombstone, value) && found == key;
+  }
+
+  /// find the first entry whose key is not less than key, the value is not copied for tombstones
+  auto Seek(lsm_key_t key, lsm_key_t &found, bool &tombstone, char *value) -> bool
+  {
+    std::shared_lock<std::shared_mutex> lock{latch_};
+    auto                                node = FindGreaterOrEqual(key, nullptr);
+    if (node == nullptr) {
+      return false;
+    }
+    found     = node->key_;
+    tombstone = node->tombstone_;
+    if (!tombstone) {
+      memcpy(value, node->value_.get(), value_size_);
+    }
+    return true;
+  }
+
+  /// @return bytes of the entries as they are written to a run
+  [[nodiscard]] auto GetSize() const -> size_t { return size_.load(); }
+
+private:
+  static constexpr size_t MAX_HEIGHT = 12;
+
+  struct Node
+  {
+    lsm_key_t                      key_{0};
+    bool                           tombstone_{false};
+    std::unique_ptr<char[]>        value_;
+    std::array<Node *, MAX_HEIGHT> next_{};
+  };
+
+  /// @param[out] prev the last node before key at each height if not nullptr
+  auto FindGreaterOrEqual(lsm_key_t key, Node **prev) -> Node *
+  {
+    Node *node = &head_;
+    for (auto i = static_cast<int>(MAX_HEIGHT) - 1; i >= 0; --i) {
+      while (node->next_[i] != nullptr && node->next_[i]->key_ < key) {
+        node = node->next_[i];
+      }
+      if (prev != nullptr) {
+        prev[i] = node;
+      }
+    }
+    return node->next_[0];
+  }
+
+  const size_t        value_size_;
+  std::shared_mutex   latch_;
+  Node                head_;
+  size_t              height_{1};
+  std::minstd_rand    rng_;
+  std::atomic<size_t> size_{0};
+};
+
+/**
+ * @brief An immutable file of entries sorted by key, see LsmTree.
+ *
+ * run file: | header page: entry num (8) | block num (8) | value size (8) | bloom bytes (8) | blocks ... |
+ * | fence pointers: first key of each block | bloom filter |
+ * A block is a page of entries, the last block may be partly filled.
+ * The file is deleted when the run is obsolete and no one reads it any more.
+ */
+class SortedRun
+{
+public:
+  SortedRun(std::string file_name, size_t run_id, size_t value_size)
+      : file_name_(std::move(file_name)),
+        run_id_(run_id),
+        entry_size_(ENTRY_HEADER_SIZE + value_size),
+        entries_per_block_(PAGE_SIZE / entry_size_)
+  {
+    fd_ = open(file_name_.c_str(), O_RDONLY);
+    if (fd_ < 0) {
+      WSDB_THROW(WSDB_FILE_NOT_OPEN, file_name_);
+    }
+    std::array<size_t, 4> header{};
+    ReadAt(fd_, reinterpret_cast<char *>(header.data()), sizeof(header), 0, file_name_);
+    entry_num_ = header[0];
+    fences_.resize(header[1]);
+    WSDB_ASSERT(header[2] == value_size, fmt::format("value size mismatch in {}", file_name_));
+    bloom_.resize(header[3]);
+    auto offset = (fences_.size() + 1) * PAGE_SIZE;
+    ReadAt(fd_, reinterpret_cast<char *>(fences_.data()), fences_.size() * sizeof(lsm_key_t), offset, file_name_);
+    offset += fences_.size() * sizeof(lsm_key_t);
+    ReadAt(fd_, bloom_.data(), bloom_.size(), offset, file_name_);
+  }
+
+  ~SortedRun()
+  {
+    close(fd_);
+    if (obsolete_.load()) {
+      unlink(file_name_.c_str());
+    }
+  }
+
+  DISABLE_COPY_MOVE_AND_ASSIGN(SortedRun)
+
+  /// @return false if there is no entry of the key, tombstone tells whether the entry deletes the key
+  auto Get(lsm_key_t key, bool &tombstone, char *value) const -> bool
+  {
+    if (!MayContain(key)) {
+      return false;
+    }
+    std::vector<char> block(PAGE_SIZE);
+    size_t            block_idx;
+    auto              entry_idx = Search(key, block.data(), block_idx);
+    // past the last entry of the block, the next one starts at its fence, which is greater than key
+    if (entry_idx == GetEntryNumOf(block_idx)) {
+      return false;
+    }
+    const char *entry = block.data() + entry_idx * entry_size_;
+    if (LoadKey(entry) != key) {
+      return false;
+    }
+    tombstone = entry[sizeof(lsm_key_t)] != 0;
+    memcpy(value, entry + ENTRY_HEADER_SIZE, entry_size_ - ENTRY_HEADER_SIZE);
+    return true;
+  }
+
+  /**
+   * Find the first entry whose key is not less than key
+   * @param block[out] PAGE_SIZE bytes, holds the block of block_idx on return
+   * @return false if every key of the run is less than key
+   */
+  auto LowerBound(lsm_key_t key, char *block, size_t &block_idx, size_t &entry_idx) const -> bool
+  {
+    entry_idx = Search(key, block, block_idx);
+    if (entry_idx == GetEntryNumOf(block_idx)) {
+      // the key is greater than every key of the block, the next block starts with a greater key
+      block_idx++;
+      entry_idx = 0;
+      if (block_idx == fences_.size()) {
+        return false;
+      }
+      ReadBlock(block_idx, block);
+    }
+    return true;
+  }
+
+  void ReadBlock(size_t block_idx, char *data) const
+  {
+    ReadAt(fd_, data, PAGE_SIZE, (block_idx + 1) * PAGE_SIZE, file_name_);
+  }
+
+  [[nodiscard]] auto GetEntryNumOf(size_t block_idx) const -> size_t
+  {
+    return std::min(entries_per_block_, entry_num_ - block_idx * entries_per_block_);
+  }
+
+  [[nodiscard]] auto GetBlockNum() const -> size_t { return fences_.size(); }
+
+  [[nodiscard]] auto GetEntrySize() const -> size_t { return entry_size_; }
+
+  [[nodiscard]] auto GetRunId() const -> size_t { return run_id_; }
+
+  /// @return bytes of the entries
+  [[nodiscard]] auto GetSize() const -> size_t { return entry_num_ * entry_size_; }
+
+  /// the run is merged into another one, delete the file once the last reader is done
+  void MarkObsolete() { obsolete_.store(true); }
+
+private:
+  /**
+   * Read the block found by the fence pointers into block
+   * @return index of the first entry of the block whose key is not less than key, the entry num of the block if none
+   */
+  auto Search(lsm_key_t key, char *block, size_t &block_idx) const -> size_t
+  {
+    auto it   = std::upper_bound(fences_.begin(), fences_.end(), key);
+    block_idx = it == fences_.begin() ? 0 : static_cast<size_t>(it - fences_.begin()) - 1;
+    ReadBlock(block_idx, block);
+    size_t lo = 0;
+    size_t hi = GetEntryNumOf(block_idx);
+    while (lo < hi) {
+      auto mid = (lo + hi) / 2;
+      if (LoadKey(block + mid * entry_size_) < key) {
+        lo = mid + 1;
+      } else {
+        hi = mid;
+      }
+    }
+    return lo;
+  }
+
+  [[nodiscard]] auto MayContain(lsm_key_t key) const -> bool
+  {
+    bool found = true;
+    ForEachBloomBit(key, bloom_.size() * 8, [&](size_t bit) {
+      found = found && ((static_cast<uint8_t>(bloom_[bit / 8]) >> (bit % 8)) & 1) != 0;
+    });
+    return found;
+  }
+
+  const std::string      file_name_;
+  const size_t           run_id_;
+  const size_t           entry_size_;
+  const size_t           entries_per_block_;
+  int                    fd_{-1};
+  size_t                 entry_num_{0};
+  std::vector<lsm_key_t> fences_;
+  std::vector<char>      bloom_;
+  std::atomic<bool>      obsolete_{false};
+};
+
+/**
+ * @brief Write entries in key order to a new run file, blocks are appended to the file as they fill up
+ */
+class RunWriter
+{
+public:
+  RunWriter(std::string file_name, size_t value_size)
+      : file_name_(std::move(file_name)),
+        value_size_(value_size),
+        entry_size_(ENTRY_HEADER_SIZE + value_size),
+        block_(PAGE_SIZE)
+  {
+    fd_ = open(file_name_.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd_ < 0) {
+      WSDB_THROW(WSDB_FILE_NOT_OPEN, file_name_);
+    }
+  }
+
+  ~RunWriter() { close(fd_); }
+
+  DISABLE_COPY_MOVE_AND_ASSIGN(RunWriter)
+
+  void Append(lsm_key_t key, bool tombstone, const char *value)
+  {
+    if (block_used_ + entry_size_ > PAGE_SIZE) {
+      WriteBlock();
+    }
+    if (block_used_ == 0) {
+      fences_.push_back(key);
+    }
+    char *entry = block_.data() + block_used_;
+    StoreKey(entry, key);
+    entry[sizeof(lsm_key_t)] = tombstone ? 1 : 0;
+    if (tombstone) {
+      memset(entry + ENTRY_HEADER_SIZE, 0, value_size_);
+    } else {
+      memcpy(entry + ENTRY_HEADER_SIZE, value, value_size_);
+    }
+    block_used_ += entry_size_;
+    keys_.push_back(key);
+  }
+
+  /**
+   * Write the last block, the fence pointers, the bloom filter and the header
+   * @return number of entries written
+   */
+  auto Finish() -> size_t
+  {
+    if (block_used_ > 0) {
+      WriteBlock();
+    }
+    std::vector<char> bloom((std::max<size_t>(64, keys_.size() * LSM_BLOOM_BITS_PER_KEY) + 7) / 8);
+    for (auto key : keys_) {
+      ForEachBloomBit(key, bloom.size() * 8, [&](size_t bit) { bloom[bit / 8] |= static_cast<char>(1 << (bit % 8)); });
+    }
+    auto offset = (fences_.size() + 1) * PAGE_SIZE;
+    WriteAt(
+        fd_, reinterpret_cast<const char *>(fences_.data()), fences_.size() * sizeof(lsm_key_t), offset, file_name_);
+    offset += fences_.size() * sizeof(lsm_key_t);
+    WriteAt(fd_, bloom.data(), bloom.size(), offset, file_name_);
+    std::vector<char>     header_page(PAGE_SIZE);
+    std::array<size_t, 4> header{keys_.size(), fences_.size(), value_size_, bloom.size()};
+    memcpy(header_page.data(), header.data(), sizeof(header));
+    WriteAt(fd_, header_page.data(), PAGE_SIZE, 0, file_name_);
+    return keys_.size();
+  }
+
+private:
+  void WriteBlock()
+  {
+    memset(block_.data() + block_used_, 0, PAGE_SIZE - block_used_);
+    WriteAt(fd_, block_.data(), PAGE_SIZE, fences_.size() * PAGE_SIZE, file_name_);
+    block_used_ = 0;
+  }
+
+  const std::string      file_name_;
+  const size_t           value_size_;
+  const size_t           entry_size_;
+  int                    fd_{-1};
+  std::vector<char>      block_;
+  size_t                 block_used_{0};
+  std::vector<lsm_key_t> fences_;
+  std::vector<lsm_key_t> keys_;
+};
+
+struct LsmVersion
+{
+  // level 0 from the newest run to the oldest, a single run in each other level, empty if there is none
+  std::vector<std::vector<std::shared_ptr<SortedRun>>> levels_;
+};
+
+/**
+ * @brief A sorted stream of entries of a memtable or a run, merged by LsmIterator
+ */
+class LsmSource
+{
+public:
+  virtual ~LsmSource() = default;
+
+  [[nodiscard]] auto IsEnd() const -> bool { return is_end_; }
+
+  [[nodiscard]] auto GetKey() const -> lsm_key_t { return key_; }
+
+  [[nodiscard]] auto IsTombstone() const -> bool { return tombstone_; }
+
+  [[nodiscard]] auto GetValue() const -> const char * { return value_; }
+
+  virtual void Next() = 0;
+
+protected:
+  bool        is_end_{true};
+  lsm_key_t   key_{0};
+  bool        tombstone_{false};
+  const char *value_{nullptr};
+};
+
+namespace {
+/// the memtable may be written while it is read, each step seeks the key after the current one again
+class MemSource : public LsmSource
+{
+public:
+  MemSource(std::shared_ptr<MemTable> mem, size_t value_size, lsm_key_t key) : mem_(std::move(mem)), buf_(value_size)
+  {
+    value_ = buf_.data();
+    Seek(key);
+  }
+
+  void Next() override
+  {
+    if (key_ == std::numeric_limits<lsm_key_t>::max()) {
+      is_end_ = true;
+      return;
+    }
+    Seek(key_ + 1);
+  }
+
+private:
+  void Seek(lsm_key_t key) { is_end_ = !mem_->Seek(key, key_, tombstone_, buf_.data()); }
+
+  std::shared_ptr<MemTable> mem_;
+  std::vector<char>         buf_;
+};
+
+/// reads the run block by block
+class RunSource : public LsmSource
+{
+public:
+  RunSource(std::shared_ptr<SortedRun> run, lsm_key_t key) : run_(std::move(run)), block_(PAGE_SIZE)
+  {
+    if (run_->LowerBound(key, block_.data(), block_idx_, entry_idx_)) {
+      Load();
+    }
+  }
+
+  void Next() override
+  {
+    if (++entry_idx_ == run_->GetEntryNumOf(block_idx_)) {
+      entry_idx_ = 0;
+      if (++block_idx_ == run_->GetBlockNum()) {
+        is_end_ = true;
+        return;
+      }
+      run_->ReadBlock(block_idx_, block_.data());
+    }
+    Load();
+  }
+
+private:
+  void Load()
+  {
+    const char *entry = block_.data() + entry_idx_ * run_->GetEntrySize();
+    is_end_           = false;
+    key_              = LoadKey(entry);
+    tombstone_        = entry[sizeof(lsm_key_t)] != 0;
+    value_            = entry + ENTRY_HEADER_SIZE;
+  }
+
+  std::shared_ptr<SortedRun> run_;
+  std::vector<char>          block_;
+  size_t                     block_idx_{0};
+  size_t                     entry_idx_{0};
+};
+}  // namespace
+
+LsmIterator::LsmIterator(std::vector<std::unique_ptr<LsmSource>> sources, lsm_key_t key, bool skip_tombstones)
+    : sources_(std::move(sources)), skip_tombstones_(skip_tombstones), key_(key)
+{
+  Settle();
+}
+
+LsmIterator::~LsmIterator() = default;
+
+auto LsmIterator::IsTombstone() const -> bool { return sources_[source_idx_]->IsTombstone(); }
+
+auto LsmIterator::GetValue() const -> const char * { return sources_[source_idx_]->GetValue(); }
+
+void LsmIterator::Next()
+{
+  WSDB_ASSERT(!is_end_, "LsmIterator is end");
+  // older entries of the key are skipped along with the current one
+  for (auto &source : sources_) {
+    if (!source->IsEnd() && source->GetKey() == key_) {
+      source->Next();
+    }
+  }
+  Settle();
+}
+
+void LsmIterator::Settle()
+{
+  while (true) {
+    is_end_ = true;
+    for (size_t i = 0; i < sources_.size(); ++i) {
+      if (!sources_[i]->IsEnd() && (is_end_ || sources_[i]->GetKey() < key_)) {
+        is_end_     = false;
+        key_        = sources_[i]->GetKey();
+        source_idx_ = i;
+      }
+    }
+    if (is_end_ || !skip_tombstones_ || !IsTombstone()) {
+      return;
+    }
+    for (auto &source : sources_) {
+      if (!source->IsEnd() && source->GetKey() == key_) {
+        source->Next();
+      }
+    }
+  }
+}
+
+LsmTree::LsmTree(std::string file_prefix, size_t value_size)
+    : file_prefix_(std::move(file_prefix)), value_size_(value_size), mem_(std::make_shared<MemTable>(value_size))
+{
+  ReadManifest();
+  background_ = std::thread(&LsmTree::BackgroundWork, this);
+}
+
+LsmTree::~LsmTree()
+{
+  {
+    std::unique_lock<std::shared_mutex> lock{latch_};
+    stop_ = true;
+  }
+  cv_.notify_all();
+  background_.join();
+}
+
+void LsmTree::DestroyFiles(const std::string &file_prefix)
+{
+  auto manifest = file_prefix + LSM_SUFFIX;
+  if (!std::filesystem::exists(manifest)) {
+    return;
+  }
+  lsm_key_t                        next_key;
+  size_t                           next_run_id;
+  std::vector<std::vector<size_t>> levels;
+  ReadManifestFile(manifest, next_key, next_run_id, levels);
+  for (const auto &level : levels) {
+    for (auto run_id : level) {
+      std::filesystem::remove(fmt::format("{}_{}{}", file_prefix, run_id, RUN_SUFFIX));
+    }
+  }
+  std::filesystem::remove(manifest);
+}
+
+auto LsmTree::AllocateKeys(size_t num) -> lsm_key_t { return next_key_.fetch_add(num); }
+
+void LsmTree::Put(lsm_key_t key, const char *value) { Write(key, value, false); }
+
+void LsmTree::Delete(lsm_key_t key) { Write(key, nullptr, true); }
+
+void LsmTree::Write(lsm_key_t key, const char *value, bool tombstone)
+{
+  while (true) {
+    {
+      std::shared_lock<std::shared_mutex> lock{latch_};
+      if (mem_->GetSize() < LSM_MEMTABLE_SIZE) {
+        mem_->Put(key, value, tombstone);
+        return;
+      }
+    }
+    // the memtable is full, it turns immutable unless the last one is still being flushed, wait for the flush then
+    std::unique_lock<std::shared_mutex> lock{latch_};
+    cv_.wait(lock, [&]() { return imm_ == nullptr || mem_->GetSize() < LSM_MEMTABLE_SIZE; });
+    if (mem_->GetSize() >= LSM_MEMTABLE_SIZE) {
+      imm_ = std::move(mem_);
+      mem_ = std::make_shared<MemTable>(value_size_);
+      cv_.notify_all();
+    }
+  }
+}
+
+auto LsmTree::Get(lsm_key_t key, char *value) -> bool
+{
+  std::shared_ptr<MemTable>         mem;
+  std::shared_ptr<MemTable>         imm;
+  std::shared_ptr<const LsmVersion> version;
+  {
+    std::shared_lock<std::shared_mutex> lock{latch_};
+    mem     = mem_;
+    imm     = imm_;
+    version = version_;
+  }
+  bool tombstone = false;
+  if (mem->Get(key, tombstone, value) || (imm != nullptr && imm->Get(key, tombstone, value))) {
+    return !tombstone;
+  }
+  for (const auto &level : version->levels_) {
+    for (const auto &run : level) {
+      if (run->Get(key, tombstone, value)) {
+        return !tombstone;
+      }
+    }
+  }
+  return false;
+}
+
+auto LsmTree::MakeIterator(lsm_key_t key) -> LsmIteratorUptr
+{
+  std::vector<std::unique_ptr<LsmSource>> sources;
+  std::shared_ptr<const LsmVersion>       version;
+  {
+    std::shared_lock<std::shared_mutex> lock{latch_};
+    sources.push_back(std::make_unique<MemSource>(mem_, value_size_, key));
+    if (imm_ != nullptr) {
+      sources.push_back(std::make_unique<MemSource>(imm_, value_size_, key));
+    }
+    version = version_;
+  }
+  for (const auto &level : version->levels_) {
+    for (const auto &run : level) {
+      sources.push_back(std::make_unique<RunSource>(run, key));
+    }
+  }
+  return std::make_unique<LsmIterator>(std::move(sources), key, true);
+}
+
+void LsmTree::Flush()
+{
+  std::lock_guard<std::mutex> work_lock{work_latch_};
+  // a memtable may have turned immutable without the background thread getting to it yet
+  FlushMemTable();
+  {
+    std::unique_lock<std::shared_mutex> lock{latch_};
+    if (mem_->GetSize() > 0) {
+      imm_ = std::move(mem_);
+      mem_ = std::make_shared<MemTable>(value_size_);
+    }
+  }
+  FlushMemTable();
+  WriteManifest(*GetVersion());
+}
+
+auto LsmTree::GetRunNum(size_t level) -> size_t
+{
+  auto version = GetVersion();
+  return level < version->levels_.size() ? version->levels_[level].size() : 0;
+}
+
+auto LsmTree::GetVersion() -> std::shared_ptr<const LsmVersion>
+{
+  std::shared_lock<std::shared_mutex> lock{latch_};
+  return version_;
+}
+
+void LsmTree::BackgroundWork()
+{
+  // the levels may be over their capacity when the tree is opened
+  bool compact = true;
+  while (true) {
+    {
+      std::unique_lock<std::shared_mutex> lock{latch_};
+      cv_.wait(lock, [&]() { return stop_ || imm_ != nullptr || compact; });
+      if (stop_) {
+        return;
+      }
+    }
+    // a flush waiting for a long compaction stalls writers, so compaction goes one step at a time
+    std::lock_guard<std::mutex> work_lock{work_latch_};
+    FlushMemTable();
+    compact = Compact();
+  }
+}
+
+void LsmTree::FlushMemTable()
+{
+  std::shared_ptr<MemTable> imm;
+  {
+    std::shared_lock<std::shared_mutex> lock{latch_};
+    imm = imm_;
+  }
+  if (imm == nullptr) {
+    return;
+  }
+  std::vector<std::unique_ptr<LsmSource>> sources;
+  sources.push_back(std::make_unique<MemSource>(imm, value_size_, 0));
+  LsmIterator iter(std::move(sources), 0, false);
+  auto        run = WriteRun(iter, false);
+  {
+    std::unique_lock<std::shared_mutex> lock{latch_};
+    auto                                version = std::make_shared<LsmVersion>(*version_);
+    if (run != nullptr) {
+      version->levels_[0].insert(version->levels_[0].begin(), run);
+    }
+    version_ = std::move(version);
+    imm_     = nullptr;
+  }
+  cv_.notify_all();
+  WriteManifest(*GetVersion());
+}
+
+auto LsmTree::Compact() -> bool
+{
+  auto        version = GetVersion();
+  const auto &levels  = version->levels_;
+  // 1. pick the level to merge into the next one
+  size_t from     = levels.size();
+  size_t capacity = LSM_LEVEL0_RUN_NUM * LSM_MEMTABLE_SIZE;
+  if (levels[0].size() > LSM_LEVEL0_RUN_NUM) {
+    from = 0;
+  }
+  for (size_t i = 1; i < levels.size() && from == levels.size(); ++i) {
+    capacity *= LSM_LEVEL_SIZE_RATIO;
+    if (!levels[i].empty() && levels[i][0]->GetSize() > capacity) {
+      from = i;
+    }
+  }
+  if (from == levels.size()) {
+    return false;
+  }
+  // 2. merge the runs from the newest to the oldest, deleted keys can be dropped if no older level is left below
+  auto                                    to     = from + 1;
+  auto                                    inputs = levels[from];
+  std::vector<std::unique_ptr<LsmSource>> sources;
+  if (to < levels.size()) {
+    inputs.insert(inputs.end(), levels[to].begin(), levels[to].end());
+  }
+  for (const auto &run : inputs) {
+    sources.push_back(std::make_unique<RunSource>(run, 0));
+  }
+  bool is_last = true;
+  for (auto i = to + 1; i < levels.size(); ++i) {
+    is_last = is_last && levels[i].empty();
+  }
+  LsmIterator iter(std::move(sources), 0, false);
+  auto        run = WriteRun(iter, is_last);
+  // 3. replace the inputs by the merged run, the files of the inputs are deleted when their last readers are done
+  {
+    std::unique_lock<std::shared_mutex> lock{latch_};
+    auto                                next = std::make_shared<LsmVersion>(*version_);
+    next->levels_.resize(std::max(next->levels_.size(), to + 1));
+    next->levels_[from].clear();
+    next->levels_[to].clear();
+    if (run != nullptr) {
+      next->levels_[to].push_back(run);
+    }
+    version_ = std::move(next);
+  }
+  WriteManifest(*GetVersion());
+  for (const auto &input : inputs) {
+    input->MarkObsolete();
+  }
+  return true;
+}
+
+auto LsmTree::WriteRun(LsmIterator &iter, bool drop_tombstones) -> std::shared_ptr<SortedRun>
+{
+  auto   run_id    = next_run_id_++;
+  auto   file_name = GetRunFileName(run_id);
+  size_t entry_num = 0;
+  {
+    RunWriter writer(file_name, value_size_);
+    for (; !iter.IsEnd(); iter.Next()) {
+      if (!drop_tombstones || !iter.IsTombstone()) {
+        writer.Append(iter.GetKey(), iter.IsTombstone(), iter.GetValue());
+      }
+    }
+    entry_num = writer.Finish();
+  }
+  if (entry_num == 0) {
+    std::filesystem::remove(file_name);
+    return nullptr;
+  }
+  return std::make_shared<SortedRun>(file_name, run_id, value_size_);
+}
+
+void LsmTree::ReadManifest()
+{
+  auto version = std::make_shared<LsmVersion>();
+  auto file    = file_prefix_ + LSM_SUFFIX;
+  if (std::filesystem::exists(file)) {
+    lsm_key_t                        next_key;
+    std::vector<std::vector<size_t>> levels;
+    ReadManifestFile(file, next_key, next_run_id_, levels);
+    next_key_.store(next_key);
+    for (const auto &level : levels) {
+      auto &runs = version->levels_.emplace_back();
+      for (auto run_id : level) {
+        runs.push_back(std::make_shared<SortedRun>(GetRunFileName(run_id), run_id, value_size_));
+      }
+    }
+  }
+  if (version->levels_.empty()) {
+    version->levels_.resize(1);
+  }
+  version_ = std::move(version);
+}
+
+void LsmTree::WriteManifest(const LsmVersion &version)
+{
+  auto file     = file_prefix_ + LSM_SUFFIX;
+  auto tmp_file = file + TMP_SUFFIX;
+  {
+    std::ofstream out(tmp_file, std::ios::binary | std::ios::trunc);
+    auto          next_key  = next_key_.load();
+    auto          level_num = version.levels_.size();
+    out.write(reinterpret_cast<const char *>(&next_key), sizeof(next_key));
+    out.write(reinterpret_cast<const char *>(&next_run_id_), sizeof(next_run_id_));
+    out.write(reinterpret_cast<const char *>(&level_num), sizeof(level_num));
+    for (const auto &level : version.levels_) {
+      auto run_num = level.size();
+      out.write(reinterpret_cast<const char *>(&run_num), sizeof(run_num));
+      for (const auto &run : level) {
+        auto run_id = run->GetRunId();
+        out.write(reinterpret_cast<const char *>(&run_id), sizeof(run_id));
+      }
+    }
+    if (!out) {
+      WSDB_THROW(WSDB_FILE_WRITE_ERROR, tmp_file);
+    }
+  }
+  std::filesystem::rename(tmp_file, file);
+}
+
+auto LsmTree::GetRunFileName(size_t run_id) const -> std::string
+{
+  return fmt::format("{}_{}{}", file_prefix_, run_id, RUN_SUFFIX);
+}
+
+}  // namespace wsdb
@@ -0,0 +1,207 @@
+/*------------------------------------------------------------------------------
+ - Copyright (c) 2024. Websoft research group, Nanjing University.
+ -
+ - This program is free software: you can redistribute it and/or modify
+ - it under the terms of the GNU General Public License as published by
+ - the Free Software Foundation, either version 3 of the License, or
+ - (at your option) any later version.
+ -
+ - This program is distributed in the hope that it will be useful,
+ - but WITHOUT ANY WARRANTY; without even the implied warranty of
+ - MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ - GNU General Public License for more details.
+ -
+ - You should have received a copy of the GNU General Public License
+ - along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ -----------------------------------------------------------------------------*/
+
+//
+// Created by ziqi on 2024/9/17.
+//
+
+#ifndef WSDB_LSM_TREE_H
+#define WSDB_LSM_TREE_H
+
+#include <atomic>
+#include <condition_variable>  // NOLINT
+#include <cstdint>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <shared_mutex>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "../../../common/micro.h"
+#include "common/types.h"
+
+namespace wsdb {
+
+/// rows of an lsm table are keyed by the order they are inserted in, see TableHandle
+using lsm_key_t = uint64_t;
+
+class MemTable;
+class SortedRun;
+class LsmSource;
+struct LsmVersion;
+
+/**
+ * @brief Iterate over the entries of some memtables and sorted runs in key order, the newest entry of a key wins.
+ * Rows written to the active memtable after the iterator is created may or may not be returned.
+ */
+class LsmIterator
+{
+public:
+  /**
+   * Position the iterator on the first key not less than key
+   * @param sources newest first
+   * @param key
+   * @param skip_tombstones false to return deleted keys as well, used to merge runs
+   */
+  LsmIterator(std::vector<std::unique_ptr<LsmSource>> sources, lsm_key_t key, bool skip_tombstones);
+
+  ~LsmIterator();
+
+  DISABLE_COPY_MOVE_AND_ASSIGN(LsmIterator)
+
+  [[nodiscard]] auto IsEnd() const -> bool { return is_end_; }
+
+  [[nodiscard]] auto GetKey() const -> lsm_key_t { return key_; }
+
+  [[nodiscard]] auto IsTombstone() const -> bool;
+
+  /// @return the nullmap and the data of the row back to back
+  [[nodiscard]] auto GetValue() const -> const char *;
+
+  void Next();
+
+private:
+  /// pick the smallest key among the sources, skip older entries of the key and deleted keys if asked to
+  void Settle();
+
+  std::vector<std::unique_ptr<LsmSource>> sources_;
+  const bool                              skip_tombstones_;
+  bool                                    is_end_{false};
+  lsm_key_t                               key_{0};
+  // the source of the current entry
+  size_t source_idx_{0};
+};
+
+DEFINE_UNIQUE_PTR(LsmIterator);
+
+/**
+ * @brief Storage of an lsm table, tuned for appends and point lookups.
+ *
+ * Rows are written to a skiplist memtable in memory. A full memtable turns immutable and is written by a background
+ * thread as a sorted run, a file of fixed-width entries sorted by key | key (8) | tombstone (1) | value |, followed by
+ * the first key of each page (fence pointers) and a bloom filter of the keys, both of which are kept in memory while
+ * the run is open. Writers only stall if the memtable fills up again before the last one is flushed, so sustained
+ * inserts run at the speed of sequential writes.
+ *
+ * Runs are organized in levels. Level 0 holds up to LSM_LEVEL0_RUN_NUM freshly flushed runs whose keys may overlap,
+ * every other level holds a single run. When level 0 has too many runs or level i outgrows its capacity, the runs
+ * are merged into the next level in the background, deleted keys are dropped once they reach the last level.
+ *
+ * A lookup goes through the memtables and the runs from the newest to the oldest, a run is read only if its bloom
+ * filter passes the key, and then one page found by the fence pointers. The runs of each level are listed in the
+ * manifest file, which is rewritten whenever they change.
+ *
+ * files: | <prefix>.lsm: manifest | <prefix>_<run id>.run: sorted runs |
+ */
+class LsmTree
+{
+public:
+  /**
+   * Open the tree stored in the files starting with file_prefix, it is empty if there is no manifest
+   * @param file_prefix
+   * @param value_size bytes of the nullmap and the data of a row
+   */
+  LsmTree(std::string file_prefix, size_t value_size);
+
+  ~LsmTree();
+
+  DISABLE_COPY_MOVE_AND_ASSIGN(LsmTree)
+
+  /// delete the manifest and the runs of a tree that is not open
+  static void DestroyFiles(const std::string &file_prefix);
+
+  /// @return the first of num keys never used before
+  auto AllocateKeys(size_t num) -> lsm_key_t;
+
+  /// @return the key allocated next, keys below it have been allocated
+  [[nodiscard]] auto GetNextKey() const -> lsm_key_t { return next_key_.load(); }
+
+  void Put(lsm_key_t key, const char *value);
+
+  void Delete(lsm_key_t key);
+
+  /**
+   * @param key
+   * @param[out] value value_size bytes
+   * @return false if the key is not found or deleted
+   */
+  auto Get(lsm_key_t key, char *value) -> bool;
+
+  /// @return iterator positioned on the first live key not less than key
+  auto MakeIterator(lsm_key_t key = 0) -> LsmIteratorUptr;
+
+  /// write the memtable to a run and the manifest, called before the tree is closed
+  void Flush();
+
+  /// @return number of runs in the level, 0 for levels beyond the last one
+  auto GetRunNum(size_t level) -> size_t;
+
+private:
+  void Write(lsm_key_t key, const char *value, bool tombstone);
+
+  auto GetVersion() -> std::shared_ptr<const LsmVersion>;
+
+  /// flush immutable memtables and compact the levels until stop_ is set
+  void BackgroundWork();
+
+  /// write the immutable memtable as a new run of level 0
+  void FlushMemTable();
+
+  /**
+   * Run one step of compaction
+   * 1. if level 0 has more than LSM_LEVEL0_RUN_NUM runs, merge them with the run of level 1 into level 1
+   * 2. else merge the run of the first level over its capacity with the run of the next level into the next level
+   * @return false if no level needs compaction
+   */
+  auto Compact() -> bool;
+
+  /// write the entries of the iterator as a run, nullptr if there is none
+  auto WriteRun(LsmIterator &iter, bool drop_tombstones) -> std::shared_ptr<SortedRun>;
+
+  void ReadManifest();
+
+  /// write the manifest to a temporary file first, the old one is replaced only when the new one is complete
+  void WriteManifest(const LsmVersion &version);
+
+  [[nodiscard]] auto GetRunFileName(size_t run_id) const -> std::string;
+
+  const std::string      file_prefix_;
+  const size_t           value_size_;
+  std::atomic<lsm_key_t> next_key_{0};
+  // only changed by the thread holding work_latch_
+  size_t next_run_id_{0};
+
+  // protects the memtables and the version, writers hold it shared while writing the active memtable
+  std::shared_mutex                 latch_;
+  std::shared_ptr<MemTable>         mem_;
+  // the full memtable being flushed, nullptr if there is none
+  std::shared_ptr<MemTable>         imm_;
+  std::shared_ptr<const LsmVersion> version_;
+  // wakes the background thread up when a memtable turns immutable, and writers waiting for it to be flushed
+  std::condition_variable_any cv_;
+  bool                        stop_{false};
+  // held while a run is written and the version is changed, by the background thread or Flush
+  std::mutex  work_latch_;
+  std::thread background_;
+};
+
+DEFINE_UNIQUE_PTR(LsmTree);
+
+}  // namespace wsdb
+
+#endif  // WSDB_LSM_TREE_H
@@ -0,0 +1,278 @@
+/*------------------------------------------------------------------------------
+ - Copyright (c) 2024. Websoft research group, Nanjing University.
+ -
+ - This program is free software: you can redistribute it and/or modify
+ - it under the terms of the GNU General Public License as published by
+ - the Free Software Foundation, either version 3 of the License, or
+ - (at your option) any later version.
+ -
+ - This program is distributed in the hope that it will be useful,
+ - but WITHOUT ANY WARRANTY; without even the implied warranty of
+ - MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ - GNU General Public License for more details.
+ -
+ - You should have received a copy of the GNU General Public License
+ - along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ -----------------------------------------------------------------------------*/
+
+//
+// Created by ziqi on 2024/9/17.
+//
+
+#include "memory_engine.h"
+
+#include <algorithm>
+#include <atomic>
+#include <mutex>  // NOLINT
+
+#include "common/bitmap.h"
+#include "page_handle.h"
+
+namespace wsdb {
+
+/// rows in rid order, each row is copied under the latch when the iterator gets to it
+class MemoryEngine::Iterator : public EngineIterator
+{
+public:
+  explicit Iterator(MemoryEngine *engine) : engine_(engine)
+  {
+    std::shared_lock<std::shared_mutex> lock{engine_->latch_};
+    Seek(engine_->NextRIDOf(INVALID_RID));
+  }
+
+  [[nodiscard]] auto IsEnd() const -> bool override { return record_ == nullptr; }
+
+  void Next() override
+  {
+    std::shared_lock<std::shared_mutex> lock{engine_->latch_};
+    Seek(engine_->NextRIDOf(record_->GetRID()));
+  }
+
+  [[nodiscard]] auto GetRID() const -> RID override { return record_->GetRID(); }
+
+  [[nodiscard]] auto GetRecord() -> RecordUptr override { return std::make_unique<Record>(*record_); }
+
+private:
+  /// copy the row at rid, called under the latch
+  void Seek(const RID &rid)
+  {
+    if (rid == INVALID_RID) {
+      record_ = nullptr;
+      return;
+    }
+    const char *nullmap = nullptr;
+    const char *data    = nullptr;
+    NAryPageHandle(&engine_->tab_hdr_, engine_->PageOf(rid)).ViewSlot(rid.SlotID(), nullmap, data);
+    record_ = std::make_unique<Record>(engine_->schema_, nullmap, data, rid);
+  }
+
+private:
+  MemoryEngine *const engine_;
+  // nullptr at the end
+  RecordUptr record_;
+};
+
+MemoryEngine::MemoryEngine(
+    DiskManager *disk_manager, table_id_t table_id, const RecordSchema *schema, TableHeader &tab_hdr)
+    : disk_manager_(disk_manager), table_id_(table_id), schema_(schema), tab_hdr_(tab_hdr)
+{
+  if (!tab_hdr_.memory_snapshot_) {
+    // the rows were dropped by the last Snapshot, the file holds no page
+    return;
+  }
+  // load the snapshot written by the last close, the table is never read from the file afterwards
+  for (auto page_id = FILE_HEADER_PAGE_ID + 1; page_id < static_cast<page_id_t>(tab_hdr_.page_num_); ++page_id) {
+    auto page = std::make_unique<Page>();
+    page->SetFilePageId(table_id_, page_id);
+    disk_manager_->ReadPage(table_id_, page_id, page->GetData());
+    pages_.push_back(std::move(page));
+  }
+}
+
+auto MemoryEngine::GetRecord(const RID &rid) -> RecordUptr
+{
+  std::shared_lock<std::shared_mutex> lock{latch_};
+  const char                         *nullmap = nullptr;
+  const char                         *data    = nullptr;
+  NAryPageHandle(&tab_hdr_, RowPageOf(rid)).ViewSlot(rid.SlotID(), nullmap, data);
+  return std::make_unique<Record>(schema_, nullmap, data, rid);
+}
+
+auto MemoryEngine::InsertRecords(std::span<const Record> records) -> std::vector<RID>
+{
+  std::unique_lock<std::shared_mutex> lock{latch_};
+  std::vector<RID>                    rids;
+  rids.reserve(records.size());
+  for (const auto &record : records) {
+    auto rid = ClaimSlot(pages_.size());
+    if (rid == INVALID_RID) {
+      // every page is full, a new page is appended at the end of the table
+      auto page = std::make_unique<Page>();
+      page->SetFilePageId(table_id_, static_cast<page_id_t>(pages_.size() + FILE_HEADER_PAGE_ID + 1));
+      pages_.push_back(std::move(page));
+      SetPageNum(pages_.size() + FILE_HEADER_PAGE_ID + 1);
+      rid = ClaimSlot(pages_.size());
+    }
+    WriteRow(PageOf(rid), rid.SlotID(), record.GetNullMap(), record.GetData());
+    rids.push_back(rid);
+  }
+  return rids;
+}
+
+void MemoryEngine::InsertRecord(const RID &rid, const Record &record)
+{
+  std::unique_lock<std::shared_mutex> lock{latch_};
+  auto                                page = PageOf(rid);
+  if (page == nullptr) {
+    WSDB_THROW(WSDB_PAGE_MISS, fmt::format("Page: {}", rid.PageID()));
+  }
+  auto bitmap = page->GetData() + PAGE_HEADER_SIZE;
+  if (BitMap::GetBit(bitmap, rid.SlotID())) {
+    WSDB_THROW(WSDB_RECORD_EXISTS, fmt::format("RID(SlotID:{},PageID:{})", rid.SlotID(), rid.PageID()));
+  }
+  BitMap::SetBit(bitmap, rid.SlotID(), true);
+  page->SetRecordNum(page->GetRecordNum() + 1);
+  WriteRow(page, rid.SlotID(), record.GetNullMap(), record.GetData());
+}
+
+void MemoryEngine::DeleteRecord(const RID &rid)
+{
+  std::unique_lock<std::shared_mutex> lock{latch_};
+  auto                                page = RowPageOf(rid);
+  BitMap::SetBit(page->GetData() + PAGE_HEADER_SIZE, rid.SlotID(), false);
+  page->SetRecordNum(page->GetRecordNum() - 1);
+  first_free_ = std::min(first_free_, static_cast<size_t>(rid.PageID() - FILE_HEADER_PAGE_ID - 1));
+}
+
+void MemoryEngine::UpdateRecord(const RID &rid, const Record &record)
+{
+  std::unique_lock<std::shared_mutex> lock{latch_};
+  WriteRow(RowPageOf(rid), rid.SlotID(), record.GetNullMap(), record.GetData());
+}
+
+auto MemoryEngine::Vacuum(size_t page_num, const std::function<void(const Record &, const Record &)> &on_move) -> bool
+{
+  std::unique_lock<std::shared_mutex> lock{latch_};
+  for (size_t n = 0; n < page_num && !pages_.empty(); ++n) {
+    auto tail_id = static_cast<page_id_t>(pages_.size() + FILE_HEADER_PAGE_ID);
+    auto tail    = pages_.back().get();
+    auto bitmap  = tail->GetData() + PAGE_HEADER_SIZE;
+    for (auto slot_id = BitMap::FindFirst(bitmap, tab_hdr_.rec_per_page_, 0, true); slot_id != tab_hdr_.rec_per_page_;
+         slot_id      = BitMap::FindFirst(bitmap, tab_hdr_.rec_per_page_, slot_id + 1, true)) {
+      // only the pages before the last one take its rows
+      auto target = ClaimSlot(pages_.size() - 1);
+      if (target == INVALID_RID) {
+        // no free slot before the page, the table is compact
+        return false;
+      }
+      const char *nullmap = nullptr;
+      const char *data    = nullptr;
+      NAryPageHandle(&tab_hdr_, tail).ViewSlot(slot_id, nullmap, data);
+      WriteRow(PageOf(target), target.SlotID(), nullmap, data);
+      Record old_record(schema_, nullmap, data, {tail_id, static_cast<slot_id_t>(slot_id)});
+      Record new_record(schema_, nullmap, data, target);
+      BitMap::SetBit(bitmap, slot_id, false);
+      tail->SetRecordNum(tail->GetRecordNum() - 1);
+      on_move(old_record, new_record);
+    }
+    pages_.pop_back();
+    first_free_ = std::min(first_free_, pages_.size());
+    SetPageNum(pages_.size() + FILE_HEADER_PAGE_ID + 1);
+  }
+  return !pages_.empty();
+}
+
+auto MemoryEngine::GetExtremum(size_t /*field_idx*/, bool /*is_max*/) -> ValueSptr
+{
+  // no zone map is kept of the pages
+  return nullptr;
+}
+
+void MemoryEngine::Snapshot()
+{
+  std::unique_lock<std::shared_mutex> lock{latch_};
+  if (!tab_hdr_.memory_snapshot_) {
+    // the table is emptied, so is its count of rows kept by the table
+    pages_.clear();
+    first_free_ = 0;
+    SetPageNum(FILE_HEADER_PAGE_ID + 1);
+    std::atomic_ref<size_t>(tab_hdr_.rec_num_).store(0);
+  }
+  for (size_t i = 0; i < pages_.size(); ++i) {
+    disk_manager_->WritePage(table_id_, static_cast<page_id_t>(i + FILE_HEADER_PAGE_ID + 1), pages_[i]->GetData());
+  }
+  disk_manager_->TruncateFile(table_id_, pages_.size() + FILE_HEADER_PAGE_ID + 1);
+}
+
+auto MemoryEngine::GetFirstRID() -> RID
+{
+  std::shared_lock<std::shared_mutex> lock{latch_};
+  return NextRIDOf(INVALID_RID);
+}
+
+auto MemoryEngine::GetNextRID(const RID &rid) -> RID
+{
+  std::shared_lock<std::shared_mutex> lock{latch_};
+  return NextRIDOf(rid);
+}
+
+auto MemoryEngine::MakeIterator() -> EngineIteratorUptr { return std::make_unique<Iterator>(this); }
+
+auto MemoryEngine::PageOf(const RID &rid) const -> Page *
+{
+  if (rid.PageID() <= FILE_HEADER_PAGE_ID || static_cast<size_t>(rid.PageID() - FILE_HEADER_PAGE_ID) > pages_.size() ||
+      rid.SlotID() < 0 || static_cast<size_t>(rid.SlotID()) >= tab_hdr_.rec_per_page_) {
+    return nullptr;
+  }
+  return pages_[rid.PageID() - FILE_HEADER_PAGE_ID - 1].get();
+}
+
+auto MemoryEngine::RowPageOf(const RID &rid) const -> Page *
+{
+  auto page = PageOf(rid);
+  if (page == nullptr || !BitMap::GetBit(page->GetData() + PAGE_HEADER_SIZE, rid.SlotID())) {
+    WSDB_THROW(WSDB_RECORD_MISS, fmt::format("RID(SlotID:{},PageID:{})", rid.SlotID(), rid.PageID()));
+  }
+  return page;
+}
+
+auto MemoryEngine::NextRIDOf(const RID &rid) const -> RID
+{
+  // the first row of the table is searched from the first slot of the first page
+  size_t page_idx = rid == INVALID_RID ? 0 : rid.PageID() - FILE_HEADER_PAGE_ID - 1;
+  size_t start    = rid == INVALID_RID ? 0 : rid.SlotID() + 1;
+  for (; page_idx < pages_.size(); ++page_idx, start = 0) {
+    auto slot_id =
+        BitMap::FindFirst(pages_[page_idx]->GetData() + PAGE_HEADER_SIZE, tab_hdr_.rec_per_page_, start, true);
+    if (slot_id != tab_hdr_.rec_per_page_) {
+      return {static_cast<page_id_t>(page_idx + FILE_HEADER_PAGE_ID + 1), static_cast<slot_id_t>(slot_id)};
+    }
+  }
+  return INVALID_RID;
+}
+
+auto MemoryEngine::ClaimSlot(size_t page_end) -> RID
+{
+  for (; first_free_ < page_end; ++first_free_) {
+    auto page    = pages_[first_free_].get();
+    auto slot_id = BitMap::ClaimFirst(page->GetData() + PAGE_HEADER_SIZE, tab_hdr_.rec_per_page_);
+    if (slot_id != tab_hdr_.rec_per_page_) {
+      page->SetRecordNum(page->GetRecordNum() + 1);
+      return {static_cast<page_id_t>(first_free_ + FILE_HEADER_PAGE_ID + 1), static_cast<slot_id_t>(slot_id)};
+    }
+  }
+  return INVALID_RID;
+}
+
+void MemoryEngine::WriteRow(Page *page, size_t slot_id, const char *nullmap, const char *data)
+{
+  NAryPageHandle(&tab_hdr_, page).WriteSlot(slot_id, nullmap, data, true);
+}
+
+void MemoryEngine::SetPageNum(size_t page_num)
+{
+  // the table reads it without the latch, see TableHandle::GetPageNum
+  std::atomic_ref<size_t>(tab_hdr_.page_num_).store(page_num);
+}
+
+}  // namespace wsdb
@@ -0,0 +1,120 @@
+/*------------------------------------------------------------------------------
+ - Copyright (c) 2024. Websoft research group, Nanjing University.
+ -
+ - This program is free software: you can redistribute it and/or modify
+ - it under the terms of the GNU General Public License as published by
+ - the Free Software Foundation, either version 3 of the License, or
+ - (at your option) any later version.
+ -
+ - This program is distributed in the hope that it will be useful,
+ - but WITHOUT ANY WARRANTY; without even the implied warranty of
+ - MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ - GNU General Public License for more details.
+ -
+ - You should have received a copy of the GNU General Public License
+ - along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ -----------------------------------------------------------------------------*/
+
+//
+// Created by ziqi on 2024/9/17.
+//
+
+#ifndef WSDB_MEMORY_ENGINE_H
+#define WSDB_MEMORY_ENGINE_H
+
+#include <memory>
+#include <shared_mutex>
+#include <vector>
+
+#include "common/meta.h"
+#include "common/page.h"
+#include "storage/disk/disk_manager.h"
+#include "storage_engine.h"
+
+namespace wsdb {
+
+/**
+ * @brief Rows of an in-memory table, stored in pages of the nary layout that are never put in the buffer pool.
+ *
+ * The n-th page in memory has page id n + 1 in the rids of its rows, as it would in the table file. The pages are read
+ * from the file when the table is opened and written back by Snapshot if the table is created with STORAGE = MEMORY
+ * SNAPSHOT, the rows are lost when the table is closed otherwise. Rows are read under the latch shared and written
+ * under it exclusively, an iterator copies the row it is at, so no row is read from a page without the latch.
+ */
+class MemoryEngine : public StorageEngine
+{
+public:
+  /**
+   * @param disk_manager
+   * @param table_id the snapshot of the rows is stored in the pages of the table file
+   * @param schema
+   * @param tab_hdr page_num_ is kept up to date with the pages in memory, and the snapshot is loaded from the file if
+   * memory_snapshot_ is set
+   */
+  MemoryEngine(DiskManager *disk_manager, table_id_t table_id, const RecordSchema *schema, TableHeader &tab_hdr);
+
+  auto GetRecord(const RID &rid) -> RecordUptr override;
+
+  auto InsertRecords(std::span<const Record> records) -> std::vector<RID> override;
+
+  void InsertRecord(const RID &rid, const Record &record) override;
+
+  void DeleteRecord(const RID &rid) override;
+
+  void UpdateRecord(const RID &rid, const Record &record) override;
+
+  /// move the rows of the last pages into free slots of the lowest pages, and drop the emptied pages
+  auto Vacuum(size_t page_num, const std::function<void(const Record &, const Record &)> &on_move) -> bool override;
+
+  auto GetExtremum(size_t field_idx, bool is_max) -> ValueSptr override;
+
+  /**
+   * Write the pages to the table file before the table header, called when the table is closed
+   * 1. if memory_snapshot_ is set, write every page and truncate the file to the pages of the table
+   * 2. else empty the table, the rows are lost
+   */
+  void Snapshot() override;
+
+  auto GetFirstRID() -> RID override;
+
+  auto GetNextRID(const RID &rid) -> RID override;
+
+  /// go through the rows in rid order
+  auto MakeIterator() -> EngineIteratorUptr override;
+
+private:
+  class Iterator;
+
+  /// @return the page of the rid, nullptr if no page has the page id
+  [[nodiscard]] auto PageOf(const RID &rid) const -> Page *;
+
+  /// @return the page holding a row at rid
+  /// @throw WSDB_RECORD_MISS if no row is at rid
+  [[nodiscard]] auto RowPageOf(const RID &rid) const -> Page *;
+
+  /// @return the first rid of a row after rid, INVALID_RID if there is none, called under the latch
+  [[nodiscard]] auto NextRIDOf(const RID &rid) const -> RID;
+
+  /// claim the first free slot of the pages before page_end, INVALID_RID if they are full, called under the latch
+  auto ClaimSlot(size_t page_end) -> RID;
+
+  /// write the row to a claimed slot
+  void WriteRow(Page *page, size_t slot_id, const char *nullmap, const char *data);
+
+  void SetPageNum(size_t page_num);
+
+private:
+  DiskManager *const        disk_manager_;
+  const table_id_t          table_id_;
+  const RecordSchema *const schema_;
+  TableHeader              &tab_hdr_;
+  std::shared_mutex         latch_;
+  // page of page id FILE_HEADER_PAGE_ID + 1 + i at i, the record num in the page header counts its rows
+  std::vector<std::unique_ptr<Page>> pages_;
+  // pages before it are full
+  size_t first_free_{0};
+};
+
+}  // namespace wsdb
+
+#endif  // WSDB_MEMORY_ENGINE_H
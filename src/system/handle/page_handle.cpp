@@ -22,6 +22,7 @@
 #include "page_handle.h"
 #include "../../../common/error.h"
 #include "storage/buffer/buffer_pool_manager.h"
+#include "toast_handle.h"
 
 namespace wsdb {
 PageHandle::PageHandle(const TableHeader *tab_hdr, Page *page, char *bit_map, char *slots_mem)
@@ -35,6 +36,8 @@ void PageHandle::WriteSlot(size_t slot_id, const char *null_map, const char *dat
 }
 
 void PageHandle::ReadSlot(size_t slot_id, char *null_map, char *data) { WSDB_THROW(WSDB_EXCEPTION_EMPTY, ""); }
+auto PageHandle::ViewSlot(size_t slot_id, const char *&null_map, const char *&data) -> bool { return false; }
+auto PageHandle::GetForward(size_t slot_id) -> RID { return INVALID_RID; }
 auto PageHandle::ReadChunk(const RecordSchema *chunk_schema) -> ChunkUptr { WSDB_THROW(WSDB_EXCEPTION_EMPTY, ""); }
 
 NAryPageHandle::NAryPageHandle(const TableHeader *tab_hdr, Page *page)
@@ -61,35 +64,740 @@ void NAryPageHandle::ReadSlot(size_t slot_id, char *null_map, char *data)
   memcpy(data, slots_mem_ + slot_id * rec_full_size + tab_hdr_->nullmap_size_, tab_hdr_->rec_size_);
 }
 
-PAXPageHandle::PAXPageHandle(
-    const TableHeader *tab_hdr, Page *page, const RecordSchema *schema, const std::vector<size_t> &offsets)
+auto NAryPageHandle::ViewSlot(size_t slot_id, const char *&null_map, const char *&data) -> bool
+{
+  WSDB_ASSERT(slot_id < tab_hdr_->rec_per_page_, "slot_id out of range");
+  WSDB_ASSERT(BitMap::GetBit(bitmap_, slot_id) == true, "slot is empty");
+  size_t rec_full_size = tab_hdr_->nullmap_size_ + tab_hdr_->rec_size_;
+  null_map             = slots_mem_ + slot_id * rec_full_size;
+  data                 = null_map + tab_hdr_->nullmap_size_;
+  return true;
+}
+
+PAXPageHandle::PAXPageHandle(const TableHeader *tab_hdr, Page *page, const RecordSchema *schema, ToastHandle *toast)
     : PageHandle(tab_hdr, page, page->GetData() + PAGE_HEADER_SIZE,
           page->GetData() + PAGE_HEADER_SIZE + tab_hdr->bitmap_size_),
       schema_(schema),
-      offsets_(offsets)
+      toast_(toast),
+      plain_map_(slots_mem_ + sizeof(PAXHeader)),
+      plain_cap_(GetPlainCapacity(tab_hdr))
 {}
 
-PAXPageHandle::~PAXPageHandle() = default;
-
-// slot memery
+// plain part of n plain slots
 // | nullmap_1, nullmap_2, ... , nullmap_n|
 // | field_1_1, field_1_2, ... , field_1_n |
 // | field_2_1, field_2_2, ... , field_2_n |
 // ...
 // | field_m_1, field_m_2, ... , field_m_n |
+// the minipage of field i begins at n * (nullmap size + offset of field i in the record)
 void PAXPageHandle::WriteSlot(size_t slot_id, const char *null_map, const char *data, bool update)
 {
-  WSDB_STUDENT_TODO(l1, f2);
+  WSDB_ASSERT(slot_id < tab_hdr_->rec_per_page_, "slot_id out of range");
+  WSDB_ASSERT(BitMap::GetBit(bitmap_, slot_id) == update, fmt::format("update: {}", update));
+  WSDB_ASSERT(IsPlain(slot_id), "slot is not plain");
+  auto plain     = GetPlain();
+  auto plain_num = GetPlainNum();
+  auto rank      = RankOf(slot_id);
+  memcpy(plain + rank * tab_hdr_->nullmap_size_, null_map, tab_hdr_->nullmap_size_);
+  for (size_t i = 0; i < schema_->GetFieldCount(); ++i) {
+    auto field_size = schema_->GetFieldAt(i).field_.field_size_;
+    auto minipage   = plain + plain_num * (tab_hdr_->nullmap_size_ + schema_->GetFieldOffset(i));
+    memcpy(minipage + rank * field_size, data + schema_->GetFieldOffset(i), field_size);
+  }
 }
 
-void PAXPageHandle::ReadSlot(size_t slot_id, char *null_map, char *data) { WSDB_STUDENT_TODO(l1, f2); }
+void PAXPageHandle::ReadSlot(size_t slot_id, char *null_map, char *data)
+{
+  WSDB_ASSERT(slot_id < tab_hdr_->rec_per_page_, "slot_id out of range");
+  WSDB_ASSERT(BitMap::GetBit(bitmap_, slot_id) == true, "slot is empty");
+  if (!IsPlain(slot_id)) {
+    DecodeFrozen();
+    auto row = rows_.data() + slot_id * GetRowSize();
+    memcpy(null_map, row, tab_hdr_->nullmap_size_);
+    memcpy(data, row + tab_hdr_->nullmap_size_, tab_hdr_->rec_size_);
+    return;
+  }
+  auto plain     = GetPlain();
+  auto plain_num = GetPlainNum();
+  auto rank      = RankOf(slot_id);
+  memcpy(null_map, plain + rank * tab_hdr_->nullmap_size_, tab_hdr_->nullmap_size_);
+  for (size_t i = 0; i < schema_->GetFieldCount(); ++i) {
+    auto field_size = schema_->GetFieldAt(i).field_.field_size_;
+    auto minipage   = plain + plain_num * (tab_hdr_->nullmap_size_ + schema_->GetFieldOffset(i));
+    memcpy(data + schema_->GetFieldOffset(i), minipage + rank * field_size, field_size);
+  }
+}
 
 auto PAXPageHandle::ReadChunk(const RecordSchema *chunk_schema) -> ChunkUptr
 {
-  std::vector<ArrayValueSptr> col_arrs;
-  col_arrs.reserve(chunk_schema->GetFieldCount());
-  // read data each field and construct ArrayValue
-  WSDB_STUDENT_TODO(l1, f2);
-  return std::make_unique<Chunk>(chunk_schema, std::move(col_arrs));
+  auto rec_num = tab_hdr_->rec_per_page_;
+  auto chunk   = std::make_unique<Chunk>(chunk_schema, rec_num);
+  DecodeFrozen();
+  // 1. only the slots in use are selected, plain ones are read from the minipages by their rank
+  std::vector<uint32_t> sel;
+  std::vector<uint32_t> ranks(rec_num);
+  uint32_t              rank{0};
+  BitMap::ForEachSetBit(GetWritableMap(), rec_num, [&ranks, &rank](size_t slot_id) { ranks[slot_id] = rank++; });
+  BitMap::ForEachSetBit(bitmap_, rec_num, [&sel](size_t slot_id) { sel.push_back(slot_id); });
+  auto plain     = GetPlain();
+  auto plain_num = GetPlainNum();
+  for (size_t i = 0; i < chunk_schema->GetFieldCount(); ++i) {
+    auto field_idx = schema_->GetRTFieldIndex(chunk_schema->GetFieldAt(i));
+    WSDB_ASSERT(field_idx < schema_->GetFieldCount(), "chunk field is not in the table");
+    // 2. frozen ones from the decoded rows
+    auto  &col      = chunk->GetCol(i);
+    auto   offset   = schema_->GetFieldOffset(field_idx);
+    auto   minipage = plain + plain_num * (tab_hdr_->nullmap_size_ + offset);
+    for (auto slot_id : sel) {
+      const char *null_map;
+      const char *value;
+      if (IsPlain(slot_id)) {
+        null_map = plain + ranks[slot_id] * tab_hdr_->nullmap_size_;
+        value    = minipage + ranks[slot_id] * col.GetWidth();
+      } else {
+        null_map = rows_.data() + slot_id * GetRowSize();
+        value    = null_map + tab_hdr_->nullmap_size_ + offset;
+      }
+      memcpy(col.GetData<char>() + slot_id * col.GetWidth(), value, col.GetWidth());
+      col.SetValid(slot_id, !BitMap::GetBit(null_map, field_idx));
+    }
+  }
+  chunk->SetSelection(std::move(sel));
+  return chunk;
+}
+
+auto PAXPageHandle::FilterSlots(const ConditionVec &conds, std::vector<char> &slots) -> bool
+{
+  auto rec_num = tab_hdr_->rec_per_page_;
+  slots.assign(bitmap_, bitmap_ + tab_hdr_->bitmap_size_);
+  std::vector<char> matches(tab_hdr_->bitmap_size_);
+  // frozen rows not spilled, in the order of their values in the columns
+  std::vector<size_t> kept;
+  if (!IsFresh()) {
+    const char *spilled = GetFrozen() + tab_hdr_->bitmap_size_;
+    BitMap::ForEachSetBit(GetFrozen(), rec_num, [&kept, spilled](size_t slot_id) {
+      if (!BitMap::GetBit(spilled, slot_id)) {
+        kept.push_back(slot_id);
+      }
+    });
+  }
+  auto plain     = GetPlain();
+  auto plain_num = GetPlainNum();
+  for (const auto &cond : conds) {
+    if (cond.GetRhsType() != kValue || cond.GetRVal() == nullptr) {
+      continue;
+    }
+    auto field_idx = schema_->GetRTFieldIndex(cond.GetLCol());
+    if (field_idx == schema_->GetFieldCount()) {
+      continue;
+    }
+    auto &field = schema_->GetFieldAt(field_idx).field_;
+    // null satisfies none of the comparisons except !=
+    auto null_match = cond.GetOp() == OP_NE;
+    // 1. the k-th plain slot is the k-th value of the minipage
+    auto minipage = plain + plain_num * (tab_hdr_->nullmap_size_ + schema_->GetFieldOffset(field_idx));
+    if (ColumnCodec::Evaluate(ColumnEncoding::PLAIN, field.field_type_, field.field_size_, minipage, plain_num,
+            cond.GetOp(), *cond.GetRVal(), matches.data())) {
+      size_t rank = 0;
+      BitMap::ForEachSetBit(GetWritableMap(), rec_num, [&](size_t slot_id) {
+        bool is_null = BitMap::GetBit(plain + rank * tab_hdr_->nullmap_size_, field_idx);
+        bool match   = is_null ? null_match : BitMap::GetBit(matches.data(), rank);
+        rank++;
+        if (!match) {
+          BitMap::SetBit(slots.data(), slot_id, false);
+        }
+      });
+    }
+    // 2. frozen rows are evaluated on the encoded column, which holds the values that are not null, spilled rows are
+    // kept
+    if (kept.empty()) {
+      continue;
+    }
+    ColumnEncoding encoding;
+    const char    *nulls;
+    const char    *values;
+    GetColumn(field_idx, encoding, nulls, values);
+    auto value_num = kept.size() - BitMap::Count(nulls, kept.size());
+    if (!ColumnCodec::Evaluate(encoding, field.field_type_, field.field_size_, values, value_num, cond.GetOp(),
+            *cond.GetRVal(), matches.data())) {
+      continue;
+    }
+    for (size_t k = 0, value_idx = 0; k < kept.size(); ++k) {
+      bool match = BitMap::GetBit(nulls, k) ? null_match : BitMap::GetBit(matches.data(), value_idx++);
+      if (!match) {
+        BitMap::SetBit(slots.data(), kept[k], false);
+      }
+    }
+  }
+  return true;
+}
+
+auto PAXPageHandle::GetWritableMap() -> const char *
+{
+  if (!IsFresh()) {
+    return plain_map_;
+  }
+  if (fresh_map_.empty()) {
+    fresh_map_.resize(tab_hdr_->bitmap_size_);
+    for (size_t slot_id = 0; slot_id < plain_cap_; ++slot_id) {
+      BitMap::SetBit(fresh_map_.data(), slot_id, true);
+    }
+  }
+  return fresh_map_.data();
+}
+
+auto PAXPageHandle::IsPlain(size_t slot_id) -> bool { return BitMap::GetBit(GetWritableMap(), slot_id); }
+
+auto PAXPageHandle::IsFull() -> bool
+{
+  auto rec_num = tab_hdr_->rec_per_page_;
+  if (FindFreePlain() != rec_num) {
+    return false;
+  }
+  auto used_num = BitMap::Count(bitmap_, rec_num);
+  auto full_num = GetHeader()->full_num_;
+  return rec_num - used_num < std::max<size_t>(1, plain_cap_ / PAX_FREEZE_GAIN) ||
+         (full_num != 0 && used_num >= full_num);
+}
+
+auto PAXPageHandle::Freeze() -> bool
+{
+  auto rec_num = tab_hdr_->rec_per_page_;
+  if (FindFreePlain() != rec_num) {
+    return true;
+  }
+  if (IsFull()) {
+    return false;
+  }
+  // 1. encode all rows in use, the page is left as it is if the room made for plain rows is too small
+  auto              used_num = BitMap::Count(bitmap_, rec_num);
+  std::vector<char> rows;
+  std::vector<char> spilled(tab_hdr_->bitmap_size_);
+  std::vector<char> frozen;
+  ReadRows(rows);
+  Encode(rows, bitmap_, spilled.data(), frozen);
+  size_t plain_num = 0;
+  if (frozen.size() <= GetSpace()) {
+    plain_num = std::min(rec_num - used_num, (GetSpace() - frozen.size()) / GetRowSize());
+  }
+  auto gain = std::max<size_t>(1, plain_cap_ / PAX_FREEZE_GAIN);
+  if (plain_num < gain) {
+    // a deleted row frees at most a plain row of space, it is tried again once enough rows are deleted
+    GetHeader()->full_num_ = static_cast<uint16_t>(std::max<size_t>(1, used_num + plain_num + 1 - gain));
+    return false;
+  }
+  // 2. the slots not in use become plain
+  Store(rows, bitmap_, spilled.data(), frozen, plain_num);
+  return true;
+}
+
+void PAXPageHandle::Rewrite(size_t slot_id, const char *null_map, const char *data)
+{
+  WSDB_ASSERT(slot_id < tab_hdr_->rec_per_page_, "slot_id out of range");
+  auto              rec_num = tab_hdr_->rec_per_page_;
+  std::vector<char> rows;
+  std::vector<char> used(bitmap_, bitmap_ + tab_hdr_->bitmap_size_);
+  std::vector<char> spilled(tab_hdr_->bitmap_size_);
+  std::vector<char> frozen;
+  // 1. the record takes the place of the row in the slot
+  ReadRows(rows);
+  BitMap::SetBit(used.data(), slot_id, true);
+  auto row = rows.data() + slot_id * GetRowSize();
+  memcpy(row, null_map, tab_hdr_->nullmap_size_);
+  memcpy(row + tab_hdr_->nullmap_size_, data, tab_hdr_->rec_size_);
+  Encode(rows, used.data(), spilled.data(), frozen);
+  // 2. spill the record first, then the rows of the last slots, as many as the average size of a row tells at a time
+  auto used_num    = BitMap::Count(used.data(), rec_num);
+  auto spilled_num = size_t{0};
+  auto next_slot   = rec_num;
+  while (frozen.size() > GetSpace()) {
+    auto row_size = std::max<size_t>(1, frozen.size() / std::max<size_t>(1, used_num - spilled_num));
+    for (auto num = (frozen.size() - GetSpace() + row_size - 1) / row_size; num > 0; --num, ++spilled_num) {
+      if (!BitMap::GetBit(spilled.data(), slot_id)) {
+        BitMap::SetBit(spilled.data(), slot_id, true);
+        continue;
+      }
+      do {
+        WSDB_ASSERT(next_slot > 0, "rows of a page do not fit even if spilled");
+        next_slot--;
+      } while (!BitMap::GetBit(used.data(), next_slot) || BitMap::GetBit(spilled.data(), next_slot));
+      BitMap::SetBit(spilled.data(), next_slot, true);
+    }
+    Encode(rows, used.data(), spilled.data(), frozen);
+  }
+  // 3. the slots not in use become plain as far as the space left allows
+  Store(rows, used.data(), spilled.data(), frozen,
+      std::min(rec_num - used_num, (GetSpace() - frozen.size()) / GetRowSize()));
+}
+
+void PAXPageHandle::ReleaseSpills()
+{
+  if (IsFresh()) {
+    return;
+  }
+  auto     spills = GetFrozen() + 2 * tab_hdr_->bitmap_size_;
+  uint16_t spill_num;
+  memcpy(&spill_num, spills, sizeof(uint16_t));
+  for (size_t i = 0; i < spill_num; ++i) {
+    page_id_t page_id;
+    memcpy(&page_id, spills + sizeof(uint16_t) + i * SPILL_SIZE, sizeof(page_id_t));
+    toast_->Release(page_id);
+  }
+}
+
+auto PAXPageHandle::GetMaxSlotNum(const RecordSchema *schema) -> size_t
+{
+  size_t row_size = BITMAP_SIZE(schema->GetFieldCount()) + schema->GetRecordLength();
+  // n = rec_per_page of a plain page, PAGE_HDR_SIZE + BITMAP_SIZE(n) + n * (rec_size + nullmap_size) <= PAGE_SIZE
+  size_t plain_num = (BITMAP_WIDTH * (PAGE_SIZE - PAGE_HEADER_SIZE - 1) + 1) / (1 + row_size * BITMAP_WIDTH);
+  size_t run_rows  = ToastHandle::GetMaxValueSize() / row_size;
+  for (auto slot_num = PAX_SLOT_RATIO * plain_num;; --slot_num) {
+    // | bitmap | pax header | plain map |, then a plain row of a fresh page, or the frozen part with all rows spilled
+    size_t fixed  = PAGE_HEADER_SIZE + 2 * BITMAP_SIZE(slot_num) + sizeof(PAXHeader);
+    size_t frozen = 2 * BITMAP_SIZE(slot_num) + sizeof(uint16_t) + (slot_num + run_rows - 1) / run_rows * SPILL_SIZE +
+                    schema->GetFieldCount() * COLUMN_HEADER_SIZE;
+    if (fixed + std::max(frozen, row_size) <= PAGE_SIZE) {
+      return slot_num;
+    }
+  }
+}
+
+auto PAXPageHandle::RankOf(size_t slot_id) -> size_t
+{
+  return IsFresh() ? slot_id : BitMap::Count(plain_map_, slot_id);
+}
+
+auto PAXPageHandle::FindFreePlain() -> size_t
+{
+  auto rec_num = tab_hdr_->rec_per_page_;
+  for (auto slot_id = BitMap::FindFirst(bitmap_, rec_num, 0, false); slot_id != rec_num;
+       slot_id      = BitMap::FindFirst(bitmap_, rec_num, slot_id + 1, false)) {
+    if (IsPlain(slot_id)) {
+      return slot_id;
+    }
+  }
+  return rec_num;
+}
+
+void PAXPageHandle::DecodeFrozen()
+{
+  if (IsFresh() || (decoded_ && decoded_epoch_ == GetHeader()->epoch_)) {
+    return;
+  }
+  auto   rec_num  = tab_hdr_->rec_per_page_;
+  auto   row_size = GetRowSize();
+  auto   frozen   = GetFrozen();
+  auto   spilled  = frozen + tab_hdr_->bitmap_size_;
+  size_t spill_num{0};
+  rows_.assign(rec_num * row_size, 0);
+  std::vector<size_t> kept;
+  std::vector<size_t> spill_slots;
+  BitMap::ForEachSetBit(frozen, rec_num, [&](size_t slot_id) {
+    (BitMap::GetBit(spilled, slot_id) ? spill_slots : kept).push_back(slot_id);
+  });
+  // 1. the columns of the rows not spilled, values are scattered to the rows whose field is not null
+  std::vector<char> values;
+  for (size_t i = 0; i < schema_->GetFieldCount(); ++i) {
+    ColumnEncoding encoding;
+    const char    *nulls;
+    const char    *in;
+    GetColumn(i, encoding, nulls, in);
+    auto width     = schema_->GetFieldAt(i).field_.field_size_;
+    auto offset    = tab_hdr_->nullmap_size_ + schema_->GetFieldOffset(i);
+    auto value_num = kept.size() - BitMap::Count(nulls, kept.size());
+    values.resize(value_num * width);
+    ColumnCodec::Decode(encoding, width, in, value_num, values.data());
+    for (size_t k = 0, value_idx = 0; k < kept.size(); ++k) {
+      auto row = rows_.data() + kept[k] * row_size;
+      if (BitMap::GetBit(nulls, k)) {
+        BitMap::SetBit(row, i, true);
+      } else {
+        memcpy(row + offset, values.data() + value_idx++ * width, width);
+      }
+    }
+  }
+  // 2. the spilled rows, a run at a time
+  auto spills = spilled + tab_hdr_->bitmap_size_;
+  memcpy(&spill_num, spills, sizeof(uint16_t));
+  std::vector<char> run;
+  for (size_t i = 0, first = 0; i < spill_num; ++i) {
+    auto      spill = spills + sizeof(uint16_t) + i * SPILL_SIZE;
+    page_id_t page_id;
+    uint16_t  offset;
+    uint16_t  row_num;
+    memcpy(&page_id, spill, sizeof(page_id_t));
+    memcpy(&offset, spill + sizeof(page_id_t), sizeof(uint16_t));
+    memcpy(&row_num, spill + sizeof(page_id_t) + sizeof(uint16_t), sizeof(uint16_t));
+    run.resize(row_num * row_size);
+    toast_->Get(page_id, offset, run.data(), run.size());
+    for (size_t k = 0; k < row_num; ++k, ++first) {
+      memcpy(rows_.data() + spill_slots[first] * row_size, run.data() + k * row_size, row_size);
+    }
+  }
+  decoded_       = true;
+  decoded_epoch_ = GetHeader()->epoch_;
+}
+
+auto PAXPageHandle::GetColumn(size_t field_idx, ColumnEncoding &encoding, const char *&nulls, const char *&values)
+    -> size_t
+{
+  auto     rec_num = tab_hdr_->rec_per_page_;
+  auto     frozen  = GetFrozen();
+  auto     kept    = BitMap::Count(frozen, rec_num) - BitMap::Count(frozen + tab_hdr_->bitmap_size_, rec_num);
+  uint16_t spill_num;
+  memcpy(&spill_num, frozen + 2 * tab_hdr_->bitmap_size_, sizeof(uint16_t));
+  const char *column = frozen + 2 * tab_hdr_->bitmap_size_ + sizeof(uint16_t) + spill_num * SPILL_SIZE;
+  for (size_t i = 0;; ++i) {
+    uint16_t size;
+    memcpy(&size, column + sizeof(ColumnEncoding), sizeof(uint16_t));
+    if (i == field_idx) {
+      encoding = static_cast<ColumnEncoding>(column[0]);
+      nulls    = column + COLUMN_HEADER_SIZE;
+      values   = nulls + BITMAP_SIZE(kept);
+      return kept;
+    }
+    column += COLUMN_HEADER_SIZE + BITMAP_SIZE(kept) + size;
+  }
+}
+
+void PAXPageHandle::ReadRows(std::vector<char> &rows)
+{
+  auto row_size = GetRowSize();
+  rows.assign(tab_hdr_->rec_per_page_ * row_size, 0);
+  BitMap::ForEachSetBit(bitmap_, tab_hdr_->rec_per_page_, [&](size_t slot_id) {
+    auto row = rows.data() + slot_id * row_size;
+    ReadSlot(slot_id, row, row + tab_hdr_->nullmap_size_);
+  });
+}
+
+void PAXPageHandle::Encode(
+    const std::vector<char> &rows, const char *used, const char *spilled, std::vector<char> &frozen)
+{
+  auto                rec_num  = tab_hdr_->rec_per_page_;
+  auto                row_size = GetRowSize();
+  size_t              spilled_num{0};
+  std::vector<size_t> kept;
+  BitMap::ForEachSetBit(used, rec_num, [&](size_t slot_id) {
+    if (BitMap::GetBit(spilled, slot_id)) {
+      spilled_num++;
+    } else {
+      kept.push_back(slot_id);
+    }
+  });
+  // 1. | frozen map | spill map | spill num | spills |, the spills are written once the rows are spilled
+  auto run_rows  = ToastHandle::GetMaxValueSize() / row_size;
+  auto spill_num = static_cast<uint16_t>((spilled_num + run_rows - 1) / run_rows);
+  frozen.assign(2 * tab_hdr_->bitmap_size_ + sizeof(uint16_t) + spill_num * SPILL_SIZE, 0);
+  memcpy(frozen.data(), used, tab_hdr_->bitmap_size_);
+  memcpy(frozen.data() + tab_hdr_->bitmap_size_, spilled, tab_hdr_->bitmap_size_);
+  memcpy(frozen.data() + 2 * tab_hdr_->bitmap_size_, &spill_num, sizeof(uint16_t));
+  // 2. a column of each field, its values are encoded the way that takes the least space
+  std::vector<char> values;
+  std::vector<char> encoded;
+  for (size_t i = 0; i < schema_->GetFieldCount(); ++i) {
+    auto  &field  = schema_->GetFieldAt(i).field_;
+    auto   width  = field.field_size_;
+    auto   offset = tab_hdr_->nullmap_size_ + schema_->GetFieldOffset(i);
+    size_t column = frozen.size();
+    frozen.resize(column + COLUMN_HEADER_SIZE + BITMAP_SIZE(kept.size()));
+    size_t value_num{0};
+    values.resize(kept.size() * width);
+    for (size_t k = 0; k < kept.size(); ++k) {
+      auto row = rows.data() + kept[k] * row_size;
+      if (BitMap::GetBit(row, i)) {
+        BitMap::SetBit(frozen.data() + column + COLUMN_HEADER_SIZE, k, true);
+      } else {
+        memcpy(values.data() + value_num++ * width, row + offset, width);
+      }
+    }
+    size_t size = value_num * width;
+    encoded.resize(size);
+    auto encoding =
+        ColumnCodec::Encode(field.field_type_, width, values.data(), value_num, encoded.data(), size);
+    auto src  = encoding == ColumnEncoding::PLAIN ? values.data() : encoded.data();
+    auto size16 = static_cast<uint16_t>(size);
+    frozen[column] = static_cast<char>(encoding);
+    memcpy(frozen.data() + column + sizeof(ColumnEncoding), &size16, sizeof(uint16_t));
+    frozen.insert(frozen.end(), src, src + size);
+  }
+}
+
+void PAXPageHandle::Store(const std::vector<char> &rows, const char *used, const char *spilled,
+    std::vector<char> &frozen, size_t plain_num)
+{
+  auto rec_num  = tab_hdr_->rec_per_page_;
+  auto row_size = GetRowSize();
+  // 1. spill the rows in runs, the old runs are released once the new ones are written
+  std::vector<size_t> spill_slots;
+  BitMap::ForEachSetBit(spilled, rec_num, [&spill_slots](size_t slot_id) { spill_slots.push_back(slot_id); });
+  auto              run_rows = ToastHandle::GetMaxValueSize() / row_size;
+  auto              spills   = frozen.data() + 2 * tab_hdr_->bitmap_size_ + sizeof(uint16_t);
+  std::vector<char> run;
+  for (size_t first = 0; first < spill_slots.size(); first += run_rows, spills += SPILL_SIZE) {
+    WSDB_ASSERT(toast_ != nullptr, "pax table without toast file");
+    auto row_num = static_cast<uint16_t>(std::min(run_rows, spill_slots.size() - first));
+    run.resize(row_num * row_size);
+    for (size_t k = 0; k < row_num; ++k) {
+      memcpy(run.data() + k * row_size, rows.data() + spill_slots[first + k] * row_size, row_size);
+    }
+    page_id_t page_id;
+    uint16_t  offset;
+    toast_->Put(run.data(), run.size(), page_id, offset);
+    memcpy(spills, &page_id, sizeof(page_id_t));
+    memcpy(spills + sizeof(page_id_t), &offset, sizeof(uint16_t));
+    memcpy(spills + sizeof(page_id_t) + sizeof(uint16_t), &row_num, sizeof(uint16_t));
+  }
+  ReleaseSpills();
+  // 2. the frozen part, then the lowest slots not in use are plain
+  WSDB_ASSERT(frozen.size() + plain_num * row_size <= GetSpace(), "frozen part does not fit");
+  auto header          = GetHeader();
+  header->frozen_size_ = static_cast<uint16_t>(frozen.size());
+  memcpy(GetFrozen(), frozen.data(), frozen.size());
+  BitMap::Clear(plain_map_, rec_num);
+  for (size_t slot_id = BitMap::FindFirst(used, rec_num, 0, false), num = 0; num < plain_num;
+       slot_id        = BitMap::FindFirst(used, rec_num, slot_id + 1, false), ++num) {
+    BitMap::SetBit(plain_map_, slot_id, true);
+  }
+  header->plain_num_ = static_cast<uint16_t>(plain_num);
+  header->full_num_  = 0;
+  header->epoch_++;
+}
+
+auto PAXPageHandle::GetSpace() -> size_t
+{
+  return PAGE_SIZE - PAGE_HEADER_SIZE - 2 * tab_hdr_->bitmap_size_ - sizeof(PAXHeader);
+}
+
+auto PAXPageHandle::GetPlainCapacity(const TableHeader *tab_hdr) -> size_t
+{
+  auto space = PAGE_SIZE - PAGE_HEADER_SIZE - 2 * tab_hdr->bitmap_size_ - sizeof(PAXHeader);
+  return std::min(tab_hdr->rec_per_page_, space / (tab_hdr->nullmap_size_ + tab_hdr->rec_size_));
+}
+
+SlottedPageHandle::SlottedPageHandle(const TableHeader *tab_hdr, Page *page, const RecordSchema *schema)
+    : PageHandle(tab_hdr, page, page->GetData() + PAGE_HEADER_SIZE,
+          page->GetData() + PAGE_HEADER_SIZE + tab_hdr->bitmap_size_),
+      schema_(schema)
+{}
+
+void SlottedPageHandle::WriteSlot(size_t slot_id, const char *null_map, const char *data, bool update)
+{
+  WSDB_ASSERT(slot_id < tab_hdr_->rec_per_page_, "slot_id out of range");
+  WSDB_ASSERT((slot_id < GetHeader()->slot_num_ && GetEntry(slot_id)->offset_ != 0) == update,
+      fmt::format("update: {}", update));
+  auto body   = AllocBody(slot_id, GetBodySize(schema_, data));
+  auto cursor = body;
+  memcpy(cursor, null_map, tab_hdr_->nullmap_size_);
+  cursor += tab_hdr_->nullmap_size_;
+  for (size_t i = 0; i < schema_->GetFieldCount(); ++i) {
+    auto &field = schema_->GetFieldAt(i).field_;
+    auto  value = data + schema_->GetFieldOffset(i);
+    if (field.field_type_ == TYPE_STRING) {
+      auto len = static_cast<uint16_t>(StringLength(value, field.field_size_));
+      memcpy(cursor, &len, sizeof(uint16_t));
+      memcpy(cursor + sizeof(uint16_t), value, len);
+      cursor += sizeof(uint16_t) + len;
+    } else {
+      memcpy(cursor, value, field.field_size_);
+      cursor += field.field_size_;
+    }
+  }
+}
+
+void SlottedPageHandle::ReadSlot(size_t slot_id, char *null_map, char *data)
+{
+  WSDB_ASSERT(slot_id < GetHeader()->slot_num_, "slot_id out of range");
+  auto entry = GetEntry(slot_id);
+  WSDB_ASSERT(entry->offset_ != 0, "slot is empty");
+  WSDB_ASSERT(!(entry->size_ & FORWARD_FLAG), "slot is a forward");
+  const char *cursor = page_->GetData() + entry->offset_;
+  memcpy(null_map, cursor, tab_hdr_->nullmap_size_);
+  cursor += tab_hdr_->nullmap_size_;
+  for (size_t i = 0; i < schema_->GetFieldCount(); ++i) {
+    auto &field = schema_->GetFieldAt(i).field_;
+    auto  value = data + schema_->GetFieldOffset(i);
+    if (field.field_type_ == TYPE_STRING) {
+      uint16_t len;
+      memcpy(&len, cursor, sizeof(uint16_t));
+      WSDB_ASSERT(len <= field.field_size_, fmt::format("{} bytes of field {}", len, field.field_name_));
+      memcpy(value, cursor + sizeof(uint16_t), len);
+      memset(value + len, 0, field.field_size_ - len);
+      cursor += sizeof(uint16_t) + len;
+    } else {
+      memcpy(value, cursor, field.field_size_);
+      cursor += field.field_size_;
+    }
+  }
+}
+
+auto SlottedPageHandle::GetForward(size_t slot_id) -> RID
+{
+  WSDB_ASSERT(slot_id < GetHeader()->slot_num_, "slot_id out of range");
+  auto entry = GetEntry(slot_id);
+  if (entry->offset_ == 0 || !(entry->size_ & FORWARD_FLAG)) {
+    return INVALID_RID;
+  }
+  RID rid;
+  memcpy(&rid, page_->GetData() + entry->offset_, sizeof(RID));
+  return rid;
+}
+
+void SlottedPageHandle::SetForward(size_t slot_id, const RID &rid)
+{
+  WSDB_ASSERT(slot_id < GetHeader()->slot_num_ && GetEntry(slot_id)->offset_ != 0, "slot is empty");
+  memcpy(AllocBody(slot_id, sizeof(RID)), &rid, sizeof(RID));
+  GetEntry(slot_id)->size_ |= FORWARD_FLAG;
+}
+
+void SlottedPageHandle::FreeSlot(size_t slot_id)
+{
+  auto hdr = GetHeader();
+  WSDB_ASSERT(slot_id < hdr->slot_num_ && GetEntry(slot_id)->offset_ != 0, "slot is empty");
+  auto entry = GetEntry(slot_id);
+  hdr->free_size_ += entry->size_ & ~FORWARD_FLAG;
+  *entry = {0, 0};
+  // shrink the slot directory if the slot is at its end
+  while (hdr->slot_num_ > 0 && GetEntry(hdr->slot_num_ - 1)->offset_ == 0) {
+    hdr->slot_num_--;
+  }
+}
+
+auto SlottedPageHandle::FindFreeSlot() -> slot_id_t
+{
+  auto hdr = GetHeader();
+  for (size_t slot_id = 0; slot_id < hdr->slot_num_; ++slot_id) {
+    if (GetEntry(slot_id)->offset_ == 0) {
+      return static_cast<slot_id_t>(slot_id);
+    }
+  }
+  return hdr->slot_num_ < tab_hdr_->rec_per_page_ ? static_cast<slot_id_t>(hdr->slot_num_) : INVALID_SLOT_ID;
+}
+
+auto SlottedPageHandle::CanWrite(size_t slot_id, size_t body_size) -> bool
+{
+  auto hdr = GetHeader();
+  if (slot_id >= hdr->slot_num_) {
+    // the slot directory grows
+    auto dir_size = (slot_id + 1 - hdr->slot_num_) * sizeof(SlotEntry);
+    return slot_id < tab_hdr_->rec_per_page_ && GetFreeSize() >= body_size + dir_size;
+  }
+  auto entry    = GetEntry(slot_id);
+  auto cur_size = static_cast<size_t>(entry->offset_ == 0 ? 0 : entry->size_ & ~FORWARD_FLAG);
+  return body_size <= cur_size || GetFreeSize() + cur_size >= body_size;
+}
+
+void SlottedPageHandle::Compact()
+{
+  auto hdr = GetHeader();
+  char buf[PAGE_SIZE];
+  memcpy(buf, page_->GetData(), PAGE_SIZE);
+  size_t heap_start = PAGE_SIZE;
+  for (size_t slot_id = 0; slot_id < hdr->slot_num_; ++slot_id) {
+    auto entry = GetEntry(slot_id);
+    if (entry->offset_ == 0) {
+      continue;
+    }
+    size_t size = entry->size_ & ~FORWARD_FLAG;
+    heap_start -= size;
+    memcpy(page_->GetData() + heap_start, buf + entry->offset_, size);
+    entry->offset_ = static_cast<uint16_t>(heap_start);
+  }
+  hdr->heap_start_ = static_cast<uint16_t>(heap_start);
+  hdr->free_size_  = 0;
 }
+
+auto SlottedPageHandle::IsFull() -> bool { return GetHeader()->is_full_ != 0; }
+
+void SlottedPageHandle::SetFull(bool is_full) { GetHeader()->is_full_ = is_full; }
+
+auto SlottedPageHandle::GetBodySize(const RecordSchema *schema, const char *data) -> size_t
+{
+  size_t size = BITMAP_SIZE(schema->GetFieldCount());
+  for (size_t i = 0; i < schema->GetFieldCount(); ++i) {
+    auto &field = schema->GetFieldAt(i).field_;
+    if (field.field_type_ == TYPE_STRING) {
+      size += sizeof(uint16_t) + StringLength(data + schema->GetFieldOffset(i), field.field_size_);
+    } else {
+      size += field.field_size_;
+    }
+  }
+  // a body can always be replaced by a forward in place
+  return std::max(size, sizeof(RID));
+}
+
+auto SlottedPageHandle::GetMaxBodySize(const RecordSchema *schema) -> size_t
+{
+  size_t size = BITMAP_SIZE(schema->GetFieldCount()) + schema->GetRecordLength();
+  for (const auto &field : schema->GetFields()) {
+    size += field.field_.field_type_ == TYPE_STRING ? sizeof(uint16_t) : 0;
+  }
+  return std::max(size, sizeof(RID));
+}
+
+auto SlottedPageHandle::GetMaxSlotNum(const RecordSchema *schema) -> size_t
+{
+  size_t min_size = BITMAP_SIZE(schema->GetFieldCount());
+  for (const auto &field : schema->GetFields()) {
+    min_size += field.field_.field_type_ == TYPE_STRING ? sizeof(uint16_t) : field.field_.field_size_;
+  }
+  min_size = std::max(min_size, sizeof(RID));
+  // n = slot_num, PAGE_HDR_SIZE + BITMAP_SIZE(n) + SLOTTED_HDR_SIZE + n * (entry_size + min_size) <= PAGE_SIZE
+  return (BITMAP_WIDTH * (PAGE_SIZE - PAGE_HEADER_SIZE - sizeof(SlottedHeader) - 1) + 1) /
+         (1 + (sizeof(SlotEntry) + min_size) * BITMAP_WIDTH);
+}
+
+auto SlottedPageHandle::StringLength(const char *str, size_t size) -> size_t
+{
+  // only the zero padding at the end is dropped, so any string is read back exactly
+  while (size > 0 && str[size - 1] == '\0') {
+    --size;
+  }
+  return size;
+}
+
+auto SlottedPageHandle::GetHeapStart() -> size_t
+{
+  auto heap_start = GetHeader()->heap_start_;
+  return heap_start == 0 ? PAGE_SIZE : heap_start;
+}
+
+auto SlottedPageHandle::GetFreeSize() -> size_t
+{
+  auto hdr     = GetHeader();
+  auto dir_end = static_cast<size_t>(slots_mem_ - page_->GetData()) + sizeof(SlottedHeader) +
+                 hdr->slot_num_ * sizeof(SlotEntry);
+  return GetHeapStart() - dir_end + hdr->free_size_;
+}
+
+auto SlottedPageHandle::AllocBody(size_t slot_id, size_t body_size) -> char *
+{
+  auto hdr = GetHeader();
+  if (slot_id < hdr->slot_num_ && GetEntry(slot_id)->offset_ != 0) {
+    auto   entry    = GetEntry(slot_id);
+    size_t cur_size = entry->size_ & ~FORWARD_FLAG;
+    if (body_size <= cur_size) {
+      // overwrite in place, the tail of the old body is freed
+      hdr->free_size_ += cur_size - body_size;
+      entry->size_ = static_cast<uint16_t>(body_size);
+      return page_->GetData() + entry->offset_;
+    }
+    hdr->free_size_ += cur_size;
+    *entry = {0, 0};
+  }
+  // both the new directory entries and the body need contiguous space
+  auto dir_size = slot_id < hdr->slot_num_ ? 0 : (slot_id + 1 - hdr->slot_num_) * sizeof(SlotEntry);
+  WSDB_ASSERT(GetFreeSize() >= body_size + dir_size, "no space for the record body");
+  auto dir_end = static_cast<size_t>(reinterpret_cast<char *>(GetEntry(hdr->slot_num_)) - page_->GetData());
+  if (GetHeapStart() - dir_end < body_size + dir_size) {
+    Compact();
+  }
+  for (; hdr->slot_num_ <= slot_id; hdr->slot_num_++) {
+    *GetEntry(hdr->slot_num_) = {0, 0};
+  }
+  auto offset        = static_cast<uint16_t>(GetHeapStart() - body_size);
+  hdr->heap_start_   = offset;
+  *GetEntry(slot_id) = {offset, static_cast<uint16_t>(body_size)};
+  return page_->GetData() + offset;
+}
+
 }  // namespace wsdb
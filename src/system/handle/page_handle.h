@@ -22,11 +22,15 @@
 #ifndef WSDB_PAGE_HANDLE_H
 #define WSDB_PAGE_HANDLE_H
 
+#include "common/condition.h"
 #include "common/meta.h"
 #include "common/page.h"
+#include "column_encoding.h"
 #include "record_handle.h"
 
 namespace wsdb {
+class ToastHandle;
+
 class PageHandle
 {
 public:
@@ -45,8 +49,35 @@ public:
 
   virtual void ReadSlot(size_t slot_id, char *null_map, char *data);
 
+  /**
+   * Point to the record in the slot without copying, only possible if the record is stored contiguously
+   * @param slot_id
+   * @param[out] null_map
+   * @param[out] data
+   * @return false if the storage model can not view a slot in place, use ReadSlot instead
+   */
+  virtual auto ViewSlot(size_t slot_id, const char *&null_map, const char *&data) -> bool;
+
+  /**
+   * @param slot_id
+   * @return the RID the record in the slot is moved to, INVALID_RID if the record is stored in the slot
+   */
+  virtual auto GetForward(size_t slot_id) -> RID;
+
   virtual auto ReadChunk(const RecordSchema *chunk_schema) -> ChunkUptr;
 
+  /**
+   * Narrow the occupied slots down to those that may satisfy the conditions, evaluated on the page without reading
+   * the records
+   * @param conds
+   * @param[out] slots bitmap of the slots that may satisfy the conditions
+   * @return false if the storage model can not evaluate conditions on the page, slots is not written then
+   */
+  virtual auto FilterSlots(const ConditionVec &conds, std::vector<char> &slots) -> bool { return false; }
+
+  /// @return bitmap of the slots a new record can be written to once free, nullptr if any slot can
+  virtual auto GetWritableMap() -> const char * { return nullptr; }
+
   virtual ~PageHandle() = default;
 
   [[nodiscard]] auto GetPage() -> Page * { return page_; }
@@ -70,6 +101,8 @@ public:
   void WriteSlot(size_t slot_id, const char *null_map, const char *data, bool update) override;
 
   void ReadSlot(size_t slot_id, char *null_map, char *data) override;
+
+  auto ViewSlot(size_t slot_id, const char *&null_map, const char *&data) -> bool override;
 };
 
 /**
@@ -83,24 +116,261 @@ public:
  * insert into pax_test values (, 6.1, , 8, 9, 'c', );
  */
 
+/**
+ * PAX page, | page header | bitmap | pax header | plain map | frozen part | plain part |
+ * A page has more slots than its rows take stored plain, rows are written plain and encoded together once the plain
+ * slots run out, so a page of well compressed rows holds several times the rows of a plain one.
+ * - plain part: | null maps | minipage of each field |, a minipage stores the field of the plain slots back to back,
+ *   the k-th slot set in the plain map is stored k-th. Only plain slots not in use take new records.
+ * - frozen part: | frozen map | spill map | spill num (2) | spills | column of each field |, the rows of the slots set
+ *   in the frozen map when the page was last encoded. A column is | encoding (1) | size (2) | null bits | values |, it
+ *   holds the non-null values of the rows not spilled encoded by ColumnCodec. Rows that do not fit in the page are
+ *   spilled to the toast file of the table in runs of rows, a spill is | page id (4) | offset (2) | row num (2) |.
+ * A fresh page has no frozen part, its first slots up to the plain capacity are plain.
+ *
+ * Freeze encodes the rows of a page whose plain slots are all in use into the frozen part, the slots not in use become
+ * the plain slots. A frozen row is updated and a slot not in use but not plain is filled by Rewrite, which encodes the
+ * page again with the row. The table latches a page exclusively for Freeze and Rewrite, shared for anything else, a
+ * deleted frozen row stays in the frozen part until the page is encoded again.
+ */
 class PAXPageHandle : public PageHandle
 {
 public:
   PAXPageHandle() = delete;
 
-  PAXPageHandle(const TableHeader *tab_hdr, Page *page, const RecordSchema *schema, const std::vector<size_t> &offsets);
-
-  ~PAXPageHandle() override;
+  /**
+   * @param toast the toast file of the table rows are spilled to
+   */
+  PAXPageHandle(const TableHeader *tab_hdr, Page *page, const RecordSchema *schema, ToastHandle *toast);
 
+  /// write a record to a plain slot
   void WriteSlot(size_t slot_id, const char *null_map, const char *data, bool update) override;
 
+  /// read a record, frozen rows of the page are decoded at the first read and kept by the handle
   void ReadSlot(size_t slot_id, char *null_map, char *data) override;
 
   auto ReadChunk(const RecordSchema *chunk_schema) -> ChunkUptr override;
 
+  /// conditions are evaluated on the plain minipages and on the encoded columns, spilled rows are kept
+  auto FilterSlots(const ConditionVec &conds, std::vector<char> &slots) -> bool override;
+
+  /// @return the plain map
+  auto GetWritableMap() -> const char * override;
+
+  auto IsPlain(size_t slot_id) -> bool;
+
+  /// @return whether no plain slot is free and too few slots are not in use for Freeze to make room
+  auto IsFull() -> bool;
+
+  /**
+   * Encode the rows of the page into the frozen part to make the slots not in use plain, the page is left as it is
+   * unless at least 1/PAX_FREEZE_GAIN of the plain capacity becomes free and no row is spilled
+   * @return whether a plain slot is free
+   */
+  auto Freeze() -> bool;
+
+  /**
+   * Encode the page again with the record in the slot, the record replaces the row in the slot or fills it if it is
+   * not in use, rows that do not fit are spilled. The bit of the slot is left to the caller.
+   */
+  void Rewrite(size_t slot_id, const char *null_map, const char *data);
+
+  /// release the spilled rows of a page that is dropped
+  void ReleaseSpills();
+
+  /// @return the number of slots of a page, as many as fit if all rows are spilled and at most PAX_SLOT_RATIO times the
+  /// rows of a plain page
+  static auto GetMaxSlotNum(const RecordSchema *schema) -> size_t;
+
+private:
+  struct PAXHeader
+  {
+    // bumped whenever the page is encoded, frozen rows decoded before are stale then
+    uint32_t epoch_;
+    uint16_t plain_num_;
+    // 0 for a fresh page, which has no frozen part
+    uint16_t frozen_size_;
+    // Freeze is not tried again while this many rows or more are in use, 0 if it has not failed
+    uint16_t full_num_;
+  };
+
+  // | page id (4) | offset (2) | row num (2) |
+  static constexpr size_t SPILL_SIZE = sizeof(page_id_t) + 2 * sizeof(uint16_t);
+  // | encoding (1) | size (2) |
+  static constexpr size_t COLUMN_HEADER_SIZE = sizeof(ColumnEncoding) + sizeof(uint16_t);
+
+  auto GetHeader() -> PAXHeader * { return reinterpret_cast<PAXHeader *>(slots_mem_); }
+
+  [[nodiscard]] auto IsFresh() -> bool { return GetHeader()->frozen_size_ == 0; }
+
+  auto GetPlainNum() -> size_t { return IsFresh() ? plain_cap_ : GetHeader()->plain_num_; }
+
+  auto GetFrozen() -> char * { return plain_map_ + tab_hdr_->bitmap_size_; }
+
+  auto GetPlain() -> char * { return GetFrozen() + GetHeader()->frozen_size_; }
+
+  /// @return index of a plain slot in the plain part
+  auto RankOf(size_t slot_id) -> size_t;
+
+  /// bytes a row takes in the plain part
+  [[nodiscard]] auto GetRowSize() const -> size_t { return tab_hdr_->nullmap_size_ + tab_hdr_->rec_size_; }
+
+  /// @return the first plain slot not in use, rec_per_page_ if none
+  auto FindFreePlain() -> size_t;
+
+  /// decode the frozen rows into rows_ unless they are decoded already
+  void DecodeFrozen();
+
+  /**
+   * Locate the column of a field in the frozen part
+   * @param[out] nulls null bits of the rows not spilled
+   * @param[out] values
+   * @return row num of the rows not spilled
+   */
+  auto GetColumn(size_t field_idx, ColumnEncoding &encoding, const char *&nulls, const char *&values) -> size_t;
+
+  /// read the rows in use into rows, a row is | null map | data | and rows are slot_id ordered
+  void ReadRows(std::vector<char> &rows);
+
+  /**
+   * Encode the frozen part of the rows in use, the spills are filled in by Store
+   * @param rows rows of all slots, see ReadRows
+   * @param used bitmap of the slots in use
+   * @param spilled bitmap of the slots spilled
+   * @param[out] frozen
+   */
+  void Encode(const std::vector<char> &rows, const char *used, const char *spilled, std::vector<char> &frozen);
+
+  /// spill rows, release the old spills and write the frozen part, the slots not in use are plain up to plain_num
+  void Store(const std::vector<char> &rows, const char *used, const char *spilled, std::vector<char> &frozen,
+      size_t plain_num);
+
+  /// @return bytes the frozen part and the plain part share
+  auto GetSpace() -> size_t;
+
+  /// @return the number of plain slots a fresh page has
+  static auto GetPlainCapacity(const TableHeader *tab_hdr) -> size_t;
+
+  const RecordSchema *schema_;
+  ToastHandle        *toast_;
+  char               *plain_map_;
+  size_t              plain_cap_;
+  // the plain map of a fresh page, the first plain_cap_ slots
+  std::vector<char> fresh_map_;
+  // frozen rows decoded by slot id, see ReadRows
+  std::vector<char> rows_;
+  bool              decoded_{false};
+  uint32_t          decoded_epoch_{0};
+};
+
+/**
+ * Slotted page, records are stored at their actual length so strings take no more space than their content
+ * | page header | bitmap | slotted header | slot directory -> ... free space ... <- record heap |
+ * The slot directory grows forward from the slotted header and record bodies are allocated backward from the end of
+ * the page, the space left by deletes and shrinking updates is merged by compaction when a body does not fit.
+ * A record body is | null map | fields |, string fields are stored as | length (2 bytes) | bytes without padding |.
+ *
+ * The bitmap marks slots holding records visible to scans. A record that outgrows its page is moved to another page,
+ * its home slot keeps the RID of the new location as a forward so RIDs stay stable, the moved body is not marked in
+ * the bitmap of the page it is moved to.
+ */
+class SlottedPageHandle : public PageHandle
+{
+public:
+  SlottedPageHandle() = delete;
+
+  SlottedPageHandle(const TableHeader *tab_hdr, Page *page, const RecordSchema *schema);
+
+  /**
+   * Write a record body to the slot, the caller should check CanWrite first
+   * @param slot_id
+   * @param null_map
+   * @param data
+   * @param update indicate whether there is already a record in the slot, it is overwritten in place if it is large
+   * enough, otherwise a new body is allocated and the old one is freed
+   */
+  void WriteSlot(size_t slot_id, const char *null_map, const char *data, bool update) override;
+
+  /// decode the record body in the slot, the slot must not be a forward
+  void ReadSlot(size_t slot_id, char *null_map, char *data) override;
+
+  auto GetForward(size_t slot_id) -> RID override;
+
+  /// replace the body in the slot with a forward to rid, always fits since a body is no smaller than a RID
+  void SetForward(size_t slot_id, const RID &rid);
+
+  void FreeSlot(size_t slot_id);
+
+  /// @return whether the slot has no body, neither a record visible to scans nor a moved one
+  auto IsEmpty(size_t slot_id) -> bool { return slot_id >= GetHeader()->slot_num_ || GetEntry(slot_id)->offset_ == 0; }
+
+  /// @return the first slot without body, INVALID_SLOT_ID if the slot directory is full
+  auto FindFreeSlot() -> slot_id_t;
+
+  /**
+   * @param slot_id an occupied slot or the one returned by FindFreeSlot
+   * @param body_size
+   * @return whether a body of body_size bytes can be written to the slot, possibly after compaction
+   */
+  auto CanWrite(size_t slot_id, size_t body_size) -> bool;
+
+  /// move all bodies to the end of the page to merge the free space between them
+  void Compact();
+
+  /// @return whether the page is taken out of the free page list of the table
+  [[nodiscard]] auto IsFull() -> bool;
+
+  void SetFull(bool is_full);
+
+  /// @return size of the body the record is encoded to
+  static auto GetBodySize(const RecordSchema *schema, const char *data) -> size_t;
+
+  /// @return body size of a record whose strings are all full length, a page in the free list can hold such a record
+  static auto GetMaxBodySize(const RecordSchema *schema) -> size_t;
+
+  /// @return the number of slots a page can hold if all records are as short as possible
+  static auto GetMaxSlotNum(const RecordSchema *schema) -> size_t;
+
+private:
+  struct SlottedHeader
+  {
+    uint16_t slot_num_;
+    // the lowest offset used by the heap, 0 for a fresh page whose heap is empty
+    uint16_t heap_start_;
+    // bytes freed inside the heap, reclaimed by compaction
+    uint16_t free_size_;
+    uint16_t is_full_;
+  };
+
+  struct SlotEntry
+  {
+    // offset of the body in the page, 0 if the slot is empty
+    uint16_t offset_;
+    uint16_t size_;
+  };
+
+  static constexpr uint16_t FORWARD_FLAG = 0x8000;
+
+  auto GetHeader() -> SlottedHeader * { return reinterpret_cast<SlottedHeader *>(slots_mem_); }
+
+  auto GetEntry(size_t slot_id) -> SlotEntry *
+  {
+    return reinterpret_cast<SlotEntry *>(slots_mem_ + sizeof(SlottedHeader)) + slot_id;
+  }
+
+  /// length of a string field without its zero padding
+  static auto StringLength(const char *str, size_t size) -> size_t;
+
+  auto GetHeapStart() -> size_t;
+
+  /// free space between the slot directory and the heap plus the space freed inside the heap
+  auto GetFreeSize() -> size_t;
+
+  /// allocate a body for the slot, the old body is reused if it is large enough
+  auto AllocBody(size_t slot_id, size_t body_size) -> char *;
+
 private:
-  const RecordSchema        *schema_;
-  const std::vector<size_t> &offsets_;
+  const RecordSchema *schema_;
 };
 
 DEFINE_UNIQUE_PTR(PageHandle);
@@ -0,0 +1,271 @@
+/*------------------------------------------------------------------------------
+ - Copyright (c) 2024. Websoft research group, Nanjing University.
+ -
+ - This program is free software: you can redistribute it and/or modify
+ - it under the terms of the GNU General Public License as published by
+ - the Free Software Foundation, either version 3 of the License, or
+ - (at your option) any later version.
+ -
+ - This program is distributed in the hope that it will be useful,
+ - but WITHOUT ANY WARRANTY; without even the implied warranty of
+ - MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ - GNU General Public License for more details.
+ -
+ - You should have received a copy of the GNU General Public License
+ - along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ -----------------------------------------------------------------------------*/
+
+//
+// Created by ziqi on 2024/9/18.
+//
+
+#include "partition.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+
+namespace wsdb {
+
+namespace {
+template <typename T>
+void Append(std::vector<char> &buf, const T &val)
+{
+  buf.insert(buf.end(), reinterpret_cast<const char *>(&val), reinterpret_cast<const char *>(&val) + sizeof(T));
+}
+
+template <typename T>
+auto Read(const char *&cursor) -> T
+{
+  T val;
+  memcpy(&val, cursor, sizeof(T));
+  cursor += sizeof(T);
+  return val;
+}
+
+/// @return the bytes of a non-null value as ValueFactory::CreateValue reads them
+auto BytesOf(const Value &value) -> std::string
+{
+  switch (value.GetType()) {
+    case TYPE_INT: {
+      auto val = dynamic_cast<const IntValue &>(value).Get();
+      return {reinterpret_cast<const char *>(&val), sizeof(val)};
+    }
+    case TYPE_FLOAT: {
+      auto val = dynamic_cast<const FloatValue &>(value).Get();
+      return {reinterpret_cast<const char *>(&val), sizeof(val)};
+    }
+    case TYPE_BOOL: {
+      auto val = dynamic_cast<const BoolValue &>(value).Get();
+      return {reinterpret_cast<const char *>(&val), sizeof(val)};
+    }
+    case TYPE_STRING: return dynamic_cast<const StringValue &>(value).Get();
+    default: WSDB_FETAL("Unsupported partition key type");
+  }
+}
+
+/**
+ * 64-bit FNV-1a over the bytes of a non-null key: an int or a float as 4 bytes in little-endian order, a bool as one
+ * byte 0 or 1 and a string as its characters without the trailing zeros. The partitions of stored rows depend on it, so
+ * it must give the same result on every platform and in every version, unlike std::hash. -0.0 is hashed as 0.0 since
+ * they compare equal
+ */
+auto HashOf(const Datum &value) -> uint64_t
+{
+  constexpr uint64_t FNV_OFFSET_BASIS = 0xcbf29ce484222325ULL;
+  constexpr uint64_t FNV_PRIME        = 0x100000001b3ULL;
+
+  uint64_t hash     = FNV_OFFSET_BASIS;
+  auto     mix      = [&hash](uint8_t byte) { hash = (hash ^ byte) * FNV_PRIME; };
+  auto     mix_word = [&mix](uint32_t word) {
+    for (int i = 0; i < 4; ++i) {
+      mix(static_cast<uint8_t>(word >> (8 * i)));
+    }
+  };
+  switch (value.GetType()) {
+    case TYPE_BOOL: mix(value.GetBool() ? 1 : 0); break;
+    case TYPE_INT: mix_word(static_cast<uint32_t>(value.GetInt())); break;
+    case TYPE_FLOAT: mix_word(std::bit_cast<uint32_t>(value.GetFloat() == 0.0F ? 0.0F : value.GetFloat())); break;
+    case TYPE_STRING:
+      for (auto c : value.GetString()) {
+        mix(static_cast<uint8_t>(c));
+      }
+      break;
+    default: WSDB_FETAL("Unsupported partition key type");
+  }
+  return hash;
+}
+
+/**
+ * Compare two non-null values, int and float are compared as float
+ * @param[out] result negative, zero or positive as lhs is less than, equal to or greater than rhs
+ * @return false if the values can not be compared
+ */
+auto Compare(ValueSptr lhs, ValueSptr rhs, int &result) -> bool
+{
+  if (lhs->GetType() != rhs->GetType()) {
+    auto is_numeric = [](const ValueSptr &value) {
+      return value->GetType() == TYPE_INT || value->GetType() == TYPE_FLOAT;
+    };
+    if (!is_numeric(lhs) || !is_numeric(rhs)) {
+      return false;
+    }
+    ValueFactory::AlignTypes(lhs, rhs);
+  }
+  result = *lhs < *rhs ? -1 : (*lhs > *rhs ? 1 : 0);
+  return true;
+}
+}  // namespace
+
+PartitionScheme::PartitionScheme(
+    PartitionType type, std::string field_name, size_t partition_num, std::vector<ValueSptr> bounds)
+    : type_(type), field_name_(std::move(field_name)), partition_num_(partition_num), bounds_(std::move(bounds))
+{
+  WSDB_ASSERT(type_ == HASH_PARTITION ? bounds_.empty() : bounds_.size() + 1 == partition_num_,
+      "partition bounds mismatch the partition number");
+}
+
+void PartitionScheme::Bind(const RecordSchema *schema)
+{
+  const auto &fields = schema->GetFields();
+  auto        field  = std::find_if(
+      fields.begin(), fields.end(), [this](const RTField &f) { return f.field_.field_name_ == field_name_; });
+  if (field == fields.end()) {
+    WSDB_THROW(WSDB_FIELD_MISS, field_name_);
+  }
+  if (partition_num_ < 1 || partition_num_ > MAX_PARTITION_NUM) {
+    WSDB_THROW(WSDB_GRAMMAR_ERROR, fmt::format("{} partitions, expect 1 to {}", partition_num_, MAX_PARTITION_NUM));
+  }
+  for (auto &bound : bounds_) {
+    if (bound->IsNull()) {
+      WSDB_THROW(WSDB_UNEXPECTED_NULL, "partition bound");
+    }
+    bound = ValueFactory::CastTo(bound, field->field_.field_type_);
+  }
+  for (size_t i = 1; i < bounds_.size(); ++i) {
+    if (!(*bounds_[i - 1] < *bounds_[i])) {
+      WSDB_THROW(WSDB_GRAMMAR_ERROR, fmt::format("partition bounds must ascend, {}", ToString()));
+    }
+  }
+  schema_    = schema;
+  field_idx_ = static_cast<size_t>(field - fields.begin());
+}
+
+auto PartitionScheme::GetPartition(const RecordView &record) const -> size_t
+{
+  auto key = record.GetDatumAt(field_idx_);
+  if (key.IsNull()) {
+    return 0;
+  }
+  if (type_ == HASH_PARTITION) {
+    return HashOf(key) % partition_num_;
+  }
+  // the number of bounds not greater than the key, the bounds are of the type of the key
+  auto bound = std::upper_bound(bounds_.begin(), bounds_.end(), key, [](const Datum &lhs, const ValueSptr &rhs) {
+    return Datum::Compare(lhs, Datum::FromValue(*rhs)) < 0;
+  });
+  return static_cast<size_t>(bound - bounds_.begin());
+}
+
+auto PartitionScheme::Prune(const ConditionVec &conds) const -> std::vector<size_t>
+{
+  std::vector<size_t> partitions;
+  for (size_t i = 0; i < partition_num_; ++i) {
+    bool may_match = true;
+    for (const auto &cond : conds) {
+      if (cond.GetRhsType() != kValue || schema_->GetRTFieldIndex(cond.GetLCol()) != field_idx_) {
+        continue;
+      }
+      auto value = cond.GetRVal();
+      if (value != nullptr && !value->IsNull() && !MayMatch(i, cond.GetOp(), value)) {
+        may_match = false;
+        break;
+      }
+    }
+    if (may_match) {
+      partitions.push_back(i);
+    }
+  }
+  return partitions;
+}
+
+void PartitionScheme::Serialize(std::vector<char> &buf) const
+{
+  Append(buf, type_);
+  buf.insert(buf.end(), field_name_.c_str(), field_name_.c_str() + field_name_.size() + 1);
+  Append(buf, partition_num_);
+  Append(buf, bounds_.size());
+  for (const auto &bound : bounds_) {
+    auto bytes = BytesOf(*bound);
+    Append(buf, bytes.size());
+    buf.insert(buf.end(), bytes.begin(), bytes.end());
+  }
+}
+
+auto PartitionScheme::Deserialize(const char *&cursor, const RecordSchema *schema) -> PartitionSchemeUptr
+{
+  auto        type = Read<PartitionType>(cursor);
+  std::string field_name(cursor);
+  cursor += field_name.size() + 1;
+  auto partition_num = Read<size_t>(cursor);
+  auto bound_num     = Read<size_t>(cursor);
+  // the bounds are stored in the type of the key, Bind throws if the key is missing
+  FieldType field_type = TYPE_STRING;
+  for (const auto &field : schema->GetFields()) {
+    if (field.field_.field_name_ == field_name) {
+      field_type = field.field_.field_type_;
+    }
+  }
+  std::vector<ValueSptr> bounds;
+  bounds.reserve(bound_num);
+  for (size_t i = 0; i < bound_num; ++i) {
+    auto size = Read<size_t>(cursor);
+    // terminate the bytes, a string value is cut at the first \0
+    std::string bytes(cursor, size);
+    cursor += size;
+    bounds.push_back(ValueFactory::CreateValue(field_type, bytes.c_str(), size));
+  }
+  auto scheme = std::make_unique<PartitionScheme>(type, field_name, partition_num, std::move(bounds));
+  scheme->Bind(schema);
+  return scheme;
+}
+
+auto PartitionScheme::ToString() const -> std::string
+{
+  if (type_ == HASH_PARTITION) {
+    return fmt::format("HASH({}) <{}>", field_name_, partition_num_);
+  }
+  std::string bounds_str;
+  for (const auto &bound : bounds_) {
+    bounds_str += (bounds_str.empty() ? "" : ", ") + bound->ToString();
+  }
+  return fmt::format("RANGE({}) <{}>", field_name_, bounds_str);
+}
+
+auto PartitionScheme::MayMatch(size_t partition, CompOp op, const ValueSptr &value) const -> bool
+{
+  if (type_ == HASH_PARTITION) {
+    // only equality tells the partition, and the value must be of the type of the key to hash the same
+    return op != OP_EQ || value->GetType() != schema_->GetFieldAt(field_idx_).field_.field_type_ ||
+           HashOf(Datum::FromValue(*value)) % partition_num_ == partition;
+  }
+  // the partition holds keys in [lower, upper), the first one has no lower bound and the last one no upper bound
+  int lower_cmp = -1;
+  int upper_cmp = 1;
+  if (partition > 0 && !Compare(bounds_[partition - 1], value, lower_cmp)) {
+    return true;
+  }
+  if (partition + 1 < partition_num_ && !Compare(bounds_[partition], value, upper_cmp)) {
+    return true;
+  }
+  switch (op) {
+    case OP_EQ: return lower_cmp <= 0 && upper_cmp > 0;
+    case OP_LT: return lower_cmp < 0;
+    case OP_LE: return lower_cmp <= 0;
+    case OP_GT:
+    case OP_GE: return upper_cmp > 0;
+    default: return true;
+  }
+}
+
+}  // namespace wsdb
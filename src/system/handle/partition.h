@@ -0,0 +1,111 @@
+/*------------------------------------------------------------------------------
+ - Copyright (c) 2024. Websoft research group, Nanjing University.
+ -
+ - This program is free software: you can redistribute it and/or modify
+ - it under the terms of the GNU General Public License as published by
+ - the Free Software Foundation, either version 3 of the License, or
+ - (at your option) any later version.
+ -
+ - This program is distributed in the hope that it will be useful,
+ - but WITHOUT ANY WARRANTY; without even the implied warranty of
+ - MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ - GNU General Public License for more details.
+ -
+ - You should have received a copy of the GNU General Public License
+ - along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ -----------------------------------------------------------------------------*/
+
+//
+// Created by ziqi on 2024/9/18.
+//
+
+#ifndef WSDB_PARTITION_H
+#define WSDB_PARTITION_H
+
+#include <string>
+#include <vector>
+
+#include "common/condition.h"
+#include "record_handle.h"
+
+namespace wsdb {
+
+/**
+ * @brief How the rows of a partitioned table are spread over its partitions, each of which is a table file of its own.
+ *
+ * RANGE(key) with bounds b_1 < b_2 < ... < b_n-1 puts a row into partition i if b_i <= key < b_i+1, where b_0 is
+ * minus infinity and b_n plus infinity, HASH(key) with n partitions puts a row into partition hash(key) % n, where hash
+ * is 64-bit FNV-1a over the bytes of the key, fixed so that rows stay in their partitions across platforms and
+ * versions.
+ * Rows whose key is null go to partition 0, no comparison is satisfied by them, so pruning never misses them.
+ *
+ * The scheme is stored in the header page of the table file after the schema
+ * | type | key name \0 | partition num | bound num | bound size 1 | bound 1 | ... | bound size n | bound n |
+ */
+class PartitionScheme
+{
+public:
+  /**
+   * @param type
+   * @param field_name name of the partition key
+   * @param partition_num number of partitions, the number of bounds plus one for range partitioning
+   * @param bounds ascending lower bounds of the partitions but the first one for range partitioning, empty for hash
+   */
+  PartitionScheme(PartitionType type, std::string field_name, size_t partition_num, std::vector<ValueSptr> bounds);
+
+  DISABLE_COPY_MOVE_AND_ASSIGN(PartitionScheme)
+
+  /**
+   * Check the scheme against the schema of the table, and cast the bounds to the type of the key
+   * @param schema must outlive the scheme, the table id of its fields is used to match conditions
+   */
+  void Bind(const RecordSchema *schema);
+
+  /// @return the partition of the row, the scheme must be bound
+  [[nodiscard]] auto GetPartition(const RecordView &record) const -> size_t;
+
+  /**
+   * Find the partitions that may hold rows satisfying all the conditions, only conditions comparing the key with a
+   * value are used, i.e. ranges for range partitioning and equality for hash partitioning
+   * @param conds
+   * @return ascending partition ids
+   */
+  [[nodiscard]] auto Prune(const ConditionVec &conds) const -> std::vector<size_t>;
+
+  /// append the scheme to buf in the layout of the header page, the scheme must be bound
+  void Serialize(std::vector<char> &buf) const;
+
+  /**
+   * Read a scheme written by Serialize, the bounds are read in the type of the key in the schema
+   * @param[in,out] cursor moved past the scheme
+   * @param schema
+   * @return a bound scheme
+   */
+  static auto Deserialize(const char *&cursor, const RecordSchema *schema) -> std::unique_ptr<PartitionScheme>;
+
+  [[nodiscard]] auto GetType() const -> PartitionType { return type_; }
+
+  [[nodiscard]] auto GetFieldName() const -> const std::string & { return field_name_; }
+
+  [[nodiscard]] auto GetPartitionNum() const -> size_t { return partition_num_; }
+
+  [[nodiscard]] auto ToString() const -> std::string;
+
+private:
+  /// @return whether partition may hold a row satisfying the condition on the key
+  [[nodiscard]] auto MayMatch(size_t partition, CompOp op, const ValueSptr &value) const -> bool;
+
+  const PartitionType    type_;
+  const std::string      field_name_;
+  const size_t           partition_num_;
+  std::vector<ValueSptr> bounds_;
+  // set by Bind
+  const RecordSchema *schema_{nullptr};
+  size_t              field_idx_{0};
+};
+
+DEFINE_UNIQUE_PTR(PartitionScheme);
+
+}  // namespace wsdb
+
+#endif  // WSDB_PARTITION_H
@@ -0,0 +1,270 @@
+/*------------------------------------------------------------------------------
+ - Copyright (c) 2024. Websoft research group, Nanjing University.
+ -
+ - This program is free software: you can redistribute it and/or modify
+ - it under the terms of the GNU General Public License as published by
+ - the Free Software Foundation, either version 3 of the License, or
+ - (at your option) any later version.
+ -
+ - This program is distributed in the hope that it will be useful,
+ - but WITHOUT ANY WARRANTY; without even the implied warranty of
+ - MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ - GNU General Public License for more details.
+ -
+ - You should have received a copy of the GNU General Public License
+ - along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ -----------------------------------------------------------------------------*/
+
+//
+// Created by ziqi on 2024/9/21.
+//
+
+#include "record_compare.h"
+
+#include <algorithm>
+#include <cstring>
+#include <string_view>
+
+namespace wsdb {
+
+namespace {
+/// template argument of the kernels for fields of any type, which are read as datums
+constexpr FieldType ANY_TYPE = TYPE_NULL;
+
+auto FindKeyFields(const RecordSchema &key_schema, const RecordSchema &schema) -> std::vector<BoundField>
+{
+  std::vector<BoundField> fields;
+  fields.reserve(key_schema.GetFieldCount());
+  for (const auto &field : key_schema.GetFields()) {
+    fields.push_back(schema.BindField(field));
+  }
+  return fields;
+}
+
+auto HasLayout(const std::vector<BoundField> &fields, std::initializer_list<FieldType> types) -> bool
+{
+  auto is_type = [](const BoundField &field, FieldType type) { return field.type_ == type; };
+  return std::equal(fields.begin(), fields.end(), types.begin(), types.end(), is_type);
+}
+
+template <typename T>
+auto Read(const char *data) -> T
+{
+  T value;
+  memcpy(&value, data, sizeof(T));
+  return value;
+}
+
+template <typename T>
+auto Three(const T &lhs, const T &rhs) -> int
+{
+  return lhs < rhs ? -1 : (rhs < lhs ? 1 : 0);
+}
+
+/// a string field is cut at the first '\0' like StringValue
+auto ReadString(const BoundField &field, const char *data) -> std::string_view
+{
+  const char *str = data + field.offset_;
+  return {str, strnlen(str, field.size_)};
+}
+
+/// compare a field of two keys, null comes first
+template <FieldType Type>
+auto CompareField(const BoundField &lhs, const char *lhs_nullmap, const char *lhs_data, const BoundField &rhs,
+    const char *rhs_nullmap, const char *rhs_data) -> int
+{
+  bool lhs_null = BitMap::GetBit(lhs_nullmap, lhs.field_idx_);
+  bool rhs_null = BitMap::GetBit(rhs_nullmap, rhs.field_idx_);
+  if (lhs_null || rhs_null) {
+    return static_cast<int>(rhs_null) - static_cast<int>(lhs_null);
+  }
+  if constexpr (Type == TYPE_INT) {
+    return Three(Read<int32_t>(lhs_data + lhs.offset_), Read<int32_t>(rhs_data + rhs.offset_));
+  } else if constexpr (Type == TYPE_STRING) {
+    return Three(ReadString(lhs, lhs_data).compare(ReadString(rhs, rhs_data)), 0);
+  } else {
+    return Datum::Compare(Datum::FromField(lhs.type_, lhs_data + lhs.offset_, lhs.size_),
+        Datum::FromField(rhs.type_, rhs_data + rhs.offset_, rhs.size_));
+  }
+}
+
+void StoreBigEndian(uint32_t value, unsigned char *dst)
+{
+  for (int i = 3; i >= 0; --i, value >>= 8) {
+    dst[i] = static_cast<unsigned char>(value & 0xFF);
+  }
+}
+
+/// @return bytes of the normalized value of a field
+auto NormalizedWidth(const BoundField &field) -> size_t
+{
+  switch (field.type_) {
+    case TYPE_BOOL: return 1;
+    case TYPE_INT:
+    case TYPE_FLOAT: return sizeof(uint32_t);
+    case TYPE_STRING: return field.size_;
+    default: WSDB_FETAL(fmt::format("Unsupported key type {}", FieldTypeToString(field.type_)));
+  }
+}
+
+/// write the normalized value of a non-null field to dst, see KeyNormalizer
+void NormalizeValue(const BoundField &field, const char *data, unsigned char *dst)
+{
+  switch (field.type_) {
+    case TYPE_BOOL: *dst = Read<bool>(data + field.offset_) ? 1 : 0; break;
+    case TYPE_INT: StoreBigEndian(static_cast<uint32_t>(Read<int32_t>(data + field.offset_)) ^ 0x80000000U, dst); break;
+    case TYPE_FLOAT: {
+      // -0 equals 0
+      auto     value = Read<float>(data + field.offset_);
+      uint32_t bits;
+      value = value == 0 ? 0.0f : value;
+      memcpy(&bits, &value, sizeof(bits));
+      StoreBigEndian((bits & 0x80000000U) != 0 ? ~bits : bits | 0x80000000U, dst);
+      break;
+    }
+    case TYPE_STRING: {
+      auto str = ReadString(field, data);
+      memcpy(dst, str.data(), str.size());
+      memset(dst + str.size(), 0, field.size_ - str.size());
+      break;
+    }
+    default: WSDB_FETAL(fmt::format("Unsupported key type {}", FieldTypeToString(field.type_)));
+  }
+}
+
+auto Combine(size_t hash, size_t value) -> size_t { return hash ^ (value + 0x9e3779b9 + (hash << 6) + (hash >> 2)); }
+
+/// hash of a field, the same as Datum::Hash
+template <FieldType Type>
+auto HashField(const BoundField &field, const char *nullmap, const char *data) -> size_t
+{
+  if (BitMap::GetBit(nullmap, field.field_idx_)) {
+    return 0;
+  }
+  if constexpr (Type == TYPE_INT) {
+    return std::hash<int32_t>{}(Read<int32_t>(data + field.offset_));
+  } else if constexpr (Type == TYPE_STRING) {
+    return std::hash<std::string_view>{}(ReadString(field, data));
+  } else {
+    return Datum::FromField(field.type_, data + field.offset_, field.size_).Hash();
+  }
+}
+}  // namespace
+
+RecordComparator::RecordComparator(const RecordSchema &key_schema, const RecordSchema &schema)
+    : RecordComparator(key_schema, schema, key_schema, schema)
+{}
+
+RecordComparator::RecordComparator(const RecordSchema &lhs_key_schema, const RecordSchema &lhs_schema,
+    const RecordSchema &rhs_key_schema, const RecordSchema &rhs_schema)
+    : lhs_fields_(FindKeyFields(lhs_key_schema, lhs_schema)), rhs_fields_(FindKeyFields(rhs_key_schema, rhs_schema))
+{
+  WSDB_ASSERT(lhs_fields_.size() == rhs_fields_.size(), "key field count mismatch");
+  // the kernels read both sides as the same types, keys mixing types, e.g. int with float, are compared as datums
+  bool same_types = std::equal(lhs_fields_.begin(),
+      lhs_fields_.end(),
+      rhs_fields_.begin(),
+      [](const BoundField &lhs, const BoundField &rhs) { return lhs.type_ == rhs.type_; });
+  if (same_types && HasLayout(lhs_fields_, {TYPE_INT})) {
+    kernel_ = &CompareFixed<TYPE_INT>;
+  } else if (same_types && HasLayout(lhs_fields_, {TYPE_INT, TYPE_INT})) {
+    kernel_ = &CompareFixed<TYPE_INT, TYPE_INT>;
+  } else if (same_types && HasLayout(lhs_fields_, {TYPE_STRING})) {
+    kernel_ = &CompareFixed<TYPE_STRING>;
+  } else {
+    kernel_ = &CompareGeneric;
+  }
+}
+
+template <FieldType... Types>
+auto RecordComparator::CompareFixed(const RecordComparator &cmp, const char *lhs_nullmap, const char *lhs_data,
+    const char *rhs_nullmap, const char *rhs_data) -> int
+{
+  int    result     = 0;
+  size_t i          = 0;
+  auto   is_same_at = [&]<FieldType Type>() {
+    result = CompareField<Type>(cmp.lhs_fields_[i], lhs_nullmap, lhs_data, cmp.rhs_fields_[i], rhs_nullmap, rhs_data);
+    ++i;
+    return result == 0;
+  };
+  // the fields are compared in order until one differs, the loop is unrolled over Types
+  static_cast<void>((is_same_at.template operator()<Types>() && ...));
+  return result;
+}
+
+auto RecordComparator::CompareGeneric(const RecordComparator &cmp, const char *lhs_nullmap, const char *lhs_data,
+    const char *rhs_nullmap, const char *rhs_data) -> int
+{
+  for (size_t i = 0; i < cmp.lhs_fields_.size(); ++i) {
+    auto result = CompareField<ANY_TYPE>(
+        cmp.lhs_fields_[i], lhs_nullmap, lhs_data, cmp.rhs_fields_[i], rhs_nullmap, rhs_data);
+    if (result != 0) {
+      return result;
+    }
+  }
+  return 0;
+}
+
+RecordHasher::RecordHasher(const RecordSchema &key_schema, const RecordSchema &schema)
+    : fields_(FindKeyFields(key_schema, schema))
+{
+  if (HasLayout(fields_, {TYPE_INT})) {
+    kernel_ = &HashFixed<TYPE_INT>;
+  } else if (HasLayout(fields_, {TYPE_INT, TYPE_INT})) {
+    kernel_ = &HashFixed<TYPE_INT, TYPE_INT>;
+  } else if (HasLayout(fields_, {TYPE_STRING})) {
+    kernel_ = &HashFixed<TYPE_STRING>;
+  } else {
+    kernel_ = &HashGeneric;
+  }
+}
+
+template <FieldType... Types>
+auto RecordHasher::HashFixed(const RecordHasher &hasher, const char *nullmap, const char *data) -> size_t
+{
+  size_t hash = 0;
+  size_t i    = 0;
+  ((hash = Combine(hash, HashField<Types>(hasher.fields_[i++], nullmap, data))), ...);
+  return hash;
+}
+
+auto RecordHasher::HashGeneric(const RecordHasher &hasher, const char *nullmap, const char *data) -> size_t
+{
+  size_t hash = 0;
+  for (const auto &field : hasher.fields_) {
+    hash = Combine(hash, HashField<ANY_TYPE>(field, nullmap, data));
+  }
+  return hash;
+}
+
+KeyNormalizer::KeyNormalizer(
+    const RecordSchema &key_schema, const RecordSchema &schema, const std::vector<bool> &is_desc)
+    : fields_(FindKeyFields(key_schema, schema)), is_desc_(is_desc)
+{
+  WSDB_ASSERT(is_desc_.size() == fields_.size(), "one order per key field");
+  for (const auto &field : fields_) {
+    widths_.push_back(NormalizedWidth(field));
+    key_size_ += 1 + widths_.back();
+  }
+}
+
+void KeyNormalizer::Normalize(const RecordView &record, char *key) const
+{
+  auto *dst = reinterpret_cast<unsigned char *>(key);
+  for (size_t i = 0; i < fields_.size(); ++i) {
+    auto *begin = dst;
+    if (BitMap::GetBit(record.GetNullMap(), fields_[i].field_idx_)) {
+      *dst = 0;
+      memset(dst + 1, 0, widths_[i]);
+    } else {
+      *dst = 1;
+      NormalizeValue(fields_[i], record.GetData(), dst + 1);
+    }
+    dst += 1 + widths_[i];
+    if (is_desc_[i]) {
+      std::for_each(begin, dst, [](unsigned char &byte) { byte = ~byte; });
+    }
+  }
+}
+
+}  // namespace wsdb
@@ -0,0 +1,165 @@
+/*------------------------------------------------------------------------------
+ - Copyright (c) 2024. Websoft research group, Nanjing University.
+ -
+ - This program is free software: you can redistribute it and/or modify
+ - it under the terms of the GNU General Public License as published by
+ - the Free Software Foundation, either version 3 of the License, or
+ - (at your option) any later version.
+ -
+ - This program is distributed in the hope that it will be useful,
+ - but WITHOUT ANY WARRANTY; without even the implied warranty of
+ - MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ - GNU General Public License for more details.
+ -
+ - You should have received a copy of the GNU General Public License
+ - along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ -----------------------------------------------------------------------------*/
+
+//
+// Created by ziqi on 2024/9/21.
+//
+
+#ifndef WSDB_RECORD_COMPARE_H
+#define WSDB_RECORD_COMPARE_H
+
+#include <vector>
+
+#include "record_handle.h"
+
+namespace wsdb {
+
+/**
+ * @brief Compare records by a key without building key records, e.g. for sort and merge join.
+ *
+ * The key fields are looked up in the record schemas once, and a kernel is chosen for the layout of the key: the
+ * common layouts (int), (int, int) and (string) are compared on the raw bytes by template-specialized kernels, other
+ * keys are compared field by field as datums. Order is that of Record::Compare, i.e. null comes first.
+ */
+class RecordComparator
+{
+public:
+  /**
+   * Compare records of the same schema
+   * @param key_schema fields of the key, the first one is the most significant
+   * @param schema schema of the records, must contain the key fields
+   */
+  RecordComparator(const RecordSchema &key_schema, const RecordSchema &schema);
+
+  /**
+   * Compare records of two schemas, the i-th fields of the two keys are compared with each other
+   * @param lhs_key_schema
+   * @param lhs_schema schema of the left records
+   * @param rhs_key_schema must have as many fields as lhs_key_schema
+   * @param rhs_schema schema of the right records
+   */
+  RecordComparator(const RecordSchema &lhs_key_schema, const RecordSchema &lhs_schema,
+      const RecordSchema &rhs_key_schema, const RecordSchema &rhs_schema);
+
+  /// @return -1, 0 or 1 as the key of lhs is less than, equal to or greater than that of rhs
+  [[nodiscard]] auto Compare(const RecordView &lhs, const RecordView &rhs) const -> int
+  {
+    return kernel_(*this, lhs.GetNullMap(), lhs.GetData(), rhs.GetNullMap(), rhs.GetData());
+  }
+
+private:
+  using Kernel = int (*)(const RecordComparator &cmp, const char *lhs_nullmap, const char *lhs_data,
+      const char *rhs_nullmap, const char *rhs_data);
+
+  /// kernel of keys whose fields are of Types on both sides
+  template <FieldType... Types>
+  static auto CompareFixed(const RecordComparator &cmp, const char *lhs_nullmap, const char *lhs_data,
+      const char *rhs_nullmap, const char *rhs_data) -> int;
+
+  static auto CompareGeneric(const RecordComparator &cmp, const char *lhs_nullmap, const char *lhs_data,
+      const char *rhs_nullmap, const char *rhs_data) -> int;
+
+  std::vector<BoundField> lhs_fields_;
+  std::vector<BoundField> rhs_fields_;
+  Kernel                  kernel_;
+};
+
+/**
+ * @brief Hash records by a key without building key records, e.g. for hash aggregation and hash join.
+ *
+ * Kernels are chosen like RecordComparator. The hash of a key only depends on its values, so keys read from records of
+ * different schemas hash the same if their fields are of the same types.
+ */
+class RecordHasher
+{
+public:
+  /**
+   * @param key_schema fields of the key
+   * @param schema schema of the records, must contain the key fields
+   */
+  RecordHasher(const RecordSchema &key_schema, const RecordSchema &schema);
+
+  /// hash all fields of records of the schema
+  explicit RecordHasher(const RecordSchema &schema) : RecordHasher(schema, schema) {}
+
+  [[nodiscard]] auto Hash(const RecordView &record) const -> size_t
+  {
+    return kernel_(*this, record.GetNullMap(), record.GetData());
+  }
+
+  auto operator()(const Record &record) const -> size_t { return Hash(record); }
+
+private:
+  using Kernel = size_t (*)(const RecordHasher &hasher, const char *nullmap, const char *data);
+
+  template <FieldType... Types>
+  static auto HashFixed(const RecordHasher &hasher, const char *nullmap, const char *data) -> size_t;
+
+  static auto HashGeneric(const RecordHasher &hasher, const char *nullmap, const char *data) -> size_t;
+
+  std::vector<BoundField> fields_;
+  Kernel                  kernel_;
+};
+
+/**
+ * @brief Encode the key of a record into bytes whose memcmp order is the order of the key, so sorting and merging
+ * compare keys with memcmp only, and radix techniques apply to them.
+ *
+ * Each field is encoded at a fixed width, so all keys are of GetKeySize bytes
+ * | null flag | value |
+ * the flag is 0 for null and 1 otherwise, so null comes first like in RecordComparator, the value is zero for null
+ * - int: big-endian with the sign bit flipped
+ * - float: big-endian, all bits flipped if negative and the sign bit flipped otherwise, -0 is encoded as 0
+ * - bool: one byte
+ * - string: the bytes up to the first '\0' padded with '\0' to the field size
+ * All bytes of a descending field, its flag included, are inverted.
+ */
+class KeyNormalizer
+{
+public:
+  /**
+   * @param key_schema fields of the key, the first one is the most significant
+   * @param schema schema of the records, must contain the key fields
+   * @param is_desc whether each key field is in descending order
+   */
+  KeyNormalizer(const RecordSchema &key_schema, const RecordSchema &schema, const std::vector<bool> &is_desc);
+
+  /// all key fields in the same order
+  KeyNormalizer(const RecordSchema &key_schema, const RecordSchema &schema, bool is_desc)
+      : KeyNormalizer(key_schema, schema, std::vector<bool>(key_schema.GetFieldCount(), is_desc))
+  {}
+
+  [[nodiscard]] auto GetKeySize() const -> size_t { return key_size_; }
+
+  /**
+   * Encode the key of a record
+   * @param record
+   * @param[out] key GetKeySize bytes
+   */
+  void Normalize(const RecordView &record, char *key) const;
+
+private:
+  std::vector<BoundField> fields_;
+  std::vector<bool>       is_desc_;
+  // bytes of the encoded value of each field, the null flag excluded
+  std::vector<size_t> widths_;
+  size_t              key_size_{0};
+};
+
+}  // namespace wsdb
+
+#endif  // WSDB_RECORD_COMPARE_H
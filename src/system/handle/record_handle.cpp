@@ -78,6 +78,16 @@ auto RecordSchema::GetRTFieldIndex(const RTField &rtfield) const -> size_t
   return fields_.size();
 }
 
+auto RecordSchema::BindField(const RTField &rtfield) const -> BoundField
+{
+  auto idx = GetRTFieldIndex(rtfield);
+  if (idx == fields_.size()) {
+    WSDB_THROW(WSDB_FIELD_MISS, rtfield.field_.field_name_);
+  }
+  const auto &field = fields_[idx].field_;
+  return {idx, offsets_[idx], field.field_size_, field.field_type_};
+}
+
 auto RecordSchema::GetFieldByName(table_id_t tid, const std::string &name) const -> const RTField &
 {
   return fields_[GetFieldIndex(tid, name)];
@@ -97,20 +107,21 @@ auto RecordSchema::HasField(table_id_t tid, const std::string &name) -> bool
   return GetFieldIndex(tid, name) != fields_.size();
 }
 
-Record::Record(const RecordSchema *schema, const char *null_map_mem, const char *data, RID rid) : schema_(schema)
+Record::Record(
+    const RecordSchema *schema, const char *null_map_mem, const char *data, RID rid, MemoryContext *mem_ctx)
+    : schema_(schema)
 {
-  data_    = new char[schema_->GetRecordLength()];
-  nullmap_ = new char[BITMAP_SIZE(schema_->GetFieldCount())];
+  AllocBuffers(mem_ctx);
   std::memcpy(data_, data, schema_->GetRecordLength());
   std::memcpy(nullmap_, null_map_mem, BITMAP_SIZE(schema_->GetFieldCount()));
   rid_ = rid;
 }
 
-Record::Record(const RecordSchema *schema, const std::vector<ValueSptr> &values, wsdb::RID rid)
+Record::Record(
+    const RecordSchema *schema, const std::vector<ValueSptr> &values, wsdb::RID rid, MemoryContext *mem_ctx)
 {
   schema_  = schema;
-  data_    = new char[schema_->GetRecordLength()];
-  nullmap_ = new char[BITMAP_SIZE(schema_->GetFieldCount())];
+  AllocBuffers(mem_ctx);
   memset(data_, 0, schema_->GetRecordLength());
   memset(nullmap_, 0, BITMAP_SIZE(schema_->GetFieldCount()));
   size_t cursor = 0;
@@ -175,29 +186,46 @@ Record::Record(const RecordSchema *schema, const std::vector<ValueSptr> &values,
   rid_ = rid;
 }
 
-Record::Record(const RecordSchema *schema, const Record &other) : schema_(schema)
+Record::Record(const RecordSchema *schema, const RecordView &other, MemoryContext *mem_ctx) : schema_(schema)
 {
   // new can deal with GetRecordLength() == 0
-  data_    = new char[schema_->GetRecordLength()];
-  nullmap_ = new char[BITMAP_SIZE(schema_->GetFieldCount())];
+  AllocBuffers(mem_ctx);
   memset(data_, 0, schema_->GetRecordLength());
   memset(nullmap_, 0, BITMAP_SIZE(schema_->GetFieldCount()));
+  auto other_schema = other.GetSchema();
   for (size_t i = 0; i < schema_->GetFieldCount(); ++i) {
     auto &field     = schema_->GetFieldAt(i);
-    auto  other_idx = other.schema_->GetRTFieldIndex(field);
-    if (other_idx == other.schema_->GetFieldCount()) {
+    auto  other_idx = other_schema->GetRTFieldIndex(field);
+    if (other_idx == other_schema->GetFieldCount()) {
       WSDB_FETAL("Field not found in other record");
     }
-    auto other_offset = other.schema_->offsets_[other_idx];
-    std::memcpy(data_ + schema_->offsets_[i], other.data_ + other_offset, field.field_.field_size_);
-    if (BitMap::GetBit(other.nullmap_, other_idx)) {
+    auto other_offset = other_schema->offsets_[other_idx];
+    std::memcpy(data_ + schema_->offsets_[i], other.GetData() + other_offset, field.field_.field_size_);
+    if (BitMap::GetBit(other.GetNullMap(), other_idx)) {
       BitMap::SetBit(nullmap_, i, true);
     }
   }
   rid_ = INVALID_RID;
 }
 
-Record::Record(const RecordSchema *schema, const wsdb::Record &rec1, const wsdb::Record &rec2)
+Record::Record(const RecordSchema *schema, const RecordView &other, const std::vector<BoundField> &fields,
+    MemoryContext *mem_ctx)
+    : schema_(schema)
+{
+  WSDB_ASSERT(fields.size() == schema_->GetFieldCount(), "one bound field per field of the schema");
+  AllocBuffers(mem_ctx);
+  memset(nullmap_, 0, BITMAP_SIZE(schema_->GetFieldCount()));
+  for (size_t i = 0; i < fields.size(); ++i) {
+    std::memcpy(data_ + schema_->offsets_[i], other.GetData() + fields[i].offset_, fields[i].size_);
+    if (BitMap::GetBit(other.GetNullMap(), fields[i].field_idx_)) {
+      BitMap::SetBit(nullmap_, i, true);
+    }
+  }
+  rid_ = INVALID_RID;
+}
+
+Record::Record(
+    const RecordSchema *schema, const wsdb::Record &rec1, const wsdb::Record &rec2, MemoryContext *mem_ctx)
 {
   // do some simple asserts
   WSDB_ASSERT(
@@ -205,8 +233,7 @@ Record::Record(const RecordSchema *schema, const wsdb::Record &rec1, const wsdb:
   WSDB_ASSERT(schema->GetRecordLength() == rec1.schema_->GetRecordLength() + rec2.schema_->GetRecordLength(),
       "Record length mismatch");
   schema_  = schema;
-  data_    = new char[schema_->GetRecordLength()];
-  nullmap_ = new char[BITMAP_SIZE(schema_->GetFieldCount())];
+  AllocBuffers(mem_ctx);
   memset(data_, 0, schema_->GetRecordLength());
   memset(nullmap_, 0, BITMAP_SIZE(schema_->GetFieldCount()));
   memcpy(data_, rec1.data_, rec1.schema_->GetRecordLength());
@@ -225,29 +252,22 @@ Record::Record(const RecordSchema *schema, const wsdb::Record &rec1, const wsdb:
   rid_ = INVALID_RID;
 }
 
-Record::Record(const wsdb::RecordSchema *schema)
+Record::Record(const wsdb::RecordSchema *schema, MemoryContext *mem_ctx)
 {
   schema_  = schema;
-  data_    = new char[schema_->GetRecordLength()];
-  nullmap_ = new char[BITMAP_SIZE(schema_->GetFieldCount())];
+  AllocBuffers(mem_ctx);
   // set nullmap to all 1
   memset(data_, 0, schema_->GetRecordLength());
   memset(nullmap_, 0xff, BITMAP_SIZE(schema_->GetFieldCount()));
   rid_ = INVALID_RID;
 }
 
-Record::~Record()
-{
-  delete[] data_;
-  delete[] nullmap_;
-}
+Record::~Record() { FreeBuffers(); }
 
-Record::Record(const Record &record)
-    : schema_(record.schema_),
-      data_(new char[schema_->GetRecordLength()]),
-      nullmap_(new char[BITMAP_SIZE(schema_->GetFieldCount())]),
-      rid_(record.rid_)
+Record::Record(const Record &record) : schema_(record.schema_), rid_(record.rid_)
 {
+  // a copy may be kept anywhere, it does not share the context of the original
+  AllocBuffers(nullptr);
   std::memcpy(data_, record.data_, schema_->GetRecordLength());
   std::memcpy(nullmap_, record.nullmap_, BITMAP_SIZE(schema_->GetFieldCount()));
 }
@@ -257,9 +277,10 @@ Record &Record::operator=(const Record &record)
   if (this == &record) {
     return *this;
   }
-  schema_  = record.schema_;
-  data_    = new char[schema_->GetRecordLength()];
-  nullmap_ = new char[BITMAP_SIZE(schema_->GetFieldCount())];
+  // the buffers stay in the context the record was created in
+  FreeBuffers();
+  schema_ = record.schema_;
+  AllocBuffers(mem_ctx_);
   std::memcpy(data_, record.data_, schema_->GetRecordLength());
   std::memcpy(nullmap_, record.nullmap_, BITMAP_SIZE(schema_->GetFieldCount()));
   rid_ = record.rid_;
@@ -267,7 +288,11 @@ Record &Record::operator=(const Record &record)
 }
 
 Record::Record(Record &&record) noexcept
-    : schema_(record.schema_), data_(record.data_), nullmap_(record.nullmap_), rid_(record.rid_)
+    : schema_(record.schema_),
+      data_(record.data_),
+      nullmap_(record.nullmap_),
+      rid_(record.rid_),
+      mem_ctx_(record.mem_ctx_)
 {
   record.data_    = nullptr;
   record.schema_  = nullptr;
@@ -279,18 +304,39 @@ Record &Record::operator=(Record &&record) noexcept
   if (this == &record) {
     return *this;
   }
-  delete[] data_;
-  delete[] nullmap_;
+  FreeBuffers();
   schema_         = record.schema_;
   data_           = record.data_;
   nullmap_        = record.nullmap_;
   rid_            = record.rid_;
+  mem_ctx_        = record.mem_ctx_;
   record.data_    = nullptr;
   record.schema_  = nullptr;
   record.nullmap_ = nullptr;
   return *this;
 }
 
+void Record::AllocBuffers(MemoryContext *mem_ctx)
+{
+  // data and null map share one allocation, the null map follows the data
+  mem_ctx_   = mem_ctx;
+  auto size  = schema_->GetRecordLength() + BITMAP_SIZE(schema_->GetFieldCount());
+  auto alloc = ContextAllocator<char>(mem_ctx_);
+  data_      = alloc.allocate(size);
+  nullmap_   = data_ + schema_->GetRecordLength();
+}
+
+void Record::FreeBuffers()
+{
+  if (data_ == nullptr) {
+    return;
+  }
+  auto size = schema_->GetRecordLength() + BITMAP_SIZE(schema_->GetFieldCount());
+  ContextAllocator<char>(mem_ctx_).deallocate(data_, size);
+  data_    = nullptr;
+  nullmap_ = nullptr;
+}
+
 auto Record::operator==(const Record &other) const -> bool
 {
   // check if the two record is defined under the same schema and whether their data are matched，
@@ -304,38 +350,27 @@ auto Record::Hash() const -> size_t
   // use schema and data_ to generate hash
   size_t hash = 0;
   for (size_t i = 0; i < schema_->GetFieldCount(); ++i) {
-    if (BitMap::GetBit(nullmap_, i)) {
-      continue;
-    }
-    auto &field = schema_->GetFieldAt(i);
-    switch (field.field_.field_type_) {
-      case FieldType::TYPE_BOOL:
-        hash ^= std::hash<bool>{}(*reinterpret_cast<const bool *>(data_ + schema_->offsets_[i]));
-        break;
-      case FieldType::TYPE_INT:
-        hash ^= std::hash<int32_t>{}(*reinterpret_cast<const int32_t *>(data_ + schema_->offsets_[i]));
-        break;
-      case FieldType::TYPE_FLOAT:
-        hash ^= std::hash<float>{}(*reinterpret_cast<const float *>(data_ + schema_->offsets_[i]));
-        break;
-      case FieldType::TYPE_STRING:
-        hash ^= std::hash<std::string>{}(std::string(data_ + schema_->offsets_[i], field.field_.field_size_));
-        break;
-      default: WSDB_FETAL("Unsupported field type to hash");
+    if (!BitMap::GetBit(nullmap_, i)) {
+      hash ^= GetDatumAt(i).Hash();
     }
   }
   return hash;
 }
 
-auto Record::GetValueAt(size_t index) const -> ValueSptr
+auto Record::GetValueAt(size_t index) const -> ValueSptr { return RecordView(*this).GetValueAt(index); }
+
+auto Record::GetDatumAt(size_t index) const -> Datum { return RecordView(*this).GetDatumAt(index); }
+
+auto RecordView::GetValueAt(size_t index) const -> ValueSptr { return GetDatumAt(index).ToValue(); }
+
+auto RecordView::GetDatumAt(size_t index) const -> Datum
 {
   WSDB_ASSERT(index < schema_->GetFieldCount(), "Index out of range");
-  auto &field = schema_->GetFieldAt(index);
+  auto &field = schema_->GetFieldAt(index).field_;
   if (BitMap::GetBit(nullmap_, index)) {
-    return ValueFactory::CreateNullValue(field.field_.field_type_);
+    return Datum::Null(field.field_type_);
   }
-  return ValueFactory::CreateValue(
-      field.field_.field_type_, data_ + schema_->offsets_[index], field.field_.field_size_);
+  return Datum::FromField(field.field_type_, data_ + schema_->GetFieldOffset(index), field.field_size_);
 }
 
 auto Record::Compare(const wsdb::Record &lrec, const wsdb::Record &rrec) -> int
@@ -344,28 +379,47 @@ auto Record::Compare(const wsdb::Record &lrec, const wsdb::Record &rrec) -> int
   //  WSDB_ASSERT(Record, Compare, lrec.GetSchema() == rrec.GetSchema(), "Schema mismatch");
   // more loose assert to support two similar records
   WSDB_ASSERT(lrec.GetSchema()->GetFieldCount() == rrec.GetSchema()->GetFieldCount(), "field count mismatch");
+  // see RecordComparator to compare many records by the same key
   for (size_t i = 0; i < lrec.GetSchema()->GetFieldCount(); ++i) {
-    auto lval = lrec.GetValueAt(i);
-    auto rval = rrec.GetValueAt(i);
-    if (lval->IsNull() && rval->IsNull()) {
+    auto lval = lrec.GetDatumAt(i);
+    auto rval = rrec.GetDatumAt(i);
+    if (lval.IsNull() && rval.IsNull()) {
       continue;
     }
-    if (lval->IsNull() || rval->IsNull()) {
-      return lval->IsNull() ? -1 : 1;
-    }
-    if (*lval < *rval) {
-      return -1;
+    if (lval.IsNull() || rval.IsNull()) {
+      return lval.IsNull() ? -1 : 1;
     }
-    if (*lval > *rval) {
-      return 1;
+    if (auto cmp = Datum::Compare(lval, rval); cmp != 0) {
+      return cmp;
     }
   }
   return 0;
 }
 
-Chunk::Chunk(const RecordSchema *schema, std::vector<ArrayValueSptr> cols) : schema_(schema), cols_(std::move(cols))
+ColumnVector::ColumnVector(FieldType type, size_t width, size_t capacity)
+    : type_(type),
+      width_(width),
+      capacity_(capacity),
+      // one more zero byte so that reading the last string stops at the end of the buffer
+      data_(width * capacity + 1, 0),
+      validity_(BITMAP_SIZE(capacity), 0)
+{}
+
+auto ColumnVector::GetValue(size_t row) const -> ValueSptr
 {
-  WSDB_ASSERT(schema_->GetFieldCount() == cols_.size(), "Field count mismatch");
+  WSDB_ASSERT(row < capacity_, "Row out of range");
+  if (!IsValid(row)) {
+    return ValueFactory::CreateNullValue(type_);
+  }
+  return ValueFactory::CreateValue(type_, data_.data() + row * width_, width_);
+}
+
+Chunk::Chunk(const RecordSchema *schema, size_t capacity) : schema_(schema), capacity_(capacity)
+{
+  cols_.reserve(schema_->GetFieldCount());
+  for (const auto &field : schema_->GetFields()) {
+    cols_.emplace_back(field.field_.field_type_, field.field_.field_size_, capacity_);
+  }
 }
 
 Chunk::~Chunk() = default;
@@ -378,7 +432,19 @@ Chunk &Chunk::operator=(const wsdb::Chunk &chunk) = default;
 
 Chunk &Chunk::operator=(wsdb::Chunk &&chunk) noexcept = default;
 
-auto Chunk::GetCol(int index) -> ArrayValueSptr { return cols_[index]; }
+auto Chunk::GetCol(size_t index) -> ColumnVector & { return cols_[index]; }
+
+auto Chunk::GetCol(size_t index) const -> const ColumnVector & { return cols_[index]; }
+
+auto Chunk::GetColCount() const -> size_t { return cols_.size(); }
+
+auto Chunk::GetSize() const -> size_t { return has_sel_ ? sel_.size() : capacity_; }
+
+void Chunk::SetSelection(std::vector<uint32_t> sel)
+{
+  sel_     = std::move(sel);
+  has_sel_ = true;
+}
 
-auto Chunk::GetColCount() -> size_t { return cols_.size(); }
+auto Chunk::GetValue(size_t col_idx, size_t idx) const -> ValueSptr { return cols_[col_idx].GetValue(GetRow(idx)); }
 }  // namespace wsdb
\ No newline at end of file
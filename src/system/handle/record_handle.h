@@ -25,19 +25,32 @@
 #include "../../../common/micro.h"
 #include "common/meta.h"
 #include "common/rid.h"
+#include "common/datum.h"
 #include "common/value.h"
 #include "common/bitmap.h"
 
 namespace wsdb {
 
 class Record;
+class RecordView;
 class Chunk;
 class RecordSchema;
 DEFINE_UNIQUE_PTR(Record);
+DEFINE_SHARED_PTR(Record);
 DEFINE_UNIQUE_PTR(RecordSchema);
 DEFINE_SHARED_PTR(RecordSchema);
 DEFINE_UNIQUE_PTR(Chunk);
 
+/// where a field is in the records of a schema, resolved once by RecordSchema::BindField so that reading the field
+/// from each record only takes integers
+struct BoundField
+{
+  size_t    field_idx_;  // index in the schema, i.e. the bit in the null map
+  size_t    offset_;
+  size_t    size_;
+  FieldType type_;
+};
+
 class RecordSchema
 {
   friend Record;
@@ -70,6 +83,14 @@ public:
    */
   [[nodiscard]] auto GetRTFieldIndex(const RTField &rtfield) const -> size_t;
 
+  /**
+   * Resolve a field to its place in the records of this schema
+   * @param rtfield
+   * @return
+   * @throw WSDB_FIELD_MISS if the schema has no such field
+   */
+  [[nodiscard]] auto BindField(const RTField &rtfield) const -> BoundField;
+
   [[nodiscard]] auto GetFieldOffset(table_id_t tid, const std::string &name) const -> size_t;
 
   [[nodiscard]] auto GetRecordLength() const -> size_t;
@@ -112,37 +133,53 @@ public:
    * @param null_map_mem
    * @param data
    * @param rid
+   * @param mem_ctx context the record is allocated from, nullptr for the heap, see MemoryContext
    */
-  Record(const RecordSchema *schema, const char *null_map_mem, const char *data, RID rid);
+  Record(const RecordSchema *schema, const char *null_map_mem, const char *data, RID rid,
+      MemoryContext *mem_ctx = nullptr);
 
   /**
    * Generate a record from a list of values
    * @param schema
    * @param values
    * @param rid
+   * @param mem_ctx
    */
-  Record(const RecordSchema *schema, const std::vector<ValueSptr> &values, RID rid);
+  Record(const RecordSchema *schema, const std::vector<ValueSptr> &values, RID rid, MemoryContext *mem_ctx = nullptr);
 
   /**
    * Generate a record from another record given the requested schema
    * @param schema should be a subset of the original schema
-   * @param other the original record
+   * @param other the original record, either an owned record or a view into a pinned page
+   * @param mem_ctx
+   */
+  Record(const RecordSchema *schema, const RecordView &other, MemoryContext *mem_ctx = nullptr);
+
+  /**
+   * Generate a record from another record with the fields resolved beforehand, see RecordSchema::BindField
+   * @param schema
+   * @param other
+   * @param fields the i-th field of schema bound to the schema of other
+   * @param mem_ctx
    */
-  Record(const RecordSchema *schema, const Record &other);
+  Record(const RecordSchema *schema, const RecordView &other, const std::vector<BoundField> &fields,
+      MemoryContext *mem_ctx = nullptr);
 
   /**
    * Generate a record from two records given the requested schema
    * @param schema should be a combination of the two records' schema
    * @param rec1 the first record
    * @param rec2 the second record
+   * @param mem_ctx
    */
-  Record(const RecordSchema *schema, const Record &rec1, const Record &rec2);
+  Record(const RecordSchema *schema, const Record &rec1, const Record &rec2, MemoryContext *mem_ctx = nullptr);
 
   /**
    * Generate a record with all fields set to null
    * @param schema
+   * @param mem_ctx
    */
-  explicit Record(const RecordSchema *schema);
+  explicit Record(const RecordSchema *schema, MemoryContext *mem_ctx = nullptr);
 
   ~Record();
 
@@ -165,6 +202,9 @@ public:
 
   [[nodiscard]] auto GetValueAt(size_t index) const -> ValueSptr;
 
+  /// Get the field at index without allocation, a long string points into the record, see Datum
+  [[nodiscard]] auto GetDatumAt(size_t index) const -> Datum;
+
   /// Get the schema of this record
   [[nodiscard]] auto GetSchema() const -> const RecordSchema * { return schema_; }
 
@@ -174,19 +214,142 @@ public:
 
   static auto Compare(const Record &lrec, const Record &rrec) -> int;
 
+private:
+  /// allocate data and null map from mem_ctx, the heap if it is nullptr
+  void AllocBuffers(MemoryContext *mem_ctx);
+
+  void FreeBuffers();
+
 private:
   const RecordSchema *schema_;
-  char               *data_;
-  char               *nullmap_;
+  char               *data_{nullptr};
+  char               *nullmap_{nullptr};
   RID                 rid_{};
+  // the memory context data and null map come from, nullptr for the heap
+  MemoryContext *mem_ctx_{nullptr};
+};
+
+/**
+ * @brief A read-only record that does not own its memory.
+ *
+ * The null map and data point either into a frame of the buffer pool or into an owned Record, guard_ keeps that
+ * memory alive (usually a PageGuard holding the page pinned), a view without guard is only valid until its producer
+ * moves on. Operators that only filter or project read through views, pipeline breakers call Materialize.
+ */
+class RecordView
+{
+public:
+  RecordView() = default;
+
+  RecordView(const RecordSchema *schema, const char *null_map, const char *data, RID rid,
+      std::shared_ptr<const void> guard = nullptr)
+      : schema_(schema), nullmap_(null_map), data_(data), rid_(rid), guard_(std::move(guard))
+  {}
+
+  /**
+   * Borrow an owned record, the record must outlive the view
+   * @param record
+   */
+  RecordView(const Record &record)  // NOLINT: implicit conversion is intended
+      : schema_(record.GetSchema()), nullmap_(record.GetNullMap()), data_(record.GetData()), rid_(record.GetRID())
+  {}
+
+  /// @return false if the view does not point to any record
+  [[nodiscard]] auto IsValid() const -> bool { return schema_ != nullptr; }
+
+  [[nodiscard]] auto GetRID() const -> RID { return rid_; }
+
+  [[nodiscard]] auto GetValueAt(size_t index) const -> ValueSptr;
+
+  /// Get the field at index without allocation, a long string points into the viewed memory, see Datum
+  [[nodiscard]] auto GetDatumAt(size_t index) const -> Datum;
+
+  /// Get a field bound to the schema of the view, nothing is looked up
+  [[nodiscard]] auto GetDatum(const BoundField &field) const -> Datum
+  {
+    if (BitMap::GetBit(nullmap_, field.field_idx_)) {
+      return Datum::Null(field.type_);
+    }
+    return Datum::FromField(field.type_, data_ + field.offset_, field.size_);
+  }
+
+  [[nodiscard]] auto GetSchema() const -> const RecordSchema * { return schema_; }
+
+  [[nodiscard]] auto GetData() const -> const char * { return data_; }
+
+  [[nodiscard]] auto GetNullMap() const -> const char * { return nullmap_; }
+
+  /// copy the viewed record into an owned one allocated from mem_ctx
+  [[nodiscard]] auto Materialize(MemoryContext *mem_ctx = nullptr) const -> RecordUptr
+  {
+    return std::make_unique<Record>(schema_, nullmap_, data_, rid_, mem_ctx);
+  }
+
+private:
+  const RecordSchema         *schema_{nullptr};
+  const char                 *nullmap_{nullptr};
+  const char                 *data_{nullptr};
+  RID                         rid_{INVALID_RID};
+  std::shared_ptr<const void> guard_;
 };
 
+/**
+ * A column of a chunk, values are stored back to back in a flat buffer of the field type: int32_t for int, float for
+ * float, bool for bool and field_size bytes for char(n). The validity bitmap marks the rows that are not null.
+ */
+class ColumnVector
+{
+public:
+  ColumnVector() = delete;
+
+  ColumnVector(FieldType type, size_t width, size_t capacity);
+
+  [[nodiscard]] auto GetType() const -> FieldType { return type_; }
+
+  /// bytes of each value
+  [[nodiscard]] auto GetWidth() const -> size_t { return width_; }
+
+  [[nodiscard]] auto GetCapacity() const -> size_t { return capacity_; }
+
+  template <typename T>
+  auto GetData() -> T *
+  {
+    return reinterpret_cast<T *>(data_.data());
+  }
+
+  template <typename T>
+  [[nodiscard]] auto GetData() const -> const T *
+  {
+    return reinterpret_cast<const T *>(data_.data());
+  }
+
+  auto GetValidity() -> char * { return validity_.data(); }
+
+  [[nodiscard]] auto IsValid(size_t row) const -> bool { return BitMap::GetBit(validity_.data(), row); }
+
+  void SetValid(size_t row, bool valid) { BitMap::SetBit(validity_.data(), row, valid); }
+
+  /// materialize the value at the physical row, only for printing and tests
+  [[nodiscard]] auto GetValue(size_t row) const -> ValueSptr;
+
+private:
+  FieldType         type_;
+  size_t            width_;
+  size_t            capacity_;
+  std::vector<char> data_;
+  std::vector<char> validity_;
+};
+
+/**
+ * Columnar batch of records, e.g. a PAX page. Each column is a typed ColumnVector of the same capacity, the optional
+ * selection vector lists the physical rows that belong to the chunk, without it all rows in [0, capacity) do.
+ */
 class Chunk
 {
 public:
   Chunk() = delete;
 
-  Chunk(const RecordSchema *schema, std::vector<ArrayValueSptr> cols);
+  Chunk(const RecordSchema *schema, size_t capacity);
 
   ~Chunk();
 
@@ -198,13 +361,34 @@ public:
 
   Chunk &operator=(Chunk &&chunk) noexcept;
 
-  auto GetCol(int index) -> ArrayValueSptr;
+  [[nodiscard]] auto GetSchema() const -> const RecordSchema * { return schema_; }
+
+  auto GetCol(size_t index) -> ColumnVector &;
+
+  [[nodiscard]] auto GetCol(size_t index) const -> const ColumnVector &;
+
+  [[nodiscard]] auto GetColCount() const -> size_t;
+
+  /// number of rows in the chunk, the size of the selection vector if there is one
+  [[nodiscard]] auto GetSize() const -> size_t;
+
+  /// physical row of the idx-th row in the chunk
+  [[nodiscard]] auto GetRow(size_t idx) const -> size_t { return has_sel_ ? sel_[idx] : idx; }
+
+  void SetSelection(std::vector<uint32_t> sel);
+
+  /// @return nullptr if all rows are selected
+  [[nodiscard]] auto GetSelection() const -> const std::vector<uint32_t> * { return has_sel_ ? &sel_ : nullptr; }
 
-  auto GetColCount() -> size_t;
+  /// value of the idx-th row in the chunk at column col_idx
+  [[nodiscard]] auto GetValue(size_t col_idx, size_t idx) const -> ValueSptr;
 
 private:
-  const RecordSchema         *schema_;
-  std::vector<ArrayValueSptr> cols_;
+  const RecordSchema       *schema_;
+  size_t                    capacity_;
+  std::vector<ColumnVector> cols_;
+  std::vector<uint32_t>     sel_;
+  bool                      has_sel_{false};
 };
 
 }  // namespace wsdb
@@ -0,0 +1,98 @@
+/*------------------------------------------------------------------------------
+ - Copyright (c) 2024. Websoft research group, Nanjing University.
+ -
+ - This program is free software: you can redistribute it and/or modify
+ - it under the terms of the GNU General Public License as published by
+ - the Free Software Foundation, either version 3 of the License, or
+ - (at your option) any later version.
+ -
+ - This program is distributed in the hope that it will be useful,
+ - but WITHOUT ANY WARRANTY; without even the implied warranty of
+ - MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ - GNU General Public License for more details.
+ -
+ - You should have received a copy of the GNU General Public License
+ - along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ -----------------------------------------------------------------------------*/
+
+//
+// Created by ziqi on 2024/9/18.
+//
+
+#include "slot_claims.h"
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+
+#include "common/bitmap.h"
+
+namespace wsdb {
+
+auto SlotClaims::Claim(page_id_t page_id, char *bitmap, size_t num, const char *writable) -> std::vector<size_t>
+{
+  std::vector<size_t>         slots;
+  auto                       &stripe = StripeOf(page_id);
+  std::lock_guard<std::mutex> lock{stripe.latch_};
+  auto                       &claimed = stripe.claimed_[page_id];
+  claimed.resize(BITMAP_SIZE(slot_num_));
+  for (size_t byte_idx = 0; byte_idx < claimed.size() && slots.size() < num; ++byte_idx) {
+    // a bit of the page bitmap is set by the insert holding the claim of its slot only, a slot seen free here stays
+    // free, a slot freed by a concurrent delete is just left to the next claim
+    auto taken = static_cast<unsigned char>(std::atomic_ref<char>(bitmap[byte_idx]).load() | claimed[byte_idx]);
+    if (writable != nullptr) {
+      taken |= static_cast<unsigned char>(~writable[byte_idx]);
+    }
+    while (taken != 0xff && slots.size() < num) {
+      size_t bit_idx = byte_idx * BITMAP_WIDTH + std::countr_one(taken);
+      if (bit_idx >= slot_num_) {
+        break;
+      }
+      taken |= static_cast<unsigned char>(1 << (bit_idx % BITMAP_WIDTH));
+      BitMap::SetBit(claimed.data(), bit_idx, true);
+      slots.push_back(bit_idx);
+    }
+  }
+  if (slots.empty() && std::all_of(claimed.begin(), claimed.end(), [](char byte) { return byte == 0; })) {
+    stripe.claimed_.erase(page_id);
+  }
+  return slots;
+}
+
+auto SlotClaims::TryClaim(page_id_t page_id, char *bitmap, size_t slot_id) -> bool
+{
+  auto                       &stripe = StripeOf(page_id);
+  std::lock_guard<std::mutex> lock{stripe.latch_};
+  auto                       &claimed = stripe.claimed_[page_id];
+  claimed.resize(BITMAP_SIZE(slot_num_));
+  auto occupied = std::atomic_ref<char>(bitmap[slot_id / BITMAP_WIDTH]).load();
+  if (BitMap::GetBit(&occupied, slot_id % BITMAP_WIDTH) || BitMap::GetBit(claimed.data(), slot_id)) {
+    if (std::all_of(claimed.begin(), claimed.end(), [](char byte) { return byte == 0; })) {
+      stripe.claimed_.erase(page_id);
+    }
+    return false;
+  }
+  BitMap::SetBit(claimed.data(), slot_id, true);
+  return true;
+}
+
+void SlotClaims::Publish(page_id_t page_id, char *bitmap, std::span<const size_t> slots)
+{
+  if (slots.empty()) {
+    return;
+  }
+  auto                       &stripe = StripeOf(page_id);
+  std::lock_guard<std::mutex> lock{stripe.latch_};
+  auto                       &claimed = stripe.claimed_.at(page_id);
+  for (auto slot_id : slots) {
+    // the record is written, the atomic set releases it to the scans that see the bit
+    bool set = BitMap::TrySetBit(bitmap, slot_id);
+    WSDB_ASSERT(set, "a claimed slot is occupied");
+    BitMap::SetBit(claimed.data(), slot_id, false);
+  }
+  if (std::all_of(claimed.begin(), claimed.end(), [](char byte) { return byte == 0; })) {
+    stripe.claimed_.erase(page_id);
+  }
+}
+
+}  // namespace wsdb
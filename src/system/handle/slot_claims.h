@@ -0,0 +1,92 @@
+/*------------------------------------------------------------------------------
+ - Copyright (c) 2024. Websoft research group, Nanjing University.
+ -
+ - This program is free software: you can redistribute it and/or modify
+ - it under the terms of the GNU General Public License as published by
+ - the Free Software Foundation, either version 3 of the License, or
+ - (at your option) any later version.
+ -
+ - This program is distributed in the hope that it will be useful,
+ - but WITHOUT ANY WARRANTY; without even the implied warranty of
+ - MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ - GNU General Public License for more details.
+ -
+ - You should have received a copy of the GNU General Public License
+ - along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ -----------------------------------------------------------------------------*/
+
+//
+// Created by ziqi on 2024/9/18.
+//
+
+#ifndef WSDB_SLOT_CLAIMS_H
+#define WSDB_SLOT_CLAIMS_H
+
+#include <array>
+#include <mutex>  // NOLINT
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+#include "../../../common/micro.h"
+#include "common/config.h"
+#include "common/page.h"
+
+namespace wsdb {
+
+/**
+ * @brief Slots of pages claimed by inserts whose records are not written yet.
+ *
+ * A slot is claimed aside of the page bitmap and its bit is set only after the record is written, so scans, which find
+ * records by the bitmap, never see a half-written record, while concurrent inserts into the same page still get
+ * different slots. Claims are kept by page in stripes, each with a latch of its own, and a page is forgotten as soon
+ * as none of its slots is claimed.
+ */
+class SlotClaims
+{
+public:
+  /// @param slot_num number of slots of a page
+  explicit SlotClaims(size_t slot_num) : slot_num_(slot_num) {}
+
+  DISABLE_COPY_MOVE_AND_ASSIGN(SlotClaims)
+
+  /**
+   * Claim free slots of a page, a slot is free if its bit in the page bitmap is 0 and no one has claimed it
+   * @param page_id
+   * @param bitmap bitmap of the page, its bytes are loaded atomically
+   * @param num at most so many slots are claimed
+   * @param writable if not nullptr, only the slots whose bit is set in it are claimed, see PageHandle::GetWritableMap
+   * @return claimed slots in ascending order, fewer than num if the page has no more free slots
+   */
+  auto Claim(page_id_t page_id, char *bitmap, size_t num, const char *writable = nullptr) -> std::vector<size_t>;
+
+  /// @return false if the slot is occupied or claimed already, else it is claimed
+  auto TryClaim(page_id_t page_id, char *bitmap, size_t slot_id) -> bool;
+
+  /**
+   * Make the records written to the claimed slots visible, their bits are set in the page bitmap and the claims are
+   * dropped
+   * @param page_id
+   * @param bitmap bitmap of the page
+   * @param slots slots returned by Claim or TryClaim
+   */
+  void Publish(page_id_t page_id, char *bitmap, std::span<const size_t> slots);
+
+private:
+  struct Stripe
+  {
+    std::mutex latch_;
+    // claimed slots of each page, one bit a slot
+    std::unordered_map<page_id_t, std::vector<char>> claimed_;
+  };
+
+  auto StripeOf(page_id_t page_id) -> Stripe & { return stripes_[static_cast<size_t>(page_id) % stripes_.size()]; }
+
+  const size_t slot_num_;
+  // as many stripes as insert pages, so inserts into different insert pages seldom wait for each other
+  std::array<Stripe, TABLE_INSERT_PAGE_NUM> stripes_;
+};
+
+}  // namespace wsdb
+
+#endif  // WSDB_SLOT_CLAIMS_H
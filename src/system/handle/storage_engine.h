@@ -0,0 +1,113 @@
+/*------------------------------------------------------------------------------
+ - Copyright (c) 2024. Websoft research group, Nanjing University.
+ -
+ - This program is free software: you can redistribute it and/or modify
+ - it under the terms of the GNU General Public License as published by
+ - the Free Software Foundation, either version 3 of the License, or
+ - (at your option) any later version.
+ -
+ - This program is distributed in the hope that it will be useful,
+ - but WITHOUT ANY WARRANTY; without even the implied warranty of
+ - MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ - GNU General Public License for more details.
+ -
+ - You should have received a copy of the GNU General Public License
+ - along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ -----------------------------------------------------------------------------*/
+
+//
+// Created by ziqi on 2024/9/17.
+//
+
+#ifndef WSDB_STORAGE_ENGINE_H
+#define WSDB_STORAGE_ENGINE_H
+
+#include <functional>
+#include <memory>
+#include <span>
+#include <vector>
+
+#include "../../../common/micro.h"
+#include "record_handle.h"
+
+namespace wsdb {
+
+/**
+ * @brief Go through the rows of a storage engine, rows written after the iterator is created may or may not be
+ * returned.
+ */
+class EngineIterator
+{
+public:
+  EngineIterator() = default;
+
+  virtual ~EngineIterator() = default;
+
+  DISABLE_COPY_MOVE_AND_ASSIGN(EngineIterator)
+
+  [[nodiscard]] virtual auto IsEnd() const -> bool = 0;
+
+  virtual void Next() = 0;
+
+  [[nodiscard]] virtual auto GetRID() const -> RID = 0;
+
+  [[nodiscard]] virtual auto GetRecord() -> RecordUptr = 0;
+};
+
+DEFINE_UNIQUE_PTR(EngineIterator);
+
+/**
+ * @brief Rows of a table that are not stored in the pages of the table file, e.g. in an lsm tree.
+ *
+ * TableHandle hands a table to an engine when the storage model does not keep rows in pages, and routes the row
+ * operations of the table to it. The table still locks its vacuum latch and counts its rows in the table header, an
+ * engine only stores them. Rids are made up by the engine, they must stay valid until the row is deleted.
+ */
+class StorageEngine
+{
+public:
+  StorageEngine() = default;
+
+  virtual ~StorageEngine() = default;
+
+  DISABLE_COPY_MOVE_AND_ASSIGN(StorageEngine)
+
+  /// @throw WSDB_RECORD_MISS if no row is at rid
+  [[nodiscard]] virtual auto GetRecord(const RID &rid) -> RecordUptr = 0;
+
+  virtual auto InsertRecords(std::span<const Record> records) -> std::vector<RID> = 0;
+
+  /**
+   * Put a row at a rid handed out by the engine before, e.g. a deleted row is put back
+   * @throw WSDB_PAGE_MISS if the rid has never been handed out, WSDB_RECORD_EXISTS if a row is at rid
+   */
+  virtual void InsertRecord(const RID &rid, const Record &record) = 0;
+
+  /// @throw WSDB_RECORD_MISS if no row is at rid
+  virtual void DeleteRecord(const RID &rid) = 0;
+
+  /// @throw WSDB_RECORD_MISS if no row is at rid
+  virtual void UpdateRecord(const RID &rid, const Record &record) = 0;
+
+  /// same as TableHandle::Vacuum, engines that reclaim space on their own return false
+  virtual auto Vacuum(size_t page_num, const std::function<void(const Record &, const Record &)> &on_move)
+      -> bool = 0;
+
+  /// same as TableHandle::GetExtremum, nullptr if the engine keeps no bounds of the column
+  virtual auto GetExtremum(size_t field_idx, bool is_max) -> ValueSptr = 0;
+
+  /// make the rows durable, called when the table is closed
+  virtual void Snapshot() = 0;
+
+  [[nodiscard]] virtual auto GetFirstRID() -> RID = 0;
+
+  [[nodiscard]] virtual auto GetNextRID(const RID &rid) -> RID = 0;
+
+  [[nodiscard]] virtual auto MakeIterator() -> EngineIteratorUptr = 0;
+};
+
+DEFINE_UNIQUE_PTR(StorageEngine);
+
+}  // namespace wsdb
+
+#endif  // WSDB_STORAGE_ENGINE_H
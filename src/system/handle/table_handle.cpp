@@ -20,34 +20,111 @@
 //
 
 #include "table_handle.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <thread>  // NOLINT
+
 namespace wsdb {
 
+namespace {
+/// the number of records in the page header, updated by concurrent inserts and deletes
+auto RecordNumOf(Page *page) -> std::atomic_ref<size_t>
+{
+  return std::atomic_ref<size_t>(*reinterpret_cast<size_t *>(page->GetData() + PAGE_RECORD_NUM_OFFSET));
+}
+
+/// the next free page id in the page header, or OWNED_PAGE_ID/FULL_PAGE_ID if the page is not in the free page list
+auto NextFreePageIdOf(Page *page) -> std::atomic_ref<page_id_t>
+{
+  return std::atomic_ref<page_id_t>(*reinterpret_cast<page_id_t *>(page->GetData() + PAGE_NEXT_FREE_PAGE_ID_OFFSET));
+}
+
+/// the number of pages in the table header, scans read it without the page latch while inserts append pages
+auto PageNumOf(TableHeader &tab_hdr) -> std::atomic_ref<size_t> { return std::atomic_ref<size_t>(tab_hdr.page_num_); }
+
+/// the number of records in the table header, updated by concurrent inserts and deletes
+auto RecordNumOf(TableHeader &tab_hdr) -> std::atomic_ref<size_t> { return std::atomic_ref<size_t>(tab_hdr.rec_num_); }
+
+/// claim the first free slot a new record can be written to without other writers, slot_num if there is none
+auto ClaimWritable(PageHandle *page_handle, size_t slot_num) -> size_t
+{
+  auto writable = page_handle->GetWritableMap();
+  if (writable == nullptr) {
+    return BitMap::ClaimFirst(page_handle->GetBitmap(), slot_num);
+  }
+  auto bitmap = page_handle->GetBitmap();
+  for (auto slot_id = BitMap::FindFirst(bitmap, slot_num, 0, false); slot_id != slot_num;
+       slot_id      = BitMap::FindFirst(bitmap, slot_num, slot_id + 1, false)) {
+    if (BitMap::GetBit(writable, slot_id)) {
+      BitMap::SetBit(bitmap, slot_id, true);
+      return slot_id;
+    }
+  }
+  return slot_num;
+}
+}  // namespace
+
 TableHandle::TableHandle(DiskManager *disk_manager, BufferPoolManager *buffer_pool_manager, table_id_t table_id,
-    TableHeader &hdr, RecordSchemaUptr &schema, StorageModel storage_model)
+    TableHeader &hdr, RecordSchemaUptr &schema, StorageModel storage_model, file_id_t toast_file_id,
+    file_id_t dict_file_id)
     : tab_hdr_(hdr),
       table_id_(table_id),
       disk_manager_(disk_manager),
       buffer_pool_manager_(buffer_pool_manager),
       schema_(std::move(schema)),
-      storage_model_(storage_model)
+      storage_model_(storage_model),
+      coded_schema_(DictHandle::MakeCodedSchema(*schema_)),
+      stored_schema_(ToastHandle::MakeStoredSchema(*coded_schema_, storage_model_)),
+      slot_claims_(tab_hdr_.rec_per_page_),
+      zone_map_(schema_.get())
 {
+  WSDB_ASSERT(stored_schema_->GetRecordLength() == tab_hdr_.rec_size_, "stored record size mismatch");
+  if (toast_file_id != INVALID_FILE_ID) {
+    toast_ =
+        std::make_unique<ToastHandle>(buffer_pool_manager_, toast_file_id, coded_schema_.get(), stored_schema_.get());
+  }
+  if (dict_file_id != INVALID_FILE_ID) {
+    dict_ = std::make_unique<DictHandle>(disk_manager_, dict_file_id, schema_.get(), coded_schema_.get());
+  }
   // set table id for table handle;
   schema_->SetTableId(table_id_);
-  if (storage_model_ == PAX_MODEL) {
-    field_offset_.resize(schema_->GetFieldCount());
-    // calculate offsets of fields
-    WSDB_STUDENT_TODO(l1, f2);
+  for (auto &insert_page : insert_pages_) {
+    insert_page.store(INVALID_PAGE_ID);
+  }
+  if (tab_hdr_.partition_num_ > 0) {
+    // rows are stored in the partitions, the storage model applies to them, see SetPartitions
+    return;
+  }
+  if (storage_model_ == LSM_MODEL) {
+    // the files of the tree are named after the table file
+    auto file_prefix = std::filesystem::path(disk_manager_->GetFileName(table_id_)).replace_extension().string();
+    engine_          = std::make_unique<LsmEngine>(file_prefix, schema_.get(), tab_hdr_);
+  }
+  if (storage_model_ == MEMORY_MODEL) {
+    engine_ = std::make_unique<MemoryEngine>(disk_manager_, table_id_, schema_.get(), tab_hdr_);
   }
 }
 
 auto TableHandle::GetRecord(const RID &rid) -> RecordUptr
 {
+  std::shared_lock<std::shared_mutex> vacuum_lock{vacuum_latch_};
+  if (partition_scheme_ != nullptr) {
+    auto [partition, partition_rid] = LocatePartition(rid);
+    auto record                     = partition->GetRecord(partition_rid);
+    record->SetRID(rid);
+    return record;
+  }
+  if (engine_ != nullptr) {
+    return engine_->GetRecord(rid);
+  }
   auto nullmap = std::make_unique<char[]>(tab_hdr_.nullmap_size_);
-  auto data    = std::make_unique<char[]>(tab_hdr_.rec_size_);
+  auto data    = std::make_unique<char[]>(schema_->GetRecordLength());
   // WSDB_STUDENT_TODO(l1, t3);
 
   slot_id_t      slot_id{rid.SlotID()};
   page_id_t      page_id{rid.PageID()};
+  auto           page_lock{LockPageShared(page_id)};
   PageHandleUptr page_handle{FetchPageHandle(page_id)};
   if (!BitMap::GetBit(page_handle->GetBitmap(), slot_id)) {
     buffer_pool_manager_->UnpinPage(table_id_, page_id, false);
@@ -56,8 +133,16 @@ auto TableHandle::GetRecord(const RID &rid) -> RecordUptr
         WSDB_RECORD_MISS, fmt::format("Table Handle 中 RID(SlotID:{},PageID:{}) 处的 Record 不存在", slot_id, page_id));
   }
 
+  // a record of a slotted page may have been moved to another page
+  if (auto forward = page_handle->GetForward(slot_id); forward != INVALID_RID) {
+    buffer_pool_manager_->UnpinPage(table_id_, page_id, false);
+    page_id     = forward.PageID();
+    slot_id     = forward.SlotID();
+    page_handle = FetchPageHandle(page_id);
+  }
+
   char *nullmap_ptr{nullmap.get()}, *data_ptr{data.get()};
-  page_handle->ReadSlot(slot_id, nullmap_ptr, data_ptr);
+  ReadRecord(page_handle.get(), slot_id, nullmap_ptr, data_ptr);
   buffer_pool_manager_->UnpinPage(table_id_, page_id, false);
 
   return std::make_unique<Record>(schema_.get(), nullmap_ptr, data_ptr, rid);
@@ -65,108 +150,556 @@ auto TableHandle::GetRecord(const RID &rid) -> RecordUptr
   // 指针将会被销毁，造成未定义行为。但无法将这两个指针的所有权转移给 Record。
 }
 
-auto TableHandle::GetChunk(page_id_t pid, const RecordSchema *chunk_schema) -> ChunkUptr { WSDB_STUDENT_TODO(l1, f2); }
+auto TableHandle::GetChunk(page_id_t pid, const RecordSchema *chunk_schema) -> ChunkUptr
+{
+  if (engine_ != nullptr) {
+    WSDB_THROW(WSDB_UNSUPPORTED_OP, "chunk of a table whose rows are not stored in pages");
+  }
+  std::shared_lock<std::shared_mutex> vacuum_lock{vacuum_latch_};
+  if (partition_scheme_ != nullptr) {
+    auto [partition, partition_rid] = LocatePartition({pid, 0});
+    return partition->GetChunk(partition_rid.PageID(), chunk_schema);
+  }
+  auto page_lock   = LockPageShared(pid);
+  auto page_handle = FetchPageHandle(pid);
+  auto chunk       = page_handle->ReadChunk(chunk_schema);
+  buffer_pool_manager_->UnpinPage(table_id_, pid, false);
+  return chunk;
+}
 
 auto TableHandle::InsertRecord(const Record &record) -> RID
 {
   // WSDB_STUDENT_TODO(l1, t3);
+  return InsertRecords(std::span<const Record>(&record, 1)).front();
+}
 
-  PageHandleUptr page_handle{CreatePageHandle()};
-
-  char     *bitmap{page_handle->GetBitmap()};
-  slot_id_t slot_id{static_cast<slot_id_t>(BitMap::FindFirst(bitmap, tab_hdr_.rec_per_page_, 0, false))};
-
-  Page &page{*page_handle->GetPage()};
-  page_handle->WriteSlot(slot_id, record.GetNullMap(), record.GetData(), false);
-  BitMap::SetBit(bitmap, slot_id, true);
-  ++tab_hdr_.rec_num_;
-  size_t record_num{page.GetRecordNum()};
-  page.SetRecordNum(record_num + 1);  // 建议增加对 page 的 record_num 的测试
-
-  if (record_num + 1 == tab_hdr_.rec_per_page_) {
-    tab_hdr_.first_free_page_ = page.GetNextFreePageId();
-    page.SetNextFreePageId(INVALID_PAGE_ID);  // 设置为 INVALID_PAGE_ID 是合理的选择
+auto TableHandle::InsertRecords(std::span<const Record> records) -> std::vector<RID>
+{
+  std::shared_lock<std::shared_mutex> vacuum_lock{vacuum_latch_};
+  std::vector<RID> rids;
+  rids.reserve(records.size());
+  if (partition_scheme_ != nullptr) {
+    // consecutive records of the same partition are inserted as a batch, e.g. rows loaded in the order of the key
+    for (size_t first = 0; first < records.size();) {
+      auto partition = partition_scheme_->GetPartition(records[first]);
+      auto last      = first + 1;
+      while (last < records.size() && partition_scheme_->GetPartition(records[last]) == partition) {
+        last++;
+      }
+      for (const auto &rid : partitions_[partition]->InsertRecords(records.subspan(first, last - first))) {
+        rids.push_back(PartitionRID(partition, rid));
+      }
+      first = last;
+    }
+    return rids;
+  }
+  if (storage_model_ == SLOTTED_MODEL) {
+    std::lock_guard<std::shared_mutex> lock{page_latch_};
+    for (const auto &record : records) {
+      rids.push_back(InsertSlottedRecord(record));
+      zone_map_.Insert(rids.back().PageID(), std::span<const Record>(&record, 1));
+    }
+    return rids;
+  }
+  if (engine_ != nullptr) {
+    rids = engine_->InsertRecords(records);
+    RecordNumOf(tab_hdr_).fetch_add(rids.size());
+    return rids;
   }
 
-  page_id_t page_id{page.GetPageId()};
-  buffer_pool_manager_->UnpinPage(table_id_, page_id, true);
-  return RID{page_id, slot_id};
+  auto &insert_page = insert_pages_[std::hash<std::thread::id>{}(std::this_thread::get_id()) % TABLE_INSERT_PAGE_NUM];
+  while (rids.size() < records.size()) {
+    page_id_t page_id{insert_page.load()};
+    if (page_id == INVALID_PAGE_ID) {
+      page_id = AcquireInsertPage(insert_page);
+    }
+    PageHandleUptr page_handle{FetchPageHandle(page_id)};
+    Page          *page{page_handle->GetPage()};
+    size_t         first{rids.size()};
+    {
+      auto page_lock{LockPageShared(page_id)};
+      // the bits of the slots are set once the records are written, scans never see a half-written record
+      auto slots =
+          slot_claims_.Claim(page_id, page_handle->GetBitmap(), records.size() - first, page_handle->GetWritableMap());
+      for (auto slot_id : slots) {
+        WriteRecord(page_handle.get(), slot_id, records[rids.size()], false);
+        rids.emplace_back(page_id, static_cast<slot_id_t>(slot_id));
+      }
+      slot_claims_.Publish(page_id, page_handle->GetBitmap(), slots);
+    }
+    size_t written{rids.size() - first};
+    RecordNumOf(page).fetch_add(written);  // 建议增加对 page 的 record_num 的测试
+    RecordNumOf(tab_hdr_).fetch_add(written);
+    zone_map_.Insert(page_id, records.subspan(first, written));
+    // a pax page makes room for plain slots by encoding its rows before it is given up
+    if (rids.size() < records.size() && !FreezePage(page_handle.get())) {
+      ReleaseInsertPage(insert_page, page);
+    }
+    buffer_pool_manager_->UnpinPage(table_id_, page_id, true);
+  }
+  return rids;
 }
 
 void TableHandle::InsertRecord(const RID &rid, const Record &record)
 {
+  std::shared_lock<std::shared_mutex> vacuum_lock{vacuum_latch_};
   page_id_t page_id{rid.PageID()};
   if (page_id == INVALID_PAGE_ID) {
     // buffer_pool_manager_->UnpinPage(table_id_, page_id, false);
     // 这里理应不需要 unpin
     WSDB_THROW(WSDB_PAGE_MISS, fmt::format("Page: {}", rid.PageID()));
   }
+  if (partition_scheme_ != nullptr) {
+    auto [partition, partition_rid] = LocatePartition(rid);
+    if (partitions_[partition_scheme_->GetPartition(record)].get() != partition) {
+      WSDB_THROW(WSDB_UNSUPPORTED_OP, fmt::format("record of another partition at page {}", rid.PageID()));
+    }
+    partition->InsertRecord(partition_rid, record);
+    return;
+  }
+  if (storage_model_ == SLOTTED_MODEL) {
+    std::lock_guard<std::shared_mutex> lock{page_latch_};
+    InsertSlottedRecord(rid, record);
+    zone_map_.Insert(page_id, std::span<const Record>(&record, 1));
+    return;
+  }
+  if (engine_ != nullptr) {
+    engine_->InsertRecord(rid, record);
+    RecordNumOf(tab_hdr_).fetch_add(1);
+    return;
+  }
   // WSDB_STUDENT_TODO(l1, t3);
   PageHandleUptr page_handle{FetchPageHandle(page_id)};
-  slot_id_t      slot_id{rid.SlotID()};
-  char          *bitmap{page_handle->GetBitmap()};
-  if (BitMap::GetBit(bitmap, slot_id)) {
+  size_t         slot_id{static_cast<size_t>(rid.SlotID())};
+  auto           page_lock{LockPageShared(page_id)};
+  if (auto pax = dynamic_cast<PAXPageHandle *>(page_handle.get()); pax != nullptr && !pax->IsPlain(slot_id)) {
+    // an encoded slot, the page is encoded again with the record in it
+    page_lock.unlock();
+    std::unique_lock<std::shared_mutex> pax_lock{PAXLatchOf(page_id)};
+    if (BitMap::GetBit(pax->GetBitmap(), slot_id)) {
+      pax_lock.unlock();
+      buffer_pool_manager_->UnpinPage(table_id_, page_id, false);
+      WSDB_THROW(WSDB_RECORD_EXISTS,
+          fmt::format("Table Handle 中 RID(SlotID:{},PageID:{}) 处的 Record 已经存在", slot_id, page_id));
+    }
+    WriteRecord(pax, slot_id, record, false);
+    BitMap::SetBit(pax->GetBitmap(), slot_id, true);
+    pax_lock.unlock();
+    RecordNumOf(pax->GetPage()).fetch_add(1);
+    RecordNumOf(tab_hdr_).fetch_add(1);
+    zone_map_.Insert(page_id, std::span<const Record>(&record, 1));
+    buffer_pool_manager_->UnpinPage(table_id_, page_id, true);
+    return;
+  }
+  if (!slot_claims_.TryClaim(page_id, page_handle->GetBitmap(), slot_id)) {
+    page_lock = {};
+    buffer_pool_manager_->UnpinPage(table_id_, page_id, false);
     WSDB_THROW(WSDB_RECORD_EXISTS,
         fmt::format("Table Handle 中 RID(SlotID:{},PageID:{}) 处的 Record 已经存在", slot_id, page_id));
   }
 
-  Page &page{*page_handle->GetPage()};
-  page_handle->WriteSlot(slot_id, record.GetNullMap(), record.GetData(), false);
-  BitMap::SetBit(bitmap, slot_id, true);
-  tab_hdr_.rec_num_++;
-  size_t record_num{page.GetRecordNum()};
-  page.SetRecordNum(record_num + 1);
-
-  if (record_num + 1 == tab_hdr_.rec_per_page_) {
-    tab_hdr_.first_free_page_ = page.GetNextFreePageId();
-    page.SetNextFreePageId(INVALID_PAGE_ID);  // 设置为 INVALID_PAGE_ID 是合理的选择
-  }
-
+  // a page in the free page list may become full here, it is taken out of the list when an insert finds it full
+  WriteRecord(page_handle.get(), slot_id, record, false);
+  slot_claims_.Publish(page_id, page_handle->GetBitmap(), std::span<const size_t>(&slot_id, 1));
+  RecordNumOf(page_handle->GetPage()).fetch_add(1);
+  RecordNumOf(tab_hdr_).fetch_add(1);
+  zone_map_.Insert(page_id, std::span<const Record>(&record, 1));
   buffer_pool_manager_->UnpinPage(table_id_, page_id, true);
 }
 
 void TableHandle::DeleteRecord(const RID &rid)
 {
+  std::shared_lock<std::shared_mutex> vacuum_lock{vacuum_latch_};
   // WSDB_STUDENT_TODO(l1, t3);
+  if (partition_scheme_ != nullptr) {
+    auto [partition, partition_rid] = LocatePartition(rid);
+    partition->DeleteRecord(partition_rid);
+    return;
+  }
+  if (storage_model_ == SLOTTED_MODEL) {
+    std::lock_guard<std::shared_mutex> lock{page_latch_};
+    DeleteSlottedRecord(rid);
+    zone_map_.Delete(rid.PageID());
+    return;
+  }
+  if (engine_ != nullptr) {
+    // the engine throws if the row is deleted already, so it is counted out once by concurrent deletes
+    engine_->DeleteRecord(rid);
+    RecordNumOf(tab_hdr_).fetch_sub(1);
+    return;
+  }
   page_id_t      page_id{rid.PageID()};
   slot_id_t      slot_id{rid.SlotID()};
   PageHandleUptr page_handle{FetchPageHandle(page_id)};
-  char          *bitmap{page_handle->GetBitmap()};
-  if (!BitMap::GetBit(bitmap, slot_id)) {
+  // the slot may be claimed by an insert once its bit is reset, keep the toast pointers before
+  std::vector<char> nullmap;
+  std::vector<char> stored;
+  if (IsToasted()) {
+    nullmap.resize(tab_hdr_.nullmap_size_);
+    stored.resize(tab_hdr_.rec_size_);
+    page_handle->ReadSlot(slot_id, nullmap.data(), stored.data());
+  }
+  // an encoded row stays in the page until the page is encoded again, only its bit is reset
+  auto page_lock{LockPageShared(page_id)};
+  if (!BitMap::TryResetBit(page_handle->GetBitmap(), slot_id)) {
+    page_lock = {};
     buffer_pool_manager_->UnpinPage(table_id_, page_id, false);
     WSDB_THROW(
         WSDB_RECORD_MISS, fmt::format("Table Handle 中 RID(SlotID:{},PageID:{}) 处的 Record 不存在", slot_id, page_id));
   }
+  page_lock = {};
+  if (IsToasted()) {
+    toast_->Free(nullmap.data(), stored.data());
+  }
 
-  Page &page{*page_handle->GetPage()};
-  BitMap::SetBit(bitmap, slot_id, false);
-  tab_hdr_.rec_num_--;
-  size_t record_num{page.GetRecordNum()};
-  page.SetRecordNum(record_num - 1);
-
-  if (record_num == tab_hdr_.rec_per_page_) {
-    page.SetNextFreePageId(tab_hdr_.first_free_page_);
-    tab_hdr_.first_free_page_ = page_id;
+  Page *page{page_handle->GetPage()};
+  RecordNumOf(page).fetch_sub(1);
+  RecordNumOf(tab_hdr_).fetch_sub(1);
+  zone_map_.Delete(page_id);
+  // the record num is decreased before the mark is checked, ReleaseInsertPage does it the other way around, so a
+  // page given up concurrently is either seen full here or seen not full there
+  if (NextFreePageIdOf(page).load() == FULL_PAGE_ID) {
+    std::lock_guard<std::shared_mutex> lock{page_latch_};
+    if (NextFreePageIdOf(page).load() == FULL_PAGE_ID && HasFreeSlot(page_handle.get())) {
+      NextFreePageIdOf(page).store(tab_hdr_.first_free_page_);
+      tab_hdr_.first_free_page_ = page_id;
+    }
   }
-  buffer_pool_manager_->UnpinPage(table_id_, page_id, false);
+  // the bitmap and the page header are changed
+  buffer_pool_manager_->UnpinPage(table_id_, page_id, true);
 }
 
 void TableHandle::UpdateRecord(const RID &rid, const Record &record)
 {
+  std::shared_lock<std::shared_mutex> vacuum_lock{vacuum_latch_};
   // WSDB_STUDENT_TODO(l1, t3);
+  if (partition_scheme_ != nullptr) {
+    // moving the row to another partition would change its rid under the caller
+    auto [partition, partition_rid] = LocatePartition(rid);
+    if (partitions_[partition_scheme_->GetPartition(record)].get() != partition) {
+      WSDB_THROW(WSDB_UNSUPPORTED_OP, fmt::format("update of the partition key {}", partition_scheme_->ToString()));
+    }
+    partition->UpdateRecord(partition_rid, record);
+    return;
+  }
+  if (storage_model_ == SLOTTED_MODEL) {
+    std::lock_guard<std::shared_mutex> lock{page_latch_};
+    UpdateSlottedRecord(rid, record);
+    zone_map_.Update(rid.PageID(), record);
+    return;
+  }
+  if (engine_ != nullptr) {
+    engine_->UpdateRecord(rid, record);
+    return;
+  }
   page_id_t      page_id{rid.PageID()};
   slot_id_t      slot_id{rid.SlotID()};
   PageHandleUptr page_handle{FetchPageHandle(page_id)};
+  auto           page_lock{LockPageShared(page_id)};
+  if (auto pax = dynamic_cast<PAXPageHandle *>(page_handle.get()); pax != nullptr && !pax->IsPlain(slot_id)) {
+    // an encoded row, the page is encoded again with the record in its place
+    page_lock.unlock();
+    std::unique_lock<std::shared_mutex> pax_lock{PAXLatchOf(page_id)};
+    if (!BitMap::GetBit(pax->GetBitmap(), slot_id)) {
+      pax_lock.unlock();
+      buffer_pool_manager_->UnpinPage(table_id_, page_id, false);
+      WSDB_THROW(WSDB_RECORD_MISS,
+          fmt::format("Table Handle 中 RID(SlotID:{},PageID:{}) 处的 Record 不存在", slot_id, page_id));
+    }
+    WriteRecord(pax, slot_id, record, true);
+    pax_lock.unlock();
+    zone_map_.Update(page_id, record);
+    buffer_pool_manager_->UnpinPage(table_id_, page_id, true);
+    return;
+  }
   if (!BitMap::GetBit(page_handle->GetBitmap(), slot_id)) {
+    page_lock = {};
     buffer_pool_manager_->UnpinPage(table_id_, page_id, false);
     WSDB_THROW(
         WSDB_RECORD_MISS, fmt::format("Table Handle 中 RID(SlotID:{},PageID:{}) 处的 Record 不存在", slot_id, page_id));
   }
 
-  page_handle->WriteSlot(slot_id, record.GetNullMap(), record.GetData(), true);
+  std::vector<char> nullmap;
+  std::vector<char> stored;
+  if (IsToasted()) {
+    nullmap.resize(tab_hdr_.nullmap_size_);
+    stored.resize(tab_hdr_.rec_size_);
+    page_handle->ReadSlot(slot_id, nullmap.data(), stored.data());
+  }
+  WriteRecord(page_handle.get(), slot_id, record, true);
+  page_lock = {};
+  if (IsToasted()) {
+    toast_->Free(nullmap.data(), stored.data());
+  }
+  zone_map_.Update(page_id, record);
   buffer_pool_manager_->UnpinPage(table_id_, page_id, true);
 }
 
+auto TableHandle::Vacuum(size_t page_num, const std::function<void(const Record &, const Record &)> &on_move) -> bool
+{
+  if (storage_model_ == SLOTTED_MODEL) {
+    WSDB_THROW(WSDB_UNSUPPORTED_OP, "vacuum of a slotted table, its records may be forwarded across pages");
+  }
+  if (partition_scheme_ != nullptr) {
+    // each partition is compacted on its own, moved records are reported with rids of the table
+    std::shared_lock<std::shared_mutex> vacuum_lock{vacuum_latch_};
+    bool                                more = false;
+    for (size_t i = 0; i < partitions_.size(); ++i) {
+      more |= partitions_[i]->Vacuum(page_num, [&on_move, i](const Record &old_record, const Record &new_record) {
+        Record old_table_record(old_record);
+        Record new_table_record(new_record);
+        old_table_record.SetRID(PartitionRID(i, old_record.GetRID()));
+        new_table_record.SetRID(PartitionRID(i, new_record.GetRID()));
+        on_move(old_table_record, new_table_record);
+      });
+    }
+    return more;
+  }
+  std::unique_lock<std::shared_mutex> vacuum_lock{vacuum_latch_};
+  if (scan_num_.load() > 0) {
+    // records moved to pages the scans have passed would be missed by them
+    WSDB_THROW(WSDB_UNSUPPORTED_OP, fmt::format("vacuum of {} while it is being scanned", GetTableName()));
+  }
+  if (engine_ != nullptr) {
+    return engine_->Vacuum(page_num, on_move);
+  }
+  // 1. no thread is inserting, the free page list covers all pages with free slots once the insert pages are back
+  ReleaseInsertPages();
+  std::lock_guard<std::shared_mutex> lock{page_latch_};
+  std::vector<page_id_t>             free_pages;
+  for (page_id_t page_id = tab_hdr_.first_free_page_; page_id != INVALID_PAGE_ID;) {
+    free_pages.push_back(page_id);
+    page_id = NextFreePageIdOf(buffer_pool_manager_->FetchPage(table_id_, page_id)).load();
+    buffer_pool_manager_->UnpinPage(table_id_, free_pages.back(), false);
+  }
+  std::sort(free_pages.begin(), free_pages.end());
+
+  // 2. move records of the last pages to the lowest pages with free slots
+  auto              target = free_pages.begin();
+  PageHandleUptr    target_handle;
+  bool              stop   = false;
+  std::vector<char> nullmap(tab_hdr_.nullmap_size_);
+  std::vector<char> data(tab_hdr_.rec_size_);
+  std::vector<char> rec_data_buf(IsPacked() ? schema_->GetRecordLength() : 0);
+  for (size_t n = 0; n < page_num && PageNumOf(tab_hdr_).load() > FILE_HEADER_PAGE_ID + 1; ++n) {
+    auto tail_id     = static_cast<page_id_t>(PageNumOf(tab_hdr_).load() - 1);
+    auto tail_handle = FetchPageHandle(tail_id);
+    auto tail_bitmap = tail_handle->GetBitmap();
+    if (buffer_pool_manager_->GetPinCount(table_id_, tail_id) > 1) {
+      // record views that outlive their iterator still point into the page, it can not be dropped now
+      buffer_pool_manager_->UnpinPage(table_id_, tail_id, false);
+      stop = true;
+      break;
+    }
+    for (auto slot_id = BitMap::FindFirst(tail_bitmap, tab_hdr_.rec_per_page_, 0, true);
+         slot_id != tab_hdr_.rec_per_page_;
+         slot_id = BitMap::FindFirst(tail_bitmap, tab_hdr_.rec_per_page_, slot_id + 1, true)) {
+      size_t target_slot = tab_hdr_.rec_per_page_;
+      for (; target != free_pages.end() && *target < tail_id; ++target) {
+        if (target_handle == nullptr) {
+          target_handle = FetchPageHandle(*target);
+        }
+        target_slot = ClaimWritable(target_handle.get(), tab_hdr_.rec_per_page_);
+        if (target_slot == tab_hdr_.rec_per_page_ && FreezePage(target_handle.get())) {
+          target_slot = ClaimWritable(target_handle.get(), tab_hdr_.rec_per_page_);
+        }
+        if (target_slot != tab_hdr_.rec_per_page_) {
+          break;
+        }
+        buffer_pool_manager_->UnpinPage(table_id_, *target, true);
+        target_handle = nullptr;
+      }
+      if (target_slot == tab_hdr_.rec_per_page_) {
+        // no free slot before the page, the table is compact
+        stop = true;
+        break;
+      }
+      tail_handle->ReadSlot(slot_id, nullmap.data(), data.data());
+      target_handle->WriteSlot(target_slot, nullmap.data(), data.data(), true);
+      BitMap::SetBit(tail_bitmap, slot_id, false);
+      RecordNumOf(tail_handle->GetPage()).fetch_sub(1);
+      RecordNumOf(target_handle->GetPage()).fetch_add(1);
+      // the slot is moved as it is stored, toast pointers and codes stay valid
+      const char *rec_data = data.data();
+      if (IsPacked()) {
+        UnpackRecord(nullmap.data(), data.data(), rec_data_buf.data());
+        rec_data = rec_data_buf.data();
+      }
+      Record old_record(schema_.get(), nullmap.data(), rec_data, {tail_id, static_cast<slot_id_t>(slot_id)});
+      Record new_record(schema_.get(), nullmap.data(), rec_data, {*target, static_cast<slot_id_t>(target_slot)});
+      zone_map_.Insert(*target, std::span<const Record>(&new_record, 1));
+      zone_map_.Delete(tail_id);
+      on_move(old_record, new_record);
+    }
+    buffer_pool_manager_->UnpinPage(table_id_, tail_id, true);
+    if (stop) {
+      break;
+    }
+    // 3. the page is empty and pinned by no one, drop it from the buffer pool unless it is evicted already, the file is
+    // truncated below, so are the rows a pax page spilled to the toast file
+    if (auto pax = dynamic_cast<PAXPageHandle *>(tail_handle.get()); pax != nullptr) {
+      pax->ReleaseSpills();
+    }
+    tail_handle = nullptr;
+    buffer_pool_manager_->DeletePage(table_id_, tail_id);
+    PageNumOf(tab_hdr_).fetch_sub(1);
+  }
+  if (target_handle != nullptr) {
+    buffer_pool_manager_->UnpinPage(table_id_, *target, true);
+  }
+  disk_manager_->TruncateFile(table_id_, PageNumOf(tab_hdr_).load());
+
+  // 4. inserts take free pages from the head of the list, so the lowest pages are filled first
+  tab_hdr_.first_free_page_ = INVALID_PAGE_ID;
+  for (auto it = free_pages.rbegin(); it != free_pages.rend(); ++it) {
+    if (static_cast<size_t>(*it) >= PageNumOf(tab_hdr_).load()) {
+      continue;
+    }
+    auto page = buffer_pool_manager_->FetchPage(table_id_, *it);
+    if (!HasFreeSlot(WrapPageHandle(page).get())) {
+      NextFreePageIdOf(page).store(FULL_PAGE_ID);
+    } else {
+      NextFreePageIdOf(page).store(tab_hdr_.first_free_page_);
+      tab_hdr_.first_free_page_ = *it;
+    }
+    buffer_pool_manager_->UnpinPage(table_id_, *it, true);
+  }
+  return !stop && PageNumOf(tab_hdr_).load() > FILE_HEADER_PAGE_ID + 1;
+}
+
+auto TableHandle::GetExtremum(size_t field_idx, bool is_max) -> ValueSptr
+{
+  if (engine_ != nullptr) {
+    return engine_->GetExtremum(field_idx, is_max);
+  }
+  if (storage_model_ == SLOTTED_MODEL) {
+    return nullptr;
+  }
+  std::shared_lock<std::shared_mutex> vacuum_lock{vacuum_latch_};
+  if (partition_scheme_ != nullptr) {
+    auto best = ValueFactory::CreateNullValue(schema_->GetFieldAt(field_idx).field_.field_type_);
+    for (auto &partition : partitions_) {
+      auto value = partition->GetExtremum(field_idx, is_max);
+      if (value == nullptr) {
+        return nullptr;
+      }
+      best = is_max ? Value::Max(best, value) : Value::Min(best, value);
+    }
+    return best;
+  }
+  std::vector<std::pair<double, page_id_t>> bounds;
+  if (!zone_map_.GetBounds(field_idx, PageNumOf(tab_hdr_).load(), is_max, bounds)) {
+    return nullptr;
+  }
+  // the most promising page first
+  std::sort(bounds.begin(), bounds.end(), [is_max](const auto &lhs, const auto &rhs) {
+    return is_max ? lhs.first > rhs.first : lhs.first < rhs.first;
+  });
+
+  // values are compared as datums, only the result is allocated
+  auto   type   = schema_->GetFieldAt(field_idx).field_.field_type_;
+  auto   offset = stored_schema_->GetFieldOffset(field_idx);
+  auto   best   = Datum::Null(type);
+  double best_num{0};
+  auto   nullmap = std::make_unique<char[]>(tab_hdr_.nullmap_size_);
+  auto   data    = std::make_unique<char[]>(tab_hdr_.rec_size_);
+  for (const auto &[bound, page_id] : bounds) {
+    if (!best.IsNull() && (is_max ? bound <= best_num : bound >= best_num)) {
+      break;
+    }
+    auto page_handle = FetchPageHandle(page_id);
+    for (auto slot_id = BitMap::FindFirst(page_handle->GetBitmap(), tab_hdr_.rec_per_page_, 0, true);
+         slot_id != tab_hdr_.rec_per_page_;
+         slot_id = BitMap::FindFirst(page_handle->GetBitmap(), tab_hdr_.rec_per_page_, slot_id + 1, true)) {
+      page_handle->ReadSlot(slot_id, nullmap.get(), data.get());
+      if (BitMap::GetBit(nullmap.get(), field_idx)) {
+        continue;
+      }
+      auto   value = Datum::FromField(type, data.get() + offset, schema_->GetFieldAt(field_idx).field_.field_size_);
+      double num   = 0;
+      switch (type) {
+        case TYPE_INT: num = value.GetInt(); break;
+        case TYPE_FLOAT: num = value.GetFloat(); break;
+        case TYPE_BOOL: num = value.GetBool() ? 1 : 0; break;
+        default: WSDB_FETAL("field without zone");
+      }
+      if (best.IsNull() || (is_max ? num > best_num : num < best_num)) {
+        best     = value;
+        best_num = num;
+      }
+    }
+    buffer_pool_manager_->UnpinPage(table_id_, page_id, false);
+  }
+  return best.ToValue();
+}
+
+void TableHandle::Snapshot()
+{
+  if (partition_scheme_ != nullptr) {
+    // the partitions are closed as tables of their own, see TableManager::CloseTable
+    return;
+  }
+  if (engine_ != nullptr) {
+    engine_->Snapshot();
+  }
+}
+
+auto TableHandle::GetRecordNum() -> size_t
+{
+  if (partition_scheme_ != nullptr) {
+    std::shared_lock<std::shared_mutex> vacuum_lock{vacuum_latch_};
+    size_t                              rec_num = 0;
+    for (auto &partition : partitions_) {
+      rec_num += partition->GetRecordNum();
+    }
+    return rec_num;
+  }
+  return RecordNumOf(tab_hdr_).load();
+}
+
+auto TableHandle::GetPageNum() -> size_t
+{
+  if (partition_scheme_ != nullptr) {
+    std::shared_lock<std::shared_mutex> vacuum_lock{vacuum_latch_};
+    size_t                              page_num = 0;
+    for (auto &partition : partitions_) {
+      page_num += partition->GetPageNum();
+    }
+    return page_num;
+  }
+  return PageNumOf(tab_hdr_).load();
+}
+
+void TableHandle::SetPartitions(PartitionSchemeUptr scheme, std::vector<std::unique_ptr<TableHandle>> partitions)
+{
+  WSDB_ASSERT(scheme->GetPartitionNum() == partitions.size(), "partition number mismatch");
+  scheme->Bind(schema_.get());
+  partition_scheme_ = std::move(scheme);
+  partitions_       = std::move(partitions);
+  // conditions and records name the fields of the table, the partitions share them
+  for (auto &partition : partitions_) {
+    partition->schema_->SetTableId(table_id_);
+  }
+}
+
+auto TableHandle::GetPartitionScheme() const -> const PartitionScheme * { return partition_scheme_.get(); }
+
+auto TableHandle::GetPartitionNum() const -> size_t { return partitions_.size(); }
+
+void TableHandle::ReplacePartition(
+    size_t partition, const std::function<std::unique_ptr<TableHandle>(std::unique_ptr<TableHandle>)> &replace)
+{
+  std::unique_lock<std::shared_mutex> vacuum_lock{vacuum_latch_};
+  if (scan_num_.load() > 0) {
+    // the iterators read the partitions without the latch
+    WSDB_THROW(WSDB_UNSUPPORTED_OP, fmt::format("replace partition {} of a table being scanned", partition));
+  }
+  partitions_[partition] = replace(std::move(partitions_[partition]));
+  partitions_[partition]->schema_->SetTableId(table_id_);
+}
+
+auto TableHandle::GetPartition(size_t partition) -> TableHandle * { return partitions_[partition].get(); }
+
 auto TableHandle::FetchPageHandle(page_id_t page_id) -> PageHandleUptr
 {
   auto page = buffer_pool_manager_->FetchPage(table_id_, page_id);
@@ -184,8 +717,7 @@ auto TableHandle::CreatePageHandle() -> PageHandleUptr
 
 auto TableHandle::CreateNewPageHandle() -> PageHandleUptr
 {
-  auto page_id = static_cast<page_id_t>(tab_hdr_.page_num_);
-  tab_hdr_.page_num_++;
+  auto page_id = static_cast<page_id_t>(PageNumOf(tab_hdr_).fetch_add(1));
   auto page   = buffer_pool_manager_->FetchPage(table_id_, page_id);
   auto pg_hdl = WrapPageHandle(page);
   page->SetNextFreePageId(tab_hdr_.first_free_page_);
@@ -193,15 +725,320 @@ auto TableHandle::CreateNewPageHandle() -> PageHandleUptr
   return pg_hdl;
 }
 
+auto TableHandle::AcquireInsertPage(std::atomic<page_id_t> &insert_page) -> page_id_t
+{
+  std::lock_guard<std::shared_mutex> lock{page_latch_};
+  if (auto page_id = insert_page.load(); page_id != INVALID_PAGE_ID) {
+    return page_id;
+  }
+  page_id_t page_id;
+  Page     *page;
+  if (tab_hdr_.first_free_page_ != INVALID_PAGE_ID) {
+    page_id                   = tab_hdr_.first_free_page_;
+    page                      = buffer_pool_manager_->FetchPage(table_id_, page_id);
+    tab_hdr_.first_free_page_ = NextFreePageIdOf(page).load();
+  } else {
+    page_id = static_cast<page_id_t>(PageNumOf(tab_hdr_).load());
+    page    = buffer_pool_manager_->FetchPage(table_id_, page_id);
+    PageNumOf(tab_hdr_).fetch_add(1);
+  }
+  NextFreePageIdOf(page).store(OWNED_PAGE_ID);
+  buffer_pool_manager_->UnpinPage(table_id_, page_id, true);
+  insert_page.store(page_id);
+  return page_id;
+}
+
+void TableHandle::ReleaseInsertPage(std::atomic<page_id_t> &insert_page, Page *page)
+{
+  std::lock_guard<std::shared_mutex> lock{page_latch_};
+  page_id_t                          page_id{page->GetPageId()};
+  // the page may have been given up by another thread sharing the insert page
+  if (!insert_page.compare_exchange_strong(page_id, INVALID_PAGE_ID)) {
+    return;
+  }
+  NextFreePageIdOf(page).store(FULL_PAGE_ID);
+  if (HasFreeSlot(WrapPageHandle(page).get())) {
+    // a record is deleted before the page is marked full, the deleting thread does not put it back then
+    NextFreePageIdOf(page).store(tab_hdr_.first_free_page_);
+    tab_hdr_.first_free_page_ = page->GetPageId();
+  }
+}
+
+void TableHandle::ReleaseInsertPages()
+{
+  if (partition_scheme_ != nullptr) {
+    // the partitions are closed as tables of their own, see TableManager::CloseTable
+    return;
+  }
+  std::lock_guard<std::shared_mutex> lock{page_latch_};
+  for (auto &insert_page : insert_pages_) {
+    page_id_t page_id{insert_page.exchange(INVALID_PAGE_ID)};
+    if (page_id == INVALID_PAGE_ID) {
+      continue;
+    }
+    // full insert pages go back to the list as well, the next insert takes them out
+    auto page = buffer_pool_manager_->FetchPage(table_id_, page_id);
+    NextFreePageIdOf(page).store(tab_hdr_.first_free_page_);
+    tab_hdr_.first_free_page_ = page_id;
+    buffer_pool_manager_->UnpinPage(table_id_, page_id, true);
+  }
+}
+
+void TableHandle::ReadRecord(PageHandle *page_handle, size_t slot_id, char *nullmap, char *data)
+{
+  if (!IsPacked()) {
+    page_handle->ReadSlot(slot_id, nullmap, data);
+    return;
+  }
+  std::vector<char> stored(tab_hdr_.rec_size_);
+  page_handle->ReadSlot(slot_id, nullmap, stored.data());
+  UnpackRecord(nullmap, stored.data(), data);
+}
+
+void TableHandle::WriteRecord(PageHandle *page_handle, size_t slot_id, const Record &record, bool update)
+{
+  std::vector<char> stored;
+  const char       *data = record.GetData();
+  if (IsPacked()) {
+    stored.resize(tab_hdr_.rec_size_);
+    PackRecord(record.GetNullMap(), record.GetData(), stored.data());
+    data = stored.data();
+  }
+  // an encoded slot of a pax page is written by encoding the page again, under the latch of its stripe exclusively
+  if (auto pax = dynamic_cast<PAXPageHandle *>(page_handle); pax != nullptr && !pax->IsPlain(slot_id)) {
+    pax->Rewrite(slot_id, record.GetNullMap(), data);
+    return;
+  }
+  page_handle->WriteSlot(slot_id, record.GetNullMap(), data, update);
+}
+
+void TableHandle::PackRecord(const char *nullmap, const char *data, char *stored)
+{
+  if (dict_ == nullptr) {
+    toast_->Pack(nullmap, data, stored);
+    return;
+  }
+  if (toast_ == nullptr) {
+    dict_->Pack(nullmap, data, stored);
+    return;
+  }
+  std::vector<char> coded(coded_schema_->GetRecordLength());
+  dict_->Pack(nullmap, data, coded.data());
+  toast_->Pack(nullmap, coded.data(), stored);
+}
+
+void TableHandle::UnpackRecord(const char *nullmap, const char *stored, char *data, const char *fields)
+{
+  if (dict_ == nullptr) {
+    toast_->Unpack(nullmap, stored, data, fields);
+    return;
+  }
+  if (toast_ == nullptr) {
+    dict_->Unpack(nullmap, stored, data);
+    return;
+  }
+  std::vector<char> coded(coded_schema_->GetRecordLength());
+  toast_->Unpack(nullmap, stored, coded.data(), fields);
+  dict_->Unpack(nullmap, coded.data(), data);
+}
+
+auto TableHandle::LockPageShared(page_id_t page_id) -> std::shared_lock<std::shared_mutex>
+{
+  if (storage_model_ == PAX_MODEL) {
+    return std::shared_lock<std::shared_mutex>{PAXLatchOf(page_id)};
+  }
+  if (storage_model_ != SLOTTED_MODEL) {
+    return {page_latch_, std::defer_lock};
+  }
+  return std::shared_lock<std::shared_mutex>{page_latch_};
+}
+
+auto TableHandle::FreezePage(PageHandle *page_handle) -> bool
+{
+  auto pax = dynamic_cast<PAXPageHandle *>(page_handle);
+  if (pax == nullptr) {
+    return false;
+  }
+  std::unique_lock<std::shared_mutex> pax_lock{PAXLatchOf(page_handle->GetPage()->GetPageId())};
+  return pax->Freeze();
+}
+
+auto TableHandle::HasFreeSlot(PageHandle *page_handle) -> bool
+{
+  if (auto pax = dynamic_cast<PAXPageHandle *>(page_handle); pax != nullptr) {
+    std::shared_lock<std::shared_mutex> pax_lock{PAXLatchOf(page_handle->GetPage()->GetPageId())};
+    return !pax->IsFull();
+  }
+  return RecordNumOf(page_handle->GetPage()).load() < tab_hdr_.rec_per_page_;
+}
+
 auto TableHandle::WrapPageHandle(Page *page) -> PageHandleUptr
 {
   switch (storage_model_) {
     case StorageModel::NARY_MODEL: return std::make_unique<NAryPageHandle>(&tab_hdr_, page);
-    case StorageModel::PAX_MODEL: return std::make_unique<PAXPageHandle>(&tab_hdr_, page, schema_.get(), field_offset_);
+    case StorageModel::PAX_MODEL:
+      return std::make_unique<PAXPageHandle>(&tab_hdr_, page, schema_.get(), toast_.get());
+    case StorageModel::SLOTTED_MODEL: return std::make_unique<SlottedPageHandle>(&tab_hdr_, page, schema_.get());
     default: WSDB_FETAL("Unknown storage model");
   }
 }
 
+auto TableHandle::CreateSlottedPageHandle(size_t body_size, slot_id_t &slot_id) -> PageHandleUptr
+{
+  while (true) {
+    auto page_handle = CreatePageHandle();
+    auto slotted     = dynamic_cast<SlottedPageHandle *>(page_handle.get());
+    slot_id          = slotted->FindFreeSlot();
+    if (slot_id != INVALID_SLOT_ID && slotted->CanWrite(slot_id, body_size)) {
+      return page_handle;
+    }
+    // pages filled up by updates stay in the list until an insert finds them full
+    auto &page = *page_handle->GetPage();
+    slotted->SetFull(true);
+    tab_hdr_.first_free_page_ = page.GetNextFreePageId();
+    page.SetNextFreePageId(INVALID_PAGE_ID);
+    buffer_pool_manager_->UnpinPage(table_id_, page.GetPageId(), true);
+  }
+}
+
+void TableHandle::ReleaseSlottedPage(SlottedPageHandle *page_handle)
+{
+  if (!page_handle->IsFull()) {
+    return;
+  }
+  auto slot_id = page_handle->FindFreeSlot();
+  if (slot_id == INVALID_SLOT_ID || !page_handle->CanWrite(slot_id, SlottedPageHandle::GetMaxBodySize(schema_.get()))) {
+    return;
+  }
+  auto &page = *page_handle->GetPage();
+  page_handle->SetFull(false);
+  page.SetNextFreePageId(tab_hdr_.first_free_page_);
+  tab_hdr_.first_free_page_ = page.GetPageId();
+}
+
+auto TableHandle::InsertSlottedRecord(const Record &record) -> RID
+{
+  slot_id_t slot_id;
+  auto      body_size   = SlottedPageHandle::GetBodySize(schema_.get(), record.GetData());
+  auto      page_handle = CreateSlottedPageHandle(body_size, slot_id);
+  auto     &page        = *page_handle->GetPage();
+  page_handle->WriteSlot(slot_id, record.GetNullMap(), record.GetData(), false);
+  BitMap::SetBit(page_handle->GetBitmap(), slot_id, true);
+  RecordNumOf(tab_hdr_).fetch_add(1);
+  page.SetRecordNum(page.GetRecordNum() + 1);
+  page_id_t page_id{page.GetPageId()};
+  buffer_pool_manager_->UnpinPage(table_id_, page_id, true);
+  return {page_id, slot_id};
+}
+
+void TableHandle::InsertSlottedRecord(const RID &rid, const Record &record)
+{
+  page_id_t      page_id{rid.PageID()};
+  slot_id_t      slot_id{rid.SlotID()};
+  PageHandleUptr page_handle{FetchPageHandle(page_id)};
+  auto           slotted = dynamic_cast<SlottedPageHandle *>(page_handle.get());
+  if (BitMap::GetBit(page_handle->GetBitmap(), slot_id)) {
+    buffer_pool_manager_->UnpinPage(table_id_, page_id, false);
+    WSDB_THROW(WSDB_RECORD_EXISTS, fmt::format("RID(SlotID:{},PageID:{})", slot_id, page_id));
+  }
+  // the slot may hold a moved body even if it is not marked in the bitmap
+  auto body_size = SlottedPageHandle::GetBodySize(schema_.get(), record.GetData());
+  if (!slotted->IsEmpty(slot_id) || !slotted->CanWrite(slot_id, body_size)) {
+    buffer_pool_manager_->UnpinPage(table_id_, page_id, false);
+    WSDB_THROW(WSDB_PAGE_FULL, fmt::format("RID(SlotID:{},PageID:{})", slot_id, page_id));
+  }
+  auto &page = *page_handle->GetPage();
+  page_handle->WriteSlot(slot_id, record.GetNullMap(), record.GetData(), false);
+  BitMap::SetBit(page_handle->GetBitmap(), slot_id, true);
+  RecordNumOf(tab_hdr_).fetch_add(1);
+  page.SetRecordNum(page.GetRecordNum() + 1);
+  buffer_pool_manager_->UnpinPage(table_id_, page_id, true);
+}
+
+auto TableHandle::InsertMovedRecord(const Record &record) -> RID
+{
+  slot_id_t slot_id;
+  auto      body_size   = SlottedPageHandle::GetBodySize(schema_.get(), record.GetData());
+  auto      page_handle = CreateSlottedPageHandle(body_size, slot_id);
+  page_id_t page_id{page_handle->GetPage()->GetPageId()};
+  page_handle->WriteSlot(slot_id, record.GetNullMap(), record.GetData(), false);
+  buffer_pool_manager_->UnpinPage(table_id_, page_id, true);
+  return {page_id, slot_id};
+}
+
+void TableHandle::DeleteSlottedRecord(const RID &rid)
+{
+  page_id_t      page_id{rid.PageID()};
+  slot_id_t      slot_id{rid.SlotID()};
+  PageHandleUptr page_handle{FetchPageHandle(page_id)};
+  auto           slotted = dynamic_cast<SlottedPageHandle *>(page_handle.get());
+  if (!BitMap::GetBit(page_handle->GetBitmap(), slot_id)) {
+    buffer_pool_manager_->UnpinPage(table_id_, page_id, false);
+    WSDB_THROW(WSDB_RECORD_MISS, fmt::format("RID(SlotID:{},PageID:{})", slot_id, page_id));
+  }
+  if (auto forward = slotted->GetForward(slot_id); forward != INVALID_RID) {
+    PageHandleUptr moved_handle{FetchPageHandle(forward.PageID())};
+    auto           moved = dynamic_cast<SlottedPageHandle *>(moved_handle.get());
+    moved->FreeSlot(forward.SlotID());
+    ReleaseSlottedPage(moved);
+    buffer_pool_manager_->UnpinPage(table_id_, forward.PageID(), true);
+  }
+  auto &page = *page_handle->GetPage();
+  slotted->FreeSlot(slot_id);
+  BitMap::SetBit(page_handle->GetBitmap(), slot_id, false);
+  RecordNumOf(tab_hdr_).fetch_sub(1);
+  page.SetRecordNum(page.GetRecordNum() - 1);
+  ReleaseSlottedPage(slotted);
+  buffer_pool_manager_->UnpinPage(table_id_, page_id, true);
+}
+
+void TableHandle::UpdateSlottedRecord(const RID &rid, const Record &record)
+{
+  page_id_t      page_id{rid.PageID()};
+  slot_id_t      slot_id{rid.SlotID()};
+  PageHandleUptr page_handle{FetchPageHandle(page_id)};
+  auto           slotted = dynamic_cast<SlottedPageHandle *>(page_handle.get());
+  if (!BitMap::GetBit(page_handle->GetBitmap(), slot_id)) {
+    buffer_pool_manager_->UnpinPage(table_id_, page_id, false);
+    WSDB_THROW(WSDB_RECORD_MISS, fmt::format("RID(SlotID:{},PageID:{})", slot_id, page_id));
+  }
+  auto body_size = SlottedPageHandle::GetBodySize(schema_.get(), record.GetData());
+  auto forward   = slotted->GetForward(slot_id);
+  if (slotted->CanWrite(slot_id, body_size)) {
+    // 1. write back to the home page, the moved body is no longer needed
+    if (forward != INVALID_RID) {
+      PageHandleUptr moved_handle{FetchPageHandle(forward.PageID())};
+      auto           moved = dynamic_cast<SlottedPageHandle *>(moved_handle.get());
+      moved->FreeSlot(forward.SlotID());
+      ReleaseSlottedPage(moved);
+      buffer_pool_manager_->UnpinPage(table_id_, forward.PageID(), true);
+    }
+    slotted->WriteSlot(slot_id, record.GetNullMap(), record.GetData(), true);
+    ReleaseSlottedPage(slotted);
+    buffer_pool_manager_->UnpinPage(table_id_, page_id, true);
+    return;
+  }
+  if (forward != INVALID_RID) {
+    // 2. update the moved body in place
+    PageHandleUptr moved_handle{FetchPageHandle(forward.PageID())};
+    auto           moved = dynamic_cast<SlottedPageHandle *>(moved_handle.get());
+    if (moved->CanWrite(forward.SlotID(), body_size)) {
+      moved->WriteSlot(forward.SlotID(), record.GetNullMap(), record.GetData(), true);
+      ReleaseSlottedPage(moved);
+      buffer_pool_manager_->UnpinPage(table_id_, forward.PageID(), true);
+      buffer_pool_manager_->UnpinPage(table_id_, page_id, false);
+      return;
+    }
+    moved->FreeSlot(forward.SlotID());
+    ReleaseSlottedPage(moved);
+    buffer_pool_manager_->UnpinPage(table_id_, forward.PageID(), true);
+  }
+  // 3. move the record, the home slot only keeps a forward so that moved records are never chained
+  slotted->SetForward(slot_id, InsertMovedRecord(record));
+  ReleaseSlottedPage(slotted);
+  buffer_pool_manager_->UnpinPage(table_id_, page_id, true);
+}
+
 auto TableHandle::GetTableId() const -> table_id_t { return table_id_; }
 
 auto TableHandle::GetTableHeader() const -> const TableHeader & { return tab_hdr_; }
@@ -216,10 +1053,37 @@ auto TableHandle::GetTableName() const -> std::string
 
 auto TableHandle::GetStorageModel() const -> StorageModel { return storage_model_; }
 
+auto TableHandle::MakeIterator(const ConditionVec *conds, const std::vector<size_t> *partitions,
+    PageMorsels *morsels, const std::vector<size_t> *fields) -> TableIteratorUptr
+{
+  return std::make_unique<TableIterator>(this, conds, partitions, morsels, fields);
+}
+
+auto TableHandle::GetZoneMap() -> ZoneMap & { return zone_map_; }
+
+auto TableHandle::GetToastFileId() const -> file_id_t
+{
+  return toast_ != nullptr ? toast_->GetFileId() : INVALID_FILE_ID;
+}
+
+auto TableHandle::GetDictFileId() const -> file_id_t { return dict_ != nullptr ? dict_->GetFileId() : INVALID_FILE_ID; }
+
 auto TableHandle::GetFirstRID() -> RID
 {
+  if (partition_scheme_ != nullptr) {
+    std::shared_lock<std::shared_mutex> vacuum_lock{vacuum_latch_};
+    for (size_t i = 0; i < partitions_.size(); ++i) {
+      if (auto rid = partitions_[i]->GetFirstRID(); rid != INVALID_RID) {
+        return PartitionRID(i, rid);
+      }
+    }
+    return INVALID_RID;
+  }
+  if (engine_ != nullptr) {
+    return engine_->GetFirstRID();
+  }
   auto page_id = FILE_HEADER_PAGE_ID + 1;
-  while (page_id < static_cast<page_id_t>(tab_hdr_.page_num_)) {
+  while (page_id < static_cast<page_id_t>(PageNumOf(tab_hdr_).load())) {
     auto pg_hdl = FetchPageHandle(page_id);
     auto id     = BitMap::FindFirst(pg_hdl->GetBitmap(), tab_hdr_.rec_per_page_, 0, true);
     if (id != tab_hdr_.rec_per_page_) {
@@ -234,9 +1098,22 @@ auto TableHandle::GetFirstRID() -> RID
 
 auto TableHandle::GetNextRID(const RID &rid) -> RID
 {
+  if (partition_scheme_ != nullptr) {
+    std::shared_lock<std::shared_mutex> vacuum_lock{vacuum_latch_};
+    auto [partition, partition_rid] = LocatePartition(rid);
+    auto i                          = static_cast<size_t>(rid.PageID()) >> PARTITION_PAGE_BITS;
+    auto next                       = partition->GetNextRID(partition_rid);
+    while (next == INVALID_RID && ++i < partitions_.size()) {
+      next = partitions_[i]->GetFirstRID();
+    }
+    return next == INVALID_RID ? INVALID_RID : PartitionRID(i, next);
+  }
+  if (engine_ != nullptr) {
+    return engine_->GetNextRID(rid);
+  }
   auto page_id = rid.PageID();
   auto slot_id = rid.SlotID();
-  while (page_id < static_cast<page_id_t>(tab_hdr_.page_num_)) {
+  while (page_id < static_cast<page_id_t>(PageNumOf(tab_hdr_).load())) {
     auto pg_hdl = FetchPageHandle(page_id);
     slot_id = static_cast<slot_id_t>(BitMap::FindFirst(pg_hdl->GetBitmap(), tab_hdr_.rec_per_page_, slot_id + 1, true));
     if (slot_id == static_cast<slot_id_t>(tab_hdr_.rec_per_page_)) {
@@ -256,4 +1133,27 @@ auto TableHandle::HasField(const std::string &field_name) const -> bool
   return schema_->HasField(table_id_, field_name);
 }
 
+auto TableHandle::LocatePartition(const RID &rid) const -> std::pair<TableHandle *, RID>
+{
+  auto partition = static_cast<size_t>(rid.PageID()) >> PARTITION_PAGE_BITS;
+  if (rid.PageID() < 0 || partition >= partitions_.size()) {
+    WSDB_THROW(WSDB_PAGE_MISS, fmt::format("Page: {}", rid.PageID()));
+  }
+  auto page_id = static_cast<page_id_t>(rid.PageID() & ((1 << PARTITION_PAGE_BITS) - 1));
+  return {partitions_[partition].get(), {page_id, rid.SlotID()}};
+}
+
+auto TableHandle::PartitionRID(size_t partition, const RID &rid) -> RID
+{
+  // a page id taking the partition bits would be read back as a page of another partition
+  if (static_cast<size_t>(rid.PageID()) >= (size_t{1} << PARTITION_PAGE_BITS)) {
+    WSDB_THROW(WSDB_UNSUPPORTED_OP,
+        fmt::format("page {} of partition {}, a partition has {} pages at most",
+            rid.PageID(),
+            partition,
+            size_t{1} << PARTITION_PAGE_BITS));
+  }
+  return {static_cast<page_id_t>(partition << PARTITION_PAGE_BITS | static_cast<size_t>(rid.PageID())), rid.SlotID()};
+}
+
 }  // namespace wsdb
@@ -21,25 +21,54 @@
 
 #ifndef WSDB_TABLE_HANDLE_H
 #define WSDB_TABLE_HANDLE_H
+#include <array>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <shared_mutex>
+#include <span>
 #include <utility>
 
 #include "../../../common/micro.h"
 #include "common/page.h"
 #include "storage/storage.h"
+#include "lsm_engine.h"
+#include "memory_engine.h"
 #include "page_handle.h"
+#include "partition.h"
+#include "slot_claims.h"
+#include "table_iterator.h"
+#include "dict_handle.h"
+#include "toast_handle.h"
+#include "zone_map.h"
 
 namespace wsdb {
 
 /**
  * Table descriptor in memory, including the column schema of the table
+ *
+ * The rows of a partitioned table are stored in its partitions, each of which is a table of its own file, the table
+ * file only keeps the header and the partition scheme. The partition of a row is kept in the page id of its rid above
+ * PARTITION_PAGE_BITS, so a rid tells the partition and the rid within it, and every method below routes to the
+ * partitions.
  */
 class TableHandle
 {
+  friend class TableIterator;
+
 public:
   TableHandle() = delete;
 
+  /**
+   * @param toast_file_id the toast file of the table, INVALID_FILE_ID if no field is stored out of line, see
+   * ToastHandle
+   * @param dict_file_id the dictionary file of the table, INVALID_FILE_ID if no field is dictionary encoded, see
+   * DictHandle
+   */
   TableHandle(DiskManager *disk_manager, BufferPoolManager *buffer_pool_manager, table_id_t table_id, TableHeader &hdr,
-      RecordSchemaUptr &schema, StorageModel storage_model);
+      RecordSchemaUptr &schema, StorageModel storage_model, file_id_t toast_file_id = INVALID_FILE_ID,
+      file_id_t dict_file_id = INVALID_FILE_ID);
 
   /**
    * Get a record by rid
@@ -61,19 +90,25 @@ public:
   auto GetChunk(page_id_t pid, const RecordSchema *chunk_schema) -> ChunkUptr;
 
   /**
-   * Insert a record into the table
-   * 1. create a page handle using CreatePageHandle
-   * 2. get an empty slot in the page
-   * 3. write the record into the slot
-   * 4. update the bitmap and the number of records in the page header
-   * 5. if the page is full after inserting the record, update the first free page id in the file header and set the
-   * next page id of the current page
-   * 6. unpin the page
+   * Insert a record into the table, threads can insert concurrently, see InsertRecords
    * @param record
    * @return rid of the inserted record
    */
   auto InsertRecord(const Record &record) -> RID;
 
+  /**
+   * Insert records into the table, threads can insert concurrently
+   * 1. pick the insert page of the calling thread, take one from the free page list or allocate a new page using
+   * AcquireInsertPage if there is none
+   * 2. claim empty slots in the page by setting their bits atomically and write the records into them until the page
+   * is full, the page is pinned once for all the records written to it
+   * 3. update the number of records in the page header and the table header
+   * 4. unpin the page, if there are records left, give up the page using ReleaseInsertPage and go back to 1
+   * @param records
+   * @return rids of the inserted records in the same order
+   */
+  auto InsertRecords(std::span<const Record> records) -> std::vector<RID>;
+
   /**
    * Insert a record into the table given rid
    * 1. if rid is invalid, unpin the page and throw WSDB_PAGE_MISS
@@ -88,8 +123,7 @@ public:
    * Delete the record by rid
    * 1. if the slot is empty, unpin the page and throw WSDB_RECORD_MISS
    * 2. update the bitmap and the number of records in the page header
-   * 3. if the page is not full after deleting the record, update the first free page id in the file header and the next
-   * page id in the page header
+   * 3. if the page was full and is not the insert page of any thread, put it back to the free page list
    * 4. unpin the page
    * @param rid
    */
@@ -105,6 +139,78 @@ public:
    */
   void UpdateRecord(const RID &rid, const Record &record);
 
+  /**
+   * Put the insert pages back to the free page list, call it before the table header is written to disk
+   */
+  void ReleaseInsertPages();
+
+  /**
+   * Run a step of VACUUM, reads and writes of the table wait for the step only, so a long vacuum is run as a series of
+   * steps. No record is moved while an iterator of the table is open, nor from a pinned last page
+   * 1. put the insert pages back to the free page list, and sort the list by page id
+   * 2. move the records of the last page into free slots of the lowest pages in the list, stop if there is none left
+   * 3. drop the emptied page from the buffer pool and the file, go back to 2 for up to page_num pages
+   * 4. rebuild the free page list in page order without the dropped pages
+   * @param page_num number of pages to empty in this step at most
+   * @param on_move called with the record at its old rid and the record at its new rid for each moved record
+   * @return true if the table may be compacted further by the next step
+   * @throw WSDB_UNSUPPORTED_OP if an iterator of the table is open, the step is not run
+   */
+  auto Vacuum(size_t page_num, const std::function<void(const Record &, const Record &)> &on_move) -> bool;
+
+  /**
+   * Get the minimum or maximum non-null value of a column without a full scan, used to answer MIN and MAX
+   * 1. order the pages by the lower (upper) bound of the column in the zone map, pages without a non-null value of
+   * the column are left out
+   * 2. read the records of the pages in that order, stop when the bound of the next page can not beat the best value
+   * @param field_idx index of the field in the schema
+   * @param is_max
+   * @return null value if the column has no non-null value, nullptr if the column has no zone or the storage model is
+   * slotted, whose records are not always stored in the page they are counted in
+   */
+  auto GetExtremum(size_t field_idx, bool is_max) -> ValueSptr;
+
+  /**
+   * Make the rows of a table not stored in pages durable before the table header is written, called when the table is
+   * closed, see StorageEngine::Snapshot. Nothing is done for tables stored in pages, the buffer pool flushes them
+   */
+  void Snapshot();
+
+  /// number of records in the table, kept up to date by inserts and deletes
+  [[nodiscard]] auto GetRecordNum() -> size_t;
+
+  /// number of pages of the table, of all partitions for a partitioned table
+  [[nodiscard]] auto GetPageNum() -> size_t;
+
+  /**
+   * Make the table a partitioned table, called by TableManager when the table is opened
+   * @param scheme
+   * @param partitions tables of the partitions in order
+   */
+  void SetPartitions(PartitionSchemeUptr scheme, std::vector<std::unique_ptr<TableHandle>> partitions);
+
+  /// @return nullptr if the table is not partitioned
+  [[nodiscard]] auto GetPartitionScheme() const -> const PartitionScheme *;
+
+  /// @return number of partitions, 0 if the table is not partitioned
+  [[nodiscard]] auto GetPartitionNum() const -> size_t;
+
+  /**
+   * Replace a partition, reads and writes of the table wait until it is done, throws WSDB_UNSUPPORTED_OP while an
+   * iterator of the table is open
+   * @param partition
+   * @param replace given the table of the partition, closes it and returns the table replacing it
+   */
+  void ReplacePartition(size_t partition,
+      const std::function<std::unique_ptr<TableHandle>(std::unique_ptr<TableHandle>)> &replace);
+
+  /**
+   * Get the table of a partition to close it along with the table
+   * @param partition
+   * @return the table of the partition
+   */
+  auto GetPartition(size_t partition) -> TableHandle *;
+
   [[nodiscard]] auto GetTableId() const -> table_id_t;
 
   [[nodiscard]] auto GetTableHeader() const -> const TableHeader &;
@@ -115,6 +221,26 @@ public:
 
   [[nodiscard]] auto GetStorageModel() const -> StorageModel;
 
+  /**
+   * Create an iterator positioned on the first record, prefer it to GetFirstRID/GetNextRID for sequential scans
+   * @param conds if given, pages that can not satisfy the conditions according to the zone map are skipped, records
+   * of the other pages are returned without being checked
+   * @param partitions if given, only these partitions of a partitioned table are read, see PartitionScheme::Prune
+   * @param morsels if given, only the runs of pages claimed from it are read, see ParallelScanExecutor
+   * @param fields if given, only these fields are read from the record views, long values of the others are not fetched
+   * @return
+   */
+  auto MakeIterator(const ConditionVec *conds = nullptr, const std::vector<size_t> *partitions = nullptr,
+      PageMorsels *morsels = nullptr, const std::vector<size_t> *fields = nullptr) -> TableIteratorUptr;
+
+  auto GetZoneMap() -> ZoneMap &;
+
+  /// @return the toast file of the table, INVALID_FILE_ID if no field is stored out of line
+  [[nodiscard]] auto GetToastFileId() const -> file_id_t;
+
+  /// @return the dictionary file of the table, INVALID_FILE_ID if no field is dictionary encoded
+  [[nodiscard]] auto GetDictFileId() const -> file_id_t;
+
   [[nodiscard]] auto GetFirstRID() -> RID;
 
   [[nodiscard]] auto GetNextRID(const RID &rid) -> RID;
@@ -141,6 +267,21 @@ private:
    */
   auto CreateNewPageHandle() -> PageHandleUptr;
 
+  /**
+   * Give the insert page an owned page, the page is popped from the free page list or newly allocated
+   * @param insert_page
+   * @return page id of the insert page, may be set by another thread sharing the insert page
+   */
+  auto AcquireInsertPage(std::atomic<page_id_t> &insert_page) -> page_id_t;
+
+  /**
+   * Give up an insert page that is found full, the page is marked full, or put back to the free page list if a
+   * record has been deleted from it in the meantime
+   * @param insert_page
+   * @param page
+   */
+  void ReleaseInsertPage(std::atomic<page_id_t> &insert_page, Page *page);
+
   /**
    * Wrap the page handle according to the storage model
    * @param page
@@ -148,6 +289,95 @@ private:
    */
   auto WrapPageHandle(Page *page) -> PageHandleUptr;
 
+  /**
+   * Read the record in the slot in the layout of the schema, values stored out of line are fetched
+   * @param page_handle
+   * @param slot_id
+   * @param[out] nullmap
+   * @param[out] data GetRecordLength() bytes of the schema, not the slot size of the table header
+   */
+  void ReadRecord(PageHandle *page_handle, size_t slot_id, char *nullmap, char *data);
+
+  /**
+   * Write the record to the slot, long values of toasted fields are moved out of line
+   * @param page_handle
+   * @param slot_id
+   * @param record
+   * @param update true if the slot holds a record, false if it is claimed and its bit is set after the write
+   */
+  void WriteRecord(PageHandle *page_handle, size_t slot_id, const Record &record, bool update);
+
+  /// @return whether slots hold rows in a layout other than the schema, i.e. with toast pointers or codes
+  [[nodiscard]] auto IsPacked() const -> bool { return IsToasted() || dict_ != nullptr; }
+
+  /// @return whether long values are moved out of line, the toast file of a pax table holds spilled rows instead
+  [[nodiscard]] auto IsToasted() const -> bool { return toast_ != nullptr && storage_model_ != PAX_MODEL; }
+
+  /// convert a row to the layout of the slots, codes are taken first, then long values are moved out of line
+  void PackRecord(const char *nullmap, const char *data, char *stored);
+
+  /// convert a row in the layout of the slots back to the schema, fields is passed on to ToastHandle::Unpack
+  void UnpackRecord(const char *nullmap, const char *stored, char *data, const char *fields = nullptr);
+
+  /// lock the page shared for reading its slots, the returned lock is not locked for models other than slotted and pax
+  auto LockPageShared(page_id_t page_id) -> std::shared_lock<std::shared_mutex>;
+
+  /// @return the latch of the stripe the pax page belongs to
+  auto PAXLatchOf(page_id_t page_id) -> std::shared_mutex & { return pax_latches_[page_id % TABLE_INSERT_PAGE_NUM]; }
+
+  /**
+   * Encode the rows of a pax page without free plain slots, so that the slots not in use can be written again
+   * @param page_handle
+   * @return false if the page is not a pax page or too few slots become writable, see PAXPageHandle::Freeze
+   */
+  auto FreezePage(PageHandle *page_handle) -> bool;
+
+  /// @return whether an insert may find a slot to write in the page, the page latch is held by the caller
+  auto HasFreeSlot(PageHandle *page_handle) -> bool;
+
+  /// methods below are used when the storage model is slotted, see SlottedPageHandle
+
+  /**
+   * Create a page handle that has a slot for a body of body_size bytes
+   * 1. take the first page in the free page list, or a new page if the list is empty
+   * 2. if the page can not take the body, mark it full, take it out of the list and go back to 1
+   * @param body_size
+   * @param[out] slot_id the slot to write the body
+   * @return
+   */
+  auto CreateSlottedPageHandle(size_t body_size, slot_id_t &slot_id) -> PageHandleUptr;
+
+  /// put the page back to the free page list if it is full but can hold a record of any length again
+  void ReleaseSlottedPage(SlottedPageHandle *page_handle);
+
+  auto InsertSlottedRecord(const Record &record) -> RID;
+
+  void InsertSlottedRecord(const RID &rid, const Record &record);
+
+  /// write a record that outgrows its home page to another page, the body is not visible to scans
+  auto InsertMovedRecord(const Record &record) -> RID;
+
+  void DeleteSlottedRecord(const RID &rid);
+
+  /**
+   * Update a record of a slotted page
+   * 1. if the home page can hold the new body, write it there and free the moved body if there is one
+   * 2. else if the record is moved and the page it is moved to can hold the new body, write it there
+   * 3. else move the record to another page and replace the home slot with a forward
+   * @param rid
+   * @param record
+   */
+  void UpdateSlottedRecord(const RID &rid, const Record &record);
+
+  /// methods below are used when the table is partitioned
+
+  /// @return the partition holding the rid and the rid within the partition
+  [[nodiscard]] auto LocatePartition(const RID &rid) const -> std::pair<TableHandle *, RID>;
+
+  /// @return rid of the table given the rid within the partition
+  /// @throw WSDB_UNSUPPORTED_OP if the page id of the rid does not fit in PARTITION_PAGE_BITS
+  [[nodiscard]] static auto PartitionRID(size_t partition, const RID &rid) -> RID;
+
 private:
   TableHeader      tab_hdr_;
   const table_id_t table_id_;  // 更改声明为 const
@@ -157,18 +387,45 @@ private:
 
   const RecordSchemaUptr schema_;         // 更改声明为 const
   const StorageModel     storage_model_;  // 更改声明为 const
+  // layout of records with dictionary encoded fields replaced by codes, see DictHandle
+  const RecordSchemaUptr coded_schema_;
+  // layout of records in the slots, wide string fields of the coded layout are replaced by toast pointers, see
+  // ToastHandle
+  const RecordSchemaUptr stored_schema_;
+  // nullptr if no field is stored out of line
+  ToastHandleUptr toast_;
+  // nullptr if no field is dictionary encoded
+  DictHandleUptr dict_;
+
+  // records are moved by Vacuum under it exclusively, reads and writes lock it shared, iterators register under it
+  std::shared_mutex vacuum_latch_;
+  // number of open iterators, no record is moved and no partition is replaced while any is open, as a record moved
+  // behind the position of a scan would be missed by it
+  std::atomic<size_t> scan_num_{0};
+  // protects the free page list and the allocation of new pages, slotted pages are modified under it exclusively as a
+  // whole and read under it shared, a write may compact the page under a reader otherwise
+  std::shared_mutex page_latch_;
+  // each inserting thread claims slots in the insert page chosen by its thread id
+  std::array<std::atomic<page_id_t>, TABLE_INSERT_PAGE_NUM> insert_pages_;
+  // slots taken by inserts whose records are not written yet, their bits are set after the records
+  SlotClaims slot_claims_;
+  // ranges of fixed-width columns of each page, updated after the page is written
+  ZoneMap zone_map_;
 
   /// field below is available when storage model is pax
-  // field offsets is the offset of each field stored in page
-  // pax model is stored like below, field_offset can be calculated by Record Schema
-  // | page header | bitmap |
-  // slot memery begins
-  // | nullmap_1, nullmap_2, ... , nullmap_n|
-  // | field_1_1, field_1_2, ... , field_1_n |
-  // | field_2_1, field_2_2, ... , field_2_n |
-  // ...
-  // | field_m_1, field_m_2, ... , field_m_n |
-  std::vector<size_t> field_offset_;
+  // pax pages are encoded as a whole under the latch of their stripe exclusively, their slots are written and read
+  // under it shared, see PAXLatchOf
+  std::array<std::shared_mutex, TABLE_INSERT_PAGE_NUM> pax_latches_;
+
+  /// field below is available when rows are not stored in pages, i.e. when storage model is lsm or memory
+  // nullptr if rows are stored in the pages of the table file
+  StorageEngineUptr engine_;
+
+  /// fields below are available when the table is partitioned, the storage model applies to the partitions
+  // nullptr if the table is not partitioned
+  PartitionSchemeUptr partition_scheme_;
+  // replaced by ReplacePartition under vacuum_latch_ exclusively, reads and writes of partitions lock it shared
+  std::vector<std::unique_ptr<TableHandle>> partitions_;
 };
 
 DEFINE_UNIQUE_PTR(TableHandle);
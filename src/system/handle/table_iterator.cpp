@@ -0,0 +1,260 @@
+/*------------------------------------------------------------------------------
+ - Copyright (c) 2024. Websoft research group, Nanjing University.
+ -
+ - This program is free software: you can redistribute it and/or modify
+ - it under the terms of the GNU General Public License as published by
+ - the Free Software Foundation, either version 3 of the License, or
+ - (at your option) any later version.
+ -
+ - This program is distributed in the hope that it will be useful,
+ - but WITHOUT ANY WARRANTY; without even the implied warranty of
+ - MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ - GNU General Public License for more details.
+ -
+ - You should have received a copy of the GNU General Public License
+ - along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ -----------------------------------------------------------------------------*/
+
+//
+// Created by ziqi on 2024/9/9.
+//
+
+#include "table_iterator.h"
+#include "table_handle.h"
+
+#include <numeric>
+
+namespace wsdb {
+
+TableIterator::TableIterator(TableHandle *tab, const ConditionVec *conds, const std::vector<size_t> *partitions,
+    PageMorsels *morsels, const std::vector<size_t> *fields)
+    : tab_(tab),
+      conds_(conds),
+      prefetch_page_id_(FILE_HEADER_PAGE_ID + 1),
+      morsels_(morsels),
+      nullmap_(tab->GetTableHeader().nullmap_size_),
+      data_(tab->GetSchema().GetRecordLength())
+{
+  {
+    // counted under the latch, so a step of Vacuum either sees the iterator or is over before it reads a page
+    std::shared_lock<std::shared_mutex> vacuum_lock{tab_->vacuum_latch_};
+    tab_->scan_num_.fetch_add(1);
+  }
+  if (fields != nullptr) {
+    fields_.resize(BITMAP_SIZE(tab_->GetSchema().GetFieldCount()));
+    for (auto field_idx : *fields) {
+      BitMap::SetBit(fields_.data(), field_idx, true);
+    }
+  }
+  WSDB_ASSERT(morsels_ == nullptr || (tab_->partition_scheme_ == nullptr && tab_->engine_ == nullptr),
+      "only tables stored in pages can be scanned in parallel");
+  if (tab_->partition_scheme_ != nullptr) {
+    if (partitions != nullptr) {
+      partitions_ = *partitions;
+    } else {
+      partitions_.resize(tab_->partitions_.size());
+      std::iota(partitions_.begin(), partitions_.end(), 0);
+    }
+    SeekPartition();
+    return;
+  }
+  if (tab_->engine_ != nullptr) {
+    engine_iter_ = tab_->engine_->MakeIterator();
+    return;
+  }
+  if (conds_ != nullptr && tab_->dict_ != nullptr) {
+    code_conds_ = tab_->dict_->BindConditions(*conds_, *tab_->stored_schema_);
+    if (DictHandle::MatchesNothing(code_conds_)) {
+      // a value compared by = or IN is in no dictionary, so in no row, nothing is read
+      return;
+    }
+  }
+  // the first run of a parallel scan is claimed by SeekPage as the current one is empty
+  morsel_end_ = morsels_ != nullptr ? FILE_HEADER_PAGE_ID + 1 : INVALID_PAGE_ID;
+  SeekPage(FILE_HEADER_PAGE_ID + 1);
+}
+
+TableIterator::~TableIterator()
+{
+  ReleaseCurrentPage();
+  tab_->scan_num_.fetch_sub(1);
+}
+
+void TableIterator::Next()
+{
+  WSDB_ASSERT(!IsEnd(), "TableIterator is end");
+  if (partition_iter_ != nullptr) {
+    partition_iter_->Next();
+    if (partition_iter_->IsEnd()) {
+      partition_pos_++;
+      SeekPartition();
+    }
+    return;
+  }
+  if (engine_iter_ != nullptr) {
+    engine_iter_->Next();
+    return;
+  }
+  auto &tab_hdr = tab_->GetTableHeader();
+  auto  slot_id = BitMap::FindFirst(slot_map_, tab_hdr.rec_per_page_, slot_id_ + 1, true);
+  if (slot_id != tab_hdr.rec_per_page_) {
+    slot_id_ = static_cast<slot_id_t>(slot_id);
+    return;
+  }
+  ReleaseCurrentPage();
+  SeekPage(page_id_ + 1);
+}
+
+auto TableIterator::IsEnd() const -> bool
+{
+  if (tab_->partition_scheme_ != nullptr) {
+    return partition_iter_ == nullptr;
+  }
+  return engine_iter_ != nullptr ? engine_iter_->IsEnd() : page_handle_ == nullptr;
+}
+
+auto TableIterator::GetRID() const -> RID
+{
+  if (partition_iter_ != nullptr) {
+    return partition_iter_->GetRID();
+  }
+  auto rid = engine_iter_ != nullptr ? engine_iter_->GetRID() : RID{page_id_, slot_id_};
+  return {rid.PageID() | partition_page_bits_, rid.SlotID()};
+}
+
+auto TableIterator::GetRecord() -> RecordUptr
+{
+  WSDB_ASSERT(!IsEnd(), "TableIterator is end");
+  if (partition_iter_ != nullptr) {
+    return partition_iter_->GetRecord();
+  }
+  if (engine_iter_ != nullptr) {
+    auto record = engine_iter_->GetRecord();
+    record->SetRID(GetRID());
+    return record;
+  }
+  auto page_lock = tab_->LockPageShared(page_id_);
+  if (page_handle_->GetForward(slot_id_) != INVALID_RID) {
+    // the record has been moved to another page of a slotted table, the table latches the pages on its own
+    page_lock.unlock();
+    auto record = tab_->GetRecord({page_id_, slot_id_});
+    record->SetRID(GetRID());
+    return record;
+  }
+  tab_->ReadRecord(page_handle_.get(), slot_id_, nullmap_.data(), data_.data());
+  return std::make_unique<Record>(&tab_->GetSchema(), nullmap_.data(), data_.data(), GetRID());
+}
+
+auto TableIterator::GetRecordView() -> RecordView
+{
+  WSDB_ASSERT(!IsEnd(), "TableIterator is end");
+  if (partition_iter_ != nullptr) {
+    return partition_iter_->GetRecordView();
+  }
+  const char *nullmap = nullptr;
+  const char *data    = nullptr;
+  if (page_handle_ != nullptr && page_handle_->ViewSlot(slot_id_, nullmap, data)) {
+    if (!tab_->IsPacked()) {
+      return {&tab_->GetSchema(), nullmap, data, GetRID(), guard_};
+    }
+    // a slot of a table with toasted or encoded fields holds toast pointers and codes, only the long values of the
+    // fields read are fetched when the row is restored
+    auto nullmap_size = nullmap_.size();
+    if (unpacked_ == nullptr || unpacked_.use_count() > 1) {
+      unpacked_ = std::make_shared_for_overwrite<char[]>(nullmap_size + data_.size());
+    }
+    memcpy(unpacked_.get(), nullmap, nullmap_size);
+    tab_->UnpackRecord(nullmap, data, unpacked_.get() + nullmap_size, fields_.empty() ? nullptr : fields_.data());
+    return {&tab_->GetSchema(), unpacked_.get(), unpacked_.get() + nullmap_size, GetRID(), unpacked_};
+  }
+  RecordSptr record = GetRecord();
+  return {&tab_->GetSchema(), record->GetNullMap(), record->GetData(), GetRID(), record};
+}
+
+void TableIterator::SeekPage(page_id_t page_id)
+{
+  auto &tab_hdr = tab_->GetTableHeader();
+  // a parallel scan reads up to the end of the current run of pages, then moves on to the next run it claims
+  auto page_num = morsels_ != nullptr ? morsel_end_ : static_cast<page_id_t>(tab_->GetPageNum());
+  for (;; page_num = morsel_end_) {
+    for (; page_id < page_num; ++page_id) {
+      if (conds_ != nullptr && tab_->zone_map_.CanSkip(page_id, *conds_)) {
+        continue;
+      }
+      if (page_id >= prefetch_page_id_) {
+        auto prefetch_num = std::min(SCAN_PREFETCH_PAGES, static_cast<size_t>(page_num - page_id));
+        tab_->disk_manager_->PrefetchPages(tab_->GetTableId(), page_id, prefetch_num);
+        prefetch_page_id_ = page_id + static_cast<page_id_t>(prefetch_num);
+      }
+      auto        guard       = std::make_shared<PageGuard>(tab_->buffer_pool_manager_, tab_->GetTableId(), page_id);
+      auto        page_handle = tab_->WrapPageHandle(guard->GetPage());
+      const char *slot_map    = page_handle->GetBitmap();
+      if (conds_ != nullptr) {
+        auto page_lock = tab_->LockPageShared(page_id);
+        if (page_handle->FilterSlots(*conds_, slots_)) {
+          slot_map = slots_.data();
+        }
+      }
+      if (!code_conds_.empty()) {
+        FilterCodes(page_handle.get(), slot_map);
+        slot_map = slots_.data();
+      }
+      auto slot_id = BitMap::FindFirst(slot_map, tab_hdr.rec_per_page_, 0, true);
+      if (slot_id != tab_hdr.rec_per_page_) {
+        guard_       = std::move(guard);
+        page_handle_ = std::move(page_handle);
+        slot_map_    = slot_map;
+        page_id_     = page_id;
+        slot_id_     = static_cast<slot_id_t>(slot_id);
+        return;
+      }
+    }
+    if (morsels_ == nullptr || !morsels_->Claim(page_id, morsel_end_)) {
+      break;
+    }
+  }
+  page_id_ = INVALID_PAGE_ID;
+  slot_id_ = INVALID_SLOT_ID;
+}
+
+void TableIterator::FilterCodes(PageHandle *page_handle, const char *slot_map)
+{
+  auto rec_per_page = tab_->GetTableHeader().rec_per_page_;
+  if (slot_map != slots_.data()) {
+    slots_.assign(slot_map, slot_map + tab_->GetTableHeader().bitmap_size_);
+  }
+  for (auto slot_id = BitMap::FindFirst(slots_.data(), rec_per_page, 0, true);
+       slot_id != rec_per_page;
+       slot_id = BitMap::FindFirst(slots_.data(), rec_per_page, slot_id + 1, true)) {
+    const char *nullmap = nullptr;
+    const char *stored  = nullptr;
+    // a slot that can not be viewed in place is kept, the conditions are evaluated on the decoded row anyway
+    if (page_handle->ViewSlot(slot_id, nullmap, stored) && !DictHandle::Match(code_conds_, nullmap, stored)) {
+      BitMap::SetBit(slots_.data(), slot_id, false);
+    }
+  }
+}
+
+void TableIterator::SeekPartition()
+{
+  partition_iter_ = nullptr;
+  for (; partition_pos_ < partitions_.size(); ++partition_pos_) {
+    auto partition = partitions_[partition_pos_];
+    auto iter      = std::make_unique<TableIterator>(tab_->partitions_[partition].get(), conds_);
+    if (!iter->IsEnd()) {
+      iter->partition_page_bits_ = static_cast<page_id_t>(partition << PARTITION_PAGE_BITS);
+      iter->fields_              = fields_;
+      partition_iter_            = std::move(iter);
+      return;
+    }
+  }
+}
+
+void TableIterator::ReleaseCurrentPage()
+{
+  // the page stays pinned while record views still share the guard
+  page_handle_ = nullptr;
+  guard_       = nullptr;
+}
+
+}  // namespace wsdb
@@ -0,0 +1,193 @@
+/*------------------------------------------------------------------------------
+ - Copyright (c) 2024. Websoft research group, Nanjing University.
+ -
+ - This program is free software: you can redistribute it and/or modify
+ - it under the terms of the GNU General Public License as published by
+ - the Free Software Foundation, either version 3 of the License, or
+ - (at your option) any later version.
+ -
+ - This program is distributed in the hope that it will be useful,
+ - but WITHOUT ANY WARRANTY; without even the implied warranty of
+ - MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ - GNU General Public License for more details.
+ -
+ - You should have received a copy of the GNU General Public License
+ - along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ -----------------------------------------------------------------------------*/
+
+//
+// Created by ziqi on 2024/9/9.
+//
+
+#ifndef WSDB_TABLE_ITERATOR_H
+#define WSDB_TABLE_ITERATOR_H
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+
+#include "common/condition.h"
+#include "dict_handle.h"
+#include "page_handle.h"
+#include "storage/buffer/page_guard.h"
+#include "storage_engine.h"
+
+namespace wsdb {
+
+class TableHandle;
+
+/**
+ * @brief Hand out runs of pages of a table to the iterators of a parallel scan, each page is handed out once.
+ */
+class PageMorsels
+{
+public:
+  /**
+   * @param begin first page to hand out
+   * @param end pages from end on are not handed out
+   * @param morsel_pages pages of each run
+   */
+  PageMorsels(page_id_t begin, page_id_t end, size_t morsel_pages)
+      : end_(end), morsel_pages_(static_cast<page_id_t>(morsel_pages)), next_(begin)
+  {}
+
+  DISABLE_COPY_MOVE_AND_ASSIGN(PageMorsels)
+
+  /**
+   * Claim the next run of pages, safe to call from any thread
+   * @param[out] begin
+   * @param[out] end
+   * @return false if all pages have been handed out
+   */
+  auto Claim(page_id_t &begin, page_id_t &end) -> bool
+  {
+    begin = next_.fetch_add(morsel_pages_);
+    if (begin >= end_) {
+      return false;
+    }
+    end = std::min(end_, begin + morsel_pages_);
+    return true;
+  }
+
+private:
+  const page_id_t        end_;
+  const page_id_t        morsel_pages_;
+  std::atomic<page_id_t> next_;
+};
+
+DEFINE_UNIQUE_PTR(PageMorsels);
+
+/**
+ * @brief Iterate over all records of a table page by page.
+ *
+ * The current page is pinned by a PageGuard until the iterator moves to the next page and no view into it is alive,
+ * occupied slots are found from the page bitmap directly, so a scan costs one FetchPage/UnpinPage per page instead of
+ * per record.
+ * Every SCAN_PREFETCH_PAGES pages, the following run of pages is prefetched from disk.
+ * Given conditions, pages whose zone map rules the conditions out are neither fetched nor prefetched, storage models
+ * that evaluate conditions on the page, e.g. PAX, only visit the slots that may satisfy them, the encoded rows of a PAX
+ * page are evaluated without being decoded. Equality conditions on dictionary encoded fields are evaluated on the
+ * codes in the slots, only matching rows are decoded.
+ * An open iterator is counted by the table, Vacuum moves no record while any is open, so no record is moved under it.
+ * Rows of tables not stored in pages, e.g. lsm and in-memory tables, are gone through with the iterator of their
+ * StorageEngine.
+ * A partitioned table is read partition by partition, each with an iterator of its own, partitions pruned by the
+ * planner are not opened at all.
+ * Iterators of a parallel scan share PageMorsels, each of them reads the runs of pages it claims instead of the whole
+ * table, which only works for tables stored in pages.
+ */
+class TableIterator
+{
+public:
+  TableIterator() = delete;
+
+  /**
+   * Position the iterator on the first record of the table
+   * @param tab
+   * @param conds if given, pages whose zone map can not satisfy the conditions are skipped without being fetched
+   * @param partitions if given, only these partitions of a partitioned table are read
+   * @param morsels if given, only the pages claimed from it are read, must outlive the iterator
+   * @param fields if given, only these fields are read from the views, the long values of other toasted fields are not
+   * fetched and the views hold their prefix only
+   */
+  explicit TableIterator(TableHandle *tab, const ConditionVec *conds = nullptr,
+      const std::vector<size_t> *partitions = nullptr, PageMorsels *morsels = nullptr,
+      const std::vector<size_t> *fields = nullptr);
+
+  ~TableIterator();
+
+  DISABLE_COPY_MOVE_AND_ASSIGN(TableIterator)
+
+  /// @return true if there is no record left
+  [[nodiscard]] auto IsEnd() const -> bool;
+
+  /// move to the next occupied slot, unpin the current page when it is exhausted
+  void Next();
+
+  [[nodiscard]] auto GetRID() const -> RID;
+
+  /// read the record in the current slot
+  [[nodiscard]] auto GetRecord() -> RecordUptr;
+
+  /**
+   * View the record in the current slot, the view shares the page guard so it stays valid after Next. The stored row of
+   * a table with toasted or encoded fields is restored into a buffer the view shares, storage models that can not view
+   * a slot in place fall back to a copy owned by the view
+   */
+  [[nodiscard]] auto GetRecordView() -> RecordView;
+
+private:
+  /**
+   * Find the first occupied slot starting from page_id, pages without records are unpinned immediately, the next run
+   * of pages is claimed when the current one is exhausted for a parallel scan
+   * @param page_id
+   */
+  void SeekPage(page_id_t page_id);
+
+  /// copy the slots of slot_map to slots_, leaving out those whose codes do not satisfy code_conds_
+  void FilterCodes(PageHandle *page_handle, const char *slot_map);
+
+  void ReleaseCurrentPage();
+
+  /// open the iterators of the partitions from partition_pos_ on until one of them has a record
+  void SeekPartition();
+
+private:
+  TableHandle *const        tab_;
+  const ConditionVec *const conds_;
+  PageGuardSptr             guard_;
+  PageHandleUptr            page_handle_;
+  page_id_t                 page_id_{INVALID_PAGE_ID};
+  slot_id_t                 slot_id_{INVALID_SLOT_ID};
+  // the slots visited in the current page, the page bitmap or the filtered slots_
+  const char       *slot_map_{nullptr};
+  std::vector<char> slots_;
+  // conditions evaluated on the codes of dictionary encoded fields, see DictHandle::BindConditions
+  std::vector<DictHandle::CodeCondition> code_conds_;
+  // the first page that is not prefetched yet
+  page_id_t prefetch_page_id_{INVALID_PAGE_ID};
+  // the runs of pages of a parallel scan, nullptr if the whole table is read, and the end of the current run
+  PageMorsels *const morsels_;
+  page_id_t          morsel_end_{INVALID_PAGE_ID};
+  // buffers reused by every GetRecord
+  std::vector<char> nullmap_;
+  std::vector<char> data_;
+  // bitmap of the fields read from the views, empty if all of them are, see ToastHandle::Unpack
+  std::vector<char> fields_;
+  // null map and data of the last restored row, a new one is allocated while a view still holds it
+  std::shared_ptr<char[]> unpacked_;
+  // rows of a table not stored in pages are read by the iterator of its engine, none of the fields above is used then
+  EngineIteratorUptr engine_iter_;
+  // rows of a partitioned table are read by the iterator of the current partition, none of the fields above is used
+  std::vector<size_t>            partitions_;
+  size_t                         partition_pos_{0};
+  std::unique_ptr<TableIterator> partition_iter_;
+  // the partition of the table the iterator is opened on, set in rids returned by GetRID
+  page_id_t partition_page_bits_{0};
+};
+
+DEFINE_UNIQUE_PTR(TableIterator);
+
+}  // namespace wsdb
+
+#endif  // WSDB_TABLE_ITERATOR_H
@@ -0,0 +1,256 @@
+/*------------------------------------------------------------------------------
+ - Copyright (c) 2024. Websoft research group, Nanjing University.
+ -
+ - This program is free software: you can redistribute it and/or modify
+ - it under the terms of the GNU General Public License as published by
+ - the Free Software Foundation, either version 3 of the License, or
+ - (at your option) any later version.
+ -
+ - This program is distributed in the hope that it will be useful,
+ - but WITHOUT ANY WARRANTY; without even the implied warranty of
+ - MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ - GNU General Public License for more details.
+ -
+ - You should have received a copy of the GNU General Public License
+ - along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ -----------------------------------------------------------------------------*/
+
+//
+// Created by ziqi on 2024/9/16.
+//
+
+#include "toast_handle.h"
+
+#include <cstring>
+
+#include "common/page.h"
+
+namespace wsdb {
+
+namespace {
+// | length (2) | page id (4) | offset (2) | prefix |
+constexpr size_t POINTER_LENGTH_OFFSET = 0;
+constexpr size_t POINTER_PAGE_OFFSET   = POINTER_LENGTH_OFFSET + sizeof(uint16_t);
+constexpr size_t POINTER_OFFSET_OFFSET = POINTER_PAGE_OFFSET + sizeof(page_id_t);
+constexpr size_t POINTER_PREFIX_OFFSET = POINTER_OFFSET_OFFSET + sizeof(uint16_t);
+constexpr size_t POINTER_SIZE          = POINTER_PREFIX_OFFSET + TOAST_PREFIX_SIZE;
+
+// header page, | page num (4) | first free page (4) |
+constexpr size_t HEADER_PAGE_NUM_OFFSET  = 0;
+constexpr size_t HEADER_FREE_PAGE_OFFSET = HEADER_PAGE_NUM_OFFSET + sizeof(page_id_t);
+
+// overflow page, | value num (2) | used bytes (2) | next free page (4) | values |
+constexpr size_t OVERFLOW_VALUE_NUM_OFFSET = 0;
+constexpr size_t OVERFLOW_USED_OFFSET      = OVERFLOW_VALUE_NUM_OFFSET + sizeof(uint16_t);
+constexpr size_t OVERFLOW_NEXT_FREE_OFFSET = OVERFLOW_USED_OFFSET + sizeof(uint16_t);
+constexpr size_t OVERFLOW_HEADER_SIZE      = OVERFLOW_NEXT_FREE_OFFSET + sizeof(page_id_t);
+
+/// a field of a page header, page data is aligned
+template <typename T>
+auto FieldOf(char *base, size_t offset) -> T &
+{
+  return *reinterpret_cast<T *>(base + offset);
+}
+
+/// fields of a toast pointer are not aligned in the row
+template <typename T>
+auto Load(const char *base, size_t offset) -> T
+{
+  T value;
+  memcpy(&value, base + offset, sizeof(T));
+  return value;
+}
+
+template <typename T>
+void Store(char *base, size_t offset, T value)
+{
+  memcpy(base + offset, &value, sizeof(T));
+}
+}  // namespace
+
+ToastHandle::ToastHandle(BufferPoolManager *buffer_pool_manager, file_id_t fid, const RecordSchema *schema,
+    const RecordSchema *stored_schema)
+    : buffer_pool_manager_(buffer_pool_manager), fid_(fid), schema_(schema), stored_schema_(stored_schema)
+{
+  for (size_t i = 0; i < schema_->GetFieldCount(); ++i) {
+    if (schema_->GetFieldAt(i).field_.field_size_ != stored_schema_->GetFieldAt(i).field_.field_size_) {
+      toasted_.push_back(i);
+    }
+  }
+}
+
+auto ToastHandle::IsToasted(const FieldSchema &field, StorageModel storage_model) -> bool
+{
+  // pax and slotted pages have layouts of their own, slotted pages already store strings at their actual length
+  return storage_model == NARY_MODEL && field.field_type_ == TYPE_STRING && field.field_size_ > TOAST_THRESHOLD;
+}
+
+auto ToastHandle::MakeStoredSchema(const RecordSchema &schema, StorageModel storage_model) -> RecordSchemaUptr
+{
+  std::vector<RTField> fields = schema.GetFields();
+  for (auto &field : fields) {
+    if (IsToasted(field.field_, storage_model)) {
+      field.field_.field_size_ = POINTER_SIZE;
+    }
+  }
+  return std::make_unique<RecordSchema>(fields);
+}
+
+auto ToastHandle::GetMaxFieldSize() -> size_t { return TOAST_PREFIX_SIZE + GetMaxValueSize(); }
+
+auto ToastHandle::GetMaxValueSize() -> size_t { return PAGE_SIZE - OVERFLOW_HEADER_SIZE; }
+
+void ToastHandle::InitFile(DiskManager *disk_manager, file_id_t fid)
+{
+  std::vector<char> header(PAGE_SIZE, 0);
+  Store<page_id_t>(header.data(), HEADER_PAGE_NUM_OFFSET, FILE_HEADER_PAGE_ID + 1);
+  Store<page_id_t>(header.data(), HEADER_FREE_PAGE_OFFSET, INVALID_PAGE_ID);
+  disk_manager->WritePage(fid, FILE_HEADER_PAGE_ID, header.data());
+}
+
+void ToastHandle::Pack(const char *nullmap, const char *data, char *stored)
+{
+  size_t field_idx = 0;
+  for (auto toasted : toasted_) {
+    // fields between toasted ones are copied as they are
+    for (; field_idx < toasted; ++field_idx) {
+      memcpy(stored + stored_schema_->GetFieldOffset(field_idx),
+          data + schema_->GetFieldOffset(field_idx),
+          schema_->GetFieldAt(field_idx).field_.field_size_);
+    }
+    field_idx++;
+    char *pointer = stored + stored_schema_->GetFieldOffset(toasted);
+    memset(pointer, 0, POINTER_SIZE);
+    Store<page_id_t>(pointer, POINTER_PAGE_OFFSET, INVALID_PAGE_ID);
+    if (BitMap::GetBit(nullmap, toasted)) {
+      continue;
+    }
+    const char *value = data + schema_->GetFieldOffset(toasted);
+    auto        len   = strnlen(value, schema_->GetFieldAt(toasted).field_.field_size_);
+    Store<uint16_t>(pointer, POINTER_LENGTH_OFFSET, static_cast<uint16_t>(len));
+    memcpy(pointer + POINTER_PREFIX_OFFSET, value, std::min(len, TOAST_PREFIX_SIZE));
+    if (len > TOAST_PREFIX_SIZE) {
+      page_id_t page_id;
+      uint16_t  offset;
+      Put(value + TOAST_PREFIX_SIZE, len - TOAST_PREFIX_SIZE, page_id, offset);
+      Store<page_id_t>(pointer, POINTER_PAGE_OFFSET, page_id);
+      Store<uint16_t>(pointer, POINTER_OFFSET_OFFSET, offset);
+    }
+  }
+  for (; field_idx < schema_->GetFieldCount(); ++field_idx) {
+    memcpy(stored + stored_schema_->GetFieldOffset(field_idx),
+        data + schema_->GetFieldOffset(field_idx),
+        schema_->GetFieldAt(field_idx).field_.field_size_);
+  }
+}
+
+void ToastHandle::Unpack(const char *nullmap, const char *stored, char *data, const char *fields)
+{
+  size_t field_idx = 0;
+  for (auto toasted : toasted_) {
+    for (; field_idx < toasted; ++field_idx) {
+      memcpy(data + schema_->GetFieldOffset(field_idx),
+          stored + stored_schema_->GetFieldOffset(field_idx),
+          schema_->GetFieldAt(field_idx).field_.field_size_);
+    }
+    field_idx++;
+    char *value = data + schema_->GetFieldOffset(toasted);
+    memset(value, 0, schema_->GetFieldAt(toasted).field_.field_size_);
+    if (BitMap::GetBit(nullmap, toasted)) {
+      continue;
+    }
+    const char *pointer = stored + stored_schema_->GetFieldOffset(toasted);
+    size_t      len     = Load<uint16_t>(pointer, POINTER_LENGTH_OFFSET);
+    memcpy(value, pointer + POINTER_PREFIX_OFFSET, std::min(len, TOAST_PREFIX_SIZE));
+    if (len > TOAST_PREFIX_SIZE && (fields == nullptr || BitMap::GetBit(fields, toasted))) {
+      Get(Load<page_id_t>(pointer, POINTER_PAGE_OFFSET),
+          Load<uint16_t>(pointer, POINTER_OFFSET_OFFSET),
+          value + TOAST_PREFIX_SIZE,
+          len - TOAST_PREFIX_SIZE);
+    }
+  }
+  for (; field_idx < schema_->GetFieldCount(); ++field_idx) {
+    memcpy(data + schema_->GetFieldOffset(field_idx),
+        stored + stored_schema_->GetFieldOffset(field_idx),
+        schema_->GetFieldAt(field_idx).field_.field_size_);
+  }
+}
+
+void ToastHandle::Free(const char *nullmap, const char *stored)
+{
+  for (auto toasted : toasted_) {
+    const char *pointer = stored + stored_schema_->GetFieldOffset(toasted);
+    if (!BitMap::GetBit(nullmap, toasted) && Load<uint16_t>(pointer, POINTER_LENGTH_OFFSET) > TOAST_PREFIX_SIZE) {
+      Release(Load<page_id_t>(pointer, POINTER_PAGE_OFFSET));
+    }
+  }
+}
+
+void ToastHandle::Put(const char *src, size_t len, page_id_t &page_id, uint16_t &offset)
+{
+  std::lock_guard<std::mutex> lock{latch_};
+  Page                       *page = nullptr;
+  if (tail_page_ != INVALID_PAGE_ID) {
+    page = buffer_pool_manager_->FetchPage(fid_, tail_page_);
+    if (FieldOf<uint16_t>(page->GetData(), OVERFLOW_USED_OFFSET) + len > PAGE_SIZE - OVERFLOW_HEADER_SIZE) {
+      // the page goes to the free list once its values are all freed, see Release
+      buffer_pool_manager_->UnpinPage(fid_, tail_page_, false);
+      page       = nullptr;
+      tail_page_ = INVALID_PAGE_ID;
+    }
+  }
+  if (page == nullptr) {
+    // 1. take a page from the free list, or append a new one to the file
+    auto  header    = buffer_pool_manager_->FetchPage(fid_, FILE_HEADER_PAGE_ID);
+    auto &free_page = FieldOf<page_id_t>(header->GetData(), HEADER_FREE_PAGE_OFFSET);
+    if (free_page != INVALID_PAGE_ID) {
+      tail_page_ = free_page;
+      page       = buffer_pool_manager_->FetchPage(fid_, tail_page_);
+      free_page  = FieldOf<page_id_t>(page->GetData(), OVERFLOW_NEXT_FREE_OFFSET);
+    } else {
+      tail_page_ = FieldOf<page_id_t>(header->GetData(), HEADER_PAGE_NUM_OFFSET)++;
+      page       = buffer_pool_manager_->FetchPage(fid_, tail_page_);
+    }
+    buffer_pool_manager_->UnpinPage(fid_, FILE_HEADER_PAGE_ID, true);
+    // 2. the page holds no value
+    FieldOf<uint16_t>(page->GetData(), OVERFLOW_VALUE_NUM_OFFSET)  = 0;
+    FieldOf<uint16_t>(page->GetData(), OVERFLOW_USED_OFFSET)       = 0;
+    FieldOf<page_id_t>(page->GetData(), OVERFLOW_NEXT_FREE_OFFSET) = INVALID_PAGE_ID;
+  }
+  auto &used = FieldOf<uint16_t>(page->GetData(), OVERFLOW_USED_OFFSET);
+  memcpy(page->GetData() + OVERFLOW_HEADER_SIZE + used, src, len);
+  page_id = tail_page_;
+  offset  = used;
+  used += static_cast<uint16_t>(len);
+  FieldOf<uint16_t>(page->GetData(), OVERFLOW_VALUE_NUM_OFFSET)++;
+  buffer_pool_manager_->UnpinPage(fid_, tail_page_, true);
+}
+
+void ToastHandle::Get(page_id_t page_id, uint16_t offset, char *dst, size_t len)
+{
+  // values are not moved once written, the header and the tail may change concurrently but not the bytes read here
+  auto page = buffer_pool_manager_->FetchPage(fid_, page_id);
+  memcpy(dst, page->GetData() + OVERFLOW_HEADER_SIZE + offset, len);
+  buffer_pool_manager_->UnpinPage(fid_, page_id, false);
+}
+
+void ToastHandle::Release(page_id_t page_id)
+{
+  std::lock_guard<std::mutex> lock{latch_};
+  auto                        page = buffer_pool_manager_->FetchPage(fid_, page_id);
+  if (--FieldOf<uint16_t>(page->GetData(), OVERFLOW_VALUE_NUM_OFFSET) == 0) {
+    if (page_id == tail_page_) {
+      // the tail is refilled from the start
+      FieldOf<uint16_t>(page->GetData(), OVERFLOW_USED_OFFSET) = 0;
+    } else {
+      auto  header    = buffer_pool_manager_->FetchPage(fid_, FILE_HEADER_PAGE_ID);
+      auto &free_page = FieldOf<page_id_t>(header->GetData(), HEADER_FREE_PAGE_OFFSET);
+      FieldOf<page_id_t>(page->GetData(), OVERFLOW_NEXT_FREE_OFFSET) = free_page;
+      free_page                                                      = page_id;
+      buffer_pool_manager_->UnpinPage(fid_, FILE_HEADER_PAGE_ID, true);
+    }
+  }
+  buffer_pool_manager_->UnpinPage(fid_, page_id, true);
+}
+
+}  // namespace wsdb
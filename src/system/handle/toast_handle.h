@@ -0,0 +1,118 @@
+/*------------------------------------------------------------------------------
+ - Copyright (c) 2024. Websoft research group, Nanjing University.
+ -
+ - This program is free software: you can redistribute it and/or modify
+ - it under the terms of the GNU General Public License as published by
+ - the Free Software Foundation, either version 3 of the License, or
+ - (at your option) any later version.
+ -
+ - This program is distributed in the hope that it will be useful,
+ - but WITHOUT ANY WARRANTY; without even the implied warranty of
+ - MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ - GNU General Public License for more details.
+ -
+ - You should have received a copy of the GNU General Public License
+ - along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ -----------------------------------------------------------------------------*/
+
+//
+// Created by ziqi on 2024/9/16.
+//
+
+#ifndef WSDB_TOAST_HANDLE_H
+#define WSDB_TOAST_HANDLE_H
+
+#include <mutex>  // NOLINT
+
+#include "common/meta.h"
+#include "storage/storage.h"
+#include "record_handle.h"
+
+namespace wsdb {
+
+/**
+ * @brief Out-of-line storage of wide string fields of a row table, in the spirit of TOAST.
+ *
+ * A string field declared wider than TOAST_THRESHOLD takes a toast pointer in the stored row
+ * | length (2) | page id (4) | offset (2) | prefix (TOAST_PREFIX_SIZE) |, a value no longer than the prefix stays in
+ * the row entirely, the rest of a longer value is appended to an overflow page of the toast file of the table.
+ * Rows are narrow, so a page holds more of them and scans read fewer pages.
+ *
+ * toast file: | header page: page num (4) | first free page (4) | overflow pages ... |
+ * overflow page: | value num (2) | used bytes (2) | next free page (4) | values back to back |
+ * The space of a freed value is reclaimed when all values of its page are freed, the page goes to the free list then.
+ * PAX tables have no toasted field, their toast file holds the rows spilled from encoded pages, see PAXPageHandle.
+ */
+class ToastHandle
+{
+public:
+  ToastHandle(BufferPoolManager *buffer_pool_manager, file_id_t fid, const RecordSchema *schema,
+      const RecordSchema *stored_schema);
+
+  DISABLE_COPY_MOVE_AND_ASSIGN(ToastHandle)
+
+  /// @return whether the field is stored out of line under the storage model
+  static auto IsToasted(const FieldSchema &field, StorageModel storage_model) -> bool;
+
+  /// @return the schema of rows as they are stored in pages, toasted fields are replaced by toast pointers
+  static auto MakeStoredSchema(const RecordSchema &schema, StorageModel storage_model) -> RecordSchemaUptr;
+
+  /// @return the widest string field that can be toasted, the rest of its value must fit in an overflow page
+  static auto GetMaxFieldSize() -> size_t;
+
+  /// @return the most bytes Put takes at a time
+  static auto GetMaxValueSize() -> size_t;
+
+  /// write the header page of a new toast file
+  static void InitFile(DiskManager *disk_manager, file_id_t fid);
+
+  /**
+   * Convert a row to the stored layout, the rest of each long value is appended to an overflow page
+   * @param nullmap
+   * @param data row in the layout of the schema
+   * @param[out] stored row in the layout of the stored schema
+   */
+  void Pack(const char *nullmap, const char *data, char *stored);
+
+  /**
+   * Restore a stored row, the rest of each long value is read from its overflow page
+   * @param nullmap
+   * @param stored row in the layout of the stored schema
+   * @param[out] data row in the layout of the schema
+   * @param fields bitmap of the fields the caller reads, if given, the long values of other fields are not read and
+   * only their prefix is restored
+   */
+  void Unpack(const char *nullmap, const char *stored, char *data, const char *fields = nullptr);
+
+  /// free the out-of-line values of a stored row, called when the row is deleted or overwritten
+  void Free(const char *nullmap, const char *stored);
+
+  /// append bytes to the tail overflow page, a new tail is taken from the free list or allocated if it is full
+  void Put(const char *src, size_t len, page_id_t &page_id, uint16_t &offset);
+
+  void Get(page_id_t page_id, uint16_t offset, char *dst, size_t len);
+
+  /// a value of the page is freed, the page goes to the free list if it holds no value any more
+  void Release(page_id_t page_id);
+
+  [[nodiscard]] auto GetFileId() const -> file_id_t { return fid_; }
+
+private:
+  BufferPoolManager *const buffer_pool_manager_;
+  const file_id_t          fid_;
+  const RecordSchema      *schema_;
+  const RecordSchema      *stored_schema_;
+  // index of toasted fields in the schema
+  std::vector<size_t> toasted_;
+
+  // protects the header page and the tail page
+  std::mutex latch_;
+  // the overflow page values are appended to, not kept across close and open
+  page_id_t tail_page_{INVALID_PAGE_ID};
+};
+
+DEFINE_UNIQUE_PTR(ToastHandle);
+
+}  // namespace wsdb
+
+#endif  // WSDB_TOAST_HANDLE_H
@@ -0,0 +1,294 @@
+/*------------------------------------------------------------------------------
+ - Copyright (c) 2024. Websoft research group, Nanjing University.
+ -
+ - This program is free software: you can redistribute it and/or modify
+ - it under the terms of the GNU General Public License as published by
+ - the Free Software Foundation, either version 3 of the License, or
+ - (at your option) any later version.
+ -
+ - This program is distributed in the hope that it will be useful,
+ - but WITHOUT ANY WARRANTY; without even the implied warranty of
+ - MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ - GNU General Public License for more details.
+ -
+ - You should have received a copy of the GNU General Public License
+ - along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ -----------------------------------------------------------------------------*/
+
+//
+// Created by ziqi on 2024/9/13.
+//
+
+#include "zone_map.h"
+
+#include <limits>
+#include <mutex>  // NOLINT
+
+namespace wsdb {
+
+namespace {
+/// the value of a fixed-width field as a double, int32 and float values are exact
+auto ReadNumber(FieldType type, const char *data) -> double
+{
+  switch (type) {
+    case TYPE_INT: return *reinterpret_cast<const int32_t *>(data);
+    case TYPE_FLOAT: return *reinterpret_cast<const float *>(data);
+    case TYPE_BOOL: return *reinterpret_cast<const bool *>(data) ? 1 : 0;
+    default: WSDB_FETAL("field without zone");
+  }
+}
+
+template <typename T>
+void Append(std::vector<char> &buf, const T &value)
+{
+  buf.insert(buf.end(), reinterpret_cast<const char *>(&value), reinterpret_cast<const char *>(&value) + sizeof(T));
+}
+
+template <typename T>
+auto Extract(const char *&cursor) -> T
+{
+  T value;
+  memcpy(&value, cursor, sizeof(T));
+  cursor += sizeof(T);
+  return value;
+}
+}  // namespace
+
+ZoneMap::ZoneMap(const RecordSchema *schema) : schema_(schema)
+{
+  for (size_t i = 0; i < schema_->GetFieldCount(); ++i) {
+    auto type = schema_->GetFieldAt(i).field_.field_type_;
+    if (type == TYPE_INT || type == TYPE_FLOAT || type == TYPE_BOOL) {
+      field_idx_.push_back(i);
+    }
+  }
+  col_idx_.assign(schema_->GetFieldCount(), field_idx_.size());
+  for (size_t j = 0; j < field_idx_.size(); ++j) {
+    col_idx_[field_idx_[j]] = j;
+  }
+}
+
+void ZoneMap::Insert(page_id_t page_id, std::span<const Record> records)
+{
+  std::unique_lock<std::shared_mutex> lock{latch_};
+  Reserve(page_id);
+  if (!pages_[page_id].known_) {
+    return;
+  }
+  pages_[page_id].rec_num_ += static_cast<uint32_t>(records.size());
+  for (const auto &record : records) {
+    Widen(page_id, record.GetNullMap(), record.GetData());
+  }
+}
+
+void ZoneMap::Update(page_id_t page_id, const Record &record)
+{
+  std::unique_lock<std::shared_mutex> lock{latch_};
+  Reserve(page_id);
+  if (pages_[page_id].known_) {
+    Widen(page_id, record.GetNullMap(), record.GetData());
+  }
+}
+
+void ZoneMap::Delete(page_id_t page_id)
+{
+  std::unique_lock<std::shared_mutex> lock{latch_};
+  if (static_cast<size_t>(page_id) >= pages_.size() || !pages_[page_id].known_) {
+    return;
+  }
+  auto &page = pages_[page_id];
+  if (page.rec_num_ > 0 && --page.rec_num_ == 0) {
+    ResetPage(page_id);
+  }
+}
+
+auto ZoneMap::CanSkip(page_id_t page_id, const ConditionVec &conds) const -> bool
+{
+  std::shared_lock<std::shared_mutex> lock{latch_};
+  // pages allocated by inserts that have not reached the zone map yet
+  if (static_cast<size_t>(page_id) >= pages_.size() || !pages_[page_id].known_) {
+    return false;
+  }
+  if (pages_[page_id].rec_num_ == 0) {
+    return true;
+  }
+  for (const auto &cond : conds) {
+    if (cond.GetRhsType() != kValue) {
+      continue;
+    }
+    auto field_idx = schema_->GetRTFieldIndex(cond.GetLCol());
+    if (field_idx == schema_->GetFieldCount() || col_idx_[field_idx] == field_idx_.size()) {
+      continue;
+    }
+    auto col_idx = col_idx_[field_idx];
+    if (CanSkip(columns_[page_id * field_idx_.size() + col_idx], col_idx, cond)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+auto ZoneMap::CanSkip(const ColumnZone &zone, size_t col_idx, const Condition &cond) const -> bool
+{
+  auto rhs = cond.GetRVal();
+  if (rhs == nullptr || rhs->IsNull()) {
+    return false;
+  }
+  auto   type = schema_->GetFieldAt(field_idx_[col_idx]).field_.field_type_;
+  double val;
+  switch (rhs->GetType()) {
+    case TYPE_INT: val = std::dynamic_pointer_cast<IntValue>(rhs)->Get(); break;
+    case TYPE_FLOAT: val = std::dynamic_pointer_cast<FloatValue>(rhs)->Get(); break;
+    case TYPE_BOOL: val = std::dynamic_pointer_cast<BoolValue>(rhs)->Get() ? 1 : 0; break;
+    default: return false;
+  }
+  double lo = zone.min_;
+  double hi = zone.max_;
+  if (type != rhs->GetType()) {
+    // int and float are compared as float, see ValueFactory::AlignTypes, other combinations fail in evaluation
+    if ((type != TYPE_INT && type != TYPE_FLOAT) || (rhs->GetType() != TYPE_INT && rhs->GetType() != TYPE_FLOAT)) {
+      return false;
+    }
+    lo  = static_cast<float>(lo);
+    hi  = static_cast<float>(hi);
+    val = static_cast<float>(val);
+  }
+  // null satisfies none of the comparisons except !=
+  bool no_value = zone.min_ > zone.max_;
+  switch (cond.GetOp()) {
+    case OP_EQ: return no_value || val < lo || val > hi;
+    case OP_NE: return zone.null_num_ == 0 && (no_value || (lo == hi && lo == val));
+    case OP_LT: return no_value || lo >= val;
+    case OP_LE: return no_value || lo > val;
+    case OP_GT: return no_value || hi <= val;
+    case OP_GE: return no_value || hi < val;
+    default: return false;
+  }
+}
+
+auto ZoneMap::GetBounds(
+    size_t field_idx, size_t page_num, bool is_max, std::vector<std::pair<double, page_id_t>> &bounds) const -> bool
+{
+  if (!HasZone(field_idx)) {
+    return false;
+  }
+  auto                                col_idx  = col_idx_[field_idx];
+  auto                                infinity = std::numeric_limits<double>::infinity();
+  std::shared_lock<std::shared_mutex> lock{latch_};
+  for (auto page_id = static_cast<page_id_t>(FILE_HEADER_PAGE_ID + 1); page_id < static_cast<page_id_t>(page_num);
+       ++page_id) {
+    if (static_cast<size_t>(page_id) >= pages_.size() || !pages_[page_id].known_) {
+      bounds.emplace_back(is_max ? infinity : -infinity, page_id);
+      continue;
+    }
+    const auto &zone = columns_[page_id * field_idx_.size() + col_idx];
+    if (pages_[page_id].rec_num_ == 0 || zone.min_ > zone.max_) {
+      continue;
+    }
+    bounds.emplace_back(is_max ? zone.max_ : zone.min_, page_id);
+  }
+  return true;
+}
+
+void ZoneMap::Invalidate(size_t page_num)
+{
+  std::unique_lock<std::shared_mutex> lock{latch_};
+  if (page_num == 0) {
+    return;
+  }
+  Reserve(static_cast<page_id_t>(page_num - 1));
+  for (size_t i = 0; i < page_num; ++i) {
+    pages_[i].known_ = false;
+  }
+}
+
+auto ZoneMap::Serialize(size_t page_num) const -> std::vector<char>
+{
+  std::shared_lock<std::shared_mutex> lock{latch_};
+  std::vector<char>                   buf;
+  Append<uint64_t>(buf, page_num);
+  Append<uint64_t>(buf, field_idx_.size());
+  for (size_t i = 0; i < page_num; ++i) {
+    // pages without entry never received a record
+    bool     known   = i >= pages_.size() || pages_[i].known_;
+    uint32_t rec_num = i < pages_.size() ? pages_[i].rec_num_ : 0;
+    Append<uint8_t>(buf, known);
+    Append<uint32_t>(buf, rec_num);
+    for (size_t j = 0; j < field_idx_.size(); ++j) {
+      auto zone = i < pages_.size() ? columns_[i * field_idx_.size() + j]
+                                    : ColumnZone{std::numeric_limits<double>::infinity(),
+                                          -std::numeric_limits<double>::infinity(),
+                                          0};
+      Append<double>(buf, zone.min_);
+      Append<double>(buf, zone.max_);
+      Append<uint32_t>(buf, zone.null_num_);
+    }
+  }
+  return buf;
+}
+
+auto ZoneMap::Deserialize(const std::vector<char> &data, size_t page_num) -> bool
+{
+  size_t col_size  = sizeof(double) * 2 + sizeof(uint32_t);
+  size_t page_size = sizeof(uint8_t) + sizeof(uint32_t) + col_size * field_idx_.size();
+  if (data.size() != sizeof(uint64_t) * 2 + page_size * page_num) {
+    return false;
+  }
+  const char *cursor = data.data();
+  if (Extract<uint64_t>(cursor) != page_num || Extract<uint64_t>(cursor) != field_idx_.size()) {
+    return false;
+  }
+  std::unique_lock<std::shared_mutex> lock{latch_};
+  pages_.resize(page_num);
+  columns_.resize(page_num * field_idx_.size());
+  for (size_t i = 0; i < page_num; ++i) {
+    pages_[i].known_   = Extract<uint8_t>(cursor) != 0;
+    pages_[i].rec_num_ = Extract<uint32_t>(cursor);
+    for (size_t j = 0; j < field_idx_.size(); ++j) {
+      auto &zone     = columns_[i * field_idx_.size() + j];
+      zone.min_      = Extract<double>(cursor);
+      zone.max_      = Extract<double>(cursor);
+      zone.null_num_ = Extract<uint32_t>(cursor);
+    }
+  }
+  return true;
+}
+
+void ZoneMap::Reserve(page_id_t page_id)
+{
+  if (static_cast<size_t>(page_id) < pages_.size()) {
+    return;
+  }
+  size_t first = pages_.size();
+  pages_.resize(page_id + 1);
+  columns_.resize((page_id + 1) * field_idx_.size());
+  for (auto i = static_cast<page_id_t>(first); i <= page_id; ++i) {
+    pages_[i].known_ = true;
+    ResetPage(i);
+  }
+}
+
+void ZoneMap::ResetPage(page_id_t page_id)
+{
+  pages_[page_id].rec_num_ = 0;
+  for (size_t j = 0; j < field_idx_.size(); ++j) {
+    GetColumnZone(page_id, j) = {std::numeric_limits<double>::infinity(), -std::numeric_limits<double>::infinity(), 0};
+  }
+}
+
+void ZoneMap::Widen(page_id_t page_id, const char *nullmap, const char *data)
+{
+  for (size_t j = 0; j < field_idx_.size(); ++j) {
+    auto &zone = GetColumnZone(page_id, j);
+    if (BitMap::GetBit(nullmap, field_idx_[j])) {
+      zone.null_num_++;
+      continue;
+    }
+    auto &field = schema_->GetFieldAt(field_idx_[j]).field_;
+    auto  value = ReadNumber(field.field_type_, data + schema_->GetFieldOffset(field_idx_[j]));
+    zone.min_   = std::min(zone.min_, value);
+    zone.max_   = std::max(zone.max_, value);
+  }
+}
+
+}  // namespace wsdb
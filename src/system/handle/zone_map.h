@@ -0,0 +1,148 @@
+/*------------------------------------------------------------------------------
+ - Copyright (c) 2024. Websoft research group, Nanjing University.
+ -
+ - This program is free software: you can redistribute it and/or modify
+ - it under the terms of the GNU General Public License as published by
+ - the Free Software Foundation, either version 3 of the License, or
+ - (at your option) any later version.
+ -
+ - This program is distributed in the hope that it will be useful,
+ - but WITHOUT ANY WARRANTY; without even the implied warranty of
+ - MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ - GNU General Public License for more details.
+ -
+ - You should have received a copy of the GNU General Public License
+ - along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ -----------------------------------------------------------------------------*/
+
+//
+// Created by ziqi on 2024/9/13.
+//
+
+#ifndef WSDB_ZONE_MAP_H
+#define WSDB_ZONE_MAP_H
+
+#include <shared_mutex>
+#include <span>
+#include <utility>
+#include <vector>
+
+#include "common/condition.h"
+#include "common/page.h"
+#include "record_handle.h"
+
+namespace wsdb {
+
+/**
+ * @brief Min, max and null number of each fixed-width column of each page, scans skip pages that can not satisfy the
+ * conditions without fetching them.
+ *
+ * Ranges are widened on insert and update but not narrowed on delete, so they always cover the values in the page, the
+ * null number is an upper bound for the same reason. The entry of a page is reset when its last record is deleted.
+ * Pages whose entry is unknown, e.g. the zone map is lost after a crash, are never skipped.
+ * Threads can update and read the zone map concurrently.
+ */
+class ZoneMap
+{
+public:
+  explicit ZoneMap(const RecordSchema *schema);
+
+  DISABLE_COPY_MOVE_AND_ASSIGN(ZoneMap)
+
+  /// widen the entry of the page with records inserted into it
+  void Insert(page_id_t page_id, std::span<const Record> records);
+
+  /// widen the entry of the page with the new value of a record
+  void Update(page_id_t page_id, const Record &record);
+
+  /// a record is deleted from the page, the entry is reset if the page becomes empty
+  void Delete(page_id_t page_id);
+
+  /**
+   * Check if no record of the page can satisfy the conjunction of conditions, only conditions comparing a fixed-width
+   * column of the table with a value are used
+   * @param page_id
+   * @param conds
+   * @return true if the page can be skipped
+   */
+  [[nodiscard]] auto CanSkip(page_id_t page_id, const ConditionVec &conds) const -> bool;
+
+  /**
+   * Get a bound of a column on each page, used to find MIN and MAX of the column without reading every page
+   * @param field_idx index of the field in the schema
+   * @param page_num number of pages of the table
+   * @param is_max get the upper bounds if true, the lower bounds otherwise
+   * @param[out] bounds bound and id of the pages that may hold a non-null value of the column, the bound of a page
+   * whose entry is unknown is infinite
+   * @return false if the column has no zone, bounds is left unchanged then, see HasZone
+   */
+  auto GetBounds(size_t field_idx, size_t page_num, bool is_max,
+      std::vector<std::pair<double, page_id_t>> &bounds) const -> bool;
+
+  /// check if the field at field_idx of the schema has a zone, i.e. it is fixed-width
+  [[nodiscard]] auto HasZone(size_t field_idx) const -> bool { return col_idx_[field_idx] != field_idx_.size(); }
+
+  /// mark all entries of pages [0, page_num) unknown
+  void Invalidate(size_t page_num);
+
+  /**
+   * Serialize the entries of pages [0, page_num)
+   * @param page_num number of pages of the table
+   * @return
+   */
+  [[nodiscard]] auto Serialize(size_t page_num) const -> std::vector<char>;
+
+  /**
+   * Load entries serialized by Serialize
+   * @param data
+   * @param page_num number of pages of the table, entries of another size are stale
+   * @return false if the data does not match the table, the zone map is left unchanged
+   */
+  auto Deserialize(const std::vector<char> &data, size_t page_num) -> bool;
+
+private:
+  struct ColumnZone
+  {
+    // min_ > max_ if there is no value other than null
+    double   min_;
+    double   max_;
+    uint32_t null_num_;
+  };
+
+  struct PageZone
+  {
+    bool     known_;
+    uint32_t rec_num_;
+  };
+
+  /// make sure the entry of the page exists, new entries are known and empty
+  void Reserve(page_id_t page_id);
+
+  void ResetPage(page_id_t page_id);
+
+  void Widen(page_id_t page_id, const char *nullmap, const char *data);
+
+  /// check if no value in zone can satisfy the condition on column col_idx
+  [[nodiscard]] auto CanSkip(const ColumnZone &zone, size_t col_idx, const Condition &cond) const -> bool;
+
+  [[nodiscard]] auto GetColumnZone(page_id_t page_id, size_t col_idx) -> ColumnZone &
+  {
+    return columns_[page_id * field_idx_.size() + col_idx];
+  }
+
+private:
+  const RecordSchema *schema_;
+  // index of fixed-width fields in the schema, col_idx below is the index in this list
+  std::vector<size_t> field_idx_;
+  // position of a field in field_idx_, field_idx_.size() for fields without zone
+  std::vector<size_t> col_idx_;
+
+  mutable std::shared_mutex latch_;
+  std::vector<PageZone>     pages_;
+  // zones of page i are at [i * field_idx_.size(), (i + 1) * field_idx_.size())
+  std::vector<ColumnZone> columns_;
+};
+
+}  // namespace wsdb
+
+#endif  // WSDB_ZONE_MAP_H
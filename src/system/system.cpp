@@ -27,6 +27,7 @@
 #include "system.h"
 #include "../common/net/net.h"
 #include "context.h"
+#include "common/memory_context.h"
 
 namespace wsdb {
 SystemManager::SystemManager() = default;
@@ -42,6 +43,10 @@ void SystemManager::Init()
   disk_manager_        = std::make_unique<DiskManager>();
   log_manager_         = std::make_unique<LogManager>(disk_manager_.get());
   buffer_pool_manager_ = std::make_unique<BufferPoolManager>(disk_manager_.get(), log_manager_.get(), REPLACER_LRU_K);
+  MemoryBroker::GetInstance()->RegisterBufferPool(buffer_pool_manager_.get(), BUFFER_POOL_SIZE);
+  if (const char *trace_file = std::getenv(BUFFER_TRACE_ENV.c_str()); trace_file != nullptr) {
+    buffer_pool_manager_->SetTraceFile(trace_file);
+  }
   recovery_            = std::make_unique<Recovery>(disk_manager_.get(), buffer_pool_manager_.get());
   table_manager_       = std::make_unique<TableManager>(disk_manager_.get(), buffer_pool_manager_.get());
   index_manager_       = std::make_unique<IndexManager>(disk_manager_.get(), buffer_pool_manager_.get());
@@ -69,7 +74,13 @@ void SystemManager::Init()
   }
 }
 
-SystemManager::~SystemManager() {}
+SystemManager::~SystemManager()
+{
+  // the broker outlives the system, it must not lend frames of a buffer pool that is destroyed below
+  if (buffer_pool_manager_ != nullptr) {
+    MemoryBroker::GetInstance()->UnregisterBufferPool(buffer_pool_manager_.get());
+  }
+}
 
 void SystemManager::CreateDatabase(const std::string &db_name)
 {
@@ -172,9 +183,14 @@ void SystemManager::ClientHandler(int client_fd)
         net_controller_->SendOK(client_fd);
       } else {
         /// plan is not a db plan
-        plan           = optimizer_->Optimize(plan, context.db_);
-        auto exec_tree = executor_->Translate(plan, context.db_);
-        executor_->Execute(exec_tree, &context);
+        plan = optimizer_->Optimize(plan, context.db_);
+        // records and values of the query are freed together with the executor tree, before the context is released
+        MemoryContext mem_ctx;
+        {
+          auto exec_tree = executor_->Translate(plan, context.db_, &mem_ctx);
+          executor_->Execute(exec_tree, &context);
+        }
+        WSDB_LOG(fmt::format("Client {} query memory: {}", client_fd, mem_ctx.GetStats().ToString()));
       }
       // commit transaction if this is a single sql statement
       if (!txn.IsExplicit()) {
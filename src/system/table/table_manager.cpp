@@ -20,14 +20,53 @@
 //
 
 #include "table_manager.h"
+
+#include <filesystem>
+
 #include "common/page.h"
 
 namespace wsdb {
-void TableManager::CreateTable(
-    const std::string &db_name, const std::string &table_name, const RecordSchema &schema, StorageModel storage_model)
+void TableManager::CreateTable(const std::string &db_name, const std::string &table_name, const RecordSchema &schema,
+    StorageModel storage_model, PartitionScheme *partition_scheme, bool memory_snapshot)
 {
-  if (schema.GetRecordLength() > MAX_REC_SIZE || schema.GetRecordLength() < 1) {
-    WSDB_THROW(WSDB_RECLEN_ERROR, fmt::format("{}", schema.GetRecordLength()));
+  // dictionary encoded fields only take their codes in the row
+  if (DictHandle::HasEncodedField(schema) && storage_model != NARY_MODEL) {
+    WSDB_THROW(WSDB_UNSUPPORTED_OP, "ENCODING DICT of a table not stored as NARY");
+  }
+  // only the rows of an in-memory table are lost on close without a snapshot
+  if (memory_snapshot && storage_model != MEMORY_MODEL) {
+    WSDB_THROW(WSDB_UNSUPPORTED_OP, "SNAPSHOT of a table not stored in MEMORY");
+  }
+  // wide string fields are stored out of line, only their toast pointers count towards the record size
+  auto stored_schema = ToastHandle::MakeStoredSchema(*DictHandle::MakeCodedSchema(schema), storage_model);
+  if (stored_schema->GetRecordLength() > MAX_REC_SIZE || stored_schema->GetRecordLength() < 1) {
+    WSDB_THROW(WSDB_RECLEN_ERROR, fmt::format("{}", stored_schema->GetRecordLength()));
+  }
+  bool has_toast = false;
+  for (const auto &field : schema.GetFields()) {
+    if (!field.field_.dict_encoded_ && ToastHandle::IsToasted(field.field_, storage_model)) {
+      if (field.field_.field_size_ > ToastHandle::GetMaxFieldSize()) {
+        WSDB_THROW(
+            WSDB_RECLEN_ERROR, fmt::format("field {} of {}", field.field_.field_name_, field.field_.field_size_));
+      }
+      has_toast = true;
+    }
+  }
+  if (partition_scheme != nullptr) {
+    // the page ids in the rids of an lsm table grow with every insert, they run out of the bits of a partition
+    if (storage_model == LSM_MODEL) {
+      WSDB_THROW(WSDB_UNSUPPORTED_OP, "PARTITION BY of a table stored as LSM");
+    }
+    partition_scheme->Bind(&schema);
+    std::vector<char> scheme_data;
+    partition_scheme->Serialize(scheme_data);
+    size_t header_size = sizeof(TableHeader) + scheme_data.size();
+    for (const auto &field : schema.GetFields()) {
+      header_size += field.field_.field_name_.size() + 1 + sizeof(FieldType) + sizeof(size_t) + sizeof(bool);
+    }
+    if (header_size > PAGE_SIZE) {
+      WSDB_THROW(WSDB_RECLEN_ERROR, fmt::format("partition scheme {} of {}", partition_scheme->ToString(), table_name));
+    }
   }
 
   // 1. create and open table file
@@ -38,22 +77,86 @@ void TableManager::CreateTable(
   table_header.page_num_        = 1;
   table_header.first_free_page_ = INVALID_PAGE_ID;
   table_header.rec_num_         = 0;
-  table_header.rec_size_        = schema.GetRecordLength();
+  table_header.rec_size_        = stored_schema->GetRecordLength();
   table_header.nullmap_size_    = BITMAP_SIZE(schema.GetFieldCount());
   // n = rec_per_page, PAGE_HDR_SIZE + BITMAP_SIZE(n) + n * (rec_size + nullmap_size) <= PAGE_SIZE
   table_header.rec_per_page_ = (BITMAP_WIDTH * (PAGE_SIZE - PAGE_HEADER_SIZE - 1) + 1) /
                                (1 + (table_header.rec_size_ + table_header.nullmap_size_) * BITMAP_WIDTH);
-  table_header.field_num_   = schema.GetFieldCount();
-  table_header.bitmap_size_ = BITMAP_SIZE(table_header.rec_per_page_);
+  if (storage_model == SLOTTED_MODEL) {
+    // records are stored at their actual length, a page holds as many slots as the shortest records fill
+    table_header.rec_per_page_ = SlottedPageHandle::GetMaxSlotNum(&schema);
+  }
+  if (storage_model == PAX_MODEL) {
+    // rows beyond those the page holds plain are encoded in the page
+    table_header.rec_per_page_ = PAXPageHandle::GetMaxSlotNum(stored_schema.get());
+  }
+  table_header.field_num_       = schema.GetFieldCount();
+  table_header.bitmap_size_     = BITMAP_SIZE(table_header.rec_per_page_);
+  table_header.partition_num_   = partition_scheme != nullptr ? partition_scheme->GetPartitionNum() : 0;
+  table_header.memory_snapshot_ = memory_snapshot;
   // 3. write table header to the zero page
-  WriteTableHeader(table_file, table_header, schema);
+  WriteTableHeader(table_file, table_header, schema, partition_scheme);
   // 4. close table file
   disk_manager_->CloseFile(table_file);
+  // 5. create the partitions as tables of their own, rows are never stored in the table file then
+  if (partition_scheme != nullptr) {
+    std::filesystem::create_directories(FILE_NAME(db_name, TAB_DIR, ""));
+    for (size_t i = 0; i < partition_scheme->GetPartitionNum(); ++i) {
+      CreateTable(db_name, GetPartitionName(table_name, i), schema, storage_model, nullptr, memory_snapshot);
+    }
+    return;
+  }
+  // 6. create the toast file for values stored out of line, or for rows spilled from encoded pax pages
+  if (has_toast || storage_model == PAX_MODEL) {
+    DiskManager::CreateFile(FILE_NAME(db_name, table_name, TST_SUFFIX));
+    auto toast_file = disk_manager_->OpenFile(FILE_NAME(db_name, table_name, TST_SUFFIX));
+    ToastHandle::InitFile(disk_manager_, toast_file);
+    disk_manager_->CloseFile(toast_file);
+  }
+  // 7. create the dictionary file of encoded fields, it is empty until values are inserted
+  if (DictHandle::HasEncodedField(schema)) {
+    DiskManager::CreateFile(FILE_NAME(db_name, table_name, DIC_SUFFIX));
+  }
 }
 
-void TableManager::DropTable(const std::string &db_name, const std::string &table_name)
+void TableManager::DropTable(const std::string &db_name, const std::string &table_name, size_t partition_num)
 {
   DiskManager::DestroyFile(FILE_NAME(db_name, table_name, TAB_SUFFIX));
+  if (DiskManager::FileExists(FILE_NAME(db_name, table_name, ZMP_SUFFIX))) {
+    DiskManager::DestroyFile(FILE_NAME(db_name, table_name, ZMP_SUFFIX));
+  }
+  if (DiskManager::FileExists(FILE_NAME(db_name, table_name, TST_SUFFIX))) {
+    DiskManager::DestroyFile(FILE_NAME(db_name, table_name, TST_SUFFIX));
+  }
+  if (DiskManager::FileExists(FILE_NAME(db_name, table_name, DIC_SUFFIX))) {
+    DiskManager::DestroyFile(FILE_NAME(db_name, table_name, DIC_SUFFIX));
+  }
+  // the manifest and the sorted runs of an lsm table
+  LsmTree::DestroyFiles(FILE_NAME(db_name, table_name, ""));
+  for (size_t i = 0; i < partition_num; ++i) {
+    DropTable(db_name, GetPartitionName(table_name, i));
+  }
+}
+
+void TableManager::DropPartition(const std::string &db_name, TableHandle &table_handle, size_t partition)
+{
+  if (partition >= table_handle.GetPartitionNum()) {
+    WSDB_THROW(WSDB_TABLE_MISS, fmt::format("partition {} of {}", partition, table_handle.GetTableName()));
+  }
+  auto partition_name = GetPartitionName(table_handle.GetTableName(), partition);
+  table_handle.ReplacePartition(partition, [&](TableHandleUptr old_partition) {
+    // the pages of the partition leave the buffer pool with its files
+    CloseTable(db_name, *old_partition);
+    old_partition = nullptr;
+    DropTable(db_name, partition_name);
+    CreateTable(db_name,
+        partition_name,
+        table_handle.GetSchema(),
+        table_handle.GetStorageModel(),
+        nullptr,
+        table_handle.GetTableHeader().memory_snapshot_);
+    return OpenTable(db_name, partition_name, table_handle.GetStorageModel());
+  });
 }
 
 TableHandleUptr TableManager::OpenTable(
@@ -67,6 +170,15 @@ TableHandleUptr TableManager::OpenTable(
   char            *cursor = file_hdr_data;
   memcpy(&header, cursor, sizeof(TableHeader));
   cursor += sizeof(TableHeader);
+  // files written before the format was versioned start with the page num, which is never the magic number
+  if (header.magic_ != TABLE_FILE_MAGIC || header.version_ != TABLE_FORMAT_VERSION) {
+    delete[] file_hdr_data;
+    disk_manager_->CloseFile(table_file);
+    WSDB_THROW(WSDB_UNSUPPORTED_OP,
+        fmt::format("table {} is not of format version {}, recreate it and load its rows again",
+            table_name,
+            TABLE_FORMAT_VERSION));
+  }
   // parse field schemas, field is arranged as a formatted string:
   // field_name1:field_type1:field_size1:field_name2:field_type2:field_size2:...
   std::vector<RTField> fields;
@@ -81,24 +193,83 @@ TableHandleUptr TableManager::OpenTable(
     cursor += sizeof(size_t);
     fields.push_back({.field_ = field});
   }
+  // flags of the fields follow the field schemas: dict_encoded1:dict_encoded2:...
+  for (auto &field : fields) {
+    field.field_.dict_encoded_ = *reinterpret_cast<bool *>(cursor);
+    cursor += sizeof(bool);
+  }
   schema = std::make_unique<RecordSchema>(fields);
+  // the partition scheme follows the schema
+  PartitionSchemeUptr partition_scheme;
+  if (header.partition_num_ > 0) {
+    const char *scheme_cursor = cursor;
+    partition_scheme          = PartitionScheme::Deserialize(scheme_cursor, schema.get());
+  }
   delete[] file_hdr_data;
-  return std::make_unique<TableHandle>(disk_manager_, buffer_pool_manager_, table_file, header, schema, storage_model);
+  file_id_t toast_file = INVALID_FILE_ID;
+  if (DiskManager::FileExists(FILE_NAME(db_name, table_name, TST_SUFFIX))) {
+    toast_file = disk_manager_->OpenFile(FILE_NAME(db_name, table_name, TST_SUFFIX));
+  }
+  file_id_t dict_file = INVALID_FILE_ID;
+  if (DiskManager::FileExists(FILE_NAME(db_name, table_name, DIC_SUFFIX))) {
+    dict_file = disk_manager_->OpenFile(FILE_NAME(db_name, table_name, DIC_SUFFIX));
+  }
+  auto table_handle = std::make_unique<TableHandle>(
+      disk_manager_, buffer_pool_manager_, table_file, header, schema, storage_model, toast_file, dict_file);
+  if (partition_scheme != nullptr) {
+    std::vector<TableHandleUptr> partitions;
+    for (size_t i = 0; i < header.partition_num_; ++i) {
+      partitions.push_back(OpenTable(db_name, GetPartitionName(table_name, i), storage_model));
+    }
+    table_handle->SetPartitions(std::move(partition_scheme), std::move(partitions));
+    return table_handle;
+  }
+  ReadZoneMap(FILE_NAME(db_name, table_name, ZMP_SUFFIX), *table_handle);
+  return table_handle;
 }
 
-void TableManager::CloseTable(const std::string &db_name, const TableHandle &table_handle)
+void TableManager::CloseTable(const std::string &db_name, TableHandle &table_handle)
 {
-  // 1. write table header to the zero page
-  WriteTableHeader(table_handle.GetTableId(), table_handle.GetTableHeader(), table_handle.GetSchema());
+  // 1. write table header to the zero page, pages kept by inserting threads are put back to the free page list first
+  table_handle.ReleaseInsertPages();
+  // pages of an in-memory table go to the file directly and the memtable of an lsm table to a run, the header written
+  // below covers them
+  table_handle.Snapshot();
+  auto file_name = disk_manager_->GetFileName(table_handle.GetTableId());
+  if (table_handle.GetPartitionScheme() == nullptr) {
+    WriteZoneMap(std::filesystem::path(file_name).replace_extension(ZMP_SUFFIX).string(), table_handle);
+  }
+  WriteTableHeader(table_handle.GetTableId(),
+      table_handle.GetTableHeader(),
+      table_handle.GetSchema(),
+      table_handle.GetPartitionScheme());
   // 2. flush all pages to disk
   buffer_pool_manager_->FlushAllPages(table_handle.GetTableId());
   // delete all pages
   buffer_pool_manager_->DeleteAllPages(table_handle.GetTableId());
-  // 3. close table file
+  // 3. close table file, and the toast file the same way, entries of the dictionary file are written as they are added
   disk_manager_->CloseFile(table_handle.GetTableId());
+  if (auto toast_file = table_handle.GetToastFileId(); toast_file != INVALID_FILE_ID) {
+    buffer_pool_manager_->FlushAllPages(toast_file);
+    buffer_pool_manager_->DeleteAllPages(toast_file);
+    disk_manager_->CloseFile(toast_file);
+  }
+  if (auto dict_file = table_handle.GetDictFileId(); dict_file != INVALID_FILE_ID) {
+    disk_manager_->CloseFile(dict_file);
+  }
+  // 4. close the partitions as tables of their own
+  for (size_t i = 0; i < table_handle.GetPartitionNum(); ++i) {
+    CloseTable(db_name, *table_handle.GetPartition(i));
+  }
 }
 
-void TableManager::WriteTableHeader(table_id_t tid, const TableHeader &header, const RecordSchema &schema)
+auto TableManager::GetPartitionName(const std::string &table_name, size_t partition) -> std::string
+{
+  return fmt::format("{}/{}_p{}", TAB_DIR, table_name, partition);
+}
+
+void TableManager::WriteTableHeader(
+    table_id_t tid, const TableHeader &header, const RecordSchema &schema, const PartitionScheme *partition_scheme)
 {
   disk_manager_->WriteFile(tid, reinterpret_cast<const char *>(&header), sizeof(TableHeader), SEEK_SET);
   // 4. write schema following the table header
@@ -109,6 +280,45 @@ void TableManager::WriteTableHeader(table_id_t tid, const TableHeader &header, c
     disk_manager_->WriteFile(tid, reinterpret_cast<const char *>(&field.field_type_), sizeof(FieldType), SEEK_CUR);
     disk_manager_->WriteFile(tid, reinterpret_cast<const char *>(&field.field_size_), sizeof(size_t), SEEK_CUR);
   }
+  // then the flags of the fields, dict_encoded1:dict_encoded2:..
+  for (size_t i = 0; i < schema.GetFieldCount(); ++i) {
+    const FieldSchema &field = schema.GetFieldAt(i).field_;
+    disk_manager_->WriteFile(tid, reinterpret_cast<const char *>(&field.dict_encoded_), sizeof(bool), SEEK_CUR);
+  }
+  if (partition_scheme != nullptr) {
+    std::vector<char> scheme_data;
+    partition_scheme->Serialize(scheme_data);
+    disk_manager_->WriteFile(tid, scheme_data.data(), scheme_data.size(), SEEK_CUR);
+  }
+}
+
+void TableManager::ReadZoneMap(const std::string &file_name, TableHandle &table_handle)
+{
+  auto page_num = table_handle.GetPageNum();
+  if (!DiskManager::FileExists(file_name)) {
+    table_handle.GetZoneMap().Invalidate(page_num);
+    return;
+  }
+  std::vector<char> data(std::filesystem::file_size(file_name));
+  auto              fid = disk_manager_->OpenFile(file_name);
+  disk_manager_->ReadFile(fid, data.data(), data.size(), 0, SEEK_SET);
+  disk_manager_->CloseFile(fid);
+  DiskManager::DestroyFile(file_name);
+  if (!table_handle.GetZoneMap().Deserialize(data, page_num)) {
+    table_handle.GetZoneMap().Invalidate(page_num);
+  }
+}
+
+void TableManager::WriteZoneMap(const std::string &file_name, TableHandle &table_handle)
+{
+  auto data = table_handle.GetZoneMap().Serialize(table_handle.GetPageNum());
+  if (DiskManager::FileExists(file_name)) {
+    DiskManager::DestroyFile(file_name);
+  }
+  DiskManager::CreateFile(file_name);
+  auto fid = disk_manager_->OpenFile(file_name);
+  disk_manager_->WriteFile(fid, data.data(), data.size(), SEEK_SET);
+  disk_manager_->CloseFile(fid);
 }
 
 auto TableManager::GetTableId(const std::string &db_name, const std::string &table_name) -> table_id_t
@@ -36,18 +36,48 @@ public:
   {}
   ~TableManager() = default;
 
-  void CreateTable(const std::string &db_name, const std::string &table_name, const RecordSchema &schema, StorageModel storage_model);
+  /**
+   * Create the files of a table
+   * @param partition_scheme if given, the table is partitioned, each partition is created as a table under TAB_DIR
+   * @param memory_snapshot if set, the rows of an in-memory table are written to its file on close and loaded on open
+   */
+  void CreateTable(const std::string &db_name, const std::string &table_name, const RecordSchema &schema,
+      StorageModel storage_model, PartitionScheme *partition_scheme = nullptr, bool memory_snapshot = false);
 
-  static void DropTable(const std::string &db_name, const std::string &table_name);
+  /// @param partition_num number of partitions of the table, whose files are removed as well
+  static void DropTable(const std::string &db_name, const std::string &table_name, size_t partition_num = 0);
+
+  /**
+   * Empty a partition of the table by replacing its files with the files of an empty table, no row is visited
+   * @param db_name
+   * @param table_handle
+   * @param partition
+   */
+  void DropPartition(const std::string &db_name, TableHandle &table_handle, size_t partition);
 
   TableHandleUptr OpenTable(const std::string &db_name, const std::string &table_name, StorageModel storage_model);
 
-  void CloseTable(const std::string &db_name, const TableHandle &table_handle);
+  void CloseTable(const std::string &db_name, TableHandle &table_handle);
 
   auto GetTableId(const std::string &db_name, const std::string &table_name) -> table_id_t;
 
 private:
-  void WriteTableHeader(table_id_t tid, const TableHeader &header, const RecordSchema &schema);
+  /// @return name of the table of a partition, e.g. tab/orders_p0 for partition 0 of orders
+  static auto GetPartitionName(const std::string &table_name, size_t partition) -> std::string;
+
+  /// write the table header and the schema to the zero page, followed by the partition scheme if there is one
+  void WriteTableHeader(table_id_t tid, const TableHeader &header, const RecordSchema &schema,
+      const PartitionScheme *partition_scheme = nullptr);
+
+  /**
+   * Load the zone map of the table and remove the file, so that a crash before CloseTable does not leave a stale zone
+   * map behind, the zone map is unknown if the file is missing or does not match the table
+   * @param file_name
+   * @param table_handle
+   */
+  void ReadZoneMap(const std::string &file_name, TableHandle &table_handle);
+
+  void WriteZoneMap(const std::string &file_name, TableHandle &table_handle);
 
 private:
   DiskManager       *disk_manager_;
@@ -0,0 +1,94 @@
+/*------------------------------------------------------------------------------
+ - Copyright (c) 2024. Websoft research group, Nanjing University.
+ -
+ - This program is free software: you can redistribute it and/or modify
+ - it under the terms of the GNU General Public License as published by
+ - the Free Software Foundation, either version 3 of the License, or
+ - (at your option) any later version.
+ -
+ - This program is distributed in the hope that it will be useful,
+ - but WITHOUT ANY WARRANTY; without even the implied warranty of
+ - MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ - GNU General Public License for more details.
+ -
+ - You should have received a copy of the GNU General Public License
+ - along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ -----------------------------------------------------------------------------*/
+
+//
+// Created by ziqi on 2024/9/15.
+//
+#include "execution/executor_aggregate_meta.h"
+#include "system/table/table_manager.h"
+#include "../config.h"
+
+#include <filesystem>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+using namespace wsdb;
+
+TEST(MetaAggregateTest, Extremum)
+{
+  auto disk_manager        = std::make_unique<DiskManager>();
+  auto buffer_pool_manager = std::make_unique<BufferPoolManager>(disk_manager.get(), nullptr);
+  auto table_manager       = std::make_unique<TableManager>(disk_manager.get(), buffer_pool_manager.get());
+  if (!std::filesystem::exists(TEST_DIR))
+    std::filesystem::create_directory(TEST_DIR);
+  std::vector<RTField> fields(1);
+  fields[0].field_ = {.field_name_ = "id", .field_size_ = sizeof(int), .field_type_ = TYPE_INT};
+  RecordSchema schema(fields);
+
+  // COUNT(*), MIN(id) and MAX(id) over the table
+  auto aggregate = [](TableHandle *table) -> std::vector<ValueSptr> {
+    std::vector<RTField> agg_fields(3, RTField{.field_ = table->GetSchema().GetFieldAt(0).field_, .is_agg_ = true});
+    agg_fields[0].field_    = {.field_name_ = "*", .field_size_ = sizeof(int), .field_type_ = TYPE_INT};
+    agg_fields[0].agg_type_ = AGG_COUNT_STAR;
+    agg_fields[1].agg_type_ = AGG_MIN;
+    agg_fields[2].agg_type_ = AGG_MAX;
+    MetaAggregateExecutor meta(table, std::make_unique<RecordSchema>(agg_fields));
+    meta.Init();
+    auto record = meta.GetRecord();
+    return {record->GetValueAt(0), record->GetValueAt(1), record->GetValueAt(2)};
+  };
+  auto int_of = [](const ValueSptr &value) { return std::dynamic_pointer_cast<IntValue>(value)->Get(); };
+  for (auto storage_model : {NARY_MODEL, SLOTTED_MODEL}) {
+    std::string table_name = fmt::format("meta_aggregate_{}", StorageModelToString(storage_model));
+    if (std::filesystem::exists(FILE_NAME(TEST_DIR, table_name, TAB_SUFFIX)))
+      table_manager->DropTable(TEST_DIR, table_name);
+    table_manager->CreateTable(TEST_DIR, table_name, schema, storage_model);
+    auto table = table_manager->OpenTable(TEST_DIR, table_name, storage_model);
+
+    // MIN and MAX of an empty or all-null column are NULL
+    auto empty = aggregate(table.get());
+    ASSERT_EQ(int_of(empty[0]), 0);
+    ASSERT_TRUE(empty[1]->IsNull());
+    ASSERT_TRUE(empty[2]->IsNull());
+    Record null_record(&table->GetSchema(), {ValueFactory::CreateNullValue(TYPE_INT)}, INVALID_RID);
+    table->InsertRecord(null_record);
+    auto all_null = aggregate(table.get());
+    ASSERT_EQ(int_of(all_null[0]), 1);
+    ASSERT_TRUE(all_null[1]->IsNull());
+    ASSERT_TRUE(all_null[2]->IsNull());
+
+    // slotted tables keep no bounds, their extremum is found by a scan
+    for (int i = 0; i < 1000; ++i) {
+      Record record(&table->GetSchema(), {ValueFactory::CreateIntValue(i * 7919 % 1000 - 500)}, INVALID_RID);
+      table->InsertRecord(record);
+    }
+    auto full = aggregate(table.get());
+    ASSERT_EQ(int_of(full[0]), 1001);
+    ASSERT_EQ(int_of(full[1]), -500);
+    ASSERT_EQ(int_of(full[2]), 499);
+
+    table_manager->CloseTable(TEST_DIR, *table);
+    table_manager->DropTable(TEST_DIR, table_name);
+  }
+}
+
+int main(int argc, char **argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,197 @@
+/*------------------------------------------------------------------------------
+ - Copyright (c) 2024. Websoft research group, Nanjing University.
+ -
+ - This program is free software: you can redistribute it and/or modify
+ - it under the terms of the GNU General Public License as published by
+ - the Free Software Foundation, either version 3 of the License, or
+ - (at your option) any later version.
+ -
+ - This program is distributed in the hope that it will be useful,
+ - but WITHOUT ANY WARRANTY; without even the implied warranty of
+ - MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ - GNU General Public License for more details.
+ -
+ - You should have received a copy of the GNU General Public License
+ - along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ -----------------------------------------------------------------------------*/
+
+//
+// Created by ziqi on 2024/9/16.
+//
+#include "execution/executor_copy.h"
+#include "system/table/table_manager.h"
+#include "../config.h"
+
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+using namespace wsdb;
+
+namespace {
+/// a table of (id int, name char(32), score float) and the file it is copied from
+class CopyTable
+{
+public:
+  CopyTable()
+      : disk_manager_(std::make_unique<DiskManager>()),
+        buffer_pool_manager_(std::make_unique<BufferPoolManager>(disk_manager_.get(), nullptr)),
+        table_manager_(std::make_unique<TableManager>(disk_manager_.get(), buffer_pool_manager_.get()))
+  {
+    if (!std::filesystem::exists(TEST_DIR))
+      std::filesystem::create_directory(TEST_DIR);
+    if (std::filesystem::exists(FILE_NAME(TEST_DIR, table_name_, TAB_SUFFIX)))
+      table_manager_->DropTable(TEST_DIR, table_name_);
+    std::vector<RTField> fields(3);
+    fields[0].field_ = {.field_name_ = "id", .field_size_ = sizeof(int), .field_type_ = TYPE_INT};
+    fields[1].field_ = {.field_name_ = "name", .field_size_ = 32, .field_type_ = TYPE_STRING};
+    fields[2].field_ = {.field_name_ = "score", .field_size_ = sizeof(float), .field_type_ = TYPE_FLOAT};
+    RecordSchema schema(fields);
+    table_manager_->CreateTable(TEST_DIR, table_name_, schema, NARY_MODEL);
+    table_ = table_manager_->OpenTable(TEST_DIR, table_name_, NARY_MODEL);
+  }
+
+  ~CopyTable()
+  {
+    table_manager_->CloseTable(TEST_DIR, *table_);
+    table_manager_->DropTable(TEST_DIR, table_name_);
+    std::filesystem::remove(file_name_);
+  }
+
+  /// @return the number of rows COPY reports for the content
+  auto Copy(const std::string &content) -> int
+  {
+    std::ofstream(file_name_, std::ios::binary) << content;
+    CopyExecutor copy(table_.get(), {}, file_name_);
+    copy.Next();
+    return std::dynamic_pointer_cast<IntValue>(copy.GetRecord()->GetValueAt(0))->Get();
+  }
+
+  /// @return the rows of the table by id
+  auto Rows() -> std::map<int, RecordUptr>
+  {
+    std::map<int, RecordUptr> rows;
+    for (auto iter = table_->MakeIterator(); !iter->IsEnd(); iter->Next()) {
+      auto record = iter->GetRecord();
+      auto id     = std::dynamic_pointer_cast<IntValue>(record->GetValueAt(0))->Get();
+      rows[id]    = std::move(record);
+    }
+    return rows;
+  }
+
+private:
+  std::string table_name_ = "copy_test";
+  std::string file_name_  = TEST_DIR + "/copy_test.csv";
+
+  std::unique_ptr<DiskManager>       disk_manager_;
+  std::unique_ptr<BufferPoolManager> buffer_pool_manager_;
+  std::unique_ptr<TableManager>      table_manager_;
+  TableHandleUptr                    table_;
+};
+
+auto NameOf(const RecordUptr &record) -> std::string
+{
+  return std::dynamic_pointer_cast<StringValue>(record->GetValueAt(1))->Get();
+}
+}  // namespace
+
+TEST(CopyTest, Quoting)
+{
+  CopyTable table;
+  ASSERT_EQ(table.Copy("1,plain,1.5\n"
+                       "2,\"a,b\",2.5\n"
+                       "3,\"say \"\"hi\"\"\",\n"
+                       "4,\"\",4.5\n"
+                       "5,,5.5\n"
+                       "6,\"two\nlines\",6.5\n"
+                       "7,\"crlf\r\ninside\",7.5\r\n"
+                       "\n"
+                       "8,last,8.5"),
+      8);
+  auto rows = table.Rows();
+  ASSERT_EQ(rows.size(), 8);
+  ASSERT_EQ(NameOf(rows[1]), "plain");
+  ASSERT_EQ(NameOf(rows[2]), "a,b");
+  ASSERT_EQ(NameOf(rows[3]), "say \"hi\"");
+  // an empty unquoted field is null, an empty quoted field is an empty string
+  ASSERT_TRUE(rows[3]->GetValueAt(2)->IsNull());
+  ASSERT_FALSE(rows[4]->GetValueAt(1)->IsNull());
+  ASSERT_EQ(NameOf(rows[4]), "");
+  ASSERT_TRUE(rows[5]->GetValueAt(1)->IsNull());
+  // line breaks inside quoted fields belong to the field
+  ASSERT_EQ(NameOf(rows[6]), "two\nlines");
+  ASSERT_EQ(NameOf(rows[7]), "crlf\r\ninside");
+  ASSERT_FALSE(rows[7]->GetValueAt(2)->IsNull());
+  ASSERT_EQ(NameOf(rows[8]), "last");
+}
+
+TEST(CopyTest, Errors)
+{
+  auto expect_error = [](const std::string &content, const std::string &rows_loaded) {
+    CopyTable table;
+    try {
+      table.Copy(content);
+      FAIL() << "no error for: " << content;
+    } catch (WSDBException_ &e) {
+      ASSERT_EQ(e.type_, WSDB_GRAMMAR_ERROR) << e.what();
+      ASSERT_NE(e.msg_.find(rows_loaded), std::string::npos) << e.what();
+    }
+  };
+  SUB_TEST(FieldCount)
+  {
+    expect_error("1,a,1.5\n2,b\n", "0 rows loaded");
+    expect_error("1,a,1.5\n2,b,2.5,extra\n", "0 rows loaded");
+    expect_error("1,\"a\"\n", "0 rows loaded");
+  }
+  SUB_TEST(Quotes)
+  {
+    expect_error("1,\"unterminated,1.5\n2,b,2.5\n", "0 rows loaded");
+    expect_error("1,a\"b,1.5\n", "0 rows loaded");
+    expect_error("1,\"a\"b,1.5\n", "0 rows loaded");
+  }
+  SUB_TEST(RowsLoaded)
+  {
+    // the first batch is inserted before the bad row is parsed, it stays in the table
+    std::string content;
+    for (size_t i = 0; i < COPY_BATCH_ROWS + 10; ++i) {
+      content += fmt::format("{},row,1.5\n", i);
+    }
+    content += "-1,bad\n";
+    CopyTable table;
+    try {
+      table.Copy(content);
+      FAIL() << "no error";
+    } catch (WSDBException_ &e) {
+      ASSERT_NE(e.msg_.find(fmt::format("{} rows loaded", COPY_BATCH_ROWS)), std::string::npos) << e.what();
+    }
+    ASSERT_EQ(table.Rows().size(), COPY_BATCH_ROWS);
+  }
+}
+
+TEST(CopyTest, MultiRange)
+{
+  // most line breaks are inside quoted fields, so ranges are cut right after them unless rows are counted by quotes
+  std::string content;
+  int         rec_num = 0;
+  while (content.size() < 3 * COPY_RANGE_SIZE) {
+    content += fmt::format("{},\"{}\n\n\n\n\n\n\n\"\"\",{}.5\n", rec_num, rec_num % 1000, rec_num % 100);
+    rec_num++;
+  }
+  CopyTable table;
+  ASSERT_EQ(table.Copy(content), rec_num);
+  auto rows = table.Rows();
+  ASSERT_EQ(rows.size(), rec_num);
+  for (int i = 0; i < rec_num; ++i) {
+    ASSERT_EQ(NameOf(rows[i]), fmt::format("{}\n\n\n\n\n\n\n\"", i % 1000));
+    ASSERT_EQ(std::dynamic_pointer_cast<FloatValue>(rows[i]->GetValueAt(2))->Get(), i % 100 + 0.5F);
+  }
+}
+
+int main(int argc, char **argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
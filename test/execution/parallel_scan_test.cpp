@@ -0,0 +1,105 @@
+/*------------------------------------------------------------------------------
+ - Copyright (c) 2024. Websoft research group, Nanjing University.
+ -
+ - This program is free software: you can redistribute it and/or modify
+ - it under the terms of the GNU General Public License as published by
+ - the Free Software Foundation, either version 3 of the License, or
+ - (at your option) any later version.
+ -
+ - This program is distributed in the hope that it will be useful,
+ - but WITHOUT ANY WARRANTY; without even the implied warranty of
+ - MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ - GNU General Public License for more details.
+ -
+ - You should have received a copy of the GNU General Public License
+ - along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ -----------------------------------------------------------------------------*/
+
+//
+// Created by ziqi on 2024/9/19.
+//
+#include "execution/executor_parallelscan.h"
+#include "execution/executor_seqscan.h"
+#include "system/table/table_manager.h"
+#include "../config.h"
+
+#include <filesystem>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+using namespace wsdb;
+
+TEST(ParallelScanTest, WorkersBoundedByFrames)
+{
+  auto        disk_manager        = std::make_unique<DiskManager>();
+  auto        buffer_pool_manager = std::make_unique<BufferPoolManager>(disk_manager.get(), nullptr);
+  auto        table_manager       = std::make_unique<TableManager>(disk_manager.get(), buffer_pool_manager.get());
+  std::string table_name          = "parallel_scan";
+  if (!std::filesystem::exists(TEST_DIR))
+    std::filesystem::create_directory(TEST_DIR);
+  if (std::filesystem::exists(FILE_NAME(TEST_DIR, table_name, TAB_SUFFIX)))
+    table_manager->DropTable(TEST_DIR, table_name);
+  std::vector<RTField> fields(2);
+  fields[0].field_ = {.field_name_ = "id", .field_size_ = sizeof(int), .field_type_ = TYPE_INT};
+  fields[1].field_ = {.field_name_ = "name", .field_size_ = 100, .field_type_ = TYPE_STRING};
+  RecordSchema schema(fields);
+  table_manager->CreateTable(TEST_DIR, table_name, schema, NARY_MODEL);
+  auto table = table_manager->OpenTable(TEST_DIR, table_name, NARY_MODEL);
+
+  // enough pages for more morsels than there are frames in the buffer pool
+  const int           rec_num = 100000;
+  std::vector<Record> records;
+  for (int i = 0; i < rec_num; ++i) {
+    std::vector<ValueSptr> values{ValueFactory::CreateIntValue(i), ValueFactory::CreateStringValue("name", 4)};
+    records.emplace_back(&table->GetSchema(), values, INVALID_RID);
+  }
+  table->InsertRecords(records);
+  ASSERT_GT(table->GetPageNum(), BUFFER_POOL_SIZE * SCAN_MORSEL_PAGES);
+
+  auto make_scan = [&table]() {
+    return std::make_unique<ParallelScanExecutor>(
+        table.get(), 2 * BUFFER_POOL_SIZE, [&table](PageMorsels *morsels, MemoryContext *) {
+          return std::make_unique<SeqScanExecutor>(table.get(), ConditionVec{}, std::nullopt, morsels);
+        });
+  };
+  auto check = [rec_num](AbstractExecutor *scan) {
+    std::vector<int> seen(rec_num);
+    for (; !scan->IsEnd(); scan->Next()) {
+      seen[std::dynamic_pointer_cast<IntValue>(scan->GetRecordView().GetValueAt(0))->Get()]++;
+    }
+    for (int i = 0; i < rec_num; ++i) {
+      ASSERT_EQ(seen[i], 1);
+    }
+  };
+
+  SUB_TEST(AboveFrameCount)
+  {
+    // PARALLEL above the frame count, each worker pins a page, some frames are left to the rest of the query
+    auto scan = make_scan();
+    scan->Init();
+    ASSERT_GT(scan->GetWorkerNum(), 0);
+    ASSERT_LE(scan->GetWorkerNum(), BUFFER_POOL_SIZE - SCAN_FRAME_HEADROOM);
+    check(scan.get());
+  }
+  SUB_TEST(ConcurrentScans)
+  {
+    // the frames are shared by all queries, the second scan runs inline once the first one holds them all
+    auto first  = make_scan();
+    auto second = make_scan();
+    first->Init();
+    second->Init();
+    ASSERT_LE(first->GetWorkerNum() + second->GetWorkerNum(), BUFFER_POOL_SIZE - SCAN_FRAME_HEADROOM);
+    check(first.get());
+    check(second.get());
+  }
+
+  table_manager->CloseTable(TEST_DIR, *table);
+  table_manager->DropTable(TEST_DIR, table_name);
+}
+
+int main(int argc, char **argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
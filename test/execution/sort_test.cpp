@@ -0,0 +1,110 @@
+/*------------------------------------------------------------------------------
+ - Copyright (c) 2024. Websoft research group, Nanjing University.
+ -
+ - This program is free software: you can redistribute it and/or modify
+ - it under the terms of the GNU General Public License as published by
+ - the Free Software Foundation, either version 3 of the License, or
+ - (at your option) any later version.
+ -
+ - This program is distributed in the hope that it will be useful,
+ - but WITHOUT ANY WARRANTY; without even the implied warranty of
+ - MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ - GNU General Public License for more details.
+ -
+ - You should have received a copy of the GNU General Public License
+ - along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ -----------------------------------------------------------------------------*/
+
+//
+// Created by ziqi on 2024/9/3.
+//
+#include "execution/executor_seqscan.h"
+#include "execution/executor_sort.h"
+#include "system/table/table_manager.h"
+#include "../config.h"
+
+#include <filesystem>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+using namespace wsdb;
+
+TEST(SortTest, LentFrames)
+{
+  auto        disk_manager        = std::make_unique<DiskManager>();
+  auto        buffer_pool_manager = std::make_unique<BufferPoolManager>(disk_manager.get(), nullptr);
+  auto        table_manager       = std::make_unique<TableManager>(disk_manager.get(), buffer_pool_manager.get());
+  std::string table_name          = "sort";
+  if (!std::filesystem::exists(TEST_DIR))
+    std::filesystem::create_directory(TEST_DIR);
+  if (!std::filesystem::exists(TMP_DIR))
+    std::filesystem::create_directory(TMP_DIR);
+  if (std::filesystem::exists(FILE_NAME(TEST_DIR, table_name, TAB_SUFFIX)))
+    table_manager->DropTable(TEST_DIR, table_name);
+  std::vector<RTField> fields(2);
+  fields[0].field_ = {.field_name_ = "id", .field_size_ = sizeof(int), .field_type_ = TYPE_INT};
+  fields[1].field_ = {.field_name_ = "name", .field_size_ = 100, .field_type_ = TYPE_STRING};
+  RecordSchema schema(fields);
+  table_manager->CreateTable(TEST_DIR, table_name, schema, NARY_MODEL);
+  auto table = table_manager->OpenTable(TEST_DIR, table_name, NARY_MODEL);
+
+  const int           rec_num = 2000;
+  std::vector<Record> records;
+  for (int i = 0; i < rec_num; ++i) {
+    // ids in a scrambled order
+    std::vector<ValueSptr> values{
+        ValueFactory::CreateIntValue(i * 7919 % rec_num), ValueFactory::CreateStringValue("name", 4)};
+    records.emplace_back(&table->GetSchema(), values, INVALID_RID);
+  }
+  table->InsertRecords(records);
+
+  auto broker = MemoryBroker::GetInstance();
+  broker->RegisterBufferPool(buffer_pool_manager.get(), BUFFER_POOL_SIZE);
+  auto pool_bytes = BUFFER_POOL_SIZE * PAGE_SIZE;
+  // hold all of the heap budget but heap_pages, the sort takes the rest of its buffer from the frames of the pool
+  auto check = [&](size_t heap_pages, size_t lent_frames) {
+    auto         heap_bytes = broker->GetBudget() - pool_bytes - heap_pages * PAGE_SIZE;
+    MemoryGrant  others(heap_bytes, heap_bytes, broker);
+    auto         key_schema = std::make_unique<RecordSchema>(std::vector<RTField>{table->GetSchema().GetFieldAt(0)});
+    SortExecutor sort(std::make_unique<SeqScanExecutor>(table.get()), std::move(key_schema), false);
+    sort.Init();
+    ASSERT_EQ(broker->GetLentFrames(), lent_frames);
+    int next = 0;
+    for (; !sort.IsEnd(); sort.Next(), ++next) {
+      ASSERT_EQ(std::dynamic_pointer_cast<IntValue>(sort.GetRecordView().GetValueAt(0))->Get(), next);
+    }
+    ASSERT_EQ(next, rec_num);
+    ASSERT_EQ(broker->GetLentFrames(), 0);
+  };
+  SUB_TEST(InMemory)
+  {
+    // the rows fit in the heap block and the frames together, the frames are held until the last row is out
+    check(64, BUFFER_POOL_SIZE - POOL_RESERVED_FRAMES);
+  }
+  SUB_TEST(Spill)
+  {
+    // several runs are filled and spilled, the frames are given back before the runs are merged
+    check(8, 0);
+  }
+  SUB_TEST(NoHeap)
+  {
+    // the frames cannot be given back without a heap row left to sort, no memory is taken beyond the budget
+    auto         heap_bytes = broker->GetBudget() - pool_bytes;
+    MemoryGrant  others(heap_bytes, heap_bytes, broker);
+    auto         key_schema = std::make_unique<RecordSchema>(std::vector<RTField>{table->GetSchema().GetFieldAt(0)});
+    SortExecutor sort(std::make_unique<SeqScanExecutor>(table.get()), std::move(key_schema), false);
+    ASSERT_THROW(sort.Init(), WSDBException_);
+    ASSERT_EQ(broker->GetGranted(), heap_bytes);
+  }
+
+  broker->UnregisterBufferPool(buffer_pool_manager.get());
+  table_manager->CloseTable(TEST_DIR, *table);
+  table_manager->DropTable(TEST_DIR, table_name);
+}
+
+int main(int argc, char **argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,103 @@
+/*------------------------------------------------------------------------------
+ - Copyright (c) 2024. Websoft research group, Nanjing University.
+ -
+ - This program is free software: you can redistribute it and/or modify
+ - it under the terms of the GNU General Public License as published by
+ - the Free Software Foundation, either version 3 of the License, or
+ - (at your option) any later version.
+ -
+ - This program is distributed in the hope that it will be useful,
+ - but WITHOUT ANY WARRANTY; without even the implied warranty of
+ - MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ - GNU General Public License for more details.
+ -
+ - You should have received a copy of the GNU General Public License
+ - along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ -----------------------------------------------------------------------------*/
+
+//
+// Created by ziqi on 2024/9/12.
+//
+#include "common/bitmap.h"
+#include "../config.h"
+
+#include <random>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+using wsdb::BitMap;
+
+// reference implementation testing one bit at a time
+static auto NaiveFindFirst(const char *bitmap, size_t bit_num, size_t start, bool value) -> size_t
+{
+  for (size_t i = start; i < bit_num; i++) {
+    if (BitMap::GetBit(bitmap, i) == value) {
+      return i;
+    }
+  }
+  return bit_num;
+}
+
+TEST(BitMapTest, FindFirst)
+{
+  std::mt19937 gen(0);
+  // cover partial bytes, partial words and bitmaps long enough to use AVX2
+  for (size_t bit_num : {1, 7, 8, 63, 64, 65, 200, 511, 1000, 4096, 33333}) {
+    std::vector<char> bitmap(BITMAP_SIZE(bit_num));
+    SUB_TEST(Sparse)
+    {
+      for (bool value : {true, false}) {
+        value ? BitMap::Clear(bitmap.data(), bit_num) : BitMap::Set(bitmap.data(), bit_num);
+        ASSERT_EQ(BitMap::FindFirst(bitmap.data(), bit_num, 0, value), bit_num);
+        auto idx = gen() % bit_num;
+        BitMap::SetBit(bitmap.data(), idx, value);
+        for (size_t start = 0; start < bit_num; start += 1 + bit_num / 16) {
+          ASSERT_EQ(BitMap::FindFirst(bitmap.data(), bit_num, start, value), start <= idx ? idx : bit_num);
+        }
+      }
+    }
+    SUB_TEST(Random)
+    {
+      for (size_t i = 0; i < bit_num; ++i) {
+        BitMap::SetBit(bitmap.data(), i, gen() % 8 == 0);
+      }
+      for (bool value : {true, false}) {
+        for (size_t start = 0; start < bit_num; start += 1 + bit_num / 64) {
+          ASSERT_EQ(BitMap::FindFirst(bitmap.data(), bit_num, start, value),
+              NaiveFindFirst(bitmap.data(), bit_num, start, value));
+        }
+      }
+    }
+  }
+}
+
+TEST(BitMapTest, CountAndForEach)
+{
+  std::mt19937 gen(0);
+  for (size_t bit_num : {1, 9, 64, 100, 777, 4096}) {
+    // set the bytes beyond bit_num to make sure they are ignored
+    std::vector<char> bitmap(BITMAP_SIZE(bit_num) + 8, static_cast<char>(0xff));
+    std::vector<size_t> expected;
+    for (size_t i = 0; i < bit_num; ++i) {
+      bool bit = gen() % 3 == 0;
+      BitMap::SetBit(bitmap.data(), i, bit);
+      if (bit) {
+        expected.push_back(i);
+      }
+    }
+    for (size_t i = bit_num; i < BITMAP_SIZE(bit_num) * BITMAP_WIDTH; ++i) {
+      BitMap::SetBit(bitmap.data(), i, true);
+    }
+    ASSERT_EQ(BitMap::Count(bitmap.data(), bit_num), expected.size());
+    std::vector<size_t> visited;
+    BitMap::ForEachSetBit(bitmap.data(), bit_num, [&visited](size_t idx) { visited.push_back(idx); });
+    ASSERT_EQ(visited, expected);
+  }
+}
+
+int main(int argc, char **argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,325 @@
+/*------------------------------------------------------------------------------
+ - Copyright (c) 2024. Websoft research group, Nanjing University.
+ -
+ - This program is free software: you can redistribute it and/or modify
+ - it under the terms of the GNU General Public License as published by
+ - the Free Software Foundation, either version 3 of the License, or
+ - (at your option) any later version.
+ -
+ - This program is distributed in the hope that it will be useful,
+ - but WITHOUT ANY WARRANTY; without even the implied warranty of
+ - MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ - GNU General Public License for more details.
+ -
+ - You should have received a copy of the GNU General Public License
+ - along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ -----------------------------------------------------------------------------*/
+
+//
+// Created by ziqi on 2024/9/5.
+//
+
+/**
+ * @brief Trace-driven benchmark of replacers and the buffer pool manager.
+ *
+ * Every configuration reports ns/op (time per access), hit ratio and throughput (items_per_second).
+ * Synthetic traces: uniform, zipfian, sequential scan, loop and scan mixed with point lookups.
+ * Recorded traces: start the server with WSDB_BUFFER_TRACE=<file>, then run this benchmark with the same
+ * environment variable to replay the recorded page accesses.
+ */
+
+#include "storage/buffer/buffer_pool_manager.h"
+#include "storage/buffer/replacer/lru_replacer.h"
+#include "storage/buffer/replacer/lru_k_replacer.h"
+#include "../config.h"
+
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+
+// distinct pages touched by the uniform and zipfian traces, 8 times the buffer pool
+constexpr int TRACE_PAGES  = 8 * BUFFER_POOL_SIZE;
+constexpr int TRACE_LENGTH = 1 << 16;
+constexpr int LRU_K        = 2;
+
+enum TraceType
+{
+  UNIFORM,
+  ZIPFIAN,
+  SEQUENTIAL,
+  LOOP,
+  SCAN_POINT,
+  RECORDED,
+};
+
+const std::vector<std::string> TRACE_NAMES    = {"uniform", "zipfian", "sequential", "loop", "scan_point", "recorded"};
+const std::vector<std::string> REPLACER_NAMES = {"LRUReplacer", "LRUKReplacer"};
+
+static auto MakeReplacer(size_t idx) -> std::unique_ptr<wsdb::Replacer>
+{
+  if (REPLACER_NAMES[idx] == "LRUKReplacer") {
+    return std::make_unique<wsdb::LRUKReplacer>(LRU_K);
+  }
+  return std::make_unique<wsdb::LRUReplacer>();
+}
+
+/// load "fid pid" lines recorded by the buffer pool, (fid, pid) pairs are renumbered to dense page ids
+static auto LoadRecordedTrace() -> std::vector<page_id_t>
+{
+  std::vector<page_id_t> trace;
+  const char            *file_name = std::getenv(BUFFER_TRACE_ENV.c_str());
+  if (file_name == nullptr) {
+    return trace;
+  }
+  std::ifstream                                     file(file_name);
+  std::map<std::pair<file_id_t, page_id_t>, page_id_t> page_ids;
+  file_id_t                                         fid;
+  page_id_t                                         pid;
+  while (file >> fid >> pid) {
+    auto it = page_ids.emplace(std::make_pair(fid, pid), static_cast<page_id_t>(page_ids.size())).first;
+    trace.push_back(it->second);
+  }
+  return trace;
+}
+
+static auto MakeTrace(TraceType type, uint32_t seed) -> std::vector<page_id_t>
+{
+  if (type == RECORDED) {
+    return LoadRecordedTrace();
+  }
+  std::mt19937                       gen(seed);
+  std::uniform_int_distribution<int> uniform(0, TRACE_PAGES - 1);
+  std::vector<page_id_t>             trace(TRACE_LENGTH);
+  switch (type) {
+    case UNIFORM:
+      std::generate(trace.begin(), trace.end(), [&] { return uniform(gen); });
+      break;
+    case ZIPFIAN: {
+      // theta = 0.99, page 0 is the hottest
+      std::vector<double> cdf(TRACE_PAGES);
+      double              sum = 0;
+      for (int i = 0; i < TRACE_PAGES; ++i) {
+        sum += 1.0 / std::pow(i + 1, 0.99);
+        cdf[i] = sum;
+      }
+      std::uniform_real_distribution<double> real(0, sum);
+      std::generate(trace.begin(), trace.end(), [&] {
+        return static_cast<page_id_t>(std::lower_bound(cdf.begin(), cdf.end(), real(gen)) - cdf.begin());
+      });
+      break;
+    }
+    case SEQUENTIAL:
+      // a scan never touches a page twice
+      for (int i = 0; i < TRACE_LENGTH; ++i) {
+        trace[i] = i;
+      }
+      break;
+    case LOOP:
+      // the loop is one page larger than the buffer pool, the worst case of LRU
+      for (int i = 0; i < TRACE_LENGTH; ++i) {
+        trace[i] = i % static_cast<int>(BUFFER_POOL_SIZE + 1);
+      }
+      break;
+    case SCAN_POINT: {
+      // point lookups on a hot set of half the buffer pool interleaved with a large scan
+      std::uniform_int_distribution<int> hot(0, BUFFER_POOL_SIZE / 2 - 1);
+      for (int i = 0; i < TRACE_LENGTH; ++i) {
+        trace[i] = i % 2 == 0 ? hot(gen) : static_cast<page_id_t>(BUFFER_POOL_SIZE + i);
+      }
+      break;
+    }
+    default: break;
+  }
+  return trace;
+}
+
+/**
+ * A cache of BUFFER_POOL_SIZE frames driven by a replacer only, so that policies are compared without disk I/O
+ */
+class ReplacerSimulator
+{
+public:
+  explicit ReplacerSimulator(std::unique_ptr<wsdb::Replacer> replacer)
+      : replacer_(std::move(replacer)), frame_pages_(BUFFER_POOL_SIZE, INVALID_PAGE_ID)
+  {
+    for (frame_id_t i = 0; i < static_cast<frame_id_t>(BUFFER_POOL_SIZE); ++i) {
+      free_frames_.push_back(i);
+    }
+  }
+
+  /// @return true if the page is in the cache
+  auto Access(page_id_t pid) -> bool
+  {
+    auto it  = page_frames_.find(pid);
+    bool hit = it != page_frames_.end();
+    frame_id_t frame_id;
+    if (hit) {
+      frame_id = it->second;
+    } else if (!free_frames_.empty()) {
+      frame_id = free_frames_.back();
+      free_frames_.pop_back();
+    } else {
+      replacer_->Victim(&frame_id);
+      page_frames_.erase(frame_pages_[frame_id]);
+    }
+    if (!hit) {
+      frame_pages_[frame_id] = pid;
+      page_frames_[pid]      = frame_id;
+    }
+    replacer_->Pin(frame_id);
+    replacer_->Unpin(frame_id);
+    return hit;
+  }
+
+private:
+  std::unique_ptr<wsdb::Replacer>           replacer_;
+  std::vector<page_id_t>                    frame_pages_;
+  std::vector<frame_id_t>                   free_frames_;
+  std::unordered_map<page_id_t, frame_id_t> page_frames_;
+};
+
+static void BM_Replacer(benchmark::State &state)
+{
+  auto replacer_idx = static_cast<size_t>(state.range(0));
+  auto trace_type   = static_cast<TraceType>(state.range(1));
+  auto trace        = MakeTrace(trace_type, 0);
+  if (trace.empty()) {
+    state.SkipWithError(fmt::format("no trace recorded, set {}", BUFFER_TRACE_ENV).c_str());
+    return;
+  }
+  ReplacerSimulator simulator(MakeReplacer(replacer_idx));
+  size_t            idx  = 0;
+  size_t            hits = 0;
+  for (auto _ : state) {
+    hits += simulator.Access(trace[idx]);
+    idx = idx + 1 == trace.size() ? 0 : idx + 1;
+  }
+  state.SetLabel(fmt::format("{}/{}", REPLACER_NAMES[replacer_idx], TRACE_NAMES[trace_type]));
+  state.SetItemsProcessed(state.iterations());
+  state.counters["hit_ratio"] = static_cast<double>(hits) / static_cast<double>(state.iterations());
+}
+
+/// replacer shared by all threads, measures the cost of the replacer latch under contention
+static std::unique_ptr<wsdb::Replacer> shared_replacer;
+
+static void SetupSharedReplacer(const benchmark::State &state)
+{
+  shared_replacer = MakeReplacer(static_cast<size_t>(state.range(0)));
+  for (frame_id_t i = 0; i < static_cast<frame_id_t>(BUFFER_POOL_SIZE); ++i) {
+    shared_replacer->Pin(i);
+    shared_replacer->Unpin(i);
+  }
+}
+
+static void TeardownSharedReplacer(const benchmark::State &) { shared_replacer = nullptr; }
+
+static void BM_ReplacerThroughput(benchmark::State &state)
+{
+  std::mt19937                       gen(state.thread_index());
+  std::uniform_int_distribution<int> frame(0, BUFFER_POOL_SIZE - 1);
+  for (auto _ : state) {
+    auto frame_id = frame(gen);
+    shared_replacer->Pin(frame_id);
+    shared_replacer->Unpin(frame_id);
+  }
+  state.SetLabel(REPLACER_NAMES[state.range(0)]);
+  state.SetItemsProcessed(state.iterations());
+}
+
+/// buffer pool shared by all threads, built with the replacer of the benchmark argument
+static std::unique_ptr<wsdb::DiskManager>       disk_manager;
+static std::unique_ptr<wsdb::BufferPoolManager> buffer_pool_manager;
+static std::vector<page_id_t>                   bpm_trace;
+static file_id_t                                bpm_fid = INVALID_FILE_ID;
+
+static void SetupBufferPool(const benchmark::State &state)
+{
+  if (!std::filesystem::exists(TEST_DIR)) {
+    std::filesystem::create_directory(TEST_DIR);
+  }
+  if (wsdb::DiskManager::FileExists(TEST_DIR + "/bench.tbl")) {
+    wsdb::DiskManager::DestroyFile(TEST_DIR + "/bench.tbl");
+  }
+  wsdb::DiskManager::CreateFile(TEST_DIR + "/bench.tbl");
+  disk_manager        = std::make_unique<wsdb::DiskManager>();
+  buffer_pool_manager = std::make_unique<wsdb::BufferPoolManager>(
+      disk_manager.get(), nullptr, LRU_K, REPLACER_NAMES[static_cast<size_t>(state.range(0))]);
+  bpm_fid             = disk_manager->OpenFile(TEST_DIR + "/bench.tbl");
+  bpm_trace           = MakeTrace(static_cast<TraceType>(state.range(1)), 0);
+}
+
+static void TeardownBufferPool(const benchmark::State &)
+{
+  buffer_pool_manager->DeleteAllPages(bpm_fid);
+  buffer_pool_manager = nullptr;
+  disk_manager->CloseFile(bpm_fid);
+  disk_manager = nullptr;
+  wsdb::DiskManager::DestroyFile(TEST_DIR + "/bench.tbl");
+}
+
+static void BM_BufferPool(benchmark::State &state)
+{
+  if (bpm_trace.empty()) {
+    state.SkipWithError(fmt::format("no trace recorded, set {}", BUFFER_TRACE_ENV).c_str());
+    return;
+  }
+  // each thread replays the trace from a different position
+  size_t idx = bpm_trace.size() * state.thread_index() / state.threads();
+  for (auto _ : state) {
+    auto  pid  = bpm_trace[idx];
+    Page *page = nullptr;
+    while (page == nullptr) {
+      try {
+        page = buffer_pool_manager->FetchPage(bpm_fid, pid);
+      } catch (wsdb::WSDBException_ &e) {
+        if (e.type_ != wsdb::WSDB_NO_FREE_FRAME) {
+          throw;
+        }
+        // more threads than frames, wait for others to unpin
+        std::this_thread::yield();
+      }
+    }
+    benchmark::DoNotOptimize(page->GetData()[0]);
+    buffer_pool_manager->UnpinPage(bpm_fid, pid, false);
+    idx = idx + 1 == bpm_trace.size() ? 0 : idx + 1;
+  }
+  auto hits   = static_cast<double>(buffer_pool_manager->GetHitCount());
+  auto misses = static_cast<double>(buffer_pool_manager->GetMissCount());
+  state.SetLabel(fmt::format("{}/{}", REPLACER_NAMES[state.range(0)], TRACE_NAMES[state.range(1)]));
+  state.SetItemsProcessed(state.iterations());
+  state.counters["hit_ratio"] = benchmark::Counter(hits / (hits + misses), benchmark::Counter::kAvgThreads);
+}
+
+static void ReplacerArgs(benchmark::internal::Benchmark *bench)
+{
+  bench->ArgNames({"replacer", "trace"});
+  for (int64_t replacer = 0; replacer < static_cast<int64_t>(REPLACER_NAMES.size()); ++replacer) {
+    for (int64_t trace = UNIFORM; trace <= RECORDED; ++trace) {
+      bench->Args({replacer, trace});
+    }
+  }
+}
+
+BENCHMARK(BM_Replacer)->Apply(ReplacerArgs);
+BENCHMARK(BM_ReplacerThroughput)
+    ->ArgName("replacer")
+    ->DenseRange(0, static_cast<int64_t>(REPLACER_NAMES.size()) - 1)
+    ->Setup(SetupSharedReplacer)
+    ->Teardown(TeardownSharedReplacer)
+    ->ThreadRange(1, 64)
+    ->UseRealTime();
+BENCHMARK(BM_BufferPool)
+    ->Apply(ReplacerArgs)
+    ->Setup(SetupBufferPool)
+    ->Teardown(TeardownBufferPool)
+    ->ThreadRange(1, 64)
+    ->UseRealTime();
+
+BENCHMARK_MAIN();
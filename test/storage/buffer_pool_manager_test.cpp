@@ -55,8 +55,10 @@ TEST(BufferPoolManagerTest, SimpleTest)
     ASSERT_EQ(page->GetFileId(), fd);
     ASSERT_EQ(page->GetPageId(), 0);
     ASSERT_NE(page->GetData(), nullptr);
+    ASSERT_EQ(buffer_pool_manager.GetPinCount(fd, 0), 1);
     buffer_pool_manager.UnpinPage(fd, 0, true);
     buffer_pool_manager.UnpinPage(fd, 0, false);
+    ASSERT_EQ(buffer_pool_manager.GetPinCount(fd, 0), 0);
     auto is_dirty = buffer_pool_manager.GetFrame(fd, 0)->IsDirty();
     ASSERT_EQ(is_dirty, true);
     buffer_pool_manager.DeletePage(fd, 0);
@@ -72,6 +74,7 @@ TEST(BufferPoolManagerTest, SimpleTest)
     buffer_pool_manager.DeleteAllPages(fd);
     auto fm = buffer_pool_manager.GetFrame(fd, 0);
     ASSERT_EQ(fm, nullptr);
+    ASSERT_EQ(buffer_pool_manager.GetPinCount(fd, 0), 0);
 
     /// test buffer pool with write
     std::vector<std::string> page_data(MAX_PAGES);
@@ -0,0 +1,186 @@
+/*------------------------------------------------------------------------------
+ - Copyright (c) 2024. Websoft research group, Nanjing University.
+ -
+ - This program is free software: you can redistribute it and/or modify
+ - it under the terms of the GNU General Public License as published by
+ - the Free Software Foundation, either version 3 of the License, or
+ - (at your option) any later version.
+ -
+ - This program is distributed in the hope that it will be useful,
+ - but WITHOUT ANY WARRANTY; without even the implied warranty of
+ - MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ - GNU General Public License for more details.
+ -
+ - You should have received a copy of the GNU General Public License
+ - along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ -----------------------------------------------------------------------------*/
+
+//
+// Created by ziqi on 2024/9/2.
+//
+#include "storage/buffer/buffer_pool_manager.h"
+#include "storage/buffer/memory_broker.h"
+#include "../config.h"
+
+#include <algorithm>
+#include <filesystem>
+
+#include "gtest/gtest.h"
+
+TEST(MemoryBrokerTest, Grant)
+{
+  wsdb::MemoryBroker broker(16 * PAGE_SIZE);
+  SUB_TEST(Basic)
+  {
+    auto size = broker.Acquire(8 * PAGE_SIZE, PAGE_SIZE);
+    ASSERT_EQ(size, 8 * PAGE_SIZE);
+    // only half of the request is available
+    auto partial = broker.Acquire(16 * PAGE_SIZE, PAGE_SIZE);
+    ASSERT_EQ(partial, 8 * PAGE_SIZE);
+    // nothing left, deny the request
+    ASSERT_EQ(broker.Acquire(2 * PAGE_SIZE, PAGE_SIZE), 0);
+    broker.Release(size);
+    broker.Release(partial);
+    ASSERT_EQ(broker.GetGranted(), 0);
+  }
+  SUB_TEST(RAII)
+  {
+    {
+      wsdb::MemoryGrant grant(4 * PAGE_SIZE, PAGE_SIZE, &broker);
+      ASSERT_FALSE(grant.IsDenied());
+      ASSERT_EQ(broker.GetGranted(), 4 * PAGE_SIZE);
+      wsdb::MemoryGrant moved = std::move(grant);
+      ASSERT_EQ(grant.GetSize(), 0);
+      ASSERT_EQ(broker.GetGranted(), 4 * PAGE_SIZE);
+    }
+    ASSERT_EQ(broker.GetGranted(), 0);
+  }
+}
+
+TEST(MemoryBrokerTest, LendFrames)
+{
+  wsdb::DiskManager       disk_manager{};
+  wsdb::BufferPoolManager buffer_pool_manager(&disk_manager);
+  // the budget only leaves one page for operators besides the buffer pool
+  wsdb::MemoryBroker broker((BUFFER_POOL_SIZE + 1) * PAGE_SIZE);
+  broker.RegisterBufferPool(&buffer_pool_manager, BUFFER_POOL_SIZE);
+  if (!std::filesystem::exists(TEST_DIR))
+    std::filesystem::create_directory(TEST_DIR);
+  std::filesystem::current_path(TEST_DIR);
+  try {
+    wsdb::DiskManager::CreateFile("broker.tbl");
+  } catch (wsdb::WSDBException_ &e) {
+    wsdb::DiskManager::DestroyFile("broker.tbl");
+    wsdb::DiskManager::CreateFile("broker.tbl");
+  }
+  auto fd = disk_manager.OpenFile("broker.tbl");
+
+  // a grant on the heap only never takes frames
+  ASSERT_EQ(broker.Acquire(3 * PAGE_SIZE, 2 * PAGE_SIZE), 0);
+  ASSERT_EQ(broker.GetLentFrames(), 0);
+  // borrow idle frames from the buffer pool, their memory is handed to the operator
+  std::vector<char *> frames;
+  auto                size = broker.Acquire(3 * PAGE_SIZE, PAGE_SIZE, &frames);
+  ASSERT_EQ(size, 3 * PAGE_SIZE);
+  ASSERT_EQ(frames.size(), 2);
+  ASSERT_EQ(broker.GetLentFrames(), 2);
+  ASSERT_EQ(broker.GetGranted(), 3 * PAGE_SIZE);
+  for (auto frame : frames) {
+    memset(frame, 0xff, PAGE_SIZE);
+  }
+  // the buffer pool can only use the frames left, none of them is handed out twice
+  for (page_id_t i = 0; i < static_cast<page_id_t>(BUFFER_POOL_SIZE - 2); ++i) {
+    auto page = buffer_pool_manager.FetchPage(fd, i);
+    ASSERT_NE(page, nullptr);
+    ASSERT_EQ(std::count(frames.begin(), frames.end(), page->GetData()), 0);
+  }
+  ASSERT_THROW(buffer_pool_manager.FetchPage(fd, BUFFER_POOL_SIZE), wsdb::WSDBException_);
+  // lent frames are returned once the grant is released
+  broker.Release(size, frames);
+  ASSERT_EQ(broker.GetLentFrames(), 0);
+  ASSERT_EQ(broker.GetGranted(), 0);
+  ASSERT_NE(buffer_pool_manager.FetchPage(fd, BUFFER_POOL_SIZE), nullptr);
+  ASSERT_NE(buffer_pool_manager.FetchPage(fd, BUFFER_POOL_SIZE + 1), nullptr);
+  for (page_id_t i = 0; i < static_cast<page_id_t>(BUFFER_POOL_SIZE - 2); ++i) {
+    buffer_pool_manager.UnpinPage(fd, i, false);
+  }
+  buffer_pool_manager.UnpinPage(fd, BUFFER_POOL_SIZE, false);
+  buffer_pool_manager.UnpinPage(fd, BUFFER_POOL_SIZE + 1, false);
+  SUB_TEST(Reserved)
+  {
+    // POOL_RESERVED_FRAMES frames stay in the buffer pool whatever the operators ask for
+    wsdb::MemoryGrant grant(BUFFER_POOL_SIZE * PAGE_SIZE, PAGE_SIZE, &broker, true);
+    ASSERT_EQ(grant.GetFrames().size(), BUFFER_POOL_SIZE - POOL_RESERVED_FRAMES);
+    ASSERT_EQ(grant.GetHeapSize(), PAGE_SIZE);
+    ASSERT_EQ(broker.GetLentFrames(), BUFFER_POOL_SIZE - POOL_RESERVED_FRAMES);
+  }
+  ASSERT_EQ(broker.GetLentFrames(), 0);
+  broker.UnregisterBufferPool(&buffer_pool_manager);
+  buffer_pool_manager.DeleteAllPages(fd);
+  disk_manager.CloseFile(fd);
+  wsdb::DiskManager::DestroyFile("broker.tbl");
+}
+
+TEST(MemoryBrokerTest, Reclaim)
+{
+  wsdb::DiskManager       disk_manager{};
+  wsdb::BufferPoolManager buffer_pool_manager(&disk_manager);
+  wsdb::MemoryBroker      broker(BUFFER_POOL_SIZE * PAGE_SIZE);
+  broker.RegisterBufferPool(&buffer_pool_manager, BUFFER_POOL_SIZE);
+  if (!std::filesystem::exists(TEST_DIR))
+    std::filesystem::create_directory(TEST_DIR);
+  std::filesystem::current_path(TEST_DIR);
+  try {
+    wsdb::DiskManager::CreateFile("reclaim.tbl");
+  } catch (wsdb::WSDBException_ &e) {
+    wsdb::DiskManager::DestroyFile("reclaim.tbl");
+    wsdb::DiskManager::CreateFile("reclaim.tbl");
+  }
+  auto fd       = disk_manager.OpenFile("reclaim.tbl");
+  auto lendable = BUFFER_POOL_SIZE - POOL_RESERVED_FRAMES;
+
+  // the operator refuses to spill, the buffer pool is left with the reserved frames
+  wsdb::MemoryGrant pinned(2 * PAGE_SIZE, PAGE_SIZE, &broker, true);
+  ASSERT_EQ(pinned.GetFrames().size(), 2);
+  pinned.SetReclaimer([]() { return false; });
+  // the operator spills and gives up its frames when the buffer pool needs them
+  int               spills = 0;
+  wsdb::MemoryGrant spillable(lendable * PAGE_SIZE, PAGE_SIZE, &broker, true);
+  ASSERT_EQ(spillable.GetFrames().size(), lendable - 2);
+  spillable.SetReclaimer([&spills]() {
+    ++spills;
+    return true;
+  });
+  ASSERT_EQ(broker.GetLentFrames(), lendable);
+
+  // fill every frame of the buffer pool while the frames are lent
+  for (page_id_t i = 0; i < static_cast<page_id_t>(BUFFER_POOL_SIZE - 2); ++i) {
+    ASSERT_NE(buffer_pool_manager.FetchPage(fd, i), nullptr);
+  }
+  ASSERT_EQ(spills, 1);
+  ASSERT_TRUE(spillable.GetFrames().empty());
+  ASSERT_EQ(spillable.GetSize(), 0);
+  ASSERT_EQ(pinned.GetFrames().size(), 2);
+  ASSERT_EQ(broker.GetLentFrames(), 2);
+  // nothing is left to reclaim
+  ASSERT_THROW(buffer_pool_manager.FetchPage(fd, BUFFER_POOL_SIZE), wsdb::WSDBException_);
+  ASSERT_EQ(spills, 1);
+
+  spillable.Reset();
+  pinned.Reset();
+  ASSERT_EQ(broker.GetLentFrames(), 0);
+  ASSERT_EQ(broker.GetGranted(), 0);
+  for (page_id_t i = 0; i < static_cast<page_id_t>(BUFFER_POOL_SIZE - 2); ++i) {
+    buffer_pool_manager.UnpinPage(fd, i, false);
+  }
+  broker.UnregisterBufferPool(&buffer_pool_manager);
+  buffer_pool_manager.DeleteAllPages(fd);
+  disk_manager.CloseFile(fd);
+  wsdb::DiskManager::DestroyFile("reclaim.tbl");
+}
+
+int main(int argc, char **argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,151 @@
+/*------------------------------------------------------------------------------
+ - Copyright (c) 2024. Websoft research group, Nanjing University.
+ -
+ - This program is free software: you can redistribute it and/or modify
+ - it under the terms of the GNU General Public License as published by
+ - the Free Software Foundation, either version 3 of the License, or
+ - (at your option) any later version.
+ -
+ - This program is distributed in the hope that it will be useful,
+ - but WITHOUT ANY WARRANTY; without even the implied warranty of
+ - MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ - GNU General Public License for more details.
+ -
+ - You should have received a copy of the GNU General Public License
+ - along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ -----------------------------------------------------------------------------*/
+
+//
+// Created by ziqi on 2024/9/12.
+//
+#include "common/memory_context.h"
+#include "system/handle/record_handle.h"
+#include "system/table/table_manager.h"
+#include "../config.h"
+
+#include <filesystem>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+using namespace wsdb;
+
+TEST(MemoryContextTest, Allocate)
+{
+  MemoryContext ctx;
+  SUB_TEST(Recycle)
+  {
+    auto p1 = ctx.Allocate(24);
+    auto p2 = ctx.Allocate(32);
+    ASSERT_NE(p1, p2);
+    ASSERT_EQ(reinterpret_cast<uintptr_t>(p1) % 16, 0);
+    ctx.Deallocate(p1, 24);
+    // same size class, the freed chunk is reused
+    ASSERT_EQ(ctx.Allocate(17), p1);
+    ctx.Deallocate(p1, 17);
+    ctx.Deallocate(p2, 32);
+    ASSERT_EQ(ctx.GetStats().alloc_count_, 3);
+    ASSERT_EQ(ctx.GetStats().free_count_, 3);
+    ASSERT_EQ(ctx.GetStats().block_count_, 1);
+  }
+  SUB_TEST(Large)
+  {
+    auto p = ctx.Allocate(MEMORY_CONTEXT_BLOCK_SIZE);
+    ASSERT_EQ(ctx.GetStats().large_alloc_count_, 1);
+    ctx.Deallocate(p, MEMORY_CONTEXT_BLOCK_SIZE);
+  }
+  SUB_TEST(Blocks)
+  {
+    std::vector<void *> ptrs;
+    for (size_t i = 0; i < MEMORY_CONTEXT_BLOCK_SIZE / 64; i++) {
+      ptrs.push_back(ctx.Allocate(256));
+    }
+    ASSERT_GE(ctx.GetStats().block_count_, 4);
+    auto block_count = ctx.GetStats().block_count_;
+    for (auto p : ptrs) {
+      ctx.Deallocate(p, 256);
+    }
+    for (size_t i = 0; i < ptrs.size(); i++) {
+      ctx.Allocate(256);
+    }
+    // freed chunks are reused before new blocks are requested
+    ASSERT_EQ(ctx.GetStats().block_count_, block_count);
+  }
+}
+
+TEST(MemoryContextTest, RecordAndValue)
+{
+  std::vector<RTField> fields(2);
+  fields[0].field_ = {.field_name_ = "id", .field_size_ = sizeof(int), .field_type_ = TYPE_INT};
+  fields[1].field_ = {.field_name_ = "name", .field_size_ = 20, .field_type_ = TYPE_STRING};
+  RecordSchema schema(fields);
+
+  std::vector<ValueSptr> values;
+  RecordUptr             heap_record;
+  MemoryContext          ctx;
+  {
+    values = {ValueFactory::CreateIntValue(1, &ctx), ValueFactory::CreateStringValue("hello", 5, &ctx)};
+    ASSERT_EQ(ctx.GetStats().alloc_count_, 2);
+    Record record(&schema, values, INVALID_RID, &ctx);
+    // data and null map share one allocation
+    ASSERT_EQ(ctx.GetStats().alloc_count_, 3);
+    // nothing is allocated from a context that is not passed explicitly
+    Record copy(record);
+    ASSERT_TRUE(copy == record);
+    Record moved(std::move(copy));
+    heap_record = std::make_unique<Record>(record);
+    ASSERT_EQ(ctx.GetStats().alloc_count_, 3);
+  }
+  ASSERT_EQ(ctx.GetStats().free_count_, 1);
+  values.clear();
+  ASSERT_EQ(ctx.GetStats().free_count_, 3);
+  ASSERT_EQ(heap_record->GetValueAt(1)->ToString(), "hello");
+}
+
+TEST(MemoryContextTest, TableAcrossQueries)
+{
+  auto        disk_manager        = std::make_unique<DiskManager>();
+  auto        buffer_pool_manager = std::make_unique<BufferPoolManager>(disk_manager.get(), nullptr);
+  auto        table_manager       = std::make_unique<TableManager>(disk_manager.get(), buffer_pool_manager.get());
+  std::string table_name          = "memory_context_partition";
+  if (!std::filesystem::exists(TEST_DIR))
+    std::filesystem::create_directory(TEST_DIR);
+  if (std::filesystem::exists(FILE_NAME(TEST_DIR, table_name, TAB_SUFFIX)))
+    table_manager->DropTable(TEST_DIR, table_name, 2);
+  std::vector<RTField> fields(2);
+  fields[0].field_ = {.field_name_ = "id", .field_size_ = sizeof(int), .field_type_ = TYPE_INT};
+  fields[1].field_ = {.field_name_ = "name", .field_size_ = 20, .field_type_ = TYPE_STRING};
+  RecordSchema schema(fields);
+  // a float bound is cast to the key type when bound
+  PartitionScheme scheme(RANGE_PARTITION, "id", 2, {ValueFactory::CreateFloatValue(100.0F)});
+
+  table_manager->CreateTable(TEST_DIR, table_name, schema, NARY_MODEL, &scheme);
+  auto table = table_manager->OpenTable(TEST_DIR, table_name, NARY_MODEL);
+  // the insert statement allocates its rows from its own context, the table keeps nothing of it
+  {
+    MemoryContext insert_ctx;
+    for (int id = 0; id < 200; id++) {
+      auto                   name = fmt::format("name_{}", id);
+      std::vector<ValueSptr> values{ValueFactory::CreateIntValue(id, &insert_ctx),
+          ValueFactory::CreateStringValue(name.c_str(), name.size(), &insert_ctx)};
+      table->InsertRecord(Record(&table->GetSchema(), values, INVALID_RID, &insert_ctx));
+    }
+    ValueSptr bound = ValueFactory::CreateIntValue(150, &insert_ctx);
+    auto      conds = ConditionVec{Condition(OP_GE, table->GetSchema().GetFieldAt(0), bound)};
+    ASSERT_EQ(table->GetPartitionScheme()->Prune(conds), std::vector<size_t>{1});
+    bound = nullptr;
+    conds.clear();
+    ASSERT_EQ(insert_ctx.GetStats().alloc_count_, insert_ctx.GetStats().free_count_);
+  }
+  ASSERT_EQ(table->GetPartition(0)->GetRecordNum(), 100);
+  ASSERT_EQ(table->GetPartition(1)->GetRecordNum(), 100);
+  table_manager->CloseTable(TEST_DIR, *table);
+  table = nullptr;
+  table_manager->DropTable(TEST_DIR, table_name, 2);
+}
+
+int main(int argc, char **argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
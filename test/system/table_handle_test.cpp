@@ -5,10 +5,15 @@
 #include "../config.h"
 #include "common/types.h"
 #include "storage/storage.h"
+#include "system/handle/record_compare.h"
 #include "system/handle/table_handle.h"
 #include "system/table/table_manager.h"
 
+#include <array>
+#include <atomic>
 #include <cassert>
+#include <fstream>
+#include <functional>
 #include <unordered_map>
 #include <vector>
 #include <unordered_set>
@@ -102,6 +107,193 @@ TEST(TableHandle, Simple)
     tbl->DeleteRecord(rid);
     ASSERT_THROW(tbl->GetRecord(rid), WSDBException_);
   }
+  // table iterator should visit the same records as GetFirstRID/GetNextRID
+  {
+    auto rid  = tbl->GetFirstRID();
+    auto iter = tbl->MakeIterator();
+    for (; !iter->IsEnd(); iter->Next(), rid = tbl->GetNextRID(rid)) {
+      ASSERT_EQ(iter->GetRID(), rid);
+      ASSERT_TRUE(*iter->GetRecord() == *tbl->GetRecord(rid));
+    }
+    ASSERT_EQ(rid, INVALID_RID);
+  }
+  // record views point into the pinned page and stay valid after the iterator has moved on
+  {
+    auto                    iter = tbl->MakeIterator();
+    std::vector<RecordView> views;
+    for (; !iter->IsEnd(); iter->Next()) {
+      views.push_back(iter->GetRecordView());
+    }
+    iter = nullptr;
+    for (const auto &view : views) {
+      ASSERT_TRUE(*view.Materialize() == *tbl->GetRecord(view.GetRID()));
+    }
+  }
+  table_manager->CloseTable(TEST_DIR, *tbl);
+  table_manager->DropTable(TEST_DIR, table_name);
+}
+
+TEST(TableHandle, FormatVersion)
+{
+  auto        disk_manager        = std::make_unique<DiskManager>();
+  auto        buffer_pool_manager = std::make_unique<BufferPoolManager>(disk_manager.get(), nullptr);
+  auto        table_manager       = std::make_unique<TableManager>(disk_manager.get(), buffer_pool_manager.get());
+  std::string table_name          = "table_handle_format_version";
+  if (!std::filesystem::exists(TEST_DIR))
+    std::filesystem::create_directory(TEST_DIR);
+  if (std::filesystem::exists(FILE_NAME(TEST_DIR, table_name, TAB_SUFFIX)))
+    table_manager->DropTable(TEST_DIR, table_name);
+  auto tbl_schema = GenTableSchema(5);
+  table_manager->CreateTable(TEST_DIR, table_name, *tbl_schema, NARY_MODEL);
+  // overwrite the start of the table header, the file is opened with a fresh disk manager each time
+  auto rewrite = [&](const char *data, size_t size) {
+    std::fstream file(FILE_NAME(TEST_DIR, table_name, TAB_SUFFIX), std::ios::in | std::ios::out | std::ios::binary);
+    file.write(data, static_cast<std::streamsize>(size));
+  };
+  // a file written before the format was versioned starts with its page num
+  size_t page_num = 1;
+  rewrite(reinterpret_cast<const char *>(&page_num), sizeof(page_num));
+  ASSERT_THROW(table_manager->OpenTable(TEST_DIR, table_name, NARY_MODEL), WSDBException_);
+  // a file of another version
+  std::array<uint32_t, 2> magic_version{TABLE_FILE_MAGIC, TABLE_FORMAT_VERSION + 1};
+  rewrite(reinterpret_cast<const char *>(magic_version.data()), sizeof(magic_version));
+  ASSERT_THROW(table_manager->OpenTable(TEST_DIR, table_name, NARY_MODEL), WSDBException_);
+  // the current version
+  magic_version[1] = TABLE_FORMAT_VERSION;
+  rewrite(reinterpret_cast<const char *>(magic_version.data()), sizeof(magic_version));
+  auto tbl = table_manager->OpenTable(TEST_DIR, table_name, NARY_MODEL);
+  ASSERT_EQ(tbl->GetSchema().GetFieldCount(), tbl_schema->GetFieldCount());
+  for (size_t i = 0; i < tbl_schema->GetFieldCount(); ++i) {
+    ASSERT_EQ(tbl->GetSchema().GetFieldAt(i).field_.field_name_, tbl_schema->GetFieldAt(i).field_.field_name_);
+  }
+  table_manager->CloseTable(TEST_DIR, *tbl);
+  table_manager->DropTable(TEST_DIR, table_name);
+}
+
+TEST(TableHandle, Slotted)
+{
+  auto        disk_manager        = std::make_unique<DiskManager>();
+  auto        buffer_pool_manager = std::make_unique<BufferPoolManager>(disk_manager.get(), nullptr);
+  auto        table_manager       = std::make_unique<TableManager>(disk_manager.get(), buffer_pool_manager.get());
+  std::string table_name          = "table_handle_slotted";
+  if (!std::filesystem::exists(TEST_DIR))
+    std::filesystem::create_directory(TEST_DIR);
+  if (std::filesystem::exists(FILE_NAME(TEST_DIR, table_name, TAB_SUFFIX)))
+    std::filesystem::remove(FILE_NAME(TEST_DIR, table_name, TAB_SUFFIX));
+  std::vector<RTField> fields(3);
+  fields[0].field_ = {.field_name_ = "id", .field_size_ = sizeof(int), .field_type_ = TYPE_INT};
+  fields[1].field_ = {.field_name_ = "name", .field_size_ = 200, .field_type_ = TYPE_STRING};
+  fields[2].field_ = {.field_name_ = "note", .field_size_ = 50, .field_type_ = TYPE_STRING};
+  RecordSchema tbl_schema(fields);
+  table_manager->CreateTable(TEST_DIR, table_name, tbl_schema, SLOTTED_MODEL);
+  auto  tbl    = table_manager->OpenTable(TEST_DIR, table_name, SLOTTED_MODEL);
+  auto &schema = tbl->GetSchema();
+
+  auto gen_record = [&schema](int id, size_t name_len) {
+    std::string            name(name_len, static_cast<char>('a' + id % 26));
+    std::vector<ValueSptr> values{ValueFactory::CreateIntValue(id),
+        ValueFactory::CreateStringValue(name.c_str(), name.size()),
+        ValueFactory::CreateStringValue("note", 4)};
+    return std::make_unique<Record>(&schema, values, INVALID_RID);
+  };
+  std::unordered_map<RID, RecordUptr> records;
+  auto                                check_table = [&]() {
+    ASSERT_EQ(tbl->GetTableHeader().rec_num_, records.size());
+    size_t count = 0;
+    for (auto iter = tbl->MakeIterator(); !iter->IsEnd(); iter->Next(), ++count) {
+      ASSERT_TRUE(records.count(iter->GetRID()));
+      ASSERT_TRUE(*iter->GetRecord() == *records[iter->GetRID()]);
+      ASSERT_TRUE(*iter->GetRecordView().Materialize() == *records[iter->GetRID()]);
+    }
+    ASSERT_EQ(count, records.size());
+    for (auto &[rid, record] : records) {
+      ASSERT_TRUE(*tbl->GetRecord(rid) == *record);
+    }
+  };
+
+  SUB_TEST(Insert)
+  {
+    for (int i = 0; i < 1000; ++i) {
+      auto record = gen_record(i, rand() % 20);
+      auto rid    = tbl->InsertRecord(*record);
+      records[rid] = std::move(record);
+    }
+    check_table();
+    // short strings are stored without padding, a fixed-width page holds less than 16 such records
+    ASSERT_LT(tbl->GetTableHeader().page_num_, 1000 / 16);
+  }
+  SUB_TEST(Grow)
+  {
+    // records outgrow their pages and are moved
+    for (auto &[rid, record] : records) {
+      record = gen_record(rid.SlotID(), 200);
+      tbl->UpdateRecord(rid, *record);
+    }
+    check_table();
+  }
+  SUB_TEST(Shrink)
+  {
+    for (auto &[rid, record] : records) {
+      record = gen_record(rid.SlotID(), rand() % 20);
+      tbl->UpdateRecord(rid, *record);
+    }
+    check_table();
+  }
+  SUB_TEST(ConcurrentRead)
+  {
+    // updates compact the pages in place while another thread reads them
+    std::vector<RID> rids;
+    for (const auto &[rid, record] : records) {
+      rids.push_back(rid);
+    }
+    std::atomic<bool> done{false};
+    std::thread       reader([&]() {
+      while (!done.load()) {
+        for (const auto &rid : rids) {
+          auto record = tbl->GetRecord(rid);
+          auto id     = std::dynamic_pointer_cast<IntValue>(record->GetValueAt(0))->Get();
+          ASSERT_EQ(id, rid.SlotID());
+          ASSERT_EQ(record->GetValueAt(1)->ToString().find_first_not_of(static_cast<char>('a' + id % 26)),
+              std::string::npos);
+        }
+        for (auto iter = tbl->MakeIterator(); !iter->IsEnd(); iter->Next()) {
+          auto id = std::dynamic_pointer_cast<IntValue>(iter->GetRecord()->GetValueAt(0))->Get();
+          ASSERT_EQ(id, iter->GetRID().SlotID());
+        }
+      }
+    });
+    for (int round = 0; round < 4; ++round) {
+      for (auto &[rid, record] : records) {
+        record = gen_record(rid.SlotID(), round % 2 == 0 ? 150 + rand() % 50 : rand() % 20);
+        tbl->UpdateRecord(rid, *record);
+      }
+    }
+    done = true;
+    reader.join();
+    check_table();
+  }
+  SUB_TEST(DeleteAndReuse)
+  {
+    auto page_num = tbl->GetTableHeader().page_num_;
+    for (auto it = records.begin(); it != records.end();) {
+      if (rand() % 2) {
+        tbl->DeleteRecord(it->first);
+        ASSERT_THROW(tbl->GetRecord(it->first), WSDBException_);
+        it = records.erase(it);
+      } else {
+        ++it;
+      }
+    }
+    check_table();
+    for (int i = 0; i < 400; ++i) {
+      auto record  = gen_record(i, rand() % 20);
+      auto rid     = tbl->InsertRecord(*record);
+      records[rid] = std::move(record);
+    }
+    check_table();
+    // the space of deleted and moved records is reused
+    ASSERT_EQ(tbl->GetTableHeader().page_num_, page_num);
+  }
   table_manager->CloseTable(TEST_DIR, *tbl);
   table_manager->DropTable(TEST_DIR, table_name);
 }
@@ -189,6 +381,1093 @@ TEST(TableHandle, MultiThread)
   table_manager->DropTable(TEST_DIR, table_name);
 }
 
+TEST(TableHandle, ConcurrentInsert)
+{
+  auto        disk_manager        = std::make_unique<DiskManager>();
+  auto        buffer_pool_manager = std::make_unique<BufferPoolManager>(disk_manager.get(), nullptr);
+  auto        table_manager       = std::make_unique<TableManager>(disk_manager.get(), buffer_pool_manager.get());
+  std::string table_name          = "table_handle_concurrent_insert";
+  if (!std::filesystem::exists(TEST_DIR))
+    std::filesystem::create_directory(TEST_DIR);
+  if (std::filesystem::exists(FILE_NAME(TEST_DIR, table_name, TAB_SUFFIX)))
+    std::filesystem::remove(FILE_NAME(TEST_DIR, table_name, TAB_SUFFIX));
+  auto tbl_schema = GenTableSchema(10);
+  table_manager->CreateTable(TEST_DIR, table_name, *tbl_schema, NARY_MODEL);
+  auto tbl   = table_manager->OpenTable(TEST_DIR, table_name, NARY_MODEL);
+  tbl_schema = nullptr;
+  // each thread pins one page at a time, keep the number of threads below the number of frames
+  const int                                            thread_num = 4;
+  const int                                            insert_num = 2000;
+  std::vector<std::vector<std::pair<RID, RecordUptr>>> inserted(thread_num);
+  std::vector<std::thread>                             threads;
+  for (int t = 0; t < thread_num; ++t) {
+    threads.emplace_back([&, t]() {
+      for (int i = 0; i < insert_num; ++i) {
+        auto record = GenRecordUnderSchema(tbl->GetSchema());
+        auto rid    = tbl->InsertRecord(*record);
+        inserted[t].emplace_back(rid, std::move(record));
+      }
+    });
+  }
+  for (auto &t : threads) {
+    t.join();
+  }
+  ASSERT_EQ(tbl->GetTableHeader().rec_num_, thread_num * insert_num);
+  std::unordered_set<RID> rids;
+  for (auto &records : inserted) {
+    for (auto &[rid, record] : records) {
+      ASSERT_TRUE(rids.insert(rid).second);
+      ASSERT_TRUE(*tbl->GetRecord(rid) == *record);
+    }
+  }
+
+  // delete half of the records while inserting, then the freed slots are reused without new pages
+  threads.clear();
+  for (int t = 0; t < thread_num; ++t) {
+    threads.emplace_back([&, t]() {
+      for (int i = 0; i < insert_num; i += 2) {
+        tbl->DeleteRecord(inserted[t][i].first);
+      }
+    });
+  }
+  for (auto &t : threads) {
+    t.join();
+  }
+  ASSERT_EQ(tbl->GetTableHeader().rec_num_, thread_num * insert_num / 2);
+  tbl->ReleaseInsertPages();
+  auto page_num = tbl->GetTableHeader().page_num_;
+  threads.clear();
+  for (int t = 0; t < thread_num; ++t) {
+    threads.emplace_back([&]() {
+      for (int i = 0; i < insert_num / 2; ++i) {
+        tbl->InsertRecord(*GenRecordUnderSchema(tbl->GetSchema()));
+      }
+    });
+  }
+  for (auto &t : threads) {
+    t.join();
+  }
+  ASSERT_EQ(tbl->GetTableHeader().rec_num_, thread_num * insert_num);
+  ASSERT_EQ(tbl->GetTableHeader().page_num_, page_num);
+  table_manager->CloseTable(TEST_DIR, *tbl);
+  table_manager->DropTable(TEST_DIR, table_name);
+}
+
+TEST(TableHandle, SlotClaims)
+{
+  // slots are claimed aside of the bitmap, scans only see the records once they are published
+  const size_t      slot_num = 20;
+  std::vector<char> bitmap(BITMAP_SIZE(slot_num));
+  SlotClaims        claims(slot_num);
+  BitMap::SetBit(bitmap.data(), 1, true);
+  auto first = claims.Claim(2, bitmap.data(), 3);
+  ASSERT_EQ(first, (std::vector<size_t>{0, 2, 3}));
+  ASSERT_EQ(BitMap::FindFirst(bitmap.data(), slot_num, 2, true), slot_num);
+  // claimed slots are taken by neither other claims nor inserts at a given slot
+  auto second = claims.Claim(2, bitmap.data(), 2);
+  ASSERT_EQ(second, (std::vector<size_t>{4, 5}));
+  ASSERT_FALSE(claims.TryClaim(2, bitmap.data(), 3));
+  ASSERT_FALSE(claims.TryClaim(2, bitmap.data(), 1));
+  ASSERT_TRUE(claims.TryClaim(2, bitmap.data(), 6));
+  // another page has claims of its own
+  std::vector<char> other(BITMAP_SIZE(slot_num));
+  ASSERT_EQ(claims.Claim(3, other.data(), 1), (std::vector<size_t>{0}));
+  claims.Publish(3, other.data(), std::vector<size_t>{0});
+  ASSERT_TRUE(BitMap::GetBit(other.data(), 0));
+  claims.Publish(2, bitmap.data(), first);
+  for (auto slot_id : first) {
+    ASSERT_TRUE(BitMap::GetBit(bitmap.data(), slot_id));
+  }
+  ASSERT_FALSE(BitMap::GetBit(bitmap.data(), 4));
+  claims.Publish(2, bitmap.data(), second);
+  claims.Publish(2, bitmap.data(), std::vector<size_t>{6});
+  // the rest of the page is claimed up to the last slot
+  ASSERT_EQ(claims.Claim(2, bitmap.data(), slot_num).size(), slot_num - 7);
+  ASSERT_TRUE(claims.Claim(2, bitmap.data(), 1).empty());
+}
+
+TEST(TableHandle, BatchInsert)
+{
+  auto        disk_manager        = std::make_unique<DiskManager>();
+  auto        buffer_pool_manager = std::make_unique<BufferPoolManager>(disk_manager.get(), nullptr);
+  auto        table_manager       = std::make_unique<TableManager>(disk_manager.get(), buffer_pool_manager.get());
+  std::string table_name          = "table_handle_batch_insert";
+  if (!std::filesystem::exists(TEST_DIR))
+    std::filesystem::create_directory(TEST_DIR);
+  for (auto storage_model : {NARY_MODEL, SLOTTED_MODEL}) {
+    if (std::filesystem::exists(FILE_NAME(TEST_DIR, table_name, TAB_SUFFIX)))
+      std::filesystem::remove(FILE_NAME(TEST_DIR, table_name, TAB_SUFFIX));
+    auto tbl_schema = GenTableSchema(10);
+    table_manager->CreateTable(TEST_DIR, table_name, *tbl_schema, storage_model);
+    auto tbl   = table_manager->OpenTable(TEST_DIR, table_name, storage_model);
+    tbl_schema = nullptr;
+    std::vector<Record> records;
+    for (int i = 0; i < 1000; ++i) {
+      records.push_back(*GenRecordUnderSchema(tbl->GetSchema()));
+    }
+    auto rids = tbl->InsertRecords(records);
+    ASSERT_EQ(rids.size(), records.size());
+    ASSERT_EQ(tbl->GetTableHeader().rec_num_, records.size());
+    ASSERT_EQ(std::unordered_set<RID>(rids.begin(), rids.end()).size(), rids.size());
+    for (size_t i = 0; i < rids.size(); ++i) {
+      ASSERT_TRUE(*tbl->GetRecord(rids[i]) == records[i]);
+    }
+    // a second batch continues on the last page before new pages are allocated
+    auto page_num = tbl->GetTableHeader().page_num_;
+    tbl->DeleteRecord(rids.back());
+    rids = tbl->InsertRecords(std::span<const Record>(records.data(), 1));
+    ASSERT_EQ(tbl->GetTableHeader().page_num_, page_num);
+    ASSERT_TRUE(*tbl->GetRecord(rids.front()) == records.front());
+    table_manager->CloseTable(TEST_DIR, *tbl);
+    table_manager->DropTable(TEST_DIR, table_name);
+  }
+}
+
+TEST(TableHandle, ZoneMap)
+{
+  auto        disk_manager        = std::make_unique<DiskManager>();
+  auto        buffer_pool_manager = std::make_unique<BufferPoolManager>(disk_manager.get(), nullptr);
+  auto        table_manager       = std::make_unique<TableManager>(disk_manager.get(), buffer_pool_manager.get());
+  std::string table_name          = "table_handle_zone_map";
+  if (!std::filesystem::exists(TEST_DIR))
+    std::filesystem::create_directory(TEST_DIR);
+  if (std::filesystem::exists(FILE_NAME(TEST_DIR, table_name, TAB_SUFFIX)))
+    std::filesystem::remove(FILE_NAME(TEST_DIR, table_name, TAB_SUFFIX));
+  std::vector<RTField> fields(2);
+  fields[0].field_ = {.field_name_ = "id", .field_size_ = sizeof(int), .field_type_ = TYPE_INT};
+  fields[1].field_ = {.field_name_ = "name", .field_size_ = 100, .field_type_ = TYPE_STRING};
+  RecordSchema tbl_schema(fields);
+  table_manager->CreateTable(TEST_DIR, table_name, tbl_schema, NARY_MODEL);
+  auto tbl = table_manager->OpenTable(TEST_DIR, table_name, NARY_MODEL);
+  // ids are inserted in order, so each page holds a narrow range of ids
+  const int           rec_num = 2000;
+  std::vector<Record> records;
+  for (int i = 0; i < rec_num; ++i) {
+    std::vector<ValueSptr> values{ValueFactory::CreateIntValue(i), ValueFactory::CreateStringValue("name", 4)};
+    records.emplace_back(&tbl->GetSchema(), values, INVALID_RID);
+  }
+  tbl->InsertRecords(records);
+
+  // count the records returned by a scan with id > bound, the matching records must all be returned
+  auto scan = [&](TableHandle *tab, int bound) {
+    ValueSptr    val = ValueFactory::CreateIntValue(bound);
+    ConditionVec conds{Condition(OP_GT, tab->GetSchema().GetFieldAt(0), val)};
+    size_t       scanned = 0;
+    size_t       matched = 0;
+    for (auto iter = tab->MakeIterator(&conds); !iter->IsEnd(); iter->Next()) {
+      scanned++;
+      matched += std::dynamic_pointer_cast<IntValue>(iter->GetRecord()->GetValueAt(0))->Get() > bound;
+    }
+    EXPECT_EQ(matched, static_cast<size_t>(std::max(rec_num - bound - 1, 0)));
+    return scanned;
+  };
+  auto rec_per_page = tbl->GetTableHeader().rec_per_page_;
+  ASSERT_LE(scan(tbl.get(), rec_num - 10), rec_per_page);
+  ASSERT_EQ(scan(tbl.get(), rec_num), 0);
+  ASSERT_EQ(scan(tbl.get(), -1), rec_num);
+
+  // ranges are not narrowed on delete, but an empty page is skipped
+  auto rids = tbl->InsertRecords(std::span<const Record>(records.data(), 1));
+  tbl->DeleteRecord(rids.front());
+  for (auto iter = tbl->MakeIterator(); !iter->IsEnd(); iter->Next()) {
+    if (iter->GetRID().PageID() == 1) {
+      tbl->DeleteRecord(iter->GetRID());
+    }
+  }
+  ValueSptr    val = ValueFactory::CreateIntValue(0);
+  ConditionVec conds{Condition(OP_GE, tbl->GetSchema().GetFieldAt(0), val)};
+  ASSERT_NE(tbl->MakeIterator(&conds)->GetRID().PageID(), 1);
+
+  // the zone map is kept across close and open, and forgotten if its file is lost
+  // records refer to the schema of the table handle closed below
+  records.clear();
+  table_manager->CloseTable(TEST_DIR, *tbl);
+  tbl = table_manager->OpenTable(TEST_DIR, table_name, NARY_MODEL);
+  ASSERT_EQ(scan(tbl.get(), rec_num), 0);
+  table_manager->CloseTable(TEST_DIR, *tbl);
+  std::filesystem::remove(FILE_NAME(TEST_DIR, table_name, ZMP_SUFFIX));
+  tbl = table_manager->OpenTable(TEST_DIR, table_name, NARY_MODEL);
+  ASSERT_EQ(scan(tbl.get(), rec_num), tbl->GetTableHeader().rec_num_);
+  table_manager->CloseTable(TEST_DIR, *tbl);
+  table_manager->DropTable(TEST_DIR, table_name);
+}
+
+TEST(TableHandle, Extremum)
+{
+  auto        disk_manager        = std::make_unique<DiskManager>();
+  auto        buffer_pool_manager = std::make_unique<BufferPoolManager>(disk_manager.get(), nullptr);
+  auto        table_manager       = std::make_unique<TableManager>(disk_manager.get(), buffer_pool_manager.get());
+  std::string table_name          = "table_handle_extremum";
+  if (!std::filesystem::exists(TEST_DIR))
+    std::filesystem::create_directory(TEST_DIR);
+  if (std::filesystem::exists(FILE_NAME(TEST_DIR, table_name, TAB_SUFFIX)))
+    std::filesystem::remove(FILE_NAME(TEST_DIR, table_name, TAB_SUFFIX));
+  std::vector<RTField> fields(2);
+  fields[0].field_ = {.field_name_ = "id", .field_size_ = sizeof(int), .field_type_ = TYPE_INT};
+  fields[1].field_ = {.field_name_ = "name", .field_size_ = 100, .field_type_ = TYPE_STRING};
+  RecordSchema tbl_schema(fields);
+  table_manager->CreateTable(TEST_DIR, table_name, tbl_schema, NARY_MODEL);
+  auto tbl = table_manager->OpenTable(TEST_DIR, table_name, NARY_MODEL);
+  ASSERT_TRUE(tbl->GetExtremum(0, false)->IsNull());
+  ASSERT_EQ(tbl->GetExtremum(1, false), nullptr);
+
+  // ids are scattered over the pages, every tenth id is null
+  const int           rec_num = 2000;
+  std::vector<Record> records;
+  for (int i = 0; i < rec_num; ++i) {
+    auto id = i % 10 == 0 ? ValueFactory::CreateNullValue(TYPE_INT) : ValueFactory::CreateIntValue(i * 7 % rec_num);
+    std::vector<ValueSptr> values{id, ValueFactory::CreateStringValue("name", 4)};
+    records.emplace_back(&tbl->GetSchema(), values, INVALID_RID);
+  }
+  auto rids = tbl->InsertRecords(records);
+  ASSERT_EQ(tbl->GetRecordNum(), rec_num);
+  auto min_of = [&]() { return std::dynamic_pointer_cast<IntValue>(tbl->GetExtremum(0, false))->Get(); };
+  auto max_of = [&]() { return std::dynamic_pointer_cast<IntValue>(tbl->GetExtremum(0, true))->Get(); };
+  // i * 7 % rec_num is a multiple of 10 only if i is
+  ASSERT_EQ(min_of(), 1);
+  ASSERT_EQ(max_of(), rec_num - 1);
+
+  // ranges are not narrowed on delete, the extremum is still exact
+  for (int i = 0; i < rec_num; ++i) {
+    auto id = i * 7 % rec_num;
+    if (i % 10 != 0 && (id < 100 || id >= rec_num - 100)) {
+      tbl->DeleteRecord(rids[i]);
+    }
+  }
+  ASSERT_EQ(min_of(), 101);
+  ASSERT_EQ(max_of(), rec_num - 101);
+
+  // pages are read in full without the zone map
+  // records refer to the schema of the table handle closed below
+  records.clear();
+  table_manager->CloseTable(TEST_DIR, *tbl);
+  std::filesystem::remove(FILE_NAME(TEST_DIR, table_name, ZMP_SUFFIX));
+  tbl = table_manager->OpenTable(TEST_DIR, table_name, NARY_MODEL);
+  ASSERT_EQ(min_of(), 101);
+  ASSERT_EQ(max_of(), rec_num - 101);
+  table_manager->CloseTable(TEST_DIR, *tbl);
+  table_manager->DropTable(TEST_DIR, table_name);
+}
+
+TEST(TableHandle, Datum)
+{
+  std::vector<RTField> fields(4);
+  fields[0].field_ = {.field_name_ = "id", .field_size_ = sizeof(int), .field_type_ = TYPE_INT};
+  fields[1].field_ = {.field_name_ = "score", .field_size_ = sizeof(float), .field_type_ = TYPE_FLOAT};
+  fields[2].field_ = {.field_name_ = "tag", .field_size_ = 4, .field_type_ = TYPE_STRING};
+  fields[3].field_ = {.field_name_ = "name", .field_size_ = 32, .field_type_ = TYPE_STRING};
+  RecordSchema           schema(fields);
+  std::string            name = "a name longer than inline";
+  std::vector<ValueSptr> values{ValueFactory::CreateIntValue(7),
+      ValueFactory::CreateNullValue(TYPE_FLOAT),
+      ValueFactory::CreateStringValue("abcd", 4),
+      ValueFactory::CreateStringValue(name.c_str(), name.size())};
+  Record record(&schema, values, INVALID_RID);
+
+  // datums read the same values as GetValueAt, the full-width tag is cut at the field size
+  for (size_t i = 0; i < schema.GetFieldCount(); ++i) {
+    auto datum = record.GetDatumAt(i);
+    auto value = record.GetValueAt(i);
+    ASSERT_EQ(datum.IsNull(), value->IsNull());
+    ASSERT_EQ(datum.ToString(), value->ToString());
+    ASSERT_TRUE(*datum.ToValue() == *value);
+  }
+  ASSERT_EQ(record.GetDatumAt(2).GetString(), "abcd");
+  ASSERT_EQ(record.GetDatumAt(3).GetString(), name);
+  ASSERT_EQ(record.GetDatumAt(3).Hash(), std::hash<std::string>{}(name));
+
+  // int and float compare as float, nulls are only equal to nulls
+  auto id = record.GetDatumAt(0);
+  ASSERT_TRUE(Datum::Eval(OP_EQ, id, Datum::Float(7.0f)));
+  ASSERT_TRUE(Datum::Eval(OP_LT, id, Datum::Float(7.5f)));
+  ASSERT_TRUE(Datum::Eval(OP_GE, id, Datum::Int(7)));
+  ASSERT_FALSE(Datum::Eval(OP_LT, record.GetDatumAt(1), Datum::Float(1.0f)));
+  ASSERT_TRUE(Datum::Eval(OP_NE, record.GetDatumAt(1), Datum::Float(1.0f)));
+  ASSERT_TRUE(Datum::Eval(OP_EQ, record.GetDatumAt(1), Datum::Null(TYPE_FLOAT)));
+  ASSERT_TRUE(Datum::Eval(OP_LT, record.GetDatumAt(2), Datum::String("abce", 4)));
+  ASSERT_THROW(Datum::Eval(OP_EQ, id, record.GetDatumAt(2)), WSDBException_);
+}
+
+TEST(TableHandle, KeyCompare)
+{
+  std::vector<RTField> fields(4);
+  fields[0].field_ = {.field_name_ = "a", .field_size_ = sizeof(int), .field_type_ = TYPE_INT};
+  fields[1].field_ = {.field_name_ = "b", .field_size_ = sizeof(int), .field_type_ = TYPE_INT};
+  fields[2].field_ = {.field_name_ = "c", .field_size_ = 12, .field_type_ = TYPE_STRING};
+  fields[3].field_ = {.field_name_ = "d", .field_size_ = sizeof(float), .field_type_ = TYPE_FLOAT};
+  RecordSchema schema(fields);
+
+  // small domains so that keys collide, every seventh value is null
+  std::vector<Record> records;
+  for (int i = 0; i < 200; ++i) {
+    auto maybe_null = [](ValueSptr value) {
+      return rand() % 7 == 0 ? ValueFactory::CreateNullValue(value->GetType()) : value;
+    };
+    auto str = std::string(rand() % 3, static_cast<char>('a' + rand() % 3));
+    std::vector<ValueSptr> values{maybe_null(ValueFactory::CreateIntValue(static_cast<int>(rand() % 5) - 2)),
+        maybe_null(ValueFactory::CreateIntValue(static_cast<int>(rand() % 5))),
+        maybe_null(ValueFactory::CreateStringValue(str.c_str(), str.size())),
+        maybe_null(ValueFactory::CreateFloatValue(static_cast<float>(rand() % 5 - 2) / 2))};
+    records.emplace_back(&schema, values, INVALID_RID);
+  }
+  // (int), (int, int), (string) and a generic key, each checked against comparing key records
+  // normalized keys compare the same with memcmp, and the other way round if descending
+  for (const auto &key : std::vector<std::vector<size_t>>{{0}, {0, 1}, {2}, {3, 2, 0}}) {
+    std::vector<RTField>    key_fields;
+    std::vector<BoundField> bound_fields;
+    for (auto idx : key) {
+      key_fields.push_back(fields[idx]);
+      bound_fields.push_back(schema.BindField(fields[idx]));
+    }
+    RecordSchema     key_schema(key_fields);
+    RecordComparator  cmp(key_schema, schema);
+    RecordHasher      hasher(key_schema, schema);
+    KeyNormalizer     asc(key_schema, schema, false);
+    KeyNormalizer     desc(key_schema, schema, true);
+    auto              size = asc.GetKeySize();
+    std::vector<char> asc_keys(records.size() * size);
+    std::vector<char> desc_keys(records.size() * size);
+    for (size_t i = 0; i < records.size(); ++i) {
+      asc.Normalize(records[i], asc_keys.data() + i * size);
+      desc.Normalize(records[i], desc_keys.data() + i * size);
+    }
+    auto sign = [](int cmp) { return (cmp > 0) - (cmp < 0); };
+    for (size_t i = 0; i < records.size(); ++i) {
+      Record lhs_key(&key_schema, records[i]);
+      ASSERT_EQ(Record::Compare(Record(&key_schema, records[i], bound_fields), lhs_key), 0);
+      for (size_t j = 0; j < records.size(); ++j) {
+        Record rhs_key(&key_schema, records[j]);
+        auto   expected = Record::Compare(lhs_key, rhs_key);
+        ASSERT_EQ(cmp.Compare(records[i], records[j]), expected);
+        ASSERT_EQ(sign(memcmp(asc_keys.data() + i * size, asc_keys.data() + j * size, size)), expected);
+        ASSERT_EQ(sign(memcmp(desc_keys.data() + i * size, desc_keys.data() + j * size, size)), -expected);
+        if (expected == 0) {
+          ASSERT_EQ(hasher.Hash(records[i]), hasher.Hash(records[j]));
+        }
+      }
+    }
+  }
+}
+
+TEST(TableHandle, Vacuum)
+{
+  auto        disk_manager        = std::make_unique<DiskManager>();
+  auto        buffer_pool_manager = std::make_unique<BufferPoolManager>(disk_manager.get(), nullptr);
+  auto        table_manager       = std::make_unique<TableManager>(disk_manager.get(), buffer_pool_manager.get());
+  std::string table_name          = "table_handle_vacuum";
+  if (!std::filesystem::exists(TEST_DIR))
+    std::filesystem::create_directory(TEST_DIR);
+  if (std::filesystem::exists(FILE_NAME(TEST_DIR, table_name, TAB_SUFFIX)))
+    std::filesystem::remove(FILE_NAME(TEST_DIR, table_name, TAB_SUFFIX));
+  std::vector<RTField> fields(2);
+  fields[0].field_ = {.field_name_ = "id", .field_size_ = sizeof(int), .field_type_ = TYPE_INT};
+  fields[1].field_ = {.field_name_ = "name", .field_size_ = 100, .field_type_ = TYPE_STRING};
+  RecordSchema tbl_schema(fields);
+  table_manager->CreateTable(TEST_DIR, table_name, tbl_schema, NARY_MODEL);
+  auto tbl = table_manager->OpenTable(TEST_DIR, table_name, NARY_MODEL);
+
+  const int           rec_num = 3000;
+  std::vector<Record> records;
+  for (int i = 0; i < rec_num; ++i) {
+    auto                   name = fmt::format("name_{}", i);
+    std::vector<ValueSptr> values{
+        ValueFactory::CreateIntValue(i), ValueFactory::CreateStringValue(name.c_str(), name.size())};
+    records.emplace_back(&tbl->GetSchema(), values, INVALID_RID);
+  }
+  auto rids     = tbl->InsertRecords(records);
+  auto page_num = tbl->GetTableHeader().page_num_;
+
+  size_t                       moved = 0;
+  std::unordered_map<int, RID> kept;
+  auto                         on_move = [&](const Record &old_record, const Record &new_record) {
+    ASSERT_TRUE(old_record == new_record);
+    ASSERT_LT(new_record.GetRID().PageID(), old_record.GetRID().PageID());
+    auto id = std::dynamic_pointer_cast<IntValue>(new_record.GetValueAt(0))->Get();
+    ASSERT_EQ(kept[id], old_record.GetRID());
+    kept[id] = new_record.GetRID();
+    moved++;
+  };
+  // keep one record in ten, deleted through the table while scanning it as DELETE does, vacuum fails while the iterator
+  // is open and moves no record
+  for (auto iter = tbl->MakeIterator(); !iter->IsEnd(); iter->Next()) {
+    auto id = std::dynamic_pointer_cast<IntValue>(iter->GetRecord()->GetValueAt(0))->Get();
+    if (id % 10 == 0) {
+      kept[id] = iter->GetRID();
+    } else {
+      tbl->DeleteRecord(iter->GetRID());
+    }
+    if (id == rec_num / 2) {
+      ASSERT_THROW(tbl->Vacuum(2, on_move), WSDBException_);
+    }
+  }
+  ASSERT_EQ(moved, 0);
+  ASSERT_EQ(kept.size(), rec_num / 10);
+  while (tbl->Vacuum(2, on_move)) {}
+  ASSERT_GT(moved, 0);
+  auto &hdr = tbl->GetTableHeader();
+  ASSERT_EQ(hdr.rec_num_, kept.size());
+  ASSERT_EQ(hdr.page_num_, 1 + (kept.size() + hdr.rec_per_page_ - 1) / hdr.rec_per_page_);
+  ASSERT_LT(hdr.page_num_, page_num);
+  ASSERT_EQ(std::filesystem::file_size(FILE_NAME(TEST_DIR, table_name, TAB_SUFFIX)), hdr.page_num_ * PAGE_SIZE);
+  for (const auto &[id, rid] : kept) {
+    ASSERT_TRUE(*tbl->GetRecord(rid) == records[id]);
+  }
+  size_t scanned = 0;
+  for (auto iter = tbl->MakeIterator(); !iter->IsEnd(); iter->Next()) {
+    scanned++;
+  }
+  ASSERT_EQ(scanned, kept.size());
+
+  // the free page list is rebuilt, inserts fill the remaining slots before allocating new pages
+  size_t free_slots = (hdr.page_num_ - 1) * hdr.rec_per_page_ - hdr.rec_num_;
+  tbl->InsertRecords(std::span<const Record>(records.data(), free_slots));
+  ASSERT_EQ(hdr.page_num_, 1 + (kept.size() + hdr.rec_per_page_ - 1) / hdr.rec_per_page_);
+  // records refer to the schema of the table handle closed below
+  records.clear();
+  table_manager->CloseTable(TEST_DIR, *tbl);
+  tbl = table_manager->OpenTable(TEST_DIR, table_name, NARY_MODEL);
+  ASSERT_EQ(tbl->GetTableHeader().rec_num_, kept.size() + free_slots);
+  table_manager->CloseTable(TEST_DIR, *tbl);
+  table_manager->DropTable(TEST_DIR, table_name);
+}
+
+TEST(TableHandle, Toast)
+{
+  auto        disk_manager        = std::make_unique<DiskManager>();
+  auto        buffer_pool_manager = std::make_unique<BufferPoolManager>(disk_manager.get(), nullptr);
+  auto        table_manager       = std::make_unique<TableManager>(disk_manager.get(), buffer_pool_manager.get());
+  std::string table_name          = "table_handle_toast";
+  if (!std::filesystem::exists(TEST_DIR))
+    std::filesystem::create_directory(TEST_DIR);
+  if (std::filesystem::exists(FILE_NAME(TEST_DIR, table_name, TAB_SUFFIX)))
+    std::filesystem::remove(FILE_NAME(TEST_DIR, table_name, TAB_SUFFIX));
+  if (std::filesystem::exists(FILE_NAME(TEST_DIR, table_name, TST_SUFFIX)))
+    std::filesystem::remove(FILE_NAME(TEST_DIR, table_name, TST_SUFFIX));
+  // the record is wider than MAX_REC_SIZE, only the toast pointers of the wide fields are stored in the rows
+  std::vector<RTField> fields(3);
+  fields[0].field_ = {.field_name_ = "id", .field_size_ = sizeof(int), .field_type_ = TYPE_INT};
+  fields[1].field_ = {.field_name_ = "doc", .field_size_ = 2000, .field_type_ = TYPE_STRING};
+  fields[2].field_ = {.field_name_ = "tag", .field_size_ = 8, .field_type_ = TYPE_STRING};
+  RecordSchema tbl_schema(fields);
+  ASSERT_GT(tbl_schema.GetRecordLength(), MAX_REC_SIZE);
+  table_manager->CreateTable(TEST_DIR, table_name, tbl_schema, NARY_MODEL);
+  ASSERT_TRUE(std::filesystem::exists(FILE_NAME(TEST_DIR, table_name, TST_SUFFIX)));
+  auto tbl = table_manager->OpenTable(TEST_DIR, table_name, NARY_MODEL);
+  ASSERT_LT(tbl->GetTableHeader().rec_size_, 64);
+
+  // short values stay in the row, long ones are moved out, every seventh value is null, i.e. empty in docs
+  const int                rec_num = 500;
+  std::vector<std::string> docs(rec_num);
+  std::vector<Record>      records;
+  for (int i = 0; i < rec_num; ++i) {
+    auto len = i % 3 == 0 ? i % 16 + 1 : i * 3 % 1990 + 10;
+    docs[i]  = i % 7 == 0 ? "" : std::string(len, static_cast<char>('a' + i % 26));
+    auto doc = i % 7 == 0 ? ValueFactory::CreateNullValue(TYPE_STRING)
+                          : ValueFactory::CreateStringValue(docs[i].c_str(), docs[i].size());
+    std::vector<ValueSptr> values{ValueFactory::CreateIntValue(i), doc, ValueFactory::CreateStringValue("tag", 3)};
+    records.emplace_back(&tbl->GetSchema(), values, INVALID_RID);
+  }
+  auto rids  = tbl->InsertRecords(records);
+  auto check = [&](TableHandle *tab) {
+    size_t num = 0;
+    for (auto iter = tab->MakeIterator(); !iter->IsEnd(); iter->Next(), ++num) {
+      auto record = iter->GetRecord();
+      auto id     = std::dynamic_pointer_cast<IntValue>(record->GetValueAt(0))->Get();
+      EXPECT_EQ(*record, *tab->GetRecord(iter->GetRID()));
+      EXPECT_EQ(record->GetValueAt(1)->IsNull(), docs[id].empty());
+      if (!docs[id].empty()) {
+        EXPECT_EQ(record->GetValueAt(1)->ToString(), docs[id]);
+      }
+      EXPECT_EQ(record->GetValueAt(2)->ToString(), "tag");
+    }
+    return num;
+  };
+  ASSERT_EQ(check(tbl.get()), rec_num);
+
+  // the views of a scan reading only the narrow fields are restored without fetching any overflow page
+  auto fetches = [&]() { return buffer_pool_manager->GetHitCount() + buffer_pool_manager->GetMissCount(); };
+  auto scan    = [&](const std::vector<size_t> *read_fields) {
+    auto   before = fetches();
+    size_t num    = 0;
+    for (auto iter = tbl->MakeIterator(nullptr, nullptr, nullptr, read_fields); !iter->IsEnd(); iter->Next(), ++num) {
+      auto view = iter->GetRecordView();
+      auto id   = std::dynamic_pointer_cast<IntValue>(view.GetValueAt(0))->Get();
+      EXPECT_EQ(view.GetValueAt(2)->ToString(), "tag");
+      if (read_fields == nullptr && !docs[id].empty()) {
+        EXPECT_EQ(view.GetValueAt(1)->ToString(), docs[id]);
+      }
+    }
+    EXPECT_EQ(num, rec_num);
+    return fetches() - before;
+  };
+  std::vector<size_t> narrow{0, 2};
+  ASSERT_EQ(scan(&narrow), tbl->GetPageNum() - 1);
+  ASSERT_GT(scan(nullptr), tbl->GetPageNum() - 1);
+
+  // updates and deletes free the old values, their pages are taken again by later inserts
+  for (int i = 0; i < rec_num; i += 2) {
+    tbl->DeleteRecord(rids[i]);
+  }
+  for (int i = 1; i < rec_num; i += 2) {
+    docs[i] = std::string(1990 - i, static_cast<char>('A' + i % 26));
+    std::vector<ValueSptr> values{ValueFactory::CreateIntValue(i),
+        ValueFactory::CreateStringValue(docs[i].c_str(), docs[i].size()),
+        ValueFactory::CreateStringValue("tag", 3)};
+    tbl->UpdateRecord(rids[i], Record(&tbl->GetSchema(), values, INVALID_RID));
+  }
+  // records refer to the schema of the table handle closed below
+  records.clear();
+  table_manager->CloseTable(TEST_DIR, *tbl);
+  auto toast_size = std::filesystem::file_size(FILE_NAME(TEST_DIR, table_name, TST_SUFFIX));
+  tbl             = table_manager->OpenTable(TEST_DIR, table_name, NARY_MODEL);
+  ASSERT_EQ(check(tbl.get()), rec_num / 2);
+  for (int i = 1; i < rec_num; i += 2) {
+    tbl->DeleteRecord(rids[i]);
+  }
+  for (int i = 1; i < rec_num; i += 2) {
+    std::vector<ValueSptr> values{ValueFactory::CreateIntValue(i),
+        ValueFactory::CreateStringValue(docs[i].c_str(), docs[i].size()),
+        ValueFactory::CreateStringValue("tag", 3)};
+    tbl->InsertRecord(Record(&tbl->GetSchema(), values, INVALID_RID));
+  }
+  ASSERT_EQ(check(tbl.get()), rec_num / 2);
+  table_manager->CloseTable(TEST_DIR, *tbl);
+  ASSERT_EQ(std::filesystem::file_size(FILE_NAME(TEST_DIR, table_name, TST_SUFFIX)), toast_size);
+  table_manager->DropTable(TEST_DIR, table_name);
+  ASSERT_FALSE(std::filesystem::exists(FILE_NAME(TEST_DIR, table_name, TST_SUFFIX)));
+}
+
+TEST(TableHandle, Dict)
+{
+  auto        disk_manager        = std::make_unique<DiskManager>();
+  auto        buffer_pool_manager = std::make_unique<BufferPoolManager>(disk_manager.get(), nullptr);
+  auto        table_manager       = std::make_unique<TableManager>(disk_manager.get(), buffer_pool_manager.get());
+  std::string table_name          = "table_handle_dict";
+  if (!std::filesystem::exists(TEST_DIR))
+    std::filesystem::create_directory(TEST_DIR);
+  for (const auto &suffix : {TAB_SUFFIX, TST_SUFFIX, DIC_SUFFIX}) {
+    if (std::filesystem::exists(FILE_NAME(TEST_DIR, table_name, suffix)))
+      std::filesystem::remove(FILE_NAME(TEST_DIR, table_name, suffix));
+  }
+  // the status takes a code in the row, the toasted doc is stored after the codes are taken
+  std::vector<RTField> fields(3);
+  fields[0].field_ = {.field_name_ = "id", .field_size_ = sizeof(int), .field_type_ = TYPE_INT};
+  fields[1].field_ = {.field_name_ = "status", .field_size_ = 32, .field_type_ = TYPE_STRING, .dict_encoded_ = true};
+  fields[2].field_ = {.field_name_ = "doc", .field_size_ = 200, .field_type_ = TYPE_STRING};
+  RecordSchema tbl_schema(fields);
+  ASSERT_THROW(table_manager->CreateTable(TEST_DIR, table_name, tbl_schema, PAX_MODEL), WSDBException_);
+  table_manager->CreateTable(TEST_DIR, table_name, tbl_schema, NARY_MODEL);
+  ASSERT_TRUE(std::filesystem::exists(FILE_NAME(TEST_DIR, table_name, DIC_SUFFIX)));
+  auto tbl = table_manager->OpenTable(TEST_DIR, table_name, NARY_MODEL);
+  ASSERT_TRUE(tbl->GetSchema().GetFieldAt(1).field_.dict_encoded_);
+  ASSERT_LT(tbl->GetTableHeader().rec_size_, sizeof(int) + 32);
+
+  // a handful of statuses repeated over many rows, every eleventh status is null
+  const std::vector<std::string> statuses{"open", "closed", "waiting for review by the owner"};
+  const int                      rec_num = 1000;
+  auto status_of = [&](int i) { return i % 11 == 0 ? std::string() : statuses[i % statuses.size()]; };
+  auto make_rec  = [&](int i) {
+    auto status = status_of(i);
+    auto doc    = std::string(i % 150 + 1, static_cast<char>('a' + i % 26));
+    std::vector<ValueSptr> values{ValueFactory::CreateIntValue(i),
+        status.empty() ? ValueFactory::CreateNullValue(TYPE_STRING)
+                        : ValueFactory::CreateStringValue(status.c_str(), status.size()),
+        ValueFactory::CreateStringValue(doc.c_str(), doc.size())};
+    return Record(&tbl->GetSchema(), values, INVALID_RID);
+  };
+  std::vector<Record> records;
+  for (int i = 0; i < rec_num; ++i) {
+    records.push_back(make_rec(i));
+  }
+  auto rids = tbl->InsertRecords(records);
+  // the rows of the scan given the conditions, each checked against the record inserted
+  auto scan = [&](const ConditionVec *conds) {
+    std::vector<int> ids;
+    for (auto iter = tbl->MakeIterator(conds); !iter->IsEnd(); iter->Next()) {
+      auto record = iter->GetRecord();
+      auto id     = std::dynamic_pointer_cast<IntValue>(record->GetValueAt(0))->Get();
+      EXPECT_EQ(*record, make_rec(id));
+      ids.push_back(id);
+    }
+    return ids;
+  };
+  ASSERT_EQ(scan(nullptr).size(), rec_num);
+
+  // equality conditions on the status are evaluated on codes, other rows are never decoded
+  auto      status_field = tbl->GetSchema().GetFieldAt(1);
+  ValueSptr closed       = ValueFactory::CreateStringValue("closed", 6);
+  ValueSptr missing      = ValueFactory::CreateStringValue("missing", 7);
+  ValueSptr open_or_miss = ValueFactory::CreateArrayValue({ValueFactory::CreateStringValue("open", 4), missing});
+  auto      eq_cond      = ConditionVec{Condition(OP_EQ, status_field, closed)};
+  auto      ne_cond      = ConditionVec{Condition(OP_NE, status_field, closed)};
+  auto      in_cond      = ConditionVec{Condition(OP_IN, status_field, open_or_miss)};
+  auto      miss_cond    = ConditionVec{Condition(OP_EQ, status_field, missing)};
+  auto      count_rows   = [&](const std::function<bool(const std::string &)> &pred) {
+    size_t num = 0;
+    for (int i = 0; i < rec_num; ++i) {
+      num += pred(status_of(i)) ? 1 : 0;
+    }
+    return num;
+  };
+  auto eq_ids = scan(&eq_cond);
+  ASSERT_EQ(eq_ids.size(), count_rows([](const std::string &status) { return status == "closed"; }));
+  for (auto id : eq_ids) {
+    ASSERT_EQ(status_of(id), "closed");
+  }
+  // null is not equal to any value, so it passes <>
+  ASSERT_EQ(scan(&ne_cond).size(), count_rows([](const std::string &status) { return status != "closed"; }));
+  ASSERT_EQ(scan(&in_cond).size(), count_rows([](const std::string &status) { return status == "open"; }));
+  ASSERT_TRUE(tbl->MakeIterator(&miss_cond)->IsEnd());
+
+  // codes survive reopening, values already in the dictionary add no entries
+  records.clear();
+  table_manager->CloseTable(TEST_DIR, *tbl);
+  auto dict_size = std::filesystem::file_size(FILE_NAME(TEST_DIR, table_name, DIC_SUFFIX));
+  tbl            = table_manager->OpenTable(TEST_DIR, table_name, NARY_MODEL);
+  ASSERT_EQ(scan(nullptr).size(), rec_num);
+  for (int i = 0; i < rec_num; i += 2) {
+    tbl->DeleteRecord(rids[i]);
+    tbl->InsertRecord(make_rec(i));
+  }
+  ASSERT_EQ(scan(&eq_cond).size(), eq_ids.size());
+  table_manager->CloseTable(TEST_DIR, *tbl);
+  ASSERT_EQ(std::filesystem::file_size(FILE_NAME(TEST_DIR, table_name, DIC_SUFFIX)), dict_size);
+  table_manager->DropTable(TEST_DIR, table_name);
+  ASSERT_FALSE(std::filesystem::exists(FILE_NAME(TEST_DIR, table_name, DIC_SUFFIX)));
+}
+
+TEST(TableHandle, Memory)
+{
+  auto        disk_manager        = std::make_unique<DiskManager>();
+  auto        buffer_pool_manager = std::make_unique<BufferPoolManager>(disk_manager.get(), nullptr);
+  auto        table_manager       = std::make_unique<TableManager>(disk_manager.get(), buffer_pool_manager.get());
+  std::string table_name          = "table_handle_memory";
+  if (!std::filesystem::exists(TEST_DIR))
+    std::filesystem::create_directory(TEST_DIR);
+  if (std::filesystem::exists(FILE_NAME(TEST_DIR, table_name, TAB_SUFFIX)))
+    std::filesystem::remove(FILE_NAME(TEST_DIR, table_name, TAB_SUFFIX));
+  std::vector<RTField> fields(2);
+  fields[0].field_ = {.field_name_ = "id", .field_size_ = sizeof(int), .field_type_ = TYPE_INT};
+  fields[1].field_ = {.field_name_ = "name", .field_size_ = 100, .field_type_ = TYPE_STRING};
+  RecordSchema tbl_schema(fields);
+  // only the rows of an in-memory table can be kept by a snapshot
+  ASSERT_THROW(table_manager->CreateTable(TEST_DIR, table_name, tbl_schema, NARY_MODEL, nullptr, true), WSDBException_);
+  table_manager->CreateTable(TEST_DIR, table_name, tbl_schema, MEMORY_MODEL, nullptr, true);
+  auto tbl = table_manager->OpenTable(TEST_DIR, table_name, MEMORY_MODEL);
+
+  const int           rec_num    = 3000;
+  const int           thread_num = 4;
+  std::vector<Record> records;
+  for (int i = 0; i < rec_num; ++i) {
+    auto                   name = fmt::format("name_{}", i);
+    std::vector<ValueSptr> values{
+        ValueFactory::CreateIntValue(i), ValueFactory::CreateStringValue(name.c_str(), name.size())};
+    records.emplace_back(&tbl->GetSchema(), values, INVALID_RID);
+  }
+  std::vector<RID>         rids(rec_num);
+  std::vector<std::thread> threads;
+  for (int t = 0; t < thread_num; ++t) {
+    threads.emplace_back([&, t]() {
+      for (int i = t; i < rec_num; i += thread_num) {
+        rids[i] = tbl->InsertRecord(records[i]);
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  ASSERT_EQ(tbl->GetRecordNum(), rec_num);
+  ASSERT_GT(tbl->GetTableHeader().page_num_, BUFFER_POOL_SIZE);
+
+  // the table has more pages than the buffer pool has frames, none of them goes through the buffer pool
+  std::vector<RecordView> views;
+  for (auto iter = tbl->MakeIterator(); !iter->IsEnd(); iter->Next()) {
+    views.push_back(iter->GetRecordView());
+  }
+  ASSERT_EQ(views.size(), rec_num);
+  for (const auto &view : views) {
+    auto id = std::dynamic_pointer_cast<IntValue>(view.GetValueAt(0))->Get();
+    ASSERT_EQ(view.GetRID(), rids[id]);
+    ASSERT_TRUE(*tbl->GetRecord(view.GetRID()) == records[id]);
+  }
+  ASSERT_EQ(buffer_pool_manager->GetHitCount() + buffer_pool_manager->GetMissCount(), 0);
+
+  // views are copies of the rows, they stay valid while vacuum moves the rows
+  for (int i = 0; i < rec_num; ++i) {
+    if (i % 10 != 0) {
+      tbl->DeleteRecord(rids[i]);
+    }
+  }
+  auto on_move = [&](const Record &, const Record &new_record) {
+    auto id  = std::dynamic_pointer_cast<IntValue>(new_record.GetValueAt(0))->Get();
+    rids[id] = new_record.GetRID();
+  };
+  auto page_num = tbl->GetTableHeader().page_num_;
+  {
+    // rows moved behind an open iterator would be missed by it
+    auto iter = tbl->MakeIterator();
+    ASSERT_THROW(tbl->Vacuum(2, on_move), WSDBException_);
+  }
+  ASSERT_EQ(tbl->GetTableHeader().page_num_, page_num);
+  while (tbl->Vacuum(2, on_move)) {}
+  ASSERT_LE(tbl->GetTableHeader().page_num_, page_num / 10 + 2);
+  for (const auto &view : views) {
+    auto id = std::dynamic_pointer_cast<IntValue>(view.GetValueAt(0))->Get();
+    ASSERT_EQ(view.GetValueAt(1)->ToString(), fmt::format("name_{}", id));
+  }
+  views.clear();
+  for (int i = 0; i < rec_num; i += 10) {
+    ASSERT_TRUE(*tbl->GetRecord(rids[i]) == records[i]);
+  }
+  ASSERT_THROW(tbl->GetRecord({static_cast<page_id_t>(page_num), 0}), WSDBException_);
+
+  // the pages are written to the table file on close and loaded again on open
+  records.clear();
+  table_manager->CloseTable(TEST_DIR, *tbl);
+  tbl = table_manager->OpenTable(TEST_DIR, table_name, MEMORY_MODEL);
+  ASSERT_EQ(std::filesystem::file_size(FILE_NAME(TEST_DIR, table_name, TAB_SUFFIX)),
+      tbl->GetTableHeader().page_num_ * PAGE_SIZE);
+  ASSERT_EQ(tbl->GetRecordNum(), rec_num / 10);
+  for (int i = 0; i < rec_num; i += 10) {
+    auto record = tbl->GetRecord(rids[i]);
+    ASSERT_EQ(std::dynamic_pointer_cast<IntValue>(record->GetValueAt(0))->Get(), i);
+    ASSERT_EQ(record->GetValueAt(1)->ToString(), fmt::format("name_{}", i));
+  }
+  size_t scanned = 0;
+  for (auto iter = tbl->MakeIterator(); !iter->IsEnd(); iter->Next()) {
+    scanned++;
+  }
+  ASSERT_EQ(scanned, rec_num / 10);
+  ASSERT_EQ(buffer_pool_manager->GetHitCount() + buffer_pool_manager->GetMissCount(), 0);
+  table_manager->CloseTable(TEST_DIR, *tbl);
+  tbl = nullptr;
+  table_manager->DropTable(TEST_DIR, table_name);
+
+  // without a snapshot the rows are lost on close
+  table_manager->CreateTable(TEST_DIR, table_name, tbl_schema, MEMORY_MODEL);
+  tbl = table_manager->OpenTable(TEST_DIR, table_name, MEMORY_MODEL);
+  for (int i = 0; i < 100; ++i) {
+    auto                   name = fmt::format("name_{}", i);
+    std::vector<ValueSptr> values{
+        ValueFactory::CreateIntValue(i), ValueFactory::CreateStringValue(name.c_str(), name.size())};
+    tbl->InsertRecord(Record(&tbl->GetSchema(), values, INVALID_RID));
+  }
+  ASSERT_EQ(tbl->GetRecordNum(), 100);
+  table_manager->CloseTable(TEST_DIR, *tbl);
+  tbl = table_manager->OpenTable(TEST_DIR, table_name, MEMORY_MODEL);
+  ASSERT_EQ(tbl->GetRecordNum(), 0);
+  ASSERT_TRUE(tbl->MakeIterator()->IsEnd());
+  ASSERT_EQ(std::filesystem::file_size(FILE_NAME(TEST_DIR, table_name, TAB_SUFFIX)), PAGE_SIZE);
+  table_manager->CloseTable(TEST_DIR, *tbl);
+  tbl = nullptr;
+  table_manager->DropTable(TEST_DIR, table_name);
+}
+
+TEST(TableHandle, Lsm)
+{
+  auto        disk_manager        = std::make_unique<DiskManager>();
+  auto        buffer_pool_manager = std::make_unique<BufferPoolManager>(disk_manager.get(), nullptr);
+  auto        table_manager       = std::make_unique<TableManager>(disk_manager.get(), buffer_pool_manager.get());
+  std::string table_name          = "table_handle_lsm";
+  if (!std::filesystem::exists(TEST_DIR))
+    std::filesystem::create_directory(TEST_DIR);
+  if (std::filesystem::exists(FILE_NAME(TEST_DIR, table_name, TAB_SUFFIX)))
+    table_manager->DropTable(TEST_DIR, table_name);
+  std::vector<RTField> fields(2);
+  fields[0].field_ = {.field_name_ = "id", .field_size_ = sizeof(int), .field_type_ = TYPE_INT};
+  fields[1].field_ = {.field_name_ = "name", .field_size_ = 100, .field_type_ = TYPE_STRING};
+  RecordSchema tbl_schema(fields);
+  table_manager->CreateTable(TEST_DIR, table_name, tbl_schema, LSM_MODEL);
+  auto tbl = table_manager->OpenTable(TEST_DIR, table_name, LSM_MODEL);
+
+  // enough rows for several memtables to be flushed and level 0 to be compacted
+  const int rec_num    = 60000;
+  const int thread_num = 4;
+  auto      make       = [&](int id, const std::string &prefix) {
+    auto                   name = fmt::format("{}_{}", prefix, id);
+    std::vector<ValueSptr> values{
+        ValueFactory::CreateIntValue(id), ValueFactory::CreateStringValue(name.c_str(), name.size())};
+    return Record(&tbl->GetSchema(), values, INVALID_RID);
+  };
+  std::vector<RID>         rids(rec_num);
+  std::vector<std::thread> threads;
+  for (int t = 0; t < thread_num; ++t) {
+    threads.emplace_back([&, t]() {
+      std::vector<Record> batch;
+      for (int i = t; i < rec_num; i += thread_num) {
+        batch.push_back(make(i, "name"));
+      }
+      auto batch_rids = tbl->InsertRecords(batch);
+      for (size_t j = 0; j < batch_rids.size(); ++j) {
+        rids[t + j * thread_num] = batch_rids[j];
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  ASSERT_EQ(tbl->GetRecordNum(), rec_num);
+  std::unordered_set<RID> unique_rids(rids.begin(), rids.end());
+  ASSERT_EQ(unique_rids.size(), rec_num);
+
+  // delete one row in three, rename one in three
+  std::vector<std::string> names(rec_num);
+  for (int i = 0; i < rec_num; ++i) {
+    names[i] = fmt::format("name_{}", i);
+    if (i % 3 == 0) {
+      tbl->DeleteRecord(rids[i]);
+      names[i].clear();
+    } else if (i % 3 == 1) {
+      tbl->UpdateRecord(rids[i], make(i, "renamed"));
+      names[i] = fmt::format("renamed_{}", i);
+    }
+  }
+  EXPECT_THROW(tbl->DeleteRecord(rids[0]), WSDBException_);
+  EXPECT_THROW(tbl->InsertRecord(rids[1], make(1, "name")), WSDBException_);
+  tbl->InsertRecord(rids[0], make(0, "name"));
+  names[0] = "name_0";
+
+  auto check = [&]() {
+    for (int i = 0; i < rec_num; i += 7) {
+      if (names[i].empty()) {
+        EXPECT_THROW(tbl->GetRecord(rids[i]), WSDBException_);
+      } else {
+        EXPECT_EQ(tbl->GetRecord(rids[i])->GetValueAt(1)->ToString(), names[i]);
+      }
+    }
+    size_t scanned = 0;
+    RID    last    = INVALID_RID;
+    for (auto iter = tbl->MakeIterator(); !iter->IsEnd(); iter->Next(), ++scanned) {
+      auto record = iter->GetRecord();
+      auto id     = std::dynamic_pointer_cast<IntValue>(record->GetValueAt(0))->Get();
+      EXPECT_EQ(iter->GetRID(), rids[id]);
+      EXPECT_EQ(record->GetValueAt(1)->ToString(), names[id]);
+      if (last == INVALID_RID) {
+        EXPECT_EQ(tbl->GetFirstRID(), iter->GetRID());
+      } else {
+        EXPECT_EQ(tbl->GetNextRID(last), iter->GetRID());
+      }
+      last = iter->GetRID();
+    }
+    EXPECT_EQ(tbl->GetNextRID(last), INVALID_RID);
+    return scanned;
+  };
+  ASSERT_EQ(check(), rec_num - rec_num / 3 + 1);
+
+  // the memtable is flushed on close, the runs are found again through the manifest
+  table_manager->CloseTable(TEST_DIR, *tbl);
+  ASSERT_TRUE(std::filesystem::exists(FILE_NAME(TEST_DIR, table_name, LSM_SUFFIX)));
+  tbl = table_manager->OpenTable(TEST_DIR, table_name, LSM_MODEL);
+  ASSERT_EQ(tbl->GetRecordNum(), rec_num - rec_num / 3 + 1);
+  ASSERT_EQ(check(), rec_num - rec_num / 3 + 1);
+  auto rid = tbl->InsertRecord(make(rec_num, "name"));
+  ASSERT_EQ(std::unordered_set<RID>(rids.begin(), rids.end()).count(rid), 0);
+  table_manager->CloseTable(TEST_DIR, *tbl);
+
+  table_manager->DropTable(TEST_DIR, table_name);
+  ASSERT_FALSE(std::filesystem::exists(FILE_NAME(TEST_DIR, table_name, LSM_SUFFIX)));
+  for (const auto &entry : std::filesystem::directory_iterator(TEST_DIR)) {
+    ASSERT_FALSE(entry.path().filename().string().starts_with(table_name + "_"));
+  }
+}
+
+TEST(TableHandle, Partition)
+{
+  auto        disk_manager        = std::make_unique<DiskManager>();
+  auto        buffer_pool_manager = std::make_unique<BufferPoolManager>(disk_manager.get(), nullptr);
+  auto        table_manager       = std::make_unique<TableManager>(disk_manager.get(), buffer_pool_manager.get());
+  std::string range_name          = "table_handle_range";
+  std::string hash_name           = "table_handle_hash";
+  if (!std::filesystem::exists(TEST_DIR))
+    std::filesystem::create_directory(TEST_DIR);
+  if (std::filesystem::exists(FILE_NAME(TEST_DIR, range_name, TAB_SUFFIX)))
+    table_manager->DropTable(TEST_DIR, range_name, 3);
+  if (std::filesystem::exists(FILE_NAME(TEST_DIR, hash_name, TAB_SUFFIX)))
+    table_manager->DropTable(TEST_DIR, hash_name, 4);
+  std::vector<RTField> fields(2);
+  fields[0].field_ = {.field_name_ = "id", .field_size_ = sizeof(int), .field_type_ = TYPE_INT};
+  fields[1].field_ = {.field_name_ = "name", .field_size_ = 20, .field_type_ = TYPE_STRING};
+  RecordSchema tbl_schema(fields);
+
+  // ids below 1000 go to partition 0, below 2000 to partition 1 and the others to partition 2
+  PartitionScheme range_scheme(
+      RANGE_PARTITION, "id", 3, {ValueFactory::CreateIntValue(1000), ValueFactory::CreateIntValue(2000)});
+  table_manager->CreateTable(TEST_DIR, range_name, tbl_schema, NARY_MODEL, &range_scheme);
+  PartitionScheme hash_scheme(HASH_PARTITION, "name", 4, {});
+  table_manager->CreateTable(TEST_DIR, hash_name, tbl_schema, SLOTTED_MODEL, &hash_scheme);
+  PartitionScheme bad_scheme(
+      RANGE_PARTITION, "id", 3, {ValueFactory::CreateIntValue(2000), ValueFactory::CreateIntValue(1000)});
+  EXPECT_THROW(table_manager->CreateTable(TEST_DIR, "table_handle_bad", tbl_schema, NARY_MODEL, &bad_scheme),
+      WSDBException_);
+  // rids of lsm tables grow without bound, they would run into the partition bits
+  EXPECT_THROW(table_manager->CreateTable(TEST_DIR, "table_handle_bad", tbl_schema, LSM_MODEL, &hash_scheme),
+      WSDBException_);
+
+  const int rec_num = 3000;
+  auto      make    = [](TableHandle &tbl, int id) {
+    auto                   name = fmt::format("name_{}", id);
+    std::vector<ValueSptr> values{
+        ValueFactory::CreateIntValue(id), ValueFactory::CreateStringValue(name.c_str(), name.size())};
+    return Record(&tbl.GetSchema(), values, INVALID_RID);
+  };
+  for (const auto &[table_name, model] : {std::pair{range_name, NARY_MODEL}, std::pair{hash_name, SLOTTED_MODEL}}) {
+    auto tbl = table_manager->OpenTable(TEST_DIR, table_name, model);
+    ASSERT_NE(tbl->GetPartitionScheme(), nullptr);
+    std::vector<Record> batch;
+    for (int i = 0; i < rec_num; ++i) {
+      batch.push_back(make(*tbl, i));
+    }
+    auto rids = tbl->InsertRecords(batch);
+    ASSERT_EQ(tbl->GetRecordNum(), rec_num);
+    if (table_name == hash_name) {
+      // partitions come from FNV-1a of the key, they must stay the same on every platform
+      std::vector<std::pair<int, size_t>> expected{{0, 1}, {1, 2}, {2, 3}, {3, 0}, {42, 1}, {2999, 0}};
+      for (auto [id, partition] : expected) {
+        EXPECT_EQ(static_cast<size_t>(rids[id].PageID()) >> PARTITION_PAGE_BITS, partition) << id;
+      }
+    }
+    for (int i = 0; i < rec_num; i += 7) {
+      auto record = tbl->GetRecord(rids[i]);
+      EXPECT_EQ(record->GetRID(), rids[i]);
+      EXPECT_EQ(std::dynamic_pointer_cast<IntValue>(record->GetValueAt(0))->Get(), i);
+    }
+    size_t scanned = 0;
+    RID    last    = INVALID_RID;
+    for (auto iter = tbl->MakeIterator(); !iter->IsEnd(); iter->Next(), ++scanned) {
+      auto id = std::dynamic_pointer_cast<IntValue>(iter->GetRecord()->GetValueAt(0))->Get();
+      EXPECT_EQ(iter->GetRID(), rids[id]);
+      EXPECT_EQ(last == INVALID_RID ? tbl->GetFirstRID() : tbl->GetNextRID(last), iter->GetRID());
+      last = iter->GetRID();
+    }
+    EXPECT_EQ(tbl->GetNextRID(last), INVALID_RID);
+    ASSERT_EQ(scanned, rec_num);
+    // moving a row to another partition is not supported
+    if (table_name == range_name) {
+      EXPECT_THROW(tbl->UpdateRecord(rids[0], make(*tbl, 2500)), WSDBException_);
+    }
+    tbl->DeleteRecord(rids[1]);
+    EXPECT_THROW(tbl->GetRecord(rids[1]), WSDBException_);
+    table_manager->CloseTable(TEST_DIR, *tbl);
+  }
+
+  // prune by ranges of the key, and by equality for hash partitioning
+  auto range_tbl = table_manager->OpenTable(TEST_DIR, range_name, NARY_MODEL);
+  auto hash_tbl  = table_manager->OpenTable(TEST_DIR, hash_name, SLOTTED_MODEL);
+  ASSERT_EQ(range_tbl->GetRecordNum(), rec_num - 1);
+  auto      id_field   = range_tbl->GetSchema().GetFieldAt(0);
+  ValueSptr lower      = ValueFactory::CreateIntValue(1500);
+  ValueSptr upper      = ValueFactory::CreateFloatValue(2000.0F);
+  auto      range_cond = ConditionVec{Condition(OP_GE, id_field, lower), Condition(OP_LT, id_field, upper)};
+  EXPECT_EQ(range_tbl->GetPartitionScheme()->Prune(range_cond), std::vector<size_t>{1});
+  ValueSptr equal      = ValueFactory::CreateIntValue(2000);
+  auto      equal_cond = ConditionVec{Condition(OP_EQ, id_field, equal)};
+  EXPECT_EQ(range_tbl->GetPartitionScheme()->Prune(equal_cond), std::vector<size_t>{2});
+  EXPECT_EQ(range_tbl->GetPartitionScheme()->Prune({}).size(), 3);
+  auto   partitions = range_tbl->GetPartitionScheme()->Prune(range_cond);
+  size_t scanned    = 0;
+  for (auto iter = range_tbl->MakeIterator(nullptr, &partitions); !iter->IsEnd(); iter->Next(), ++scanned) {
+    auto id = std::dynamic_pointer_cast<IntValue>(iter->GetRecord()->GetValueAt(0))->Get();
+    EXPECT_TRUE(id >= 1000 && id < 2000);
+  }
+  EXPECT_EQ(scanned, 1000);
+  auto      name_field = hash_tbl->GetSchema().GetFieldAt(1);
+  ValueSptr name       = ValueFactory::CreateStringValue("name_42", 7);
+  auto      name_cond  = ConditionVec{Condition(OP_EQ, name_field, name)};
+  partitions           = hash_tbl->GetPartitionScheme()->Prune(name_cond);
+  ASSERT_EQ(partitions.size(), 1);
+  bool found = false;
+  for (auto iter = hash_tbl->MakeIterator(nullptr, &partitions); !iter->IsEnd(); iter->Next()) {
+    found |= iter->GetRecord()->GetValueAt(1)->ToString() == "name_42";
+  }
+  EXPECT_TRUE(found);
+
+  // dropping a partition empties it without touching the others
+  table_manager->DropPartition(TEST_DIR, *range_tbl, 0);
+  EXPECT_THROW(table_manager->DropPartition(TEST_DIR, *range_tbl, 3), WSDBException_);
+  ASSERT_EQ(range_tbl->GetRecordNum(), rec_num - 1000);
+  for (auto iter = range_tbl->MakeIterator(); !iter->IsEnd(); iter->Next()) {
+    EXPECT_GE(std::dynamic_pointer_cast<IntValue>(iter->GetRecord()->GetValueAt(0))->Get(), 1000);
+  }
+  auto rid = range_tbl->InsertRecord(make(*range_tbl, 1));
+  EXPECT_EQ(std::dynamic_pointer_cast<IntValue>(range_tbl->GetRecord(rid)->GetValueAt(0))->Get(), 1);
+  table_manager->CloseTable(TEST_DIR, *range_tbl);
+  table_manager->CloseTable(TEST_DIR, *hash_tbl);
+  range_tbl = table_manager->OpenTable(TEST_DIR, range_name, NARY_MODEL);
+  ASSERT_EQ(range_tbl->GetRecordNum(), rec_num - 1000 + 1);
+  table_manager->CloseTable(TEST_DIR, *range_tbl);
+
+  table_manager->DropTable(TEST_DIR, range_name, 3);
+  table_manager->DropTable(TEST_DIR, hash_name, 4);
+  for (const auto &entry : std::filesystem::recursive_directory_iterator(TEST_DIR)) {
+    ASSERT_FALSE(entry.path().filename().string().starts_with(range_name));
+    ASSERT_FALSE(entry.path().filename().string().starts_with(hash_name));
+  }
+}
+
+TEST(TableHandle, Morsel)
+{
+  auto        disk_manager        = std::make_unique<DiskManager>();
+  auto        buffer_pool_manager = std::make_unique<BufferPoolManager>(disk_manager.get(), nullptr);
+  auto        table_manager       = std::make_unique<TableManager>(disk_manager.get(), buffer_pool_manager.get());
+  std::string table_name          = "table_handle_morsel";
+  if (!std::filesystem::exists(TEST_DIR))
+    std::filesystem::create_directory(TEST_DIR);
+  if (std::filesystem::exists(FILE_NAME(TEST_DIR, table_name, TAB_SUFFIX)))
+    table_manager->DropTable(TEST_DIR, table_name);
+  std::vector<RTField> fields(2);
+  fields[0].field_ = {.field_name_ = "id", .field_size_ = sizeof(int), .field_type_ = TYPE_INT};
+  fields[1].field_ = {.field_name_ = "name", .field_size_ = 100, .field_type_ = TYPE_STRING};
+  RecordSchema tbl_schema(fields);
+  table_manager->CreateTable(TEST_DIR, table_name, tbl_schema, NARY_MODEL);
+  auto tbl = table_manager->OpenTable(TEST_DIR, table_name, NARY_MODEL);
+
+  const int           rec_num = 50000;
+  std::vector<Record> records;
+  for (int i = 0; i < rec_num; ++i) {
+    std::vector<ValueSptr> values{ValueFactory::CreateIntValue(i), ValueFactory::CreateStringValue("name", 4)};
+    records.emplace_back(&tbl->GetSchema(), values, INVALID_RID);
+  }
+  auto rids = tbl->InsertRecords(records);
+  for (int i = 0; i < rec_num; i += 3) {
+    tbl->DeleteRecord(rids[i]);
+  }
+  ASSERT_GT(tbl->GetPageNum(), 4 * SCAN_MORSEL_PAGES);
+
+  // iterators sharing the morsels read every record once between them, with or without conditions
+  ValueSptr    bound = ValueFactory::CreateIntValue(rec_num / 2);
+  ConditionVec conds{Condition(OP_GE, tbl->GetSchema().GetFieldAt(0), bound)};
+  for (const auto *scan_conds : std::array<const ConditionVec *, 2>{nullptr, &conds}) {
+    auto                     page_num = static_cast<page_id_t>(tbl->GetPageNum());
+    PageMorsels              morsels(FILE_HEADER_PAGE_ID + 1, page_num, SCAN_MORSEL_PAGES);
+    std::vector<int>         seen(rec_num, 0);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+      threads.emplace_back([&]() {
+        for (auto iter = tbl->MakeIterator(scan_conds, nullptr, &morsels); !iter->IsEnd(); iter->Next()) {
+          auto id = std::dynamic_pointer_cast<IntValue>(iter->GetRecordView().GetValueAt(0))->Get();
+          EXPECT_EQ(iter->GetRID(), rids[id]);
+          std::atomic_ref<int>(seen[id])++;
+        }
+      });
+    }
+    for (auto &thread : threads) {
+      thread.join();
+    }
+    for (int i = 0; i < rec_num; ++i) {
+      // pages skipped by the zone map may still return records that do not satisfy the conditions
+      if (i % 3 == 0) {
+        EXPECT_EQ(seen[i], 0);
+      } else if (scan_conds == nullptr || i >= rec_num / 2) {
+        EXPECT_EQ(seen[i], 1);
+      } else {
+        EXPECT_LE(seen[i], 1);
+      }
+    }
+  }
+  table_manager->CloseTable(TEST_DIR, *tbl);
+  table_manager->DropTable(TEST_DIR, table_name);
+}
+
 TEST(TableHandle, PAX_MultiThread)
 {
   auto        disk_manager        = std::make_unique<DiskManager>();
@@ -198,7 +1477,7 @@ TEST(TableHandle, PAX_MultiThread)
   if (!std::filesystem::exists(TEST_DIR))
     std::filesystem::create_directory(TEST_DIR);
   if (std::filesystem::exists(FILE_NAME(TEST_DIR, table_name, TAB_SUFFIX)))
-    std::filesystem::remove(FILE_NAME(TEST_DIR, table_name, TAB_SUFFIX));
+    table_manager->DropTable(TEST_DIR, table_name);
   auto tbl_schema = GenTableSchema(10);
   table_manager->CreateTable(TEST_DIR, table_name, *tbl_schema, PAX_MODEL);
   auto tbl   = table_manager->OpenTable(TEST_DIR, table_name, PAX_MODEL);
@@ -256,8 +1535,13 @@ TEST(TableHandle, PAX_MultiThread)
   }
   for (const auto &[pid, chunk] : chunks) {
     ASSERT_TRUE(chunk_data.find(pid) != chunk_data.end());
+    ASSERT_EQ(chunk->GetSize(), chunk_data[pid][0]->GetValueNum());
     for (int i = 0; i < 3; ++i) {
-      ASSERT_TRUE(*chunk->GetCol(i) == *chunk_data[pid][i]);
+      auto col = ValueFactory::CreateArrayValue();
+      for (size_t j = 0; j < chunk->GetSize(); ++j) {
+        col->Append(chunk->GetValue(i, j));
+      }
+      ASSERT_TRUE(*col == *chunk_data[pid][i]);
     }
   }
 
@@ -302,6 +1586,161 @@ TEST(TableHandle, PAX_MultiThread)
     t.join();
   }
   ASSERT_EQ(cnt, rids.size());
+  table_manager->CloseTable(TEST_DIR, *tbl);
+  table_manager->DropTable(TEST_DIR, table_name);
+}
+
+TEST(TableHandle, PAX_Encoding)
+{
+  // sorted ints are delta or frame-of-reference encoded, repeated strings are dictionary or run-length encoded
+  std::vector<int32_t> ints(200);
+  for (size_t i = 0; i < ints.size(); ++i) {
+    ints[i] = static_cast<int32_t>(1000 + i * 3);
+  }
+  std::vector<char> encoded(ints.size() * sizeof(int32_t));
+  std::vector<char> decoded(ints.size() * sizeof(int32_t));
+  size_t            size     = 0;
+  auto              encoding = ColumnCodec::Encode(TYPE_INT, sizeof(int32_t),
+      reinterpret_cast<const char *>(ints.data()), ints.size(), encoded.data(), size);
+  ASSERT_NE(encoding, ColumnEncoding::PLAIN);
+  ASSERT_LT(size, encoded.size());
+  ColumnCodec::Decode(encoding, sizeof(int32_t), encoded.data(), ints.size(), decoded.data());
+  ASSERT_EQ(memcmp(decoded.data(), ints.data(), decoded.size()), 0);
+
+  auto        disk_manager        = std::make_unique<DiskManager>();
+  auto        buffer_pool_manager = std::make_unique<BufferPoolManager>(disk_manager.get(), nullptr);
+  auto        table_manager       = std::make_unique<TableManager>(disk_manager.get(), buffer_pool_manager.get());
+  std::string table_name          = "table_handle_pax_encoding";
+  if (!std::filesystem::exists(TEST_DIR))
+    std::filesystem::create_directory(TEST_DIR);
+  if (std::filesystem::exists(FILE_NAME(TEST_DIR, table_name, TAB_SUFFIX)))
+    table_manager->DropTable(TEST_DIR, table_name);
+  std::vector<RTField> fields(3);
+  fields[0].field_ = {.field_name_ = "id", .field_size_ = sizeof(int), .field_type_ = TYPE_INT};
+  fields[1].field_ = {.field_name_ = "name", .field_size_ = 16, .field_type_ = TYPE_STRING};
+  fields[2].field_ = {.field_name_ = "score", .field_size_ = sizeof(float), .field_type_ = TYPE_FLOAT};
+  RecordSchema tbl_schema(fields);
+  table_manager->CreateTable(TEST_DIR, table_name, tbl_schema, PAX_MODEL);
+  auto tbl = table_manager->OpenTable(TEST_DIR, table_name, PAX_MODEL);
+
+  const char         *names[] = {"alice", "bob", "carol"};
+  const int           rec_num = 2000;
+  std::vector<Record> records;
+  for (int i = 0; i < rec_num; ++i) {
+    std::vector<ValueSptr> values{ValueFactory::CreateIntValue(i),
+        ValueFactory::CreateStringValue(names[i / 100 % 3], 16),
+        i % 7 == 0 ? ValueFactory::CreateNullValue(TYPE_FLOAT) : ValueFactory::CreateFloatValue(i % 10)};
+    records.emplace_back(&tbl->GetSchema(), values, INVALID_RID);
+  }
+  auto rids = tbl->InsertRecords(records);
+  for (int i = 0; i < rec_num; ++i) {
+    ASSERT_TRUE(*tbl->GetRecord(rids[i]) == records[i]);
+  }
+
+  // rows beyond those a page holds plain are encoded in the page, the pages hold more rows than plain ones would
+  auto  &tab_hdr   = tbl->GetTableHeader();
+  size_t plain_num = (BITMAP_WIDTH * (PAGE_SIZE - PAGE_HEADER_SIZE - 1) + 1) /
+                     (1 + (tab_hdr.rec_size_ + tab_hdr.nullmap_size_) * BITMAP_WIDTH);
+  ASSERT_GT(tab_hdr.rec_per_page_, plain_num);
+  ASSERT_LT(tbl->GetPageNum() - 1, rec_num / plain_num);
+
+  // conditions are evaluated on the plain minipages and on the encoded columns of each page
+  auto scan = [&](const ConditionVec &conds, const std::function<bool(int)> &pred) {
+    size_t expected = 0;
+    for (int i = 0; i < rec_num; ++i) {
+      expected += pred(i);
+    }
+    size_t scanned = 0;
+    for (auto iter = tbl->MakeIterator(&conds); !iter->IsEnd(); iter->Next()) {
+      auto id = std::dynamic_pointer_cast<IntValue>(iter->GetRecord()->GetValueAt(0))->Get();
+      ASSERT_TRUE(pred(id));
+      scanned++;
+    }
+    ASSERT_EQ(scanned, expected);
+  };
+  ValueSptr bob   = ValueFactory::CreateStringValue("bob", 3);
+  ValueSptr bound = ValueFactory::CreateIntValue(500);
+  ValueSptr score = ValueFactory::CreateFloatValue(5);
+  auto     &id_field    = tbl->GetSchema().GetFieldAt(0);
+  auto     &name_field  = tbl->GetSchema().GetFieldAt(1);
+  auto     &score_field = tbl->GetSchema().GetFieldAt(2);
+  scan({Condition(OP_EQ, name_field, bob)}, [](int i) { return i / 100 % 3 == 1; });
+  scan({Condition(OP_GE, id_field, bound), Condition(OP_LT, score_field, score)},
+      [](int i) { return i >= 500 && i % 7 != 0 && i % 10 < 5; });
+  scan({Condition(OP_NE, score_field, score)}, [](int i) { return i % 7 == 0 || i % 10 != 5; });
+
+  // an encoded row is updated, deleted and inserted again in place, the page is encoded again with it
+  std::vector<ValueSptr> values{ValueFactory::CreateIntValue(-1), ValueFactory::CreateStringValue("dave", 4),
+      ValueFactory::CreateFloatValue(0.5)};
+  Record    updated(&tbl->GetSchema(), values, INVALID_RID);
+  ValueSptr dave = ValueFactory::CreateStringValue("dave", 4);
+  tbl->UpdateRecord(rids[150], updated);
+  tbl->DeleteRecord(rids[250]);
+  tbl->InsertRecord(rids[250], updated);
+  ASSERT_THROW(tbl->InsertRecord(rids[250], updated), WSDBException_);
+  tbl->DeleteRecord(rids[350]);
+  ConditionVec     dave_conds{Condition(OP_EQ, name_field, dave)};
+  std::vector<RID> dave_rids;
+  for (auto iter = tbl->MakeIterator(&dave_conds); !iter->IsEnd(); iter->Next()) {
+    dave_rids.push_back(iter->GetRID());
+  }
+  ASSERT_EQ(dave_rids, (std::vector<RID>{rids[150], rids[250]}));
+  for (int i = 0; i < rec_num; ++i) {
+    if (i != 150 && i != 250 && i != 350) {
+      ASSERT_TRUE(*tbl->GetRecord(rids[i]) == records[i]);
+    }
+  }
+  // a deleted slot is not visited
+  ValueSptr deleted = ValueFactory::CreateIntValue(350);
+  scan({Condition(OP_EQ, id_field, deleted)}, [](int) { return false; });
+
+  // rows that encode badly take more space than the page has, they are spilled to the toast file and still read back
+  for (int i = 0; i < rec_num; i += 2) {
+    auto                   name = fmt::format("{:016x}", std::hash<int>{}(i) * 0x9e3779b97f4a7c15ULL);
+    std::vector<ValueSptr> random{ValueFactory::CreateIntValue(10000 + i * 7919 % 100003),
+        ValueFactory::CreateStringValue(name.c_str(), 16), ValueFactory::CreateFloatValue(i * 0.37F)};
+    records[i] = Record(&tbl->GetSchema(), random, INVALID_RID);
+    if (i != 150 && i != 250 && i != 350) {
+      tbl->UpdateRecord(rids[i], records[i]);
+    }
+  }
+  for (int i = 0; i < rec_num; ++i) {
+    if (i != 150 && i != 250 && i != 350) {
+      ASSERT_TRUE(*tbl->GetRecord(rids[i]) == records[i]);
+    }
+  }
+
+  // chunks gather plain and encoded rows of the page
+  std::vector<RTField> chunk_fields{tbl->GetSchema().GetFieldAt(0), tbl->GetSchema().GetFieldAt(2)};
+  RecordSchema         chunk_schema(chunk_fields);
+  std::unordered_map<int, int> index;
+  for (int i = 0; i < rec_num; ++i) {
+    index[std::dynamic_pointer_cast<IntValue>(records[i].GetValueAt(0))->Get()] = i;
+  }
+  auto page_id = rids[1].PageID();
+  auto chunk   = tbl->GetChunk(page_id, &chunk_schema);
+  ASSERT_EQ(chunk->GetSize(), std::count_if(rids.begin(), rids.end(), [&](const RID &rid) {
+    return rid.PageID() == page_id && rid != rids[350];
+  }));
+  for (size_t i = 0; i < chunk->GetSize(); ++i) {
+    auto id = std::dynamic_pointer_cast<IntValue>(chunk->GetValue(0, i))->Get();
+    if (id == -1) {
+      continue;
+    }
+    ASSERT_TRUE(*chunk->GetValue(1, i) == *records[index.at(id)].GetValueAt(2));
+  }
+
+  // the encoded pages and their spilled rows are read back once the table is opened again
+  table_manager->CloseTable(TEST_DIR, *tbl);
+  auto reopened = table_manager->OpenTable(TEST_DIR, table_name, PAX_MODEL);
+  for (int i = 0; i < rec_num; ++i) {
+    if (i != 150 && i != 250 && i != 350) {
+      Record expected(&reopened->GetSchema(), records[i].GetNullMap(), records[i].GetData(), rids[i]);
+      ASSERT_TRUE(*reopened->GetRecord(rids[i]) == expected);
+    }
+  }
+  table_manager->CloseTable(TEST_DIR, *reopened);
+  table_manager->DropTable(TEST_DIR, table_name);
 }
 
 int main(int argc, char **argv)